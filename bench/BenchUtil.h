@@ -0,0 +1,39 @@
+/* CryHTML5 - for licensing and copyright see license.txt */
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+namespace HTML5Bench
+{
+    /** @return monotonic time in seconds */
+    inline double GetSeconds()
+    {
+        return std::chrono::duration<double>( std::chrono::steady_clock::now().time_since_epoch() ).count();
+    }
+
+    /** @return the value below which nPercent percent of the samples lie (sorts the samples) */
+    inline double GetPercentile( std::vector<double>& samples, int nPercent )
+    {
+        if ( samples.empty() )
+        {
+            return 0.0;
+        }
+
+        std::sort( samples.begin(), samples.end() );
+        const size_t nIndex = std::min( samples.size() - 1, samples.size() * nPercent / 100 );
+        return samples[nIndex];
+    }
+
+    /** @brief keeps the optimizer from dropping a computed value */
+    template<class T>
+    inline void KeepValue( const T& value )
+    {
+        static volatile T s_sink;
+        s_sink = value;
+        ( void )s_sink;
+    }
+}
@@ -0,0 +1,135 @@
+/* CryHTML5 - for licensing and copyright see license.txt */
+
+// Cost of the alpha coverage on a 1920x1080 HUD: updates for small and full paints, point and region queries with p50/p99 latency.
+
+#include "StdAfx.h"
+#include "AlphaCoverage.h"
+#include "BenchUtil.h"
+
+using namespace HTML5Plugin;
+using namespace HTML5Bench;
+
+namespace
+{
+    enum
+    {
+        eWidth = 1920,
+        eHeight = 1080,
+        eRounds = 2000,
+    };
+
+    /** @brief transparent frame with a dozen opaque HUD panels and soft edges */
+    void MakeHUD( std::vector<uint8>& frame )
+    {
+        static const SDirtyRect panels[] =
+        {
+            SDirtyRect( 20, 20, 320, 60 ), SDirtyRect( 20, 70, 320, 110 ), SDirtyRect( 1600, 20, 1900, 320 ),
+            SDirtyRect( 1700, 960, 1900, 1060 ), SDirtyRect( 20, 960, 260, 1060 ), SDirtyRect( 900, 20, 1020, 60 ),
+            SDirtyRect( 940, 520, 980, 560 ), SDirtyRect( 600, 980, 1320, 1000 ), SDirtyRect( 20, 400, 300, 700 ),
+            SDirtyRect( 1500, 400, 1900, 440 ), SDirtyRect( 1500, 450, 1900, 490 ), SDirtyRect( 1500, 500, 1900, 540 ),
+        };
+
+        frame.assign( size_t( eWidth ) * eHeight * 4, 0 );
+
+        for ( size_t p = 0; p < sizeof( panels ) / sizeof( panels[0] ); ++p )
+        {
+            const SDirtyRect& rect = panels[p];
+
+            for ( int y = rect.y; y < rect.y2; ++y )
+            {
+                for ( int x = rect.x; x < rect.x2; ++x )
+                {
+                    const bool bEdge = x == rect.x || y == rect.y || x == rect.x2 - 1 || y == rect.y2 - 1;
+                    frame[( size_t( y ) * eWidth + x ) * 4 + 3] = bEdge ? 128 : 255;
+                }
+            }
+        }
+    }
+
+    void PrintLatency( const char* sName, std::vector<double>& samples )
+    {
+        double fTotal = 0.0;
+
+        for ( size_t i = 0; i < samples.size(); ++i )
+        {
+            fTotal += samples[i];
+        }
+
+        printf( "%-22s mean %9.2f us  p50 %9.2f us  p99 %9.2f us\n", sName, fTotal * 1e6 / samples.size(),
+                GetPercentile( samples, 50 ) * 1e6, GetPercentile( samples, 99 ) * 1e6 );
+    }
+
+    /** @brief time updates with the given dirty rect */
+    void BenchUpdate( const char* sName, CAlphaCoverage& coverage, const std::vector<uint8>& frame, const SDirtyRect& rect, int nRounds )
+    {
+        CDirtyRegion dirty;
+        dirty.Add( rect );
+
+        std::vector<double> samples;
+
+        for ( int i = 0; i < nRounds; ++i )
+        {
+            const double fStart = GetSeconds();
+            coverage.Update( &frame[0], eWidth, eHeight, dirty );
+            samples.push_back( GetSeconds() - fStart );
+        }
+
+        PrintLatency( sName, samples );
+    }
+
+    /** @brief time batches of 64 queries, a batch is timed as a whole so the clock doesn't dominate */
+    template<class TQuery>
+    void BenchQuery( const char* sName, const TQuery& query )
+    {
+        std::vector<double> samples;
+        uint32 nState = 99;
+        uint32 nHits = 0;
+
+        for ( int i = 0; i < eRounds; ++i )
+        {
+            const double fStart = GetSeconds();
+
+            for ( int n = 0; n < 64; ++n )
+            {
+                nState = nState * 1664525u + 1013904223u;
+                nHits += query( int( ( nState >> 8 ) % eWidth ), int( ( nState >> 4 ) % eHeight ) ) ? 1 : 0;
+            }
+
+            samples.push_back( ( GetSeconds() - fStart ) / 64 );
+        }
+
+        KeepValue( nHits );
+        PrintLatency( sName, samples );
+    }
+}
+
+int main()
+{
+    std::vector<uint8> frame;
+    MakeHUD( frame );
+
+    CAlphaCoverage coverage;
+    CDirtyRegion none;
+    coverage.Update( &frame[0], eWidth, eHeight, none );
+
+    BenchUpdate( "update 32x32", coverage, frame, SDirtyRect( 940, 520, 972, 552 ), eRounds );
+    BenchUpdate( "update 300x300", coverage, frame, SDirtyRect( 1600, 20, 1900, 320 ), eRounds );
+    BenchUpdate( "update full frame", coverage, frame, SDirtyRect( 0, 0, eWidth, eHeight ), 100 );
+
+    BenchQuery( "point query", [&coverage]( int x, int y )
+    {
+        return coverage.IsOpaque( x, y, 128 );
+    } );
+
+    BenchQuery( "region query 24x24", [&coverage]( int x, int y )
+    {
+        return coverage.IsRegionOpaque( SDirtyRect( x, y, x + 24, y + 24 ), 128 );
+    } );
+
+    BenchQuery( "region query 400x300", [&coverage]( int x, int y )
+    {
+        return coverage.IsRegionOpaque( SDirtyRect( x, y, x + 400, y + 300 ), 255 );
+    } );
+
+    return 0;
+}
@@ -0,0 +1,128 @@
+/* CryHTML5 - for licensing and copyright see license.txt */
+
+// Occupancy and fragmentation of the atlas while surfaces are created and destroyed at random, for a few mixes of surface sizes.
+
+#include "StdAfx.h"
+#include "AtlasPacker.h"
+#include "BenchUtil.h"
+
+using namespace HTML5Plugin;
+using namespace HTML5Bench;
+
+namespace
+{
+    enum
+    {
+        ePageSize = 2048,
+        eMaxPages = 4,
+        ePadding = 1,
+        eOperations = 40000,
+        eReportEvery = 10000,
+    };
+
+    /** @brief small deterministic generator so runs compare */
+    struct SRandom
+    {
+        uint32 nState;
+
+        explicit SRandom( uint32 nSeed )
+            : nState( nSeed )
+        {
+        }
+
+        int Next( int nRange )
+        {
+            nState = nState * 1664525u + 1013904223u;
+            return int( ( nState >> 8 ) % uint32( nRange ) );
+        }
+    };
+
+    /** @brief range of surface sizes */
+    struct SMix
+    {
+        const char* sName;
+        int nMinWidth;
+        int nMaxWidth;
+        int nMinHeight;
+        int nMaxHeight;
+    };
+
+    void BenchMix( const SMix& mix )
+    {
+        CAtlasPacker packer;
+        packer.Configure( ePageSize, eMaxPages, ePadding );
+
+        SRandom random( 11 );
+        std::vector<CAtlasPacker::THandle> live;
+        std::vector<double> times;
+        int nRequests = 0;
+        int nFailed = 0;
+
+        printf( "%s (%dx%d to %dx%d)\n", mix.sName, mix.nMinWidth, mix.nMinHeight, mix.nMaxWidth, mix.nMaxHeight );
+
+        for ( int i = 1; i <= eOperations; ++i )
+        {
+            // allocations outweigh frees, so the atlas fills up and stays full
+            if ( live.empty() || random.Next( 5 ) < 3 )
+            {
+                const int nWidth = mix.nMinWidth + random.Next( mix.nMaxWidth - mix.nMinWidth + 1 );
+                const int nHeight = mix.nMinHeight + random.Next( mix.nMaxHeight - mix.nMinHeight + 1 );
+
+                const double fStart = GetSeconds();
+                const CAtlasPacker::THandle hEntry = packer.Allocate( nWidth, nHeight );
+                times.push_back( GetSeconds() - fStart );
+
+                ++nRequests;
+
+                if ( hEntry )
+                {
+                    live.push_back( hEntry );
+                }
+
+                else
+                {
+                    ++nFailed;
+                }
+            }
+
+            else
+            {
+                const size_t n = size_t( random.Next( int( live.size() ) ) );
+                packer.Free( live[n] );
+                live[n] = live.back();
+                live.pop_back();
+            }
+
+            if ( i % eReportEvery == 0 )
+            {
+                const CAtlasPacker::SStats stats = packer.GetStats();
+                const double fCapacity = double( ePageSize ) * ePageSize * max( stats.nPages, 1u );
+
+                printf( "  %6d ops: %5u surfaces  %u pages  occupancy %5.1f%%  fragmentation %5.1f%%  failed %5.1f%%  repacks %4u  moves %7u  allocate p50 %5.2f us p99 %7.2f us\n",
+                        i, stats.nEntries, stats.nPages, 100.0 * double( stats.nLiveArea ) / fCapacity, 100.0 * packer.GetFragmentation(),
+                        100.0 * nFailed / max( nRequests, 1 ), stats.nRepacks, stats.nMoves, GetPercentile( times, 50 ) * 1e6, GetPercentile( times, 99 ) * 1e6 );
+
+                times.clear();
+                nRequests = 0;
+                nFailed = 0;
+            }
+        }
+    }
+}
+
+int main()
+{
+    const SMix mixes[] =
+    {
+        { "icons and labels", 16, 128, 16, 64 },
+        { "mixed widgets", 16, 400, 16, 200 },
+        { "panels", 200, 700, 100, 500 },
+    };
+
+    for ( size_t i = 0; i < sizeof( mixes ) / sizeof( mixes[0] ); ++i )
+    {
+        BenchMix( mixes[i] );
+    }
+
+    return 0;
+}
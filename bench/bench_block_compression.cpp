@@ -0,0 +1,303 @@
+/* CryHTML5 - for licensing and copyright see license.txt */
+
+// BC3 encoding speed and quality on 1920x1080 UI frames: a mostly transparent HUD and an opaque menu with gradients, text and icons.
+
+#include "StdAfx.h"
+#include "BlockCompression.h"
+#include "BenchUtil.h"
+
+using namespace HTML5Plugin;
+using namespace HTML5Bench;
+
+namespace
+{
+    enum
+    {
+        eWidth = 1920,
+        eHeight = 1080,
+        eRounds = 20,
+    };
+
+    /** @brief small deterministic generator so runs compare */
+    struct SRandom
+    {
+        uint32 nState;
+
+        explicit SRandom( uint32 nSeed )
+            : nState( nSeed )
+        {
+        }
+
+        int Next( int nRange )
+        {
+            nState = nState * 1664525u + 1013904223u;
+            return int( ( nState >> 8 ) % uint32( nRange ) );
+        }
+    };
+
+    /** @brief BGRA frame the test content is drawn into */
+    struct SImage
+    {
+        std::vector<uint8> pixels;
+
+        SImage()
+            : pixels( size_t( eWidth ) * eHeight * 4, 0 )
+        {
+        }
+
+        /** @brief blend a color over a pixel, fCoverage scales the alpha (anti-aliased edges) */
+        void Blend( int x, int y, const uint8 color[4], float fCoverage )
+        {
+            if ( x < 0 || y < 0 || x >= eWidth || y >= eHeight )
+            {
+                return;
+            }
+
+            uint8* pPixel = &pixels[( size_t( y ) * eWidth + x ) * 4];
+            const float fAlpha = color[3] / 255.0f * clamp_tpl( fCoverage, 0.0f, 1.0f );
+            const float fDestAlpha = pPixel[3] / 255.0f;
+            const float fOutAlpha = fAlpha + fDestAlpha * ( 1.0f - fAlpha );
+
+            for ( int c = 0; c < 3 && fOutAlpha > 0.0f; ++c )
+            {
+                pPixel[c] = uint8( ( color[c] * fAlpha + pPixel[c] * fDestAlpha * ( 1.0f - fAlpha ) ) / fOutAlpha + 0.5f );
+            }
+
+            pPixel[3] = uint8( fOutAlpha * 255.0f + 0.5f );
+        }
+
+        /** @brief rounded panel with a vertical gradient from top to bottom color */
+        void Panel( int x0, int y0, int x1, int y1, float fRadius, const uint8 top[4], const uint8 bottom[4] )
+        {
+            for ( int y = y0; y < y1; ++y )
+            {
+                const float t = float( y - y0 ) / float( max( y1 - y0 - 1, 1 ) );
+                const uint8 color[4] = { uint8( top[0] + ( bottom[0] - top[0] ) * t ), uint8( top[1] + ( bottom[1] - top[1] ) * t ),
+                                         uint8( top[2] + ( bottom[2] - top[2] ) * t ), uint8( top[3] + ( bottom[3] - top[3] ) * t )
+                                       };
+
+                for ( int x = x0; x < x1; ++x )
+                {
+                    // distance outside the rounded corner, one pixel of anti-aliasing
+                    const float dx = max( max( x0 + fRadius - x - 0.5f, x + 0.5f - ( x1 - fRadius ) ), 0.0f );
+                    const float dy = max( max( y0 + fRadius - y - 0.5f, y + 0.5f - ( y1 - fRadius ) ), 0.0f );
+                    Blend( x, y, color, fRadius + 0.5f - sqrtf( dx * dx + dy * dy ) );
+                }
+            }
+        }
+
+        /** @brief line of text: glyphs of one or two pixel strokes with anti-aliased columns */
+        void Text( int x0, int y0, int nChars, int nSize, const uint8 color[4], SRandom& random )
+        {
+            for ( int n = 0; n < nChars; ++n )
+            {
+                const int x = x0 + n * nSize * 6 / 10;
+
+                if ( random.Next( 7 ) == 0 )
+                {
+                    continue; // space
+                }
+
+                // a few strokes per glyph
+                for ( int nStroke = 0; nStroke < 3; ++nStroke )
+                {
+                    const bool bVertical = random.Next( 2 ) != 0;
+                    const int sx = x + random.Next( nSize / 2 );
+                    const int sy = y0 + random.Next( nSize / 2 );
+                    const int nLength = nSize / 3 + random.Next( nSize / 2 );
+
+                    for ( int i = 0; i < nLength; ++i )
+                    {
+                        Blend( bVertical ? sx : sx + i, bVertical ? sy + i : sy, color, 1.0f );
+                        Blend( bVertical ? sx + 1 : sx + i, bVertical ? sy + i : sy + 1, color, 0.4f );
+                    }
+                }
+            }
+        }
+
+        /** @brief round icon with a radial color ramp */
+        void Icon( int cx, int cy, int nRadius )
+        {
+            for ( int y = cy - nRadius - 1; y <= cy + nRadius + 1; ++y )
+            {
+                for ( int x = cx - nRadius - 1; x <= cx + nRadius + 1; ++x )
+                {
+                    const float d = sqrtf( float( ( x - cx ) * ( x - cx ) + ( y - cy ) * ( y - cy ) ) );
+                    const float t = d / nRadius;
+                    const uint8 color[4] = { uint8( 40 + 200 * t ), uint8( 220 - 150 * t ), uint8( 90 + 60 * t ), 255 };
+                    Blend( x, y, color, nRadius + 0.5f - d );
+                }
+            }
+        }
+    };
+
+    /** @brief expand a 5:6:5 color to 8 bits per channel */
+    void Unpack565( uint16 nColor, int color[3] )
+    {
+        const int r = ( nColor >> 11 ) & 31;
+        const int g = ( nColor >> 5 ) & 63;
+        const int b = nColor & 31;
+        color[0] = ( r << 3 ) | ( r >> 2 );
+        color[1] = ( g << 2 ) | ( g >> 4 );
+        color[2] = ( b << 3 ) | ( b >> 2 );
+    }
+
+    /** @brief BC3 block decoder following the Direct3D block layout */
+    void DecodeBC3Block( const uint8* pBlock, uint8 pixels[16][4] )
+    {
+        const int a0 = pBlock[0];
+        const int a1 = pBlock[1];
+        int alpha[8] = { a0, a1 };
+
+        for ( int i = 1; i < ( a0 > a1 ? 7 : 5 ); ++i )
+        {
+            alpha[i + 1] = a0 > a1 ? ( ( 7 - i ) * a0 + i * a1 ) / 7 : ( ( 5 - i ) * a0 + i * a1 ) / 5;
+        }
+
+        if ( a0 <= a1 )
+        {
+            alpha[6] = 0;
+            alpha[7] = 255;
+        }
+
+        uint64 nAlphaBits = 0;
+
+        for ( int i = 0; i < 6; ++i )
+        {
+            nAlphaBits |= uint64( pBlock[2 + i] ) << ( i * 8 );
+        }
+
+        int colors[4][3];
+        Unpack565( uint16( pBlock[8] | ( pBlock[9] << 8 ) ), colors[0] );
+        Unpack565( uint16( pBlock[10] | ( pBlock[11] << 8 ) ), colors[1] );
+
+        for ( int c = 0; c < 3; ++c )
+        {
+            colors[2][c] = ( 2 * colors[0][c] + colors[1][c] ) / 3;
+            colors[3][c] = ( colors[0][c] + 2 * colors[1][c] ) / 3;
+        }
+
+        const uint32 nColorBits = pBlock[12] | ( pBlock[13] << 8 ) | ( pBlock[14] << 16 ) | ( uint32( pBlock[15] ) << 24 );
+
+        for ( int i = 0; i < 16; ++i )
+        {
+            const int* pColor = colors[( nColorBits >> ( i * 2 ) ) & 3];
+            pixels[i][0] = uint8( pColor[0] );
+            pixels[i][1] = uint8( pColor[1] );
+            pixels[i][2] = uint8( pColor[2] );
+            pixels[i][3] = uint8( alpha[( nAlphaBits >> ( i * 3 ) ) & 7] );
+        }
+    }
+
+    /** @return PSNR in dB of a squared error sum over nSamples */
+    double GetPSNR( double fSquaredError, double fSamples )
+    {
+        return fSquaredError > 0.0 ? 10.0 * log10( 255.0 * 255.0 * fSamples / fSquaredError ) : 99.0;
+    }
+
+    void BenchImage( const char* sName, const SImage& image )
+    {
+        std::vector<uint8> encoded( GetBC3Size( eWidth, eHeight ) );
+        std::vector<double> times;
+
+        for ( int r = 0; r < eRounds; ++r )
+        {
+            const double fStart = GetSeconds();
+            EncodeBC3( &image.pixels[0], eWidth, eHeight, eWidth * 4, &encoded[0] );
+            times.push_back( GetSeconds() - fStart );
+        }
+
+        KeepValue( encoded[encoded.size() / 2] );
+
+        // color error only counts where something is visible, the shaders multiply it with the alpha
+        double fColorError = 0.0, fColorSamples = 0.0;
+        double fAlphaError = 0.0;
+        int nVisible = 0;
+
+        for ( int by = 0; by < eHeight / 4; ++by )
+        {
+            for ( int bx = 0; bx < eWidth / 4; ++bx )
+            {
+                uint8 decoded[16][4];
+                DecodeBC3Block( &encoded[( size_t( by ) * ( eWidth / 4 ) + bx ) * eBC3BlockBytes], decoded );
+
+                for ( int i = 0; i < 16; ++i )
+                {
+                    const uint8* pSource = &image.pixels[( size_t( by * 4 + i / 4 ) * eWidth + bx * 4 + i % 4 ) * 4];
+                    const double fAlpha = double( decoded[i][3] ) - pSource[3];
+                    fAlphaError += fAlpha * fAlpha;
+
+                    if ( pSource[3] == 0 )
+                    {
+                        continue;
+                    }
+
+                    ++nVisible;
+
+                    for ( int c = 0; c < 3; ++c )
+                    {
+                        const double fDiff = double( decoded[i][c] ) - pSource[c];
+                        fColorError += fDiff * fDiff;
+                    }
+
+                    fColorSamples += 3.0;
+                }
+            }
+        }
+
+        const double fMedian = GetPercentile( times, 50 );
+        const double fBytes = double( eWidth ) * eHeight * 4;
+
+        printf( "%-5s %4.1f%% visible: %6.2f ms/frame (p90 %6.2f ms) %7.1f MB/s   PSNR color %5.2f dB alpha %5.2f dB\n", sName,
+                100.0 * nVisible / ( double( eWidth ) * eHeight ), fMedian * 1e3, GetPercentile( times, 90 ) * 1e3, fBytes / fMedian / 1e6,
+                GetPSNR( fColorError, fColorSamples ), GetPSNR( fAlphaError, double( eWidth ) * eHeight ) );
+    }
+}
+
+int main()
+{
+    SRandom random( 5 );
+
+    // HUD: transparent frame with a health bar, a minimap, a few icons and labels
+    SImage hud;
+    {
+        const uint8 barTop[4] = { 40, 200, 60, 230 }, barBottom[4] = { 20, 120, 30, 230 };
+        const uint8 mapTop[4] = { 30, 40, 50, 180 }, mapBottom[4] = { 10, 15, 20, 200 };
+        const uint8 white[4] = { 255, 255, 255, 255 };
+
+        hud.Panel( 40, 980, 520, 1020, 8.0f, barTop, barBottom );
+        hud.Panel( 1600, 40, 1880, 320, 24.0f, mapTop, mapBottom );
+
+        for ( int i = 0; i < 6; ++i )
+        {
+            hud.Icon( 600 + i * 70, 1000, 24 );
+            hud.Text( 40, 60 + i * 34, 30, 22, white, random );
+        }
+    }
+
+    // menu: opaque backdrop, translucent panels, buttons with labels and a list of icons
+    SImage menu;
+    {
+        const uint8 backTop[4] = { 20, 30, 60, 255 }, backBottom[4] = { 60, 20, 40, 255 };
+        const uint8 panelTop[4] = { 230, 230, 240, 200 }, panelBottom[4] = { 180, 180, 200, 220 };
+        const uint8 buttonTop[4] = { 250, 160, 40, 255 }, buttonBottom[4] = { 200, 90, 20, 255 };
+        const uint8 dark[4] = { 20, 20, 30, 255 }, white[4] = { 255, 255, 255, 255 };
+
+        menu.Panel( 0, 0, eWidth, eHeight, 0.0f, backTop, backBottom );
+        menu.Panel( 160, 120, 1000, 960, 16.0f, panelTop, panelBottom );
+        menu.Panel( 1080, 120, 1760, 960, 16.0f, panelTop, panelBottom );
+
+        for ( int i = 0; i < 8; ++i )
+        {
+            menu.Panel( 220, 180 + i * 95, 940, 250 + i * 95, 12.0f, buttonTop, buttonBottom );
+            menu.Text( 250, 200 + i * 95, 36, 28, white, random );
+            menu.Icon( 1140, 190 + i * 95, 30 );
+            menu.Text( 1200, 175 + i * 95, 40, 18, dark, random );
+            menu.Text( 1200, 205 + i * 95, 44, 14, dark, random );
+        }
+    }
+
+    BenchImage( "hud", hud );
+    BenchImage( "menu", menu );
+    return 0;
+}
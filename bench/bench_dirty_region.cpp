@@ -0,0 +1,184 @@
+/* CryHTML5 - for licensing and copyright see license.txt */
+
+// Replays rect lists of typical UI paints and compares the bytes uploaded by the old bounding box with the disjoint rect region.
+// Usage: bench_dirty_region [trace.txt], a trace has one paint per line as "x y x2 y2 x y x2 y2 ..." (surface 1920x1080).
+
+#include "StdAfx.h"
+#include "DirtyRegion.h"
+#include "BenchUtil.h"
+
+#include <fstream>
+#include <sstream>
+#include <string>
+
+using namespace HTML5Plugin;
+using namespace HTML5Bench;
+
+namespace
+{
+    enum
+    {
+        eWidth = 1920,
+        eHeight = 1080,
+        ePaints = 2000,
+    };
+
+    typedef std::vector<SDirtyRect> TPaint;
+    typedef std::vector<TPaint> TTrace;
+
+    /** @brief blinking text cursor in one corner, loading spinner in the other */
+    TTrace MakeCursorSpinner()
+    {
+        TTrace trace;
+
+        for ( int i = 0; i < ePaints; ++i )
+        {
+            TPaint paint;
+            paint.push_back( SDirtyRect( 1850, 1010, 1882, 1042 ) );
+
+            if ( i % 30 == 0 )
+            {
+                paint.push_back( SDirtyRect( 40, 40, 42, 60 ) );
+            }
+
+            trace.push_back( paint );
+        }
+
+        return trace;
+    }
+
+    /** @brief HUD with a dozen widgets, a few of them repaint every frame */
+    TTrace MakeHUD()
+    {
+        static const SDirtyRect widgets[] =
+        {
+            SDirtyRect( 20, 20, 320, 60 ), SDirtyRect( 20, 70, 320, 110 ), SDirtyRect( 1600, 20, 1900, 320 ),
+            SDirtyRect( 1700, 960, 1900, 1060 ), SDirtyRect( 20, 960, 260, 1060 ), SDirtyRect( 900, 20, 1020, 60 ),
+            SDirtyRect( 940, 520, 980, 560 ), SDirtyRect( 600, 980, 1320, 1000 ), SDirtyRect( 20, 400, 300, 700 ),
+            SDirtyRect( 1500, 400, 1900, 440 ), SDirtyRect( 1500, 450, 1900, 490 ), SDirtyRect( 1500, 500, 1900, 540 ),
+        };
+        const int nWidgets = int( sizeof( widgets ) / sizeof( widgets[0] ) );
+
+        TTrace trace;
+        uint32 nState = 7;
+
+        for ( int i = 0; i < ePaints; ++i )
+        {
+            TPaint paint;
+
+            for ( int w = 0; w < nWidgets; ++w )
+            {
+                nState = nState * 1664525u + 1013904223u;
+
+                if ( ( nState >> 24 ) < 64 )
+                {
+                    paint.push_back( widgets[w] );
+                }
+            }
+
+            trace.push_back( paint );
+        }
+
+        return trace;
+    }
+
+    /** @brief scrolling list panel with its scroll bar and a moving tooltip */
+    TTrace MakeScrollTooltip()
+    {
+        TTrace trace;
+
+        for ( int i = 0; i < ePaints; ++i )
+        {
+            TPaint paint;
+            paint.push_back( SDirtyRect( 100, 100, 500, 900 ) );
+            paint.push_back( SDirtyRect( 502, 100 + ( i * 7 ) % 700, 512, 200 + ( i * 7 ) % 700 ) );
+
+            const int x = 600 + ( i * 13 ) % 1000;
+            const int y = 200 + ( i * 5 ) % 600;
+            paint.push_back( SDirtyRect( x, y, x + 220, y + 60 ) );
+            trace.push_back( paint );
+        }
+
+        return trace;
+    }
+
+    /** @brief read a recorded trace */
+    bool LoadTrace( const char* sFile, TTrace& trace )
+    {
+        std::ifstream file( sFile );
+        std::string sLine;
+
+        while ( std::getline( file, sLine ) )
+        {
+            std::istringstream line( sLine );
+            TPaint paint;
+            SDirtyRect rect;
+
+            while ( line >> rect.x >> rect.y >> rect.x2 >> rect.y2 )
+            {
+                paint.push_back( rect );
+            }
+
+            trace.push_back( paint );
+        }
+
+        return !trace.empty();
+    }
+
+    void Replay( const char* sName, const TTrace& trace )
+    {
+        uint64 nBoundsBytes = 0;
+        uint64 nRegionBytes = 0;
+        uint64 nCalls = 0;
+
+        const double fStart = GetSeconds();
+
+        for ( size_t i = 0; i < trace.size(); ++i )
+        {
+            SDirtyRect bounds;
+            CDirtyRegion region;
+
+            for ( size_t r = 0; r < trace[i].size(); ++r )
+            {
+                bounds.Merge( trace[i][r] );
+                region.Add( trace[i][r] );
+            }
+
+            bounds.Clip( eWidth, eHeight );
+            region.Clip( eWidth, eHeight );
+
+            nBoundsBytes += uint64( bounds.GetArea() ) * 4;
+            nRegionBytes += uint64( region.GetArea() ) * 4;
+            nCalls += region.GetCount();
+        }
+
+        const double fSeconds = GetSeconds() - fStart;
+        const double fPaints = double( max( trace.size(), size_t( 1 ) ) );
+
+        printf( "%-16s paints %6u  bounding box %8.1f KB/paint  region %8.1f KB/paint (%5.1f%%)  %.2f calls/paint  %.0f ns/paint\n",
+                sName, uint32( trace.size() ), nBoundsBytes / fPaints / 1024.0, nRegionBytes / fPaints / 1024.0,
+                nBoundsBytes ? 100.0 * nRegionBytes / nBoundsBytes : 100.0, nCalls / fPaints, fSeconds * 1e9 / fPaints );
+    }
+}
+
+int main( int argc, char** argv )
+{
+    if ( argc > 1 )
+    {
+        TTrace trace;
+
+        if ( !LoadTrace( argv[1], trace ) )
+        {
+            printf( "can't read %s\n", argv[1] );
+            return 1;
+        }
+
+        Replay( argv[1], trace );
+        return 0;
+    }
+
+    Replay( "cursor_spinner", MakeCursorSpinner() );
+    Replay( "hud", MakeHUD() );
+    Replay( "scroll_tooltip", MakeScrollTooltip() );
+    return 0;
+}
@@ -0,0 +1,226 @@
+/* CryHTML5 - for licensing and copyright see license.txt */
+
+// Input events per second through the lock-free ring against a mutex guarded deque, with and without allocating every event like the old queue did.
+
+#include "StdAfx.h"
+#include "InputRing.h"
+#include "BenchUtil.h"
+
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+using namespace HTML5Plugin;
+using namespace HTML5Bench;
+
+namespace
+{
+    enum
+    {
+        eCapacity = 1024,
+        eEvents = 500000, //!< events per producer
+        eMaxProducers = 4,
+    };
+
+    /** @brief the size of a mouse or key event */
+    struct SEvent
+    {
+        int nType;
+        int nX;
+        int nY;
+        uint32 nModifiers;
+
+        SEvent()
+            : nType( 0 )
+            , nX( 0 )
+            , nY( 0 )
+            , nModifiers( 0 )
+        {
+        }
+
+        SEvent( int type, int x )
+            : nType( type )
+            , nX( x )
+            , nY( 0 )
+            , nModifiers( 0 )
+        {
+        }
+    };
+
+    /** @brief the ring as used by the input handler, a dropped event is retried */
+    struct SRingQueue
+    {
+        CInputRing<SEvent, eCapacity> ring;
+
+        void Push( const SEvent& event )
+        {
+            while ( !ring.Push( event ) )
+            {
+                std::this_thread::yield();
+            }
+        }
+
+        bool Pop( SEvent& event )
+        {
+            return ring.Pop( event );
+        }
+    };
+
+    /** @brief events by value in a deque behind a mutex */
+    struct SLockedQueue
+    {
+        std::mutex lock;
+        std::deque<SEvent> events;
+
+        void Push( const SEvent& event )
+        {
+            std::lock_guard<std::mutex> guard( lock );
+            events.push_back( event );
+        }
+
+        bool Pop( SEvent& event )
+        {
+            std::lock_guard<std::mutex> guard( lock );
+
+            if ( events.empty() )
+            {
+                return false;
+            }
+
+            event = events.front();
+            events.pop_front();
+            return true;
+        }
+    };
+
+    /** @brief the old queue made thread safe: every event is allocated and queued by pointer */
+    struct SAllocatingQueue
+    {
+        std::mutex lock;
+        std::deque<SEvent*> events;
+
+        void Push( const SEvent& event )
+        {
+            SEvent* pEvent = new SEvent( event );
+            std::lock_guard<std::mutex> guard( lock );
+            events.push_back( pEvent );
+        }
+
+        bool Pop( SEvent& event )
+        {
+            SEvent* pEvent = NULL;
+            {
+                std::lock_guard<std::mutex> guard( lock );
+
+                if ( events.empty() )
+                {
+                    return false;
+                }
+
+                pEvent = events.front();
+                events.pop_front();
+            }
+
+            event = *pEvent;
+            delete pEvent;
+            return true;
+        }
+    };
+
+    /** @return events per second moved from nProducers threads to the consumer */
+    template<class TQueue>
+    double BenchQueue( int nProducers )
+    {
+        // the ring is too large for the stack
+        std::unique_ptr<TQueue> pQueue( new TQueue() );
+        std::vector<std::thread> producers;
+        const double fStart = GetSeconds();
+
+        for ( int p = 0; p < nProducers; ++p )
+        {
+            producers.push_back( std::thread( [&, p]()
+            {
+                for ( int i = 0; i < eEvents; ++i )
+                {
+                    pQueue->Push( SEvent( p, i ) );
+                }
+            } ) );
+        }
+
+        // the consumer drains like the main thread does, yielding when it finds nothing
+        const int nTotal = nProducers * eEvents;
+        int nReceived = 0;
+        int nSum = 0;
+        SEvent event;
+
+        while ( nReceived < nTotal )
+        {
+            if ( pQueue->Pop( event ) )
+            {
+                nSum += event.nX;
+                ++nReceived;
+            }
+
+            else
+            {
+                std::this_thread::yield();
+            }
+        }
+
+        for ( size_t p = 0; p < producers.size(); ++p )
+        {
+            producers[p].join();
+        }
+
+        const double fSeconds = GetSeconds() - fStart;
+        KeepValue( nSum );
+        return nTotal / fSeconds;
+    }
+
+    /** @return events per second pushed and popped on one thread, the queue never holds more than a batch */
+    template<class TQueue>
+    double BenchSingleThread()
+    {
+        std::unique_ptr<TQueue> pQueue( new TQueue() );
+        SEvent event;
+        int nSum = 0;
+        const double fStart = GetSeconds();
+
+        for ( int i = 0; i < eEvents; i += 16 )
+        {
+            for ( int n = 0; n < 16; ++n )
+            {
+                pQueue->Push( SEvent( 0, i + n ) );
+            }
+
+            while ( pQueue->Pop( event ) )
+            {
+                nSum += event.nX;
+            }
+        }
+
+        const double fSeconds = GetSeconds() - fStart;
+        KeepValue( nSum );
+        return eEvents / fSeconds;
+    }
+}
+
+int main()
+{
+    printf( "%u hardware threads, %d events per producer\n", std::thread::hardware_concurrency(), int( eEvents ) );
+    printf( "single thread: ring %6.1f M/s  mutex deque %6.1f M/s  mutex deque allocating %6.1f M/s\n", BenchSingleThread<SRingQueue>() / 1e6,
+            BenchSingleThread<SLockedQueue>() / 1e6, BenchSingleThread<SAllocatingQueue>() / 1e6 );
+
+    for ( int nProducers = 1; nProducers <= eMaxProducers; ++nProducers )
+    {
+        const double fRing = BenchQueue<SRingQueue>( nProducers );
+        const double fLocked = BenchQueue<SLockedQueue>( nProducers );
+        const double fAllocating = BenchQueue<SAllocatingQueue>( nProducers );
+
+        printf( "%d producers:   ring %6.1f M/s  mutex deque %6.1f M/s  mutex deque allocating %6.1f M/s  (%.1fx, %.1fx)\n", nProducers,
+                fRing / 1e6, fLocked / 1e6, fAllocating / 1e6, fRing / fLocked, fRing / fAllocating );
+    }
+
+    return 0;
+}
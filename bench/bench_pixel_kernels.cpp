@@ -0,0 +1,113 @@
+/* CryHTML5 - for licensing and copyright see license.txt */
+
+// Throughput of the pixel kernels per instruction set level on the rows of a 1920x1080 frame, warm in cache and cold.
+
+#include "StdAfx.h"
+#include "PixelKernels.h"
+#include "BenchUtil.h"
+
+using namespace HTML5Plugin;
+using namespace HTML5Bench;
+
+namespace
+{
+    enum
+    {
+        eWidth = 1920,
+        eHeight = 1080,
+        eRounds = 50,
+    };
+
+    const char* GetLevelName( EPixelKernelLevel level )
+    {
+        static const char* names[] = { "scalar", "sse2", "avx2" };
+        return names[level];
+    }
+
+    /** @return GB/s copying nRows rows of the frame, rows are offset by one pixel so the loads are unaligned */
+    double BenchCopyRow( const SPixelKernels& kernels, std::vector<uint8>& dest, const std::vector<uint8>& source, int nRows )
+    {
+        const size_t nRowBytes = eWidth * 4;
+        const double fStart = GetSeconds();
+
+        for ( int r = 0; r < eRounds; ++r )
+        {
+            for ( int y = 0; y < nRows; ++y )
+            {
+                kernels.CopyRow( &dest[y * nRowBytes + 4], &source[y * nRowBytes], nRowBytes - 4 );
+            }
+        }
+
+        KeepValue( dest[nRowBytes] );
+        return double( nRowBytes ) * nRows * eRounds / ( GetSeconds() - fStart ) / 1e9;
+    }
+
+    typedef void ( *TPixelOp )( uint8* pDest, const uint8* pSrc, size_t nPixels );
+
+    /** @return GB/s running a per pixel kernel over nRows rows */
+    double BenchPixelOp( TPixelOp op, std::vector<uint8>& dest, const std::vector<uint8>& source, int nRows )
+    {
+        const size_t nRowBytes = eWidth * 4;
+        const double fStart = GetSeconds();
+
+        for ( int r = 0; r < eRounds; ++r )
+        {
+            for ( int y = 0; y < nRows; ++y )
+            {
+                op( &dest[y * nRowBytes], &source[y * nRowBytes], eWidth );
+            }
+        }
+
+        KeepValue( dest[nRowBytes] );
+        return double( nRowBytes ) * nRows * eRounds / ( GetSeconds() - fStart ) / 1e9;
+    }
+
+    /** @return GB/s scanning the alpha of nRows rows */
+    double BenchAlphaRange( const SPixelKernels& kernels, const std::vector<uint8>& source, int nRows )
+    {
+        const size_t nRowBytes = eWidth * 4;
+        uint32 nSum = 0;
+        const double fStart = GetSeconds();
+
+        for ( int r = 0; r < eRounds; ++r )
+        {
+            for ( int y = 0; y < nRows; ++y )
+            {
+                uint8 nMin, nMax;
+                kernels.AlphaRange( &source[y * nRowBytes], eWidth, nMin, nMax );
+                nSum += nMin + nMax;
+            }
+        }
+
+        KeepValue( nSum );
+        return double( nRowBytes ) * nRows * eRounds / ( GetSeconds() - fStart ) / 1e9;
+    }
+}
+
+int main()
+{
+    std::vector<uint8> source( size_t( eWidth ) * eHeight * 4 + 64 );
+    std::vector<uint8> dest( source.size() );
+
+    for ( size_t i = 0; i < source.size(); ++i )
+    {
+        source[i] = uint8( i * 2654435761u >> 13 );
+    }
+
+    const EPixelKernelLevel best = DetectPixelKernelLevel();
+
+    for ( int n = ePKL_Scalar; n <= best; ++n )
+    {
+        const SPixelKernels& kernels = GetPixelKernels( EPixelKernelLevel( n ) );
+
+        // 32 rows fit the cache, the full frame does not
+        printf( "%-6s copy %6.2f GB/s warm %6.2f GB/s frame   alpha range %6.2f GB/s warm %6.2f GB/s frame\n", GetLevelName( kernels.level ),
+                BenchCopyRow( kernels, dest, source, 32 ), BenchCopyRow( kernels, dest, source, eHeight ),
+                BenchAlphaRange( kernels, source, 32 ), BenchAlphaRange( kernels, source, eHeight ) );
+        printf( "%-6s swizzle %6.2f GB/s warm %6.2f GB/s frame   premultiply %6.2f GB/s warm %6.2f GB/s frame\n", GetLevelName( kernels.level ),
+                BenchPixelOp( kernels.Swizzle, dest, source, 32 ), BenchPixelOp( kernels.Swizzle, dest, source, eHeight ),
+                BenchPixelOp( kernels.Premultiply, dest, source, 32 ), BenchPixelOp( kernels.Premultiply, dest, source, eHeight ) );
+    }
+
+    return 0;
+}
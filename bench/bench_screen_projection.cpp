@@ -0,0 +1,126 @@
+/* CryHTML5 - for licensing and copyright see license.txt */
+
+// World to screen projection of HUD markers: one call per position like WorldPosToScreenPos against the scalar and SSE batch paths.
+
+#include "StdAfx.h"
+#include "ScreenProjection.h"
+#include "BenchUtil.h"
+
+using namespace HTML5Plugin;
+using namespace HTML5Bench;
+
+namespace
+{
+    enum
+    {
+        ePositionsPerRound = 1 << 20, //!< positions projected per measurement, whatever the batch size
+    };
+
+    /** @brief positions and results of a batch */
+    struct SBatchData
+    {
+        std::vector<float> x, y, z, ox, oy, oz, sx, sy, depth;
+
+        explicit SBatchData( size_t nCount )
+            : x( nCount ), y( nCount ), z( nCount ), ox( nCount ), oy( nCount ), oz( nCount ), sx( nCount ), sy( nCount ), depth( nCount )
+        {
+        }
+
+        /** @return the batch of positions n to n + nCount */
+        SWorldPosBatch GetBatch( size_t n, size_t nCount )
+        {
+            SWorldPosBatch batch;
+            batch.pWorldX = &x[n];
+            batch.pWorldY = &y[n];
+            batch.pWorldZ = &z[n];
+            batch.pOffsetX = &ox[n];
+            batch.pOffsetY = &oy[n];
+            batch.pOffsetZ = &oz[n];
+            batch.pScreenX = &sx[n];
+            batch.pScreenY = &sy[n];
+            batch.pDepth = &depth[n];
+            batch.nCount = uint32( nCount );
+            return batch;
+        }
+    };
+
+    enum EPath
+    {
+        eP_PerPoint = 0, //!< a call per position
+        eP_Scalar, //!< ProjectScalar on the batch
+        eP_Batch, //!< Project on the batch
+    };
+
+    /** @return nanoseconds per position */
+    double BenchPath( const CScreenProjection& projection, SBatchData& data, EPath path )
+    {
+        const size_t nCount = data.x.size();
+        const size_t nRounds = max( size_t( ePositionsPerRound ) / nCount, size_t( 1 ) );
+        const double fStart = GetSeconds();
+
+        for ( size_t r = 0; r < nRounds; ++r )
+        {
+            if ( path == eP_PerPoint )
+            {
+                for ( size_t i = 0; i < nCount; ++i )
+                {
+                    projection.Project( data.GetBatch( i, 1 ) );
+                }
+            }
+
+            else if ( path == eP_Scalar )
+            {
+                projection.ProjectScalar( data.GetBatch( 0, nCount ) );
+            }
+
+            else
+            {
+                projection.Project( data.GetBatch( 0, nCount ) );
+            }
+        }
+
+        KeepValue( data.sx[nCount - 1] );
+        return ( GetSeconds() - fStart ) * 1e9 / double( nRounds * nCount );
+    }
+}
+
+int main()
+{
+    // a tilted camera away from the origin, markers spread around it with small offsets
+    CScreenProjection projection;
+    const float pos[3] = { 12.0f, -30.0f, 8.0f };
+    const float c = cosf( 0.3f ), s = sinf( 0.3f );
+    const float right[3] = { c, -s, 0.0f };
+    const float forward[3] = { s, c, 0.0f };
+    const float up[3] = { 0.0f, 0.0f, 1.0f };
+    projection.SetView( pos, right, forward, up, 1.1f, 16.0f / 9.0f, 1920, 1080 );
+    projection.SetScreenTransform( 0.75f, 0.0f, 0.75f, 0.0f );
+
+    const size_t counts[] = { 16, 256, 4096, 65536 };
+
+    for ( size_t n = 0; n < sizeof( counts ) / sizeof( counts[0] ); ++n )
+    {
+        SBatchData data( counts[n] );
+        uint32 nState = 17;
+
+        for ( size_t i = 0; i < counts[n]; ++i )
+        {
+            nState = nState * 1664525u + 1013904223u;
+            data.x[i] = float( nState >> 20 ) * 0.05f - 100.0f;
+            nState = nState * 1664525u + 1013904223u;
+            data.y[i] = float( nState >> 20 ) * 0.05f - 50.0f;
+            nState = nState * 1664525u + 1013904223u;
+            data.z[i] = float( nState >> 24 ) * 0.1f;
+            data.oz[i] = 2.0f;
+        }
+
+        const double fPerPoint = BenchPath( projection, data, eP_PerPoint );
+        const double fScalar = BenchPath( projection, data, eP_Scalar );
+        const double fBatch = BenchPath( projection, data, eP_Batch );
+
+        printf( "%6u positions: per point %6.2f ns  scalar batch %6.2f ns  sse batch %6.2f ns  (%.1fx per point, %.1fx scalar batch)\n", uint32( counts[n] ),
+                fPerPoint, fScalar, fBatch, fPerPoint / fBatch, fScalar / fBatch );
+    }
+
+    return 0;
+}
@@ -0,0 +1,207 @@
+/* CryHTML5 - for licensing and copyright see license.txt */
+
+// Feeds CSurfacePipeline with synthetic paints through a headless ISurfaceDevice (rect copies into CPU memory instead of a texture).
+// Reports frame throughput, bytes uploaded and p50/p99 of the paint to upload time (drawing the synthetic paint isn't counted), untiled and tiled.
+
+#include "StdAfx.h"
+#include "SurfacePipeline.h"
+#include "BenchUtil.h"
+
+#include <functional>
+
+using namespace HTML5Plugin;
+using namespace HTML5Bench;
+
+namespace
+{
+    enum
+    {
+        eWidth = 1920,
+        eHeight = 1080,
+        eFrames = 600,
+    };
+
+    /** @brief surface in CPU memory, an upload copies the rects like UpdateSubresource would */
+    class CHeadlessDevice : public ISurfaceDevice
+    {
+        public:
+            CHeadlessDevice()
+                : m_nWidth( 0 )
+                , m_nUploads( 0 )
+                , m_nBytes( 0 )
+            {
+            }
+
+            virtual bool CreateSurface( int nWidth, int nHeight ) override
+            {
+                m_nWidth = nWidth;
+                m_surface.assign( size_t( nWidth ) * nHeight * 4, 0 );
+                return true;
+            }
+
+            virtual bool OpenSharedSurface( void* /*hShared*/, int /*nWidth*/, int /*nHeight*/ ) override
+            {
+                return false;
+            }
+
+            virtual void ReleaseSurface() override
+            {
+                m_surface.clear();
+            }
+
+            virtual bool HasSurface() const override
+            {
+                return !m_surface.empty();
+            }
+
+            virtual void Upload( const uint8* pSource, int nPitch, const SDirtyRect* pRects, int nRects ) override
+            {
+                for ( int i = 0; i < nRects; ++i )
+                {
+                    const SDirtyRect& rect = pRects[i];
+                    const size_t nRowBytes = size_t( rect.x2 - rect.x ) * 4;
+
+                    for ( int y = rect.y; y < rect.y2; ++y )
+                    {
+                        memcpy( &m_surface[( size_t( y ) * m_nWidth + rect.x ) * 4], pSource + y * nPitch + rect.x * 4, nRowBytes );
+                    }
+
+                    m_nBytes += nRowBytes * ( rect.y2 - rect.y );
+                }
+
+                ++m_nUploads;
+            }
+
+            uint64 GetBytes() const
+            {
+                return m_nBytes;
+            }
+
+            uint32 GetUploads() const
+            {
+                return m_nUploads;
+            }
+
+        private:
+            int m_nWidth;
+            std::vector<uint8> m_surface;
+            uint32 m_nUploads;
+            uint64 m_nBytes;
+    };
+
+    /** @brief draws paint nFrame into the frame and reports what CEF would report as dirty */
+    typedef std::function<void( int nFrame, std::vector<uint8>& frame, CDirtyRegion& dirty )> TWorkload;
+
+    void FillRect( std::vector<uint8>& frame, const SDirtyRect& rect, uint32 nColor )
+    {
+        for ( int y = rect.y; y < rect.y2; ++y )
+        {
+            uint32* pRow = reinterpret_cast<uint32*>( &frame[( size_t( y ) * eWidth + rect.x ) * 4] );
+            std::fill( pRow, pRow + ( rect.x2 - rect.x ), nColor );
+        }
+    }
+
+    /** @brief blinking text cursor, nothing else changes */
+    void PaintCursor( int nFrame, std::vector<uint8>& frame, CDirtyRegion& dirty )
+    {
+        const SDirtyRect rect( 800, 500, 802, 520 );
+        FillRect( frame, rect, ( nFrame / 30 ) & 1 ? 0xFF000000 : 0xFFFFFFFF );
+        dirty.Add( rect );
+    }
+
+    /** @brief HUD where a few widgets repaint every frame, some with the same content */
+    void PaintHUD( int nFrame, std::vector<uint8>& frame, CDirtyRegion& dirty )
+    {
+        static const SDirtyRect widgets[] =
+        {
+            SDirtyRect( 20, 20, 320, 60 ), SDirtyRect( 1600, 20, 1900, 320 ), SDirtyRect( 1700, 960, 1900, 1060 ),
+            SDirtyRect( 900, 20, 1020, 60 ), SDirtyRect( 600, 980, 1320, 1000 ), SDirtyRect( 1500, 400, 1900, 440 ),
+        };
+
+        for ( int w = 0; w < 6; ++w )
+        {
+            if ( ( nFrame + w ) % 3 == 0 )
+            {
+                // only every other repaint really changes the widget
+                FillRect( frame, widgets[w], 0xC0000000 | uint32( ( nFrame / 6 + w ) * 0x10203 ) );
+                dirty.Add( widgets[w] );
+            }
+        }
+    }
+
+    /** @brief list panel scrolling by a few pixels per frame, its content moves so every pixel changes */
+    void PaintScroll( int nFrame, std::vector<uint8>& frame, CDirtyRegion& dirty )
+    {
+        const SDirtyRect panel( 100, 100, 600, 1000 );
+
+        for ( int y = panel.y; y < panel.y2; ++y )
+        {
+            const uint32 nColor = ( ( y + nFrame * 3 ) / 24 ) & 1 ? 0xFF202020 : 0xFF404040;
+            FillRect( frame, SDirtyRect( panel.x, y, panel.x2, y + 1 ), nColor );
+        }
+
+        dirty.Add( panel );
+    }
+
+    /** @brief page that reports a full repaint every frame while only a spinner changes (e.g. a CSS animation) */
+    void PaintFullRepaint( int nFrame, std::vector<uint8>& frame, CDirtyRegion& dirty )
+    {
+        const SDirtyRect spinner( 940, 520, 980, 560 );
+        FillRect( frame, spinner, 0xFF000000 | uint32( nFrame * 0x50A0F ) );
+        dirty.Add( SDirtyRect( 0, 0, eWidth, eHeight ) );
+    }
+
+    void Run( const char* sName, const TWorkload& workload, int nTileSize )
+    {
+        std::vector<uint8> frame( size_t( eWidth ) * eHeight * 4, 0 );
+        FillRect( frame, SDirtyRect( 0, 0, eWidth, eHeight ), 0x80102030 );
+
+        CSurfacePipeline pipeline( eWidth, eHeight );
+        CHeadlessDevice device;
+
+        // the first paint and present create the surface
+        CDirtyRegion all;
+        all.Add( SDirtyRect( 0, 0, eWidth, eHeight ) );
+        pipeline.Paint( &frame[0], eWidth, eHeight, all, nTileSize );
+        pipeline.Present( device, 0.0f, 0.0f );
+
+        const uint64 nStartBytes = device.GetBytes();
+        const uint32 nStartUploads = device.GetUploads();
+        std::vector<double> samples;
+        samples.reserve( eFrames );
+        double fSeconds = 0.0;
+
+        for ( int i = 1; i <= eFrames; ++i )
+        {
+            CDirtyRegion dirty;
+            workload( i, frame, dirty );
+
+            const double fPaint = GetSeconds();
+            pipeline.Paint( &frame[0], eWidth, eHeight, dirty, nTileSize );
+            pipeline.Present( device, float( i ), 0.0f );
+            samples.push_back( GetSeconds() - fPaint );
+            fSeconds += samples.back();
+        }
+
+        const uint64 nBytes = device.GetBytes() - nStartBytes;
+
+        printf( "%-14s tile %3d  %8.0f frames/s  %9.1f KB/frame  %4u uploads  paint->upload p50 %8.1f us  p99 %8.1f us\n", sName, nTileSize,
+                eFrames / fSeconds, nBytes / 1024.0 / eFrames, device.GetUploads() - nStartUploads,
+                GetPercentile( samples, 50 ) * 1e6, GetPercentile( samples, 99 ) * 1e6 );
+    }
+}
+
+int main()
+{
+    static const int tileSizes[] = { 0, 64 };
+
+    for ( int t = 0; t < 2; ++t )
+    {
+        Run( "cursor", PaintCursor, tileSizes[t] );
+        Run( "hud", PaintHUD, tileSizes[t] );
+        Run( "scroll", PaintScroll, tileSizes[t] );
+        Run( "full_repaint", PaintFullRepaint, tileSizes[t] );
+    }
+
+    return 0;
+}
@@ -0,0 +1,76 @@
+/* CryHTML5 - for licensing and copyright see license.txt */
+
+// Hashing throughput of the tile diff on a 1920x1080 frame for a few tile sizes, and the share of tiles a HUD-like repaint really changes.
+
+#include "StdAfx.h"
+#include "TileTracker.h"
+#include "BenchUtil.h"
+
+using namespace HTML5Plugin;
+using namespace HTML5Bench;
+
+namespace
+{
+    enum
+    {
+        eWidth = 1920,
+        eHeight = 1080,
+        eRounds = 100,
+    };
+
+    void BenchTileSize( int nTileSize, std::vector<uint8>& frame )
+    {
+        CTileTracker tracker;
+        tracker.Configure( eWidth, eHeight, nTileSize );
+
+        CDirtyRegion full;
+        full.Add( SDirtyRect( 0, 0, eWidth, eHeight ) );
+
+        CTileMask changed;
+        CDirtyRegion changedRegion;
+        tracker.Diff( &frame[0], full, changed, changedRegion );
+
+        // identical repaints: every tile is hashed, none is reported
+        const double fStart = GetSeconds();
+
+        for ( int i = 0; i < eRounds; ++i )
+        {
+            tracker.Diff( &frame[0], full, changed, changedRegion );
+        }
+
+        const double fSeconds = GetSeconds() - fStart;
+        const double fBytes = double( eWidth ) * eHeight * 4 * eRounds;
+
+        // a repaint that changes one pixel in every 8th row of widgets
+        uint64 nChangedBytes = 0;
+
+        for ( int i = 0; i < eRounds; ++i )
+        {
+            for ( int y = 0; y < eHeight; y += 128 )
+            {
+                frame[( size_t( y ) * eWidth + ( i * 37 ) % eWidth ) * 4] ^= 0xFF;
+            }
+
+            tracker.Diff( &frame[0], full, changed, changedRegion );
+            nChangedBytes += uint64( changedRegion.GetArea() ) * 4;
+        }
+
+        printf( "tile %3d: hash %6.2f GB/s  %6.2f ms/frame  sparse change uploads %5.1f%% of the frame\n", nTileSize, fBytes / fSeconds / 1e9,
+                fSeconds * 1e3 / eRounds, 100.0 * double( nChangedBytes ) / fBytes );
+    }
+}
+
+int main()
+{
+    std::vector<uint8> frame( size_t( eWidth ) * eHeight * 4 );
+
+    for ( size_t i = 0; i < frame.size(); ++i )
+    {
+        frame[i] = uint8( i * 2654435761u >> 13 );
+    }
+
+    BenchTileSize( 32, frame );
+    BenchTileSize( 64, frame );
+    BenchTileSize( 128, frame );
+    return 0;
+}
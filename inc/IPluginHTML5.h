@@ -1,6 +1,7 @@
 /* CryHTML5 - for licensing and copyright see license.txt */
 
 #include <IPluginBase.h>
+#include <WorldPosBatch.h>
 
 #pragma once
 
@@ -9,6 +10,27 @@
 */
 namespace HTML5Plugin
 {
+    /**
+    * @brief summary of an UI instrumentation counter
+    */
+    struct SUIStat
+    {
+        const char* sName; //!< counter name
+        const char* sUnit; //!< unit of the values
+        unsigned int nCount; //!< recorded samples
+        float fMean; //!< average value
+        float fMin; //!< smallest value
+        float fP50; //!< median
+        float fP90; //!< 90th percentile
+        float fP99; //!< 99th percentile
+        float fMax; //!< largest value
+    };
+
+    /**
+    * @brief handle of an offscreen browser view, 0 is never a valid view
+    */
+    typedef unsigned int TViewHandle;
+
     /**
     * @brief HTML5 Plugin concrete interface
     */
@@ -43,6 +65,14 @@ namespace HTML5Plugin
         */
         virtual bool WorldPosToScreenPos( CCamera cam, Vec3 vWorld, Vec3& vScreen, Vec3 vOffset = Vec3( ZERO ) ) = 0;
 
+        /**
+        * @brief project many world positions onto the screen (nameplates, markers), faster than one WorldPosToScreenPos call per position
+        * @param cam the screens camera (onto which the coordinates should be projected)
+        * @param batch positions, offsets and output arrays
+        * @return true if successful
+        */
+        virtual bool WorldPosToScreenPosBatch( const CCamera& cam, const SWorldPosBatch& batch ) = 0;
+
         /**
         * @brief scale the coordinates in screen space
         * @param fX the horizontal position in renderer/relative scale
@@ -83,5 +113,117 @@ namespace HTML5Plugin
         * @return true when position is opaque
         */
         virtual bool IsOpaque( float fX, float fY ) = 0;
+
+        /**
+        * @brief check if any position of a region is opaque on HTML5 surface
+        * @param fX the horizontal start of the region in screen space (in pixels)
+        * @param fY the vertical start of the region in screen space (in pixels)
+        * @param fWidth the region width (in pixels)
+        * @param fHeight the region height (in pixels)
+        * @return true when at least one position of the region is opaque
+        */
+        virtual bool IsRegionOpaque( float fX, float fY, float fWidth, float fHeight ) = 0;
+
+        /**
+        * @brief get the UI instrumentation counters (paint latency, upload, draw and composite timings, dirty areas, input events, draw calls)
+        * @param[out] pStats receives the counters
+        * @param nMaxStats size of pStats
+        * @return number of counters written to pStats
+        */
+        virtual int GetUIStats( SUIStat* pStats, int nMaxStats ) = 0;
+
+        /**
+        * @brief create an additional offscreen browser view
+        * @param sURL the url of the website
+        * @param nWidth fixed surface width in pixels (0 = follow the viewport)
+        * @param nHeight fixed surface height in pixels (0 = follow the viewport)
+        * @return handle of the view, 0 if it couldn't be created
+        */
+        virtual TViewHandle CreateView( const wchar_t* sURL, int nWidth = 0, int nHeight = 0 ) = 0;
+
+        /**
+        * @brief close a view and release its resources
+        * @return false when the handle was invalid
+        */
+        virtual bool DestroyView( TViewHandle hView ) = 0;
+
+        /**
+        * @brief get the view created with the plugin (used by SetURL, ExecuteJS and the coordinate functions)
+        */
+        virtual TViewHandle GetMainView() = 0;
+
+        /**
+        * @brief set the url of a view
+        * @return true if successful
+        */
+        virtual bool SetViewURL( TViewHandle hView, const wchar_t* sURL ) = 0;
+
+        /**
+        * @brief execute java script code in the main frame of a view
+        * @return true if successful
+        */
+        virtual bool ExecuteViewJS( TViewHandle hView, const wchar_t* sJS ) = 0;
+
+        /**
+        * @brief set a fixed surface size of a view
+        * @param nWidth width in pixels (0 = follow the viewport)
+        * @param nHeight height in pixels (0 = follow the viewport)
+        */
+        virtual void SetViewSize( TViewHandle hView, int nWidth, int nHeight ) = 0;
+
+        /**
+        * @brief limit the frame rate of a view
+        * @param fRate maximum frames per second (0 = every game frame, less than 0 = cm5_ui_fps)
+        */
+        virtual void SetViewFrameRate( TViewHandle hView, float fRate ) = 0;
+
+        /**
+        * @brief show or hide a view, hidden views neither paint nor render
+        */
+        virtual void SetViewActive( TViewHandle hView, bool bActive ) = 0;
+
+        /**
+        * @brief set the position of a fixed size view, such views are shown unscaled instead of covering the viewport
+        * @param fX left in screen space (in pixels)
+        * @param fY top in screen space (in pixels)
+        */
+        virtual void SetViewPosition( TViewHandle hView, float fX, float fY ) = 0;
+
+        /**
+        * @brief show a view on a rectangle in the world instead of the screen (terminals, billboards)
+        * @param tm center and orientation, the surface spans the x (right) and z (up) axes
+        * @param fWidth width in meters (0 shows the view on the screen again)
+        * @param fHeight height in meters
+        */
+        virtual void SetViewWorldQuad( TViewHandle hView, const Matrix34& tm, float fWidth, float fHeight ) = 0;
+
+        /**
+        * @brief intersect a ray with the world rectangle of a view
+        * @param vOrigin ray start
+        * @param vDir ray direction
+        * @param[out] fX hit position in view pixels
+        * @param[out] fY
+        * @return true when the ray hits the view
+        */
+        virtual bool RayHitView( TViewHandle hView, const Vec3& vOrigin, const Vec3& vDir, float& fX, float& fY ) = 0;
+
+        /**
+        * @brief set the rects of the focusable elements of a view the virtual cursor snaps to
+        * Pages can push them as well: prompt( "cm5_snap_rects", "x y w h x y w h ..." ).
+        * @param pRects x, y, width and height of each rect in view pixels
+        * @param nRects number of rects (0 removes all)
+        */
+        virtual void SetViewSnapRects( TViewHandle hView, const float* pRects, int nRects ) = 0;
+
+        /**
+        * @brief set the view receiving keyboard and mouse input
+        * @return false when the handle was invalid
+        */
+        virtual bool SetFocusView( TViewHandle hView ) = 0;
+
+        /**
+        * @brief get the view receiving keyboard and mouse input
+        */
+        virtual TViewHandle GetFocusView() = 0;
     };
 };
\ No newline at end of file
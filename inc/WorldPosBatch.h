@@ -0,0 +1,23 @@
+/* CryHTML5 - for licensing and copyright see license.txt */
+
+#pragma once
+
+namespace HTML5Plugin
+{
+    /**
+    * @brief world positions projected in one call, all arrays hold nCount elements (structure of arrays)
+    */
+    struct SWorldPosBatch
+    {
+        const float* pWorldX; //!< world positions
+        const float* pWorldY;
+        const float* pWorldZ;
+        const float* pOffsetX; //!< offsets in world space like WorldPosToScreenPos (all three nullptr for none)
+        const float* pOffsetY;
+        const float* pOffsetZ;
+        float* pScreenX; //!< [out] screen positions
+        float* pScreenY;
+        float* pDepth; //!< [out] distance from the camera, negative for positions behind it
+        unsigned int nCount; //!< number of positions
+    };
+}
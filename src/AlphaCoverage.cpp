@@ -0,0 +1,297 @@
+/* CryHTML5 - for licensing and copyright see license.txt */
+
+#include "StdAfx.h"
+#include "AlphaCoverage.h"
+#include "PixelKernels.h"
+
+namespace HTML5Plugin
+{
+    CAlphaCoverage::CAlphaCoverage()
+        : m_pFront( std::make_shared<SPlane>() )
+    {
+    }
+
+    void CAlphaCoverage::SPlane::Configure( int nNewWidth, int nNewHeight )
+    {
+        nWidth = nNewWidth;
+        nHeight = nNewHeight;
+        alpha.assign( size_t( nWidth ) * nHeight, 0 );
+        levels.clear();
+
+        const int nTileSize = 1 << eTileShift;
+
+        SLevel level;
+        level.nTilesX = ( nWidth + nTileSize - 1 ) / nTileSize;
+        level.nTilesY = ( nHeight + nTileSize - 1 ) / nTileSize;
+
+        for ( ;; )
+        {
+            SRange empty = { 0, 0 };
+            level.ranges.assign( level.nTilesX * level.nTilesY, empty );
+            levels.push_back( level );
+
+            if ( level.nTilesX <= 1 && level.nTilesY <= 1 )
+            {
+                break;
+            }
+
+            level.nTilesX = ( level.nTilesX + 1 ) / 2;
+            level.nTilesY = ( level.nTilesY + 1 ) / 2;
+        }
+    }
+
+    void CAlphaCoverage::Update( const uint8* pSource, int nWidth, int nHeight, const CDirtyRegion& dirty )
+    {
+        if ( !pSource || nWidth <= 0 || nHeight <= 0 )
+        {
+            return;
+        }
+
+        CDirtyRegion changed = dirty;
+        changed.Clip( nWidth, nHeight );
+
+        // the back plane misses this paint and the one before it, pSource is a complete frame so both are taken from it
+        CDirtyRegion region = changed;
+        region.Add( m_backStale );
+
+        // a query may still hold the back plane, or the size changed: start from a copy of the front one
+        const TPlanePtr pFront = GetPlane();
+
+        if ( !m_pBack || m_pBack.use_count() > 1 || m_pBack->nWidth != pFront->nWidth || m_pBack->nHeight != pFront->nHeight )
+        {
+            m_pBack = std::make_shared<SPlane>( *pFront );
+            region = changed;
+        }
+
+        if ( nWidth != m_pBack->nWidth || nHeight != m_pBack->nHeight )
+        {
+            m_pBack->Configure( nWidth, nHeight );
+
+            region.Reset();
+            region.Add( SDirtyRect( 0, 0, nWidth, nHeight ) );
+        }
+
+        for ( int i = 0; i < region.GetCount(); ++i )
+        {
+            m_pBack->Update( pSource, region[i] );
+        }
+
+        // publish, the old front becomes the back plane once its queries are done
+        {
+            std::lock_guard<std::mutex> lock( m_lock );
+            m_pFront = m_pBack;
+        }
+
+        m_pBack = std::const_pointer_cast<SPlane>( pFront );
+        m_backStale = changed;
+    }
+
+    void CAlphaCoverage::SPlane::Update( const uint8* pSource, const SDirtyRect& rect )
+    {
+        const size_t nPitch = size_t( nWidth ) * 4;
+
+        // extract the alpha channel
+        for ( int row = rect.y; row < rect.y2; ++row )
+        {
+            const uint8* pSrc = pSource + row * nPitch + rect.x * 4 + 3;
+            uint8* pDest = &alpha[size_t( row ) * nWidth + rect.x];
+
+            for ( int x = rect.x; x < rect.x2; ++x, pSrc += 4 )
+            {
+                *pDest++ = *pSrc;
+            }
+        }
+
+        UpdateTiles( pSource, rect );
+        UpdateLevels( rect );
+    }
+
+    void CAlphaCoverage::SPlane::UpdateTiles( const uint8* pSource, const SDirtyRect& rect )
+    {
+        const SPixelKernels& kernels = GetPixelKernels();
+        const size_t nPitch = size_t( nWidth ) * 4;
+        SLevel& level = levels[0];
+
+        for ( int ty = rect.y >> eTileShift; ty <= ( rect.y2 - 1 ) >> eTileShift; ++ty )
+        {
+            for ( int tx = rect.x >> eTileShift; tx <= ( rect.x2 - 1 ) >> eTileShift; ++tx )
+            {
+                const SDirtyRect tile = GetTileRect( 0, tx, ty );
+                SRange range = { 255, 0 };
+
+                for ( int row = tile.y; row < tile.y2; ++row )
+                {
+                    uint8 nMin, nMax;
+                    kernels.AlphaRange( pSource + row * nPitch + tile.x * 4, tile.x2 - tile.x, nMin, nMax );
+
+                    range.nMin = min( range.nMin, nMin );
+                    range.nMax = max( range.nMax, nMax );
+                }
+
+                level.ranges[ty * level.nTilesX + tx] = range;
+            }
+        }
+    }
+
+    void CAlphaCoverage::SPlane::UpdateLevels( const SDirtyRect& rect )
+    {
+        int tx = rect.x >> eTileShift;
+        int ty = rect.y >> eTileShift;
+        int tx2 = ( rect.x2 - 1 ) >> eTileShift;
+        int ty2 = ( rect.y2 - 1 ) >> eTileShift;
+
+        for ( size_t l = 1; l < levels.size(); ++l )
+        {
+            const SLevel& child = levels[l - 1];
+            SLevel& level = levels[l];
+
+            tx >>= 1;
+            ty >>= 1;
+            tx2 >>= 1;
+            ty2 >>= 1;
+
+            for ( int y = ty; y <= ty2; ++y )
+            {
+                for ( int x = tx; x <= tx2; ++x )
+                {
+                    SRange range = { 255, 0 };
+
+                    for ( int cy = y * 2; cy < min( y * 2 + 2, child.nTilesY ); ++cy )
+                    {
+                        for ( int cx = x * 2; cx < min( x * 2 + 2, child.nTilesX ); ++cx )
+                        {
+                            const SRange& c = child.ranges[cy * child.nTilesX + cx];
+                            range.nMin = min( range.nMin, c.nMin );
+                            range.nMax = max( range.nMax, c.nMax );
+                        }
+                    }
+
+                    level.ranges[y * level.nTilesX + x] = range;
+                }
+            }
+        }
+    }
+
+    SDirtyRect CAlphaCoverage::SPlane::GetTileRect( int nLevel, int tx, int ty ) const
+    {
+        const int nShift = eTileShift + nLevel;
+
+        SDirtyRect rect( tx << nShift, ty << nShift, ( tx + 1 ) << nShift, ( ty + 1 ) << nShift );
+        rect.Clip( nWidth, nHeight );
+        return rect;
+    }
+
+    uint8 CAlphaCoverage::GetAlpha( int x, int y ) const
+    {
+        const TPlanePtr pPlane = GetPlane();
+
+        if ( x < 0 || y < 0 || x >= pPlane->nWidth || y >= pPlane->nHeight )
+        {
+            return 0;
+        }
+
+        return pPlane->alpha[size_t( y ) * pPlane->nWidth + x];
+    }
+
+    void CAlphaCoverage::GetCoveredTiles( CTileMask& mask, uint8 nThreshold ) const
+    {
+        const TPlanePtr pPlane = GetPlane();
+
+        mask.Configure( pPlane->nWidth, pPlane->nHeight, 1 << eTileShift );
+
+        if ( pPlane->levels.empty() )
+        {
+            return;
+        }
+
+        const SLevel& level = pPlane->levels[0];
+
+        for ( int ty = 0; ty < level.nTilesY; ++ty )
+        {
+            for ( int tx = 0; tx < level.nTilesX; ++tx )
+            {
+                if ( level.ranges[ty * level.nTilesX + tx].nMax >= nThreshold )
+                {
+                    mask.Set( tx, ty );
+                }
+            }
+        }
+    }
+
+    bool CAlphaCoverage::IsRegionOpaque( const SDirtyRect& rect, uint8 nThreshold ) const
+    {
+        const TPlanePtr pPlane = GetPlane();
+
+        SDirtyRect clipped = rect;
+        clipped.Clip( pPlane->nWidth, pPlane->nHeight );
+
+        if ( clipped.IsEmpty() )
+        {
+            return false;
+        }
+
+        if ( nThreshold == 0 )
+        {
+            return true;
+        }
+
+        return pPlane->QueryTile( int( pPlane->levels.size() ) - 1, 0, 0, clipped, nThreshold );
+    }
+
+    bool CAlphaCoverage::SPlane::QueryTile( int nLevel, int tx, int ty, const SDirtyRect& rect, uint8 nThreshold ) const
+    {
+        const SLevel& level = levels[nLevel];
+
+        if ( tx >= level.nTilesX || ty >= level.nTilesY )
+        {
+            return false;
+        }
+
+        const SDirtyRect tile = GetTileRect( nLevel, tx, ty );
+
+        if ( !tile.Overlaps( rect ) )
+        {
+            return false;
+        }
+
+        const SRange& range = level.ranges[ty * level.nTilesX + tx];
+
+        // nothing reaches the threshold or everything does
+        if ( range.nMax < nThreshold )
+        {
+            return false;
+        }
+
+        if ( range.nMin >= nThreshold )
+        {
+            return true;
+        }
+
+        if ( nLevel > 0 )
+        {
+            return QueryTile( nLevel - 1, tx * 2, ty * 2, rect, nThreshold )
+                   || QueryTile( nLevel - 1, tx * 2 + 1, ty * 2, rect, nThreshold )
+                   || QueryTile( nLevel - 1, tx * 2, ty * 2 + 1, rect, nThreshold )
+                   || QueryTile( nLevel - 1, tx * 2 + 1, ty * 2 + 1, rect, nThreshold );
+        }
+
+        // mixed tile, check the pixels of the overlap
+        const int x = max( tile.x, rect.x );
+        const int x2 = min( tile.x2, rect.x2 );
+
+        for ( int y = max( tile.y, rect.y ); y < min( tile.y2, rect.y2 ); ++y )
+        {
+            const uint8* pRow = &alpha[size_t( y ) * nWidth];
+
+            for ( int i = x; i < x2; ++i )
+            {
+                if ( pRow[i] >= nThreshold )
+                {
+                    return true;
+                }
+            }
+        }
+
+        return false;
+    }
+}
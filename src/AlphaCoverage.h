@@ -0,0 +1,131 @@
+/* CryHTML5 - for licensing and copyright see license.txt */
+
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <DirtyRegion.h>
+#include <TileTracker.h>
+
+namespace HTML5Plugin
+{
+    /**
+    * @brief Alpha plane of the surface with a min/max alpha mipmap over tiles for hit testing.
+    * Updated incrementally from the dirty rects of each paint (paint thread) and queried from any thread,
+    * point queries are O(1) and region queries skip fully transparent or fully opaque areas on coarse levels.
+    * The paint thread updates a second plane and swaps it in, so queries never wait for an update.
+    */
+    class CAlphaCoverage
+    {
+        public:
+            enum
+            {
+                eTileShift = 4, //!< level 0 tiles are 16x16 pixels, every level above halves the tiles per axis
+            };
+
+            CAlphaCoverage();
+
+            /**
+            * @brief update the coverage from a paint (paint thread)
+            * @param pSource complete BGRA frame
+            * @param nWidth width of pSource
+            * @param nHeight height of pSource
+            * @param dirty area that changed with this paint (a size change updates everything)
+            */
+            void Update( const uint8* pSource, int nWidth, int nHeight, const CDirtyRegion& dirty );
+
+            /** @return alpha at x, y (0 outside of the surface) */
+            uint8 GetAlpha( int x, int y ) const;
+
+            /** @return true when the alpha at x, y is at least nThreshold */
+            bool IsOpaque( int x, int y, uint8 nThreshold ) const
+            {
+                return nThreshold == 0 || GetAlpha( x, y ) >= nThreshold;
+            }
+
+            /** @return true when any pixel of rect has an alpha of at least nThreshold */
+            bool IsRegionOpaque( const SDirtyRect& rect, uint8 nThreshold ) const;
+
+            /**
+            * @brief mark the level 0 tiles containing any pixel with an alpha of at least nThreshold
+            * @param mask configured for the surface with tiles of 1 << eTileShift pixels
+            * @param nThreshold alpha a pixel needs (at least 1)
+            */
+            void GetCoveredTiles( CTileMask& mask, uint8 nThreshold ) const;
+
+            /** @return surface width */
+            int GetWidth() const
+            {
+                return GetPlane()->nWidth;
+            }
+
+            /** @return surface height */
+            int GetHeight() const
+            {
+                return GetPlane()->nHeight;
+            }
+
+        private:
+            struct SRange
+            {
+                uint8 nMin; //!< smallest alpha in the tile
+                uint8 nMax; //!< largest alpha in the tile
+            };
+
+            struct SLevel
+            {
+                int nTilesX; //!< tiles per row
+                int nTilesY; //!< tiles per column
+                std::vector<SRange> ranges; //!< alpha range per tile
+            };
+
+            /** @brief alpha plane and mipmap of one surface state, never changed while queries can see it */
+            struct SPlane
+            {
+                int nWidth; //!< surface width
+                int nHeight; //!< surface height
+                std::vector<uint8> alpha; //!< alpha per pixel
+                std::vector<SLevel> levels; //!< level 0 are the tiles, the last level is a single tile
+
+                SPlane()
+                    : nWidth( 0 )
+                    , nHeight( 0 )
+                {
+                }
+
+                /** @brief allocate plane and levels for a new surface size */
+                void Configure( int nNewWidth, int nNewHeight );
+
+                /** @brief copy the alpha of rect from pSource and recompute the tiles of all levels covering it */
+                void Update( const uint8* pSource, const SDirtyRect& rect );
+
+                /** @brief recompute the level 0 tiles covering rect from pSource */
+                void UpdateTiles( const uint8* pSource, const SDirtyRect& rect );
+
+                /** @brief recompute the tiles of all levels above 0 covering rect */
+                void UpdateLevels( const SDirtyRect& rect );
+
+                /** @return pixel rect of a tile, clipped to the surface */
+                SDirtyRect GetTileRect( int nLevel, int tx, int ty ) const;
+
+                /** @return true when any pixel of rect inside tile tx, ty of nLevel reaches nThreshold */
+                bool QueryTile( int nLevel, int tx, int ty, const SDirtyRect& rect, uint8 nThreshold ) const;
+            };
+
+            typedef std::shared_ptr<const SPlane> TPlanePtr;
+
+            /** @return the plane queries run on, kept alive by the caller while the paint thread moves on */
+            TPlanePtr GetPlane() const
+            {
+                std::lock_guard<std::mutex> lock( m_lock );
+                return m_pFront;
+            }
+
+            mutable std::mutex m_lock; //!< guards m_pFront, only held to copy or swap the pointer
+            TPlanePtr m_pFront; //!< the newest complete plane, queried from any thread
+            std::shared_ptr<SPlane> m_pBack; //!< the previous plane, rebuilt by the paint thread (nullptr while unused)
+            CDirtyRegion m_backStale; //!< area of m_pBack older than m_pFront
+    };
+}
@@ -0,0 +1,335 @@
+/* CryHTML5 - for licensing and copyright see license.txt */
+
+#include "StdAfx.h"
+#include "AtlasPacker.h"
+
+#include <algorithm>
+
+namespace HTML5Plugin
+{
+    CSkyline::CSkyline()
+        : m_nWidth( 0 )
+        , m_nHeight( 0 )
+    {
+    }
+
+    void CSkyline::Reset( int nWidth, int nHeight )
+    {
+        m_nWidth = nWidth;
+        m_nHeight = nHeight;
+
+        SNode node = { 0, 0, nWidth };
+        m_nodes.clear();
+        m_nodes.push_back( node );
+    }
+
+    int CSkyline::Fit( size_t nNode, int nWidth, int nHeight ) const
+    {
+        const int x = m_nodes[nNode].x;
+
+        if ( x + nWidth > m_nWidth )
+        {
+            return -1;
+        }
+
+        // the rect rests on the highest segment it spans
+        int y = 0;
+        int nLeft = nWidth;
+
+        for ( size_t i = nNode; nLeft > 0; ++i )
+        {
+            y = max( y, m_nodes[i].y );
+
+            if ( y + nHeight > m_nHeight )
+            {
+                return -1;
+            }
+
+            nLeft -= m_nodes[i].w;
+        }
+
+        return y;
+    }
+
+    bool CSkyline::Insert( int nWidth, int nHeight, int& x, int& y )
+    {
+        size_t nBest = m_nodes.size();
+        int nBestBottom = INT_MAX;
+        int nBestWidth = INT_MAX;
+
+        // bottom-left: lowest resulting top edge, then the narrowest segment
+        for ( size_t i = 0; i < m_nodes.size(); ++i )
+        {
+            const int nY = Fit( i, nWidth, nHeight );
+
+            if ( nY < 0 )
+            {
+                continue;
+            }
+
+            if ( nY + nHeight < nBestBottom || ( nY + nHeight == nBestBottom && m_nodes[i].w < nBestWidth ) )
+            {
+                nBest = i;
+                nBestBottom = nY + nHeight;
+                nBestWidth = m_nodes[i].w;
+            }
+        }
+
+        if ( nBest == m_nodes.size() )
+        {
+            return false;
+        }
+
+        x = m_nodes[nBest].x;
+        y = nBestBottom - nHeight;
+
+        SNode node = { x, nBestBottom, nWidth };
+        m_nodes.insert( m_nodes.begin() + nBest, node );
+
+        // cut the segments now covered by the new one
+        for ( size_t i = nBest + 1; i < m_nodes.size(); )
+        {
+            const SNode& prev = m_nodes[i - 1];
+            SNode& cur = m_nodes[i];
+            const int nOverlap = prev.x + prev.w - cur.x;
+
+            if ( nOverlap <= 0 )
+            {
+                break;
+            }
+
+            cur.x += nOverlap;
+            cur.w -= nOverlap;
+
+            if ( cur.w > 0 )
+            {
+                break;
+            }
+
+            m_nodes.erase( m_nodes.begin() + i );
+        }
+
+        // merge neighbours of the same height
+        for ( size_t i = 0; i + 1 < m_nodes.size(); )
+        {
+            if ( m_nodes[i].y == m_nodes[i + 1].y )
+            {
+                m_nodes[i].w += m_nodes[i + 1].w;
+                m_nodes.erase( m_nodes.begin() + i + 1 );
+            }
+
+            else
+            {
+                ++i;
+            }
+        }
+
+        return true;
+    }
+
+    int CSkyline::GetUsedArea() const
+    {
+        int nArea = 0;
+
+        for ( size_t i = 0; i < m_nodes.size(); ++i )
+        {
+            nArea += m_nodes[i].w * m_nodes[i].y;
+        }
+
+        return nArea;
+    }
+
+    CAtlasPacker::CAtlasPacker()
+        : m_nPageSize( 0 )
+        , m_nMaxPages( 0 )
+        , m_nPadding( 0 )
+        , m_nLiveArea( 0 )
+        , m_nFreedArea( 0 )
+        , m_nRepacks( 0 )
+        , m_nMoves( 0 )
+    {
+    }
+
+    void CAtlasPacker::Configure( int nPageSize, int nMaxPages, int nPadding )
+    {
+        if ( nPageSize == m_nPageSize && nMaxPages == m_nMaxPages && nPadding == m_nPadding )
+        {
+            return;
+        }
+
+        // destroying bumps the generations so handles held by surfaces become invalid
+        while ( m_entries.GetCount() )
+        {
+            m_entries.Destroy( m_entries.GetHandle( 0 ) );
+        }
+
+        m_pages.clear();
+        m_nPageSize = max( nPageSize, 0 );
+        m_nMaxPages = max( nMaxPages, 0 );
+        m_nPadding = max( nPadding, 0 );
+        m_nLiveArea = 0;
+        m_nFreedArea = 0;
+        m_nRepacks = 0;
+        m_nMoves = 0;
+    }
+
+    bool CAtlasPacker::Place( SAtlasEntry& entry )
+    {
+        const int nWidth = entry.nWidth + m_nPadding;
+        const int nHeight = entry.nHeight + m_nPadding;
+        int x, y;
+
+        for ( size_t i = 0; i <= m_pages.size(); ++i )
+        {
+            if ( i == m_pages.size() )
+            {
+                if ( int( m_pages.size() ) >= m_nMaxPages )
+                {
+                    break;
+                }
+
+                m_pages.push_back( CSkyline() );
+                m_pages.back().Reset( m_nPageSize, m_nPageSize );
+            }
+
+            if ( m_pages[i].Insert( nWidth, nHeight, x, y ) )
+            {
+                entry.nPage = int( i );
+                entry.rect = SDirtyRect( x, y, x + entry.nWidth, y + entry.nHeight );
+                entry.bPlaced = true;
+                return true;
+            }
+        }
+
+        entry.bPlaced = false;
+        return false;
+    }
+
+    CAtlasPacker::THandle CAtlasPacker::Allocate( int nWidth, int nHeight )
+    {
+        if ( !CanPack( nWidth, nHeight ) )
+        {
+            return 0;
+        }
+
+        SAtlasEntry entry;
+        entry.nWidth = nWidth;
+        entry.nHeight = nHeight;
+
+        const THandle hEntry = m_entries.Create( entry );
+
+        if ( !hEntry )
+        {
+            return 0;
+        }
+
+        m_nLiveArea += uint64( nWidth + m_nPadding ) * ( nHeight + m_nPadding );
+
+        SAtlasEntry& created = *m_entries.Get( hEntry );
+
+        if ( Place( created ) )
+        {
+            return hEntry;
+        }
+
+        // reclaim the space of freed surfaces when that could be enough, a full atlas isn't repacked on every request
+        const uint64 nCapacity = uint64( m_nMaxPages ) * m_nPageSize * m_nPageSize;
+        const uint64 nArea = uint64( nWidth + m_nPadding ) * ( nHeight + m_nPadding );
+
+        if ( m_nLiveArea <= nCapacity && m_nFreedArea >= nArea )
+        {
+            Repack();
+
+            if ( m_entries.Get( hEntry )->bPlaced )
+            {
+                return hEntry;
+            }
+        }
+
+        Free( hEntry );
+        return 0;
+    }
+
+    void CAtlasPacker::Free( THandle hEntry )
+    {
+        const SAtlasEntry* pEntry = m_entries.Get( hEntry );
+
+        if ( pEntry )
+        {
+            const uint64 nArea = uint64( pEntry->nWidth + m_nPadding ) * ( pEntry->nHeight + m_nPadding );
+            m_nLiveArea -= nArea;
+
+            // only space below the skyline can be reclaimed
+            if ( pEntry->bPlaced )
+            {
+                m_nFreedArea += nArea;
+            }
+
+            m_entries.Destroy( hEntry );
+        }
+    }
+
+    void CAtlasPacker::Repack()
+    {
+        m_order.clear();
+
+        for ( size_t i = 0; i < m_entries.GetCount(); ++i )
+        {
+            m_order.push_back( m_entries.GetHandle( i ) );
+        }
+
+        // tall surfaces first keeps the skyline flat
+        CHandlePool<SAtlasEntry>& entries = m_entries;
+        std::sort( m_order.begin(), m_order.end(), [&entries]( THandle a, THandle b ) -> bool
+        {
+            const SAtlasEntry& ea = *entries.Get( a );
+            const SAtlasEntry& eb = *entries.Get( b );
+            return ea.nHeight != eb.nHeight ? ea.nHeight > eb.nHeight : ea.nWidth > eb.nWidth;
+        } );
+
+        m_pages.clear();
+
+        for ( size_t i = 0; i < m_order.size(); ++i )
+        {
+            SAtlasEntry& entry = *m_entries.Get( m_order[i] );
+
+            const bool bWasPlaced = entry.bPlaced;
+            const int nPage = entry.nPage;
+            const SDirtyRect rect = entry.rect;
+
+            Place( entry );
+
+            if ( entry.bPlaced != bWasPlaced || entry.nPage != nPage || entry.rect.x != rect.x || entry.rect.y != rect.y )
+            {
+                ++entry.nVersion;
+                ++m_nMoves;
+            }
+        }
+
+        m_nFreedArea = 0;
+        ++m_nRepacks;
+    }
+
+    float CAtlasPacker::GetFragmentation() const
+    {
+        uint64 nUsed = 0;
+
+        for ( size_t i = 0; i < m_pages.size(); ++i )
+        {
+            nUsed += m_pages[i].GetUsedArea();
+        }
+
+        return nUsed ? 1.0f - float( double( min( m_nLiveArea, nUsed ) ) / double( nUsed ) ) : 0.0f;
+    }
+
+    CAtlasPacker::SStats CAtlasPacker::GetStats() const
+    {
+        SStats stats;
+        stats.nEntries = uint32( m_entries.GetCount() );
+        stats.nPages = uint32( m_pages.size() );
+        stats.nLiveArea = m_nLiveArea;
+        stats.nRepacks = m_nRepacks;
+        stats.nMoves = m_nMoves;
+        return stats;
+    }
+}
@@ -0,0 +1,178 @@
+/* CryHTML5 - for licensing and copyright see license.txt */
+
+#pragma once
+
+#include <vector>
+
+#include <DirtyRegion.h>
+#include <HandlePool.h>
+
+namespace HTML5Plugin
+{
+    /**
+    * @brief Skyline bottom-left packer for one atlas page.
+    * The skyline is the top edge of the allocated area, new rects are placed where they end lowest.
+    * Space below the skyline can't be reused, so freed rects are only reclaimed by repacking.
+    */
+    class CSkyline
+    {
+        public:
+            CSkyline();
+
+            /** @brief remove all rects */
+            void Reset( int nWidth, int nHeight );
+
+            /**
+            * @brief place a rect
+            * @param[out] x left of the placed rect
+            * @param[out] y top of the placed rect
+            * @return false when the rect doesn't fit
+            */
+            bool Insert( int nWidth, int nHeight, int& x, int& y );
+
+            /** @return area below the skyline (allocated or wasted) */
+            int GetUsedArea() const;
+
+        private:
+            /**
+            * @brief find the height a rect starting at a node would be placed at
+            * @return top of the rect, -1 when it doesn't fit there
+            */
+            int Fit( size_t nNode, int nWidth, int nHeight ) const;
+
+            /** @brief horizontal segment of the skyline */
+            struct SNode
+            {
+                int x; //!< start of the segment
+                int y; //!< height of the allocated area below the segment
+                int w; //!< width of the segment
+            };
+
+            std::vector<SNode> m_nodes; //!< segments from left to right
+            int m_nWidth; //!< page size
+            int m_nHeight;
+    };
+
+    /** @brief place of a surface in the atlas */
+    struct SAtlasEntry
+    {
+        int nWidth; //!< requested size
+        int nHeight;
+        int nPage; //!< atlas page the surface is on
+        SDirtyRect rect; //!< area on the page
+        uint32 nVersion; //!< incremented whenever the surface moved, its content has to be uploaded again then
+        bool bPlaced; //!< false when repacking couldn't place the surface again
+
+        SAtlasEntry()
+            : nWidth( 0 )
+            , nHeight( 0 )
+            , nPage( 0 )
+            , nVersion( 0 )
+            , bPlaced( false )
+        {
+        }
+
+        /**
+        * @brief map a rect of the surface into page coordinates
+        * @param rect rect in surface pixels, clipped to the surface
+        */
+        SDirtyRect ToPage( const SDirtyRect& rect ) const
+        {
+            SDirtyRect mapped( rect );
+            mapped.Clip( nWidth, nHeight );
+
+            mapped.x += this->rect.x;
+            mapped.y += this->rect.y;
+            mapped.x2 += this->rect.x;
+            mapped.y2 += this->rect.y;
+            return mapped;
+        }
+    };
+
+    /**
+    * @brief Packs many small surfaces into a few square atlas pages.
+    * Pages are added on demand up to a limit, when nothing fits anymore the live surfaces are repacked
+    * (sorted by height) to reclaim the space of freed ones. Moved surfaces get a new version.
+    */
+    class CAtlasPacker
+    {
+        public:
+            typedef CHandlePool<SAtlasEntry>::THandle THandle;
+
+            CAtlasPacker();
+
+            /**
+            * @brief set the page layout, invalidates all surfaces when it changed
+            * @param nPageSize width and height of a page (0 disables the atlas)
+            * @param nMaxPages maximum number of pages
+            * @param nPadding empty pixels kept right and below every surface against filtering bleed
+            */
+            void Configure( int nPageSize, int nMaxPages, int nPadding );
+
+            /** @return true when a surface of that size can be packed at all */
+            bool CanPack( int nWidth, int nHeight ) const
+            {
+                return nWidth > 0 && nHeight > 0 && nWidth + m_nPadding <= m_nPageSize && nHeight + m_nPadding <= m_nPageSize;
+            }
+
+            /**
+            * @brief place a surface
+            * @return handle of the surface, 0 when the atlas is full
+            */
+            THandle Allocate( int nWidth, int nHeight );
+
+            /** @brief remove a surface */
+            void Free( THandle hEntry );
+
+            /** @return place of a surface or nullptr when the handle is invalid */
+            const SAtlasEntry* Get( THandle hEntry )
+            {
+                return m_entries.Get( hEntry );
+            }
+
+            /** @brief place all surfaces again, largest first */
+            void Repack();
+
+            /** @return number of pages in use */
+            int GetPageCount() const
+            {
+                return int( m_pages.size() );
+            }
+
+            int GetPageSize() const
+            {
+                return m_nPageSize;
+            }
+
+            /** @return part of the allocated page area not used by live surfaces (0..1) */
+            float GetFragmentation() const;
+
+            /** @brief packing statistics */
+            struct SStats
+            {
+                uint32 nEntries; //!< live surfaces
+                uint32 nPages; //!< pages in use
+                uint64 nLiveArea; //!< pixels of live surfaces including padding
+                uint32 nRepacks; //!< repacks done since the last Configure
+                uint32 nMoves; //!< surfaces moved by repacks
+            };
+
+            SStats GetStats() const;
+
+        private:
+            /** @brief find a place for an entry, adds a page when needed */
+            bool Place( SAtlasEntry& entry );
+
+            int m_nPageSize; //!< width and height of a page
+            int m_nMaxPages; //!< page limit
+            int m_nPadding; //!< pixels kept free right and below surfaces
+
+            std::vector<CSkyline> m_pages; //!< packer per page
+            CHandlePool<SAtlasEntry> m_entries; //!< live surfaces
+            std::vector<THandle> m_order; //!< scratch list for repacking
+            uint64 m_nLiveArea; //!< pixels of live surfaces including padding
+            uint64 m_nFreedArea; //!< pixels freed since the last repack
+            uint32 m_nRepacks;
+            uint32 m_nMoves;
+    };
+}
@@ -0,0 +1,240 @@
+/* CryHTML5 - for licensing and copyright see license.txt */
+
+#include "StdAfx.h"
+#include "BlockCompression.h"
+
+namespace HTML5Plugin
+{
+    /** @return 8 bit color channels packed into 5:6:5 */
+    static inline uint16 PackColor565( const int color[3] )
+    {
+        return uint16( ( ( color[0] >> 3 ) << 11 ) | ( ( color[1] >> 2 ) << 5 ) | ( color[2] >> 3 ) );
+    }
+
+    /** @brief expand a 5:6:5 color to 8 bit channels like the hardware decodes it */
+    static inline void UnpackColor565( uint16 nPacked, int color[3] )
+    {
+        const int r = ( nPacked >> 11 ) & 31;
+        const int g = ( nPacked >> 5 ) & 63;
+        const int b = nPacked & 31;
+
+        color[0] = ( r << 3 ) | ( r >> 2 );
+        color[1] = ( g << 2 ) | ( g >> 4 );
+        color[2] = ( b << 3 ) | ( b >> 2 );
+    }
+
+    /** @brief 8 alpha mode block: two endpoints and 3 bit indices */
+    static void EncodeAlphaBlock( const uint8 alpha[16], uint8* pDest )
+    {
+        int nMin = 255;
+        int nMax = 0;
+
+        for ( int i = 0; i < 16; ++i )
+        {
+            nMin = min( nMin, int( alpha[i] ) );
+            nMax = max( nMax, int( alpha[i] ) );
+        }
+
+        memset( pDest, 0, 8 );
+        pDest[0] = uint8( nMax );
+        pDest[1] = uint8( nMin );
+
+        // a0 == a1 would select the 6 alpha mode, every index 0 decodes to a0 anyway
+        if ( nMax == nMin )
+        {
+            return;
+        }
+
+        const int nRange = nMax - nMin;
+        uint64 nBits = 0;
+
+        for ( int i = 0; i < 16; ++i )
+        {
+            // sevenths from a1 to a0, index 0 is a0, 1 is a1 and 2 - 7 step from a0 towards a1
+            const int t = ( ( alpha[i] - nMin ) * 14 + nRange ) / ( nRange * 2 );
+            const uint64 nIndex = t == 7 ? 0 : t == 0 ? 1 : uint64( 8 - t );
+
+            nBits |= nIndex << ( i * 3 );
+        }
+
+        for ( int i = 0; i < 6; ++i )
+        {
+            pDest[2 + i] = uint8( nBits >> ( i * 8 ) );
+        }
+    }
+
+    /**
+    * @brief 4 color block: endpoints on the diagonal of the bounding box that follows the colors, 2 bit indices
+    * Fully transparent pixels don't contribute to the endpoints, their color isn't visible.
+    */
+    static void EncodeColorBlock( const uint8 pixels[16][4], uint8* pDest )
+    {
+        int minColor[3] = { 255, 255, 255 };
+        int maxColor[3] = { 0, 0, 0 };
+        int nVisible = 0;
+
+        for ( int i = 0; i < 16; ++i )
+        {
+            if ( pixels[i][3] == 0 )
+            {
+                continue;
+            }
+
+            ++nVisible;
+
+            for ( int c = 0; c < 3; ++c )
+            {
+                minColor[c] = min( minColor[c], int( pixels[i][c] ) );
+                maxColor[c] = max( maxColor[c], int( pixels[i][c] ) );
+            }
+        }
+
+        if ( nVisible == 0 )
+        {
+            memset( pDest, 0, 8 );
+            return;
+        }
+
+        // pick the diagonal of the box the colors are spread along (sign of the covariance against the widest channel,
+        // a flat channel would leave the other two without a direction)
+        int center[3];
+        int nPivot = 0;
+
+        for ( int c = 0; c < 3; ++c )
+        {
+            center[c] = ( minColor[c] + maxColor[c] ) >> 1;
+
+            if ( maxColor[c] - minColor[c] > maxColor[nPivot] - minColor[nPivot] )
+            {
+                nPivot = c;
+            }
+        }
+
+        int covariance[3] = { 0, 0, 0 };
+
+        for ( int i = 0; i < 16; ++i )
+        {
+            if ( pixels[i][3] != 0 )
+            {
+                const int d = pixels[i][nPivot] - center[nPivot];
+
+                for ( int c = 0; c < 3; ++c )
+                {
+                    covariance[c] += d * ( pixels[i][c] - center[c] );
+                }
+            }
+        }
+
+        for ( int c = 0; c < 3; ++c )
+        {
+            if ( covariance[c] < 0 )
+            {
+                std::swap( minColor[c], maxColor[c] );
+            }
+        }
+
+        // inset the box by 1/16 of its size, the endpoints of a fitted line lie inside the extremes
+        for ( int c = 0; c < 3; ++c )
+        {
+            const int nInset = ( maxColor[c] - minColor[c] ) >> 4;
+            minColor[c] = clamp_tpl( minColor[c] + nInset, 0, 255 );
+            maxColor[c] = clamp_tpl( maxColor[c] - nInset, 0, 255 );
+        }
+
+        uint16 nColor0 = PackColor565( maxColor );
+        uint16 nColor1 = PackColor565( minColor );
+
+        // color0 > color1 selects the 4 color mode
+        if ( nColor0 < nColor1 )
+        {
+            std::swap( nColor0, nColor1 );
+        }
+
+        pDest[0] = uint8( nColor0 );
+        pDest[1] = uint8( nColor0 >> 8 );
+        pDest[2] = uint8( nColor1 );
+        pDest[3] = uint8( nColor1 >> 8 );
+
+        uint32 nBits = 0;
+
+        if ( nColor0 != nColor1 )
+        {
+            // project onto the line between the decoded endpoints, index 0 is color0, 1 is color1, 2 and 3 the thirds in between
+            int end0[3], end1[3], dir[3];
+            UnpackColor565( nColor0, end0 );
+            UnpackColor565( nColor1, end1 );
+
+            int nLength = 0;
+
+            for ( int c = 0; c < 3; ++c )
+            {
+                dir[c] = end1[c] - end0[c];
+                nLength += dir[c] * dir[c];
+            }
+
+            static const uint32 indexMap[4] = { 0, 2, 3, 1 };
+
+            for ( int i = 0; i < 16; ++i )
+            {
+                const int nDot = ( pixels[i][0] - end0[0] ) * dir[0] + ( pixels[i][1] - end0[1] ) * dir[1] + ( pixels[i][2] - end0[2] ) * dir[2];
+                const int t = clamp_tpl( ( nDot * 6 + nLength ) / ( nLength * 2 ), 0, 3 );
+
+                nBits |= indexMap[nDot <= 0 ? 0 : t] << ( i * 2 );
+            }
+        }
+
+        pDest[4] = uint8( nBits );
+        pDest[5] = uint8( nBits >> 8 );
+        pDest[6] = uint8( nBits >> 16 );
+        pDest[7] = uint8( nBits >> 24 );
+    }
+
+    void EncodeBC3Block( const uint8* pSource, int nPitch, uint8* pDest )
+    {
+        uint8 pixels[16][4];
+        uint8 alpha[16];
+
+        for ( int y = 0; y < 4; ++y )
+        {
+            memcpy( pixels[y * 4], pSource + y * nPitch, 16 );
+        }
+
+        for ( int i = 0; i < 16; ++i )
+        {
+            alpha[i] = pixels[i][3];
+        }
+
+        EncodeAlphaBlock( alpha, pDest );
+        EncodeColorBlock( pixels, pDest + 8 );
+    }
+
+    void EncodeBC3( const uint8* pSource, int nWidth, int nHeight, int nPitch, uint8* pDest )
+    {
+        uint8 edge[4 * 16];
+
+        for ( int y = 0; y < nHeight; y += 4 )
+        {
+            for ( int x = 0; x < nWidth; x += 4, pDest += eBC3BlockBytes )
+            {
+                if ( x + 4 <= nWidth && y + 4 <= nHeight )
+                {
+                    EncodeBC3Block( pSource + y * nPitch + x * 4, nPitch, pDest );
+                    continue;
+                }
+
+                // gather the partial block, repeating the last pixels
+                for ( int by = 0; by < 4; ++by )
+                {
+                    for ( int bx = 0; bx < 4; ++bx )
+                    {
+                        const int sx = min( x + bx, nWidth - 1 );
+                        const int sy = min( y + by, nHeight - 1 );
+                        memcpy( edge + ( by * 4 + bx ) * 4, pSource + sy * nPitch + sx * 4, 4 );
+                    }
+                }
+
+                EncodeBC3Block( edge, 16, pDest );
+            }
+        }
+    }
+}
@@ -0,0 +1,37 @@
+/* CryHTML5 - for licensing and copyright see license.txt */
+
+#pragma once
+
+namespace HTML5Plugin
+{
+    enum
+    {
+        eBC3BlockBytes = 16, //!< bytes of a compressed 4x4 block
+    };
+
+    /** @return bytes of a BC3 surface (4x4 blocks, partial blocks are rounded up) */
+    inline size_t GetBC3Size( int nWidth, int nHeight )
+    {
+        return size_t( ( nWidth + 3 ) / 4 ) * ( ( nHeight + 3 ) / 4 ) * eBC3BlockBytes;
+    }
+
+    /**
+    * @brief encode a 4x4 block of 4 byte pixels into BC3 (DXT5)
+    * Channels 0 - 2 become the color block in the order they are stored, channel 3 the alpha block,
+    * so a BGRA frame encoded as it is needs the same red/blue swap when sampled as an RGBA upload.
+    * @param pSource top left pixel of the block
+    * @param nPitch bytes per row of pSource
+    * @param pDest receives eBC3BlockBytes
+    */
+    void EncodeBC3Block( const uint8* pSource, int nPitch, uint8* pDest );
+
+    /**
+    * @brief encode a surface into BC3, blocks reaching over the edge repeat the last row and column
+    * @param pSource 4 byte pixels
+    * @param nWidth size of pSource
+    * @param nHeight
+    * @param nPitch bytes per row of pSource
+    * @param pDest receives GetBC3Size( nWidth, nHeight ) bytes, rows of blocks top to bottom
+    */
+    void EncodeBC3( const uint8* pSource, int nWidth, int nHeight, int nPitch, uint8* pDest );
+}
@@ -4,26 +4,123 @@
 #include <ICryPak.h>
 #include <PMUtils.hpp>
 
+#include <PakStream.h>
+
 #include <cef_scheme.h>
 #include <include/wrapper/cef_stream_resource_handler.h>
 
-/** @brief Implementation of the resource handler for client requests. */
+/** @brief CryPak access for the pak streams, CryPak handles are thread safe as long as one thread uses a handle at a time. */
+class CEFCryPakFiles : public HTML5Plugin::IPakFiles
+{
+    public:
+        virtual void* Open( const char* sPath ) override
+        {
+            return gEnv->pCryPak->FOpen( sPath, "rb" );
+        }
+
+        virtual size_t GetSize( void* hFile ) override
+        {
+            return gEnv->pCryPak->FGetSize( static_cast<FILE*>( hFile ) );
+        }
+
+        virtual uint64 GetStamp( void* hFile ) override
+        {
+            return gEnv->pCryPak->GetModificationTime( static_cast<FILE*>( hFile ) );
+        }
+
+        virtual bool FindRange( void* hFile, const char* sPath, std::string& sArchive, uint64& nOffset ) override
+        {
+            // only entries stored uncompressed inside a pak, loose files go through the stream
+            const char* sPak = gEnv->pCryPak->GetFileArchivePath( static_cast<FILE*>( hFile ) );
+
+            if ( !sPak || !*sPak || gEnv->pCryPak->IsFileCompressed( sPath ) )
+            {
+                return false;
+            }
+
+            // offset of the entry data, the stream compares the mapping with FReadRaw before using it
+            nOffset = gEnv->pCryPak->GetFileOffsetOnMedia( sPath );
+
+            if ( nOffset == 0 )
+            {
+                return false;
+            }
+
+            char sFullPath[ICryPak::g_nMaxPath];
+            sArchive = gEnv->pCryPak->AdjustFileName( sPak, sFullPath, ICryPak::FLAGS_PATH_REAL );
+            return true;
+        }
+
+        virtual size_t Read( void* hFile, void* pDest, size_t nBytes ) override
+        {
+            return gEnv->pCryPak->FReadRaw( pDest, 1, nBytes, static_cast<FILE*>( hFile ) );
+        }
+
+        virtual void Close( void* hFile ) override
+        {
+            gEnv->pCryPak->FClose( static_cast<FILE*>( hFile ) );
+        }
+};
+
+/**
+* @brief Implementation of the resource handler for client requests.
+* Opens and reads run on the pak worker pool, the CEF IO thread only copies data that is already there
+* and is told through callback->Continue() when the headers or the next chunk are ready.
+*/
 class CEFCryPakResourceHandler : public CefResourceHandler
 {
     public:
-        FILE* m_fHandle; //!< file handle inside CryPak
+        std::shared_ptr<HTML5Plugin::CPakStream> m_pStream; //!< the file streamed through the worker pool
+        std::shared_ptr<HTML5Plugin::IPakFiles> m_pFiles; //!< CryPak access
         string m_sPath; //!< file path
         string m_sExtension; //!< file extension
         string m_sMime; //!< mime type
-        size_t m_nSize; //!< file size
-        size_t m_nOffset; //!< current position inside of file
 
-        CEFCryPakResourceHandler()
+        CEFCryPakResourceHandler( const std::shared_ptr<HTML5Plugin::IPakFiles>& pFiles )
+            : m_pFiles( pFiles )
         {
-            m_fHandle = NULL;
             m_sExtension = "html";
-            m_nSize = 0;
-            m_nOffset = 0;
+        }
+
+        ~CEFCryPakResourceHandler()
+        {
+            Cancel();
+        }
+
+        /**
+        * @brief scheduling priority of a request
+        * Frames come first, then what the layout waits for, then images and everything else.
+        * Pages can rank an image with a cm5_priority=<EPakPriority> query, e.g. to load the visible ones before those further down.
+        * @param request request
+        * @param sQuery query part of the url
+        */
+        static int GetPriority( CefRefPtr<CefRequest> request, const string& sQuery )
+        {
+            size_t nHint = sQuery.find( "cm5_priority=" );
+
+            if ( nHint != string::npos )
+            {
+                return atoi( sQuery.c_str() + nHint + 13 );
+            }
+
+            switch ( request->GetResourceType() )
+            {
+                case RT_MAIN_FRAME:
+                case RT_SUB_FRAME:
+                    return HTML5Plugin::ePP_Document;
+
+                case RT_STYLESHEET:
+                case RT_SCRIPT:
+                case RT_FONT_RESOURCE:
+                    return HTML5Plugin::ePP_Layout;
+
+                case RT_IMAGE:
+                case RT_FAVICON:
+                    return HTML5Plugin::ePP_Image;
+
+                default:
+                    return HTML5Plugin::ePP_Background;
+            }
         }
 
         /**
@@ -33,9 +130,6 @@ class CEFCryPakResourceHandler : public CefResourceHandler
         */
         virtual bool ProcessRequest( CefRefPtr<CefRequest> request, CefRefPtr<CefCallback> callback ) OVERRIDE
         {
-            // Evaluate request to determine proper handling
-            bool handled = false;
-
             // CryPak uses UTF-8
             string sPath = PluginManager::UCS22UTF8( request->GetURL().ToWString().c_str() );
 
@@ -43,6 +137,16 @@ class CEFCryPakResourceHandler : public CefResourceHandler
             size_t nOffset = sPath.find_first_of( '/' ) + 2;
             m_sPath = sPath.Mid( nOffset ).Trim();
 
+            // Split off query and fragment, they aren't part of the file name
+            string sQuery;
+            nOffset = m_sPath.find_first_of( "?#" );
+
+            if ( nOffset != string::npos )
+            {
+                sQuery = m_sPath.Mid( nOffset );
+                m_sPath = m_sPath.Left( nOffset );
+            }
+
             // Get extension
             nOffset = m_sPath.find_last_of( '.' ) + 1;
             m_sExtension = m_sPath.Mid( nOffset, 3 ).Trim().MakeLower();
@@ -70,23 +174,19 @@ class CEFCryPakResourceHandler : public CefResourceHandler
                 m_sMime = "application/javascript";
             }
 
-            // Open File
-            if ( ( m_fHandle = gEnv->pCryPak->FOpen( m_sPath, "rb" ) ) == NULL )
+            else if ( m_sExtension == "css" )
             {
-                HTML5Plugin::gPlugin->LogWarning( "ProcessReques(%s) Unable to find specified path in pak", m_sPath.c_str() );
+                m_sMime = "text/css";
             }
 
-            else {
-                m_nSize = gEnv->pCryPak->FGetSize( m_fHandle );
-
-                HTML5Plugin::gPlugin->LogAlways( "ProcessReques(%s) Success Ext(%s) Mime(%s) Size(%ld)", m_sPath.c_str(), m_sExtension.c_str(), m_sMime.c_str(), m_nSize );
-
-                // Indicate the headers are available.
+            // Open on the worker pool, the headers are available once it finished either way
+            m_pStream = std::make_shared<HTML5Plugin::CPakStream>( m_pFiles, HTML5Plugin::gPlugin->m_pakPool, m_sPath.c_str(), GetPriority( request, sQuery ), &HTML5Plugin::gPlugin->m_resourceCache );
+            m_pStream->Open( [callback]()
+            {
                 callback->Continue();
-                return true; // Return true to handle the request.
-            }
+            } );
 
-            return false;
+            return true; // Return true to handle the request.
         }
 
         /**
@@ -97,73 +197,56 @@ class CEFCryPakResourceHandler : public CefResourceHandler
         */
         virtual void GetResponseHeaders( CefRefPtr<CefResponse> response, int64& response_length, CefString& redirectUrl ) OVERRIDE
         {
-            if(m_fHandle)
+            if ( m_pStream && m_pStream->IsOpen() )
             {
                 // Populate the response headers.
                 response->SetStatus( 200 ); // OK
                 response->SetMimeType( m_sMime.c_str() );
 
                 // Specify the resulting response length.
-                response_length = m_nSize;
+                response_length = m_pStream->GetSize();
+
+                HTML5Plugin::gPlugin->LogAlways( "ProcessReques(%s) Success Ext(%s) Mime(%s) Size(%ld)", m_sPath.c_str(), m_sExtension.c_str(), m_sMime.c_str(), long( response_length ) );
             } else {
+                HTML5Plugin::gPlugin->LogWarning( "ProcessReques(%s) Unable to find specified path in pak", m_sPath.c_str() );
+
                 response->SetStatus( 404 ); // not found
                 response->SetMimeType( m_sMime.c_str() );
 
                 // Specify the resulting response length.
                 response_length = 0;
             }
-
         }
 
         virtual void Cancel() OVERRIDE
         {
-            if ( m_fHandle )
+            if ( m_pStream )
             {
-                gEnv->pCryPak->FClose( m_fHandle );
-                m_fHandle = NULL;
+                m_pStream->Cancel();
             }
         }
 
         /**
-        * @brief read data from disk
+        * @brief hand out data read by the worker pool
         * @param data_out data_out
         * @param bytes_to_read bytes_to_read
-        * @param bytes_read bytes_read
+        * @param bytes_read 0 when the next chunk is still being read, callback continues the request then
         * @param callback callback
         * @return data left?
         */
         virtual bool ReadResponse( void* data_out, int bytes_to_read, int& bytes_read, CefRefPtr<CefCallback> callback ) OVERRIDE
         {
-            // Read up to |bytes_to_read| data into |data_out| and set |bytes_read|.
-            // If data isn't immediately available set bytes_read=0 and execute
-            // |callback| asynchronously.
-            // Return true to continue the request or false to complete the request.
-            bool has_data = false;
             bytes_read = 0;
 
-            if ( m_nOffset < m_nSize && data_out && m_fHandle )
+            if ( !m_pStream || !data_out )
             {
-                // Copy the next block of data into the buffer.
-                int transfer_size = min( bytes_to_read, static_cast<int>( m_nSize - m_nOffset ) );
-
-                // Read from pack
-                transfer_size = gEnv->pCryPak->FReadRaw( data_out, 1, transfer_size, m_fHandle );
-
-                // Save offset
-                m_nOffset += transfer_size;
-
-                // Success
-                bytes_read = transfer_size;
-                has_data = true; // m_nOffset < m_nSize ?
+                return false;
             }
 
-            // Close File Handle
-            if ( !has_data )
+            return m_pStream->Read( data_out, bytes_to_read, bytes_read, [callback]()
             {
-                Cancel();
-            }
-
-            return has_data;
+                callback->Continue();
+            } );
         }
 
     private:
@@ -174,10 +257,20 @@ class CEFCryPakResourceHandler : public CefResourceHandler
 class CEFCryPakHandlerFactory : public CefSchemeHandlerFactory
 {
     public:
+        std::shared_ptr<HTML5Plugin::IPakFiles> m_pFiles; //!< CryPak access shared by all handlers
+
+        CEFCryPakHandlerFactory()
+            : m_pFiles( std::make_shared<CEFCryPakFiles>() )
+        {
+        }
+
         virtual CefRefPtr<CefResourceHandler> Create( CefRefPtr<CefBrowser> browser, CefRefPtr<CefFrame> frame, const CefString& scheme_name, CefRefPtr<CefRequest> request ) OVERRIDE
         {
+            // Follow changes of the cache budget
+            HTML5Plugin::gPlugin->m_resourceCache.SetBudget( size_t( max( HTML5Plugin::gPlugin->cm5_cache_size, 0 ) ) << 20 );
+
             // Return a new resource handler instance to handle the request.
-            return new CEFCryPakResourceHandler();
+            return new CEFCryPakResourceHandler( m_pFiles );
 
             /*
             // Create a stream reader for |html_content|.
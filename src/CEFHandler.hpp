@@ -10,6 +10,8 @@
 
 #include <CEFInputHandler.hpp>
 
+#include <atomic>
+
 /** @brief handle loading of web pages */
 class CEFCryLoadHandler : public CefLoadHandler
 {
@@ -52,18 +54,32 @@ class CEFCryHandler : public CefClient, public CefLifeSpanHandler, public CefCon
 {
     private:
         CefRefPtr<CEFCryLoadHandler> _loadHandler; //!< the load handler
+        std::atomic<bool> _closing; //!< the view was destroyed, close the browser as soon as it exists
 
     public:
         CefRefPtr<CEFCryRenderHandler> _renderHandler; //!< the renderer handler
-        CEFCryInputHandler m_input; //!< the input handler
 
     public:
-        CEFCryHandler( int windowWidth, int windowHeight )
+        CEFCryHandler( int windowWidth, int windowHeight ) :
+            _closing( false )
         {
             _renderHandler = new CEFCryRenderHandler( windowWidth, windowHeight );
             _loadHandler = new CEFCryLoadHandler();
         };
 
+        /** @brief close the browser of this view (also when it is still being created) */
+        void Close()
+        {
+            _closing = true;
+
+            CefRefPtr<CefBrowserHost> host = _renderHandler->GetHost();
+
+            if ( host.get() != nullptr )
+            {
+                host->CloseBrowser( true );
+            }
+        }
+
         ~CEFCryHandler() { };
 
 #pragma warning(disable: 4927)
@@ -110,6 +126,32 @@ class CEFCryHandler : public CefClient, public CefLifeSpanHandler, public CefCon
 
         virtual bool OnJSDialog( CefRefPtr<CefBrowser> browser, const CefString& origin_url, const CefString& accept_lang, JSDialogType dialog_type, const CefString& message_text, const CefString& default_prompt_text, CefRefPtr<CefJSDialogCallback> callback, bool& suppress_message )
         {
+            // pages push the rects of their focusable elements for the virtual cursor: prompt( "cm5_snap_rects", "x y w h x y w h ..." )
+            if ( dialog_type == JSDIALOGTYPE_PROMPT && message_text.ToString() == "cm5_snap_rects" )
+            {
+                const std::string sValues = default_prompt_text.ToString();
+                std::vector<float> values;
+
+                for ( const char* pValue = sValues.c_str(); *pValue; )
+                {
+                    char* pEnd = nullptr;
+                    const float fValue = float( strtod( pValue, &pEnd ) );
+
+                    if ( pEnd == pValue )
+                    {
+                        ++pValue;
+                        continue;
+                    }
+
+                    values.push_back( fValue );
+                    pValue = pEnd;
+                }
+
+                _renderHandler->SetSnapRects( values.empty() ? nullptr : &values[0], int( values.size() / 4 ) );
+                callback->Continue( true, CefString() );
+                return true;
+            }
+
             string text = message_text.ToString().c_str();
             HTML5Plugin::gPlugin->LogAlways( "JSDialog: %s", text.c_str() );
 
@@ -126,10 +168,17 @@ class CEFCryHandler : public CefClient, public CefLifeSpanHandler, public CefCon
 
         virtual void OnAfterCreated( CefRefPtr<CefBrowser> browser )
         {
-            if ( HTML5Plugin::gPlugin->m_sCEFDebugURL.empty() )
+            _renderHandler->SetBrowser( browser ); // remember browser
+
+            // the view was destroyed while its browser was created
+            if ( _closing )
             {
-                HTML5Plugin::gPlugin->m_refCEFFrame = browser->GetMainFrame(); // remember frame
+                browser->GetHost()->CloseBrowser( true );
+                return;
+            }
 
+            if ( HTML5Plugin::gPlugin->m_sCEFDebugURL.empty() )
+            {
                 HTML5Plugin::gPlugin->m_sCEFDebugURL = browser->GetHost()->GetDevToolsURL( false ).ToString().c_str(); // browser->GetHost()->GetDevToolsURL( false ).ToString();
                 HTML5Plugin::gPlugin->LogAlways( "Devtools URL: %s", HTML5Plugin::gPlugin->m_sCEFDebugURL.c_str() );
 
@@ -139,10 +188,11 @@ class CEFCryHandler : public CefClient, public CefLifeSpanHandler, public CefCon
 
         virtual void OnBeforeClose( CefRefPtr<CefBrowser> browser )
         {
-            if ( HTML5Plugin::gPlugin->m_refCEFFrame.get() == nullptr || HTML5Plugin::gPlugin->m_refCEFFrame->GetBrowser()->GetIdentifier() == browser->GetIdentifier() )
+            _renderHandler->SetBrowser( nullptr );
+
+            if ( HTML5Plugin::gPlugin->m_sCEFDebugURL == browser->GetHost()->GetDevToolsURL( false ).ToString().c_str() )
             {
                 HTML5Plugin::gPlugin->m_sCEFDebugURL = "";
-                HTML5Plugin::gPlugin->m_refCEFFrame = nullptr;
             }
         };
 
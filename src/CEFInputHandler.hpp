@@ -8,7 +8,11 @@
 #include <cef_app.h>
 #include <cef_client.h>
 
-#include <CEFInputHandler.hpp>
+#include <CEFRenderHandler.hpp>
+#include <InputRing.h>
+#include <InputBatch.h>
+#include <KeyTable.h>
+#include <VirtualCursor.h>
 
 /** @brief CryENGINE CEF input handler class */
 class CEFCryInputHandler :
@@ -51,6 +55,15 @@ class CEFCryInputHandler :
             int modifiers; //!< key modefiers
             int key; //!< the key itself
 
+            SCryInputEvent()
+            {
+                type = Position;
+                d.x = 0;
+                d2.y = 0;
+                modifiers = 0;
+                key = 0;
+            };
+
             SCryInputEvent( eCryIputType t, int _d, int _d2 )
             {
                 type = t;
@@ -72,11 +85,19 @@ class CEFCryInputHandler :
             SCryInputEvent( const SInputEvent& ev );
         };
 
-        std::queue<SCryInputEvent*> m_qEvents; //!< all queued input events
+        enum
+        {
+            eMaxQueuedEvents = 1024, //!< capacity of the event ring
+        };
+
+        HTML5Plugin::CInputRing<SCryInputEvent, eMaxQueuedEvents> m_events; //!< input events queued by the input and hardware mouse callbacks
+        uint32 m_nDroppedReported; //!< dropped events already logged
+        SCryInputEvent m_batch[eMaxQueuedEvents]; //!< events of the current frame (main thread)
+        HTML5Plugin::CKeyTable m_keyTable; //!< key and modifier translation
 
-        float m_scaleEmulation; //!< scale for analog pad emuolation
-        float m_xEmulation; //!< emulation x pos
-        float m_yEmulation; //!< emulation y pos
+        HTML5Plugin::CVirtualCursor m_cursor; //!< pointer driven by the controller stick
+        float m_xEmulation; //!< controller stick x deflection
+        float m_yEmulation; //!< controller stick y deflection (down is positive)
         float m_xPosition; //!< hardware x pos
         float m_yPosition; //!< hardware y pos
         bool m_leftMB; //!< true when left mouse button pressed
@@ -88,7 +109,6 @@ class CEFCryInputHandler :
 
     public:
         CEFCryInputHandler() :
-            m_scaleEmulation( 500 ), // max 500 px per second when using controller mouse emulation
             m_xEmulation( 0.0 ),
             m_yEmulation( 0.0 ),
             m_xPosition( 0.0 ),
@@ -97,8 +117,11 @@ class CEFCryInputHandler :
             m_middleMB( false ),
             m_rightMB( false ),
             m_bExclusive( true ),
-            m_nMode( 0 )
+            m_nMode( 0 ),
+            m_nDroppedReported( 0 )
         {
+            BuildKeyTable();
+
             gEnv->pGame->GetIGameFramework()->RegisterListener( this, HTML5Plugin::gPlugin->GetName(), FRAMEWORKLISTENERPRIORITY_DEFAULT );
             gEnv->pSystem->GetISystemEventDispatcher()->RegisterListener( this );
             gEnv->pHardwareMouse->AddListener( this );
@@ -149,55 +172,77 @@ class CEFCryInputHandler :
 
             if ( m_nMode == 3 )
             {
-                m_qEvents.push( new SCryInputEvent( Position, m_xPosition, m_yPosition ) );
+                m_events.Push( SCryInputEvent( Position, m_xPosition, m_yPosition ) );
 
                 switch ( eHardwareMouseEvent )
                 {
                     case HARDWAREMOUSEEVENT_LBUTTONDOWN:
-                        m_qEvents.push( new SCryInputEvent( Click, eIS_Pressed, eKI_Mouse1 ) );
+                        m_events.Push( SCryInputEvent( Click, eIS_Pressed, eKI_Mouse1 ) );
                         break;
 
                     case HARDWAREMOUSEEVENT_LBUTTONUP:
-                        m_qEvents.push( new SCryInputEvent( Click, eIS_Released, eKI_Mouse1 ) );
+                        m_events.Push( SCryInputEvent( Click, eIS_Released, eKI_Mouse1 ) );
                         break;
 
                     case HARDWAREMOUSEEVENT_LBUTTONDOUBLECLICK:
-                        m_qEvents.push( new SCryInputEvent( DoubleClick, eIS_Pressed, eKI_Mouse1 ) );
+                        m_events.Push( SCryInputEvent( DoubleClick, eIS_Pressed, eKI_Mouse1 ) );
                         break;
 
                     case HARDWAREMOUSEEVENT_RBUTTONDOWN:
-                        m_qEvents.push( new SCryInputEvent( Click, eIS_Pressed, eKI_Mouse2 ) );
+                        m_events.Push( SCryInputEvent( Click, eIS_Pressed, eKI_Mouse2 ) );
                         break;
 
                     case HARDWAREMOUSEEVENT_RBUTTONUP:
-                        m_qEvents.push( new SCryInputEvent( Click, eIS_Released, eKI_Mouse2 ) );
+                        m_events.Push( SCryInputEvent( Click, eIS_Released, eKI_Mouse2 ) );
                         break;
 
                     case HARDWAREMOUSEEVENT_RBUTTONDOUBLECLICK:
-                        m_qEvents.push( new SCryInputEvent( DoubleClick, eIS_Pressed, eKI_Mouse2 ) );
+                        m_events.Push( SCryInputEvent( DoubleClick, eIS_Pressed, eKI_Mouse2 ) );
                         break;
 
                     case HARDWAREMOUSEEVENT_MBUTTONDOWN:
-                        m_qEvents.push( new SCryInputEvent( Click, eIS_Pressed, eKI_Mouse3 ) );
+                        m_events.Push( SCryInputEvent( Click, eIS_Pressed, eKI_Mouse3 ) );
                         break;
 
                     case HARDWAREMOUSEEVENT_MBUTTONUP:
-                        m_qEvents.push( new SCryInputEvent( Click, eIS_Released, eKI_Mouse3 ) );
+                        m_events.Push( SCryInputEvent( Click, eIS_Released, eKI_Mouse3 ) );
                         break;
 
                     case HARDWAREMOUSEEVENT_MBUTTONDOUBLECLICK:
-                        m_qEvents.push( new SCryInputEvent( DoubleClick, eIS_Pressed, eKI_Mouse3 ) );
+                        m_events.Push( SCryInputEvent( DoubleClick, eIS_Pressed, eKI_Mouse3 ) );
                         break;
 
                     case HARDWAREMOUSEEVENT_WHEEL:
-                        m_qEvents.push( new SCryInputEvent( Scroll, wheelDelta, 0 ) );
+                        m_events.Push( SCryInputEvent( Scroll, wheelDelta, 0 ) );
                         break;
                 }
             }
         }
 
+        /** @brief fill the key and modifier tables (once, before input arrives) */
+        void BuildKeyTable()
+        {
+            // the portable translation keeps its own copy of these values
+            static_assert( HTML5Plugin::eKM_LCtrl == eMM_LCtrl && HTML5Plugin::eKM_LShift == eMM_LShift && HTML5Plugin::eKM_LAlt == eMM_LAlt
+                           && HTML5Plugin::eKM_LWin == eMM_LWin && HTML5Plugin::eKM_RCtrl == eMM_RCtrl && HTML5Plugin::eKM_RShift == eMM_RShift
+                           && HTML5Plugin::eKM_RAlt == eMM_RAlt && HTML5Plugin::eKM_RWin == eMM_RWin && HTML5Plugin::eKM_NumLock == eMM_NumLock
+                           && HTML5Plugin::eKM_CapsLock == eMM_CapsLock && HTML5Plugin::eKM_ScrollLock == eMM_ScrollLock, "modifier bits differ from EModifierMask" );
+            static_assert( HTML5Plugin::eKEF_CapsLockOn == EVENTFLAG_CAPS_LOCK_ON && HTML5Plugin::eKEF_ShiftDown == EVENTFLAG_SHIFT_DOWN
+                           && HTML5Plugin::eKEF_ControlDown == EVENTFLAG_CONTROL_DOWN && HTML5Plugin::eKEF_AltDown == EVENTFLAG_ALT_DOWN
+                           && HTML5Plugin::eKEF_NumLockOn == EVENTFLAG_NUM_LOCK_ON && HTML5Plugin::eKEF_IsLeft == EVENTFLAG_IS_LEFT
+                           && HTML5Plugin::eKEF_IsRight == EVENTFLAG_IS_RIGHT, "event flags differ from cef_event_flags_t" );
+
+#define HTML5_KEY_ID( name ) uint32( eKI_##name - KI_KEYBOARD_BASE ),
+            static const uint32 s_keyIds[HTML5Plugin::eDK_Count] = { HTML5_DEFAULT_KEYS( HTML5_KEY_ID ) };
+#undef HTML5_KEY_ID
+
+            m_keyTable.SetDefaultKeys( s_keyIds );
+            m_keyTable.SetModifiers( HTML5Plugin::GetModifierFlags );
+        }
+
         /**
         * @brief Convert CryENGINE input event to generalized input event
+        * Keys and modifiers are looked up in the key table, keys missing there fall back to their character as key code.
         * @param inputEvent inputEvent
         * @param event event
         * @param bChar if text input
@@ -205,14 +250,23 @@ class CEFCryInputHandler :
         */
         bool MapKeyEvent( const SInputEvent& inputEvent, SCryInputEvent& event, bool bChar )
         {
-            event.key = gEnv->pInput->GetInputCharAscii( inputEvent );
+            const HTML5Plugin::SKeyInfo& info = m_keyTable.GetKey( uint32( inputEvent.keyId - KI_KEYBOARD_BASE ) );
+
+            uint32 nFlags;
+
+            if ( !m_keyTable.GetModifiers( uint32( inputEvent.modifiers ), nFlags ) )
+            {
+                nFlags = HTML5Plugin::GetModifierFlags( uint32( inputEvent.modifiers ) );
+            }
+
+            event.modifiers = nFlags;
 
             // Requires printable character
             if ( bChar )
             {
                 // We only have ACP atm
                 char temp[2];
-                temp[0] = event.key;
+                temp[0] = gEnv->pInput->GetInputCharAscii( inputEvent );
                 temp[1] = 0;
 
                 // ACP to UCS-2
@@ -223,100 +277,17 @@ class CEFCryInputHandler :
                 {
                     event.key = inputEvent.inputChar;
                 }
-            }
-
-            event.d2.code = event.key;
-
-            event.modifiers = EVENTFLAG_NONE;
-            event.modifiers |= ( ( inputEvent.modifiers & eMM_Shift ) != 0 ) ? EVENTFLAG_SHIFT_DOWN : 0;
-            event.modifiers |= ( ( inputEvent.modifiers & eMM_Ctrl ) != 0 ) ? EVENTFLAG_CONTROL_DOWN : 0;
-            event.modifiers |= ( ( inputEvent.modifiers & eMM_Alt ) != 0 ) ?  EVENTFLAG_ALT_DOWN : 0;
-            event.modifiers |= ( ( inputEvent.modifiers & eMM_CapsLock ) != 0 ) ? EVENTFLAG_CAPS_LOCK_ON : 0;
-            event.modifiers |= ( ( inputEvent.modifiers & eMM_NumLock ) != 0 ) ? EVENTFLAG_NUM_LOCK_ON : 0;
-
-            event.modifiers |= ( ( inputEvent.modifiers & eMM_LShift ) || ( inputEvent.modifiers & eMM_LCtrl ) || ( inputEvent.modifiers & eMM_LAlt ) ) ? EVENTFLAG_IS_LEFT : 0;
-            event.modifiers |= ( ( inputEvent.modifiers & eMM_RShift ) || ( inputEvent.modifiers & eMM_RCtrl ) || ( inputEvent.modifiers & eMM_RAlt ) ) ? EVENTFLAG_IS_RIGHT : 0;
-
-            bool bPrintable = false;
-
-            switch ( EKeyId( inputEvent.keyId ) )
-            {
-                case eKI_Backspace:
-                    event.key = VK_BACK;
-                    break;
-
-                case eKI_Tab:
-                    event.key = VK_TAB;
-                    bPrintable = true;
-                    break;
-
-                case eKI_Enter:
-                    event.key = VK_RETURN;
-                    bPrintable = true;
-                    break;
 
-                case eKI_LShift:
-                    event.key = VK_LSHIFT;
-                    break;
-
-                case eKI_RShift:
-                    event.key = VK_RSHIFT;
-                    break;
-
-                case eKI_LCtrl:
-                    event.key = VK_LCONTROL;
-                    break;
-
-                case eKI_RCtrl:
-                    event.key = VK_RCONTROL;
-                    break;
-
-                case eKI_LAlt:
-                    event.key = VK_LMENU;
-                    break;
-
-                case eKI_RAlt:
-                    event.key = VK_RMENU;
-                    break;
-
-                case eKI_Escape:
-                    event.key = VK_ESCAPE;
-                    break;
-
-                case eKI_Left:
-                    event.key = VK_LEFT;
-                    break;
-
-                case eKI_Up:
-                    event.key = VK_UP;
-                    break;
-
-                case eKI_Right:
-                    event.key = VK_RIGHT;
-                    break;
-
-                case eKI_Down:
-                    event.key = VK_DOWN;
-                    break;
-
-                case eKI_Insert:
-                    event.key = VK_INSERT;
-                    break;
-
-                case eKI_Delete:
-                    event.key = VK_DELETE;
-                    break;
-
-                default:
-                    bPrintable = true;
+                event.d2.code = event.key;
             }
 
-            if ( !bChar )
+            else
             {
+                event.key = info.nKeyCode ? info.nKeyCode : gEnv->pInput->GetInputCharAscii( inputEvent );
                 event.d2.code = event.key;
             }
 
-            return bPrintable;
+            return info.bPrintable;
         }
 
         virtual bool OnInputEvent( const SInputEvent& ev )
@@ -347,7 +318,7 @@ class CEFCryInputHandler :
 
                         m_xPosition += ev.value;
 
-                        m_qEvents.push( new SCryInputEvent( Position, m_xPosition, m_yPosition ) );
+                        m_events.Push( SCryInputEvent( Position, m_xPosition, m_yPosition ) );
                         break;
 
                     case eKI_XI_ThumbLX: // XBOX Controller
@@ -365,7 +336,7 @@ class CEFCryInputHandler :
 
                         m_yPosition += ev.value;
 
-                        m_qEvents.push( new SCryInputEvent( Position, m_xPosition, m_yPosition ) );
+                        m_events.Push( SCryInputEvent( Position, m_xPosition, m_yPosition ) );
                         break;
 
                     case eKI_XI_ThumbLY: // XBOX Controller
@@ -378,7 +349,7 @@ class CEFCryInputHandler :
                     case eKI_XI_ThumbL:
                         if ( ev.state == eIS_Released || ev.state == eIS_Pressed )
                         {
-                            m_qEvents.push( new SCryInputEvent( Click, ev.state, eKI_Mouse1 ) );
+                            m_events.Push( SCryInputEvent( Click, ev.state, eKI_Mouse1 ) );
                         }
 
                         break;
@@ -388,7 +359,7 @@ class CEFCryInputHandler :
                     case eKI_XI_ThumbR:
                         if ( ev.state == eIS_Released || ev.state == eIS_Pressed )
                         {
-                            m_qEvents.push( new SCryInputEvent( Click, ev.state, eKI_Mouse2 ) );
+                            m_events.Push( SCryInputEvent( Click, ev.state, eKI_Mouse2 ) );
                         }
 
                         break;
@@ -397,7 +368,7 @@ class CEFCryInputHandler :
                     case eKI_Mouse3:
                         if ( ev.state == eIS_Released || ev.state == eIS_Pressed )
                         {
-                            m_qEvents.push( new SCryInputEvent( Click, ev.state, eKI_Mouse3 ) );
+                            m_events.Push( SCryInputEvent( Click, ev.state, eKI_Mouse3 ) );
                         }
 
                         break;
@@ -406,7 +377,7 @@ class CEFCryInputHandler :
                     case eKI_MouseWheelUp:
                         if ( ev.state == eIS_Pressed )
                         {
-                            m_qEvents.push( new SCryInputEvent( Scroll, 50, 0 ) );
+                            m_events.Push( SCryInputEvent( Scroll, 50, 0 ) );
                         }
 
                         break;
@@ -415,7 +386,7 @@ class CEFCryInputHandler :
                     case eKI_MouseWheelDown:
                         if ( ev.state == eIS_Pressed )
                         {
-                            m_qEvents.push( new SCryInputEvent( Scroll, -50, 0 ) );
+                            m_events.Push( SCryInputEvent( Scroll, -50, 0 ) );
                         }
 
                         break;
@@ -426,22 +397,17 @@ class CEFCryInputHandler :
             {
                 if ( ev.state == eIS_Released || ev.state == eIS_Pressed )
                 {
-                    SCryInputEvent* eva = new SCryInputEvent( Key, ev.state, 0 );
-                    MapKeyEvent( ev, *eva, false );
-                    m_qEvents.push( eva );
+                    SCryInputEvent eva( Key, ev.state, 0 );
+                    MapKeyEvent( ev, eva, false );
+                    m_events.Push( eva );
 
                     if ( ev.state == eIS_Pressed )
                     {
-                        eva = new SCryInputEvent( TextChar, ev.state, 0 );
+                        SCryInputEvent evc( TextChar, ev.state, 0 );
 
-                        if ( MapKeyEvent( ev, *eva, true ) )
+                        if ( MapKeyEvent( ev, evc, true ) )
                         {
-                            m_qEvents.push( eva );
-                        }
-
-                        else
-                        {
-                            delete eva;
+                            m_events.Push( evc );
                         }
                     }
                 }
@@ -450,47 +416,114 @@ class CEFCryInputHandler :
             return bRet;
         }
 
+        /** @return how BatchInput treats an event */
+        static HTML5Plugin::EInputBatchKind GetBatchKind( const SCryInputEvent& event )
+        {
+            switch ( event.type )
+            {
+                case Position:
+                    return HTML5Plugin::eIBK_Move;
+
+                case Scroll:
+                    return HTML5Plugin::eIBK_Wheel;
+
+                default:
+                    return HTML5Plugin::eIBK_Other;
+            }
+        }
+
+        /** @brief add the wheel delta of next to into */
+        static void MergeWheel( SCryInputEvent& into, const SCryInputEvent& next )
+        {
+            into.d.amount += next.d.amount;
+        }
+
         /**
         * @brief Scales the mouse position to screen size
+        * @param view the view receiving the input
         * @param[in,out] mouse mouse
         */
-        void ScaleMouse( CefMouseEvent& mouse )
+        void ScaleMouse( CEFCryRenderHandler& view, CefMouseEvent& mouse )
         {
             float x = 0.f, y = 0.f;
-            HTML5Plugin::gPlugin->ScaleCoordinates( mouse.x, mouse.y, x, y, true, true );
+            view.ScaleCoordinates( mouse.x, mouse.y, x, y, true, true );
             mouse.x = x;
             mouse.y = y;
         }
 
+        /** @brief drop all queued input events */
+        void ClearInput()
+        {
+            m_events.Clear();
+        }
+
         /**
-        * @brief push all queued input events to CEF
-        * @param frame the browser to push the events too
+        * @brief move the virtual cursor by the controller stick, at most one position event per frame
+        * The cursor stays on the screen. When the stick is released the cursor snaps to the closest element the page registered.
+        * @param view the view receiving the input
+        * @param fFrameTime frame time in seconds
         */
-        void GetInput( CefRefPtr<CefFrame> frame )
+        void UpdateVirtualCursor( CEFCryRenderHandler& view, float fFrameTime )
         {
-            float frameTime = gEnv->pTimer->GetFrameTime( ITimer::ETimer::ETIMER_UI );
+            HTML5Plugin::SVirtualCursorSettings settings;
+            settings.fMaxSpeed = HTML5Plugin::gPlugin->cm5_cursor_speed;
+            settings.fDeadZone = HTML5Plugin::gPlugin->cm5_cursor_deadzone;
+            settings.fCurve = HTML5Plugin::gPlugin->cm5_cursor_curve;
+            settings.fAccelTime = HTML5Plugin::gPlugin->cm5_cursor_accel;
+
+            m_cursor.SetSettings( settings );
+            m_cursor.SetStick( m_xEmulation, m_yEmulation );
 
-            if ( fabsf( m_xEmulation ) > 0.01f || fabsf( m_yEmulation ) > 0.01f )
+            int nViewportX, nViewportY, nWidth, nHeight;
+            gEnv->pRenderer->GetViewport( &nViewportX, &nViewportY, &nWidth, &nHeight );
+            m_cursor.SetBounds( 0.0f, 0.0f, float( nWidth - 1 ), float( nHeight - 1 ) );
+
+            float x = m_xPosition;
+            float y = m_yPosition;
+
+            if ( gEnv->pHardwareMouse )
             {
-                float cx = m_xEmulation * m_scaleEmulation * frameTime;
-                float cy = m_yEmulation * m_scaleEmulation * frameTime;
+                gEnv->pHardwareMouse->GetHardwareMouseClientPosition( &x, &y );
+            }
 
-                if ( gEnv->pHardwareMouse )
+            bool bMoved = m_cursor.Update( fFrameTime, x, y );
+
+            if ( m_cursor.ConsumeRelease() && HTML5Plugin::gPlugin->cm5_cursor_snap > 0.0f )
+            {
+                if ( view.FindSnapTarget( x, y, HTML5Plugin::gPlugin->cm5_cursor_snap, x, y ) )
                 {
-                    gEnv->pHardwareMouse->GetHardwareMouseClientPosition( &m_xPosition, &m_yPosition );
+                    m_cursor.Clamp( x, y );
+                    bMoved = true;
                 }
+            }
 
-                m_xPosition += cx;
-                m_yPosition += cy;
+            if ( !bMoved )
+            {
+                return;
+            }
 
-                if ( gEnv->pHardwareMouse )
-                {
-                    gEnv->pHardwareMouse->SetHardwareMouseClientPosition( m_xPosition, m_yPosition );
-                }
+            m_xPosition = x;
+            m_yPosition = y;
 
-                m_qEvents.push( new SCryInputEvent( Position, m_xPosition, m_yPosition ) );
+            if ( gEnv->pHardwareMouse )
+            {
+                gEnv->pHardwareMouse->SetHardwareMouseClientPosition( m_xPosition, m_yPosition );
             }
 
+            m_events.Push( SCryInputEvent( Position, m_xPosition, m_yPosition ) );
+        }
+
+        /**
+        * @brief push all queued input events to CEF
+        * @param view the view to push the events to
+        * @param browser the browser of the view
+        */
+        void GetInput( CEFCryRenderHandler& view, CefRefPtr<CefBrowser> browser )
+        {
+            float frameTime = gEnv->pTimer->GetFrameTime( ITimer::ETimer::ETIMER_UI );
+
+            UpdateVirtualCursor( view, frameTime );
+
             CefMouseEvent mouse;
             mouse.x = m_xPosition;
             mouse.y = m_yPosition;
@@ -500,23 +533,38 @@ class CEFCryInputHandler :
             mouse.modifiers |= m_middleMB ? EVENTFLAG_MIDDLE_MOUSE_BUTTON : 0;
             mouse.modifiers |= m_rightMB ? EVENTFLAG_RIGHT_MOUSE_BUTTON : 0;
 
-            ScaleMouse( mouse );
+            ScaleMouse( view, mouse );
 
-            CefRefPtr<CefBrowserHost> bh = frame->GetBrowser()->GetHost();
+            CefRefPtr<CefBrowserHost> bh = browser->GetHost();
 
             CefKeyEvent cefKey;
 
+            // drain the queue and collapse moves and wheel ticks, every call into the browser host is an IPC
+            size_t nEvents = 0;
+
+            while ( nEvents < eMaxQueuedEvents && m_events.Pop( m_batch[nEvents] ) )
+            {
+                ++nEvents;
+            }
+
+            size_t nBatched = nEvents;
+
+            if ( HTML5Plugin::gPlugin->cm5_input_batch )
+            {
+                nBatched = HTML5Plugin::BatchInput( m_batch, nEvents, GetBatchKind, MergeWheel );
+            }
+
             // Inject events
-            while ( !m_qEvents.empty() )
+            for ( size_t i = 0; i < nBatched; ++i )
             {
-                SCryInputEvent& item = *m_qEvents.front();
+                const SCryInputEvent& item = m_batch[i];
 
                 switch ( item.type )
                 {
                     case Position:
                         mouse.x = item.d.x;
                         mouse.y = item.d2.y;
-                        ScaleMouse( mouse );
+                        ScaleMouse( view, mouse );
                         //HTML5Plugin::gPlugin->LogAlways( "Move: %d, %d", mouse.x, mouse.y );
 
                         bh->SendMouseMoveEvent( mouse, false );
@@ -617,8 +665,17 @@ class CEFCryInputHandler :
                         bh->SendFocusEvent( true );
                         break;
                 }
+            }
+
+            HTML5Plugin::gPlugin->m_stats.Record( HTML5Plugin::eUIS_InputEvents, nEvents );
+            HTML5Plugin::gPlugin->m_stats.Record( HTML5Plugin::eUIS_InputSent, nBatched );
 
-                m_qEvents.pop();
+            const uint32 nDropped = m_events.GetCounters().nDropped;
+
+            if ( nDropped != m_nDroppedReported )
+            {
+                HTML5Plugin::gPlugin->LogWarning( "Input: %u events dropped, the queue holds %u", nDropped - m_nDroppedReported, m_events.GetCapacity() );
+                m_nDroppedReported = nDropped;
             }
         }
 
@@ -631,13 +688,13 @@ class CEFCryInputHandler :
                 case ESYSTEM_EVENT_ACTIVATE:
                     if ( !wparam )
                     {
-                        m_qEvents.push( new SCryInputEvent( LostFocus, 0, 0 ) );
+                        m_events.Push( SCryInputEvent( LostFocus, 0, 0 ) );
                     }
 
                     break;
 
                 case ESYSTEM_EVENT_CHANGE_FOCUS: // wparam is not 0 is focused, 0 if not focused
-                    m_qEvents.push( new SCryInputEvent( wparam ? GotFocus : LostFocus, 0, 0 ) );
+                    m_events.Push( SCryInputEvent( wparam ? GotFocus : LostFocus, 0, 0 ) );
                     break;
             }
         }
@@ -649,7 +706,17 @@ class CEFCryInputHandler :
                 return;
             }
 
-            GetInput( HTML5Plugin::gPlugin->m_refCEFFrame );
+            // input goes to the focused view
+            CefRefPtr<CEFCryRenderHandler> pView = HTML5Plugin::gPlugin->GetViewRenderer( HTML5Plugin::gPlugin->GetFocusView() );
+            CefRefPtr<CefBrowser> browser = pView ? pView->GetBrowser() : nullptr;
+
+            if ( browser.get() == nullptr )
+            {
+                ClearInput();
+                return;
+            }
+
+            GetInput( *pView, browser );
         }
 
         virtual void OnSaveGame( ISaveGame* pSaveGame )
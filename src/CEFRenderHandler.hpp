@@ -7,63 +7,56 @@
 #include <cef_process_util.h>
 #include <cef_runnable.h>
 
+#include <mutex>
+
 #include <CPluginHTML5.h>
 #include <FullscreenTriangleDrawer.h>
-
-#include <d3d11.h>
-
-//#define USE_MAPPED // define when using mapped memory (not performant)
-
-//#include "../GameSDK/GameDll/MyFiles/Camera/MeasureTime.hpp"
-
-#define TEXTURE_FLAGS FILTER_LINEAR | FT_DONT_STREAM | FT_NOMIPS // texture flags
+#include <SurfacePipeline.h>
+#include <D3D11SurfaceDevice.h>
+#include <D3D11Compositor.h>
+#include <CoverageRects.h>
+#include <CompressionWorker.h>
+#include <SnapGrid.h>
+#include <ResizeDebounce.h>
 
 /** @brief CryENGINE & Direct3D renderer handler */
-class CEFCryRenderHandler : public CefRenderHandler, public D3DPlugin::ID3DEventListener
+class CEFCryRenderHandler : public CefRenderHandler
 {
-    public:
-        int _windowHeight; //!< the frame height in pixels
-        int _windowWidth; //!< the frame width in pixels
-
     private:
-        const void* _buffer; //!< the CEF frame buffer (not synchronized to reduce overhead)
-
-        ID3D11Texture2D* _texture; //!< the Direct3D 11 texture
-        ITexture* _itexture;  //!< the CryENGINE texture
-        ID3D11ShaderResourceView* _srv; //!< the Direct3D 11 texture resource
+        HTML5Plugin::CResizeDebounce _windowSize; //!< the frame size in pixels, read by CEF on its UI thread
+        HTML5Plugin::CSurfacePipeline _pipeline; //!< paint to texture pipeline (software rendering)
+        HTML5Plugin::CSharedFrameSource _shared; //!< shared textures (accelerated rendering)
+        HTML5Plugin::IFrameSource* _source; //!< the frame source in use, fixed when the handler is created
+        HTML5Plugin::CD3D11SurfaceDevice _device; //!< the texture the frames are brought onto
+        HTML5Plugin::CD3D11AtlasDevice _atlasDevice; //!< the atlas area the pipeline uploads into instead
+        bool _inAtlas; //!< the surface is uploaded into the atlas
+        bool _atlasFull; //!< the atlas had no room, use an own texture until the size changes
+        bool _hidden; //!< true while CEF was told the surface is hidden
+
+        int _fixedWidth; //!< view size, 0 follows the viewport
+        int _fixedHeight;
+        float _x; //!< position of a fixed size view in viewport pixels
+        float _y;
+        HTML5Plugin::CWorldQuad _world; //!< quad in the world the view is shown on (instead of the screen)
+        float _rate; //!< maximum frame rate of this view, less than 0 uses cm5_ui_fps
+        bool _active; //!< view is drawn and painted
+
+        std::mutex _browserLock; //!< guards _browser
+        CefRefPtr<CefBrowser> _browser; //!< the browser painting into this handler (set on the CEF UI thread)
+
+        std::mutex _snapLock; //!< guards _snapGrid
+        HTML5Plugin::CSnapGrid _snapGrid; //!< focusable elements the virtual cursor snaps to (view pixels)
 
         HTML5Plugin::CFullscreenTriangleDrawer _triangledrawer; //!< the draw helper
+        HTML5Plugin::CTileMask _coveredTiles; //!< tiles of a fullscreen view with visible pixels
+        HTML5Plugin::CCoverageRects _coveredRects; //!< visible parts of a fullscreen view drawn instead of the whole screen
 
-        int _dx; //!< dirtyrect start x
-        int _dy; //!< dirtyrect start y
-        int _dy2; //!< dirtyrect end x
-        int _dx2; //!< dirtyrect end y
-
-    private:
-        /**
-        * @brief reset dirty rect
-        */
-        void resetdirty()
-        {
-            _dx = 10000;
-            _dy = 10000;
-            _dy2 = 0;
-            _dx2 = 0;
-        }
-
-        /**
-        * @brief increase dirty rect area
-        */
-        void dirtyarea( int x, int y, int w, int h )
-        {
-            int x2 = x + w;
-            int y2 = y + h;
-
-            _dx = min( _dx, x );
-            _dy = min( _dy, y );
-            _dx2 = max( _dx2, x2 );
-            _dy2 = max( _dy2, y2 );
-        }
+        std::shared_ptr<HTML5Plugin::SCompressionJob> _compressJob; //!< BC3 encoding of the current frame in flight
+        uint32 _idleSequence; //!< paint sequence of the frame presented last
+        int _idleFrames; //!< frames presented since the frame last changed
+        int _compressFailedWidth; //!< size the device refused a compressed copy of, 0 while none failed
+        int _compressFailedHeight;
+        int _compressFailedSetting; //!< cm5_compress when it failed, changing the cvar tries again
 
     public:
         /** @brief see interface */
@@ -74,6 +67,56 @@ class CEFCryRenderHandler : public CefRenderHandler, public D3DPlugin::ID3DEvent
             int x, y, width, height;
             gEnv->pRenderer->GetViewport( &x, &y, &width, &height );
 
+            int nWindowWidth, nWindowHeight;
+            _windowSize.GetSize( nWindowWidth, nWindowHeight );
+
+            // world views map the ray through the cursor onto their quad
+            if ( _world.IsEnabled() )
+            {
+                if ( !bCERenderer )
+                {
+                    fX *= width;
+                    fY *= height;
+                }
+
+                Vec3 vOrigin, vDir;
+                HTML5Plugin::CWorldQuad::GetCameraRay( gEnv->pSystem->GetViewCamera(), fX, fY, width, height, vOrigin, vDir );
+
+                float fU, fV;
+                _world.Intersect( vOrigin, vDir, fU, fV );
+
+                if ( bLimit )
+                {
+                    fU = clamp_tpl( fU, 0.0f, 1.0f );
+                    fV = clamp_tpl( fV, 0.0f, 1.0f );
+                }
+
+                foX = fU * nWindowWidth;
+                foY = fV * nWindowHeight;
+                return;
+            }
+
+            // fixed size views are shown unscaled at their position
+            if ( IsFixedSize() )
+            {
+                if ( !bCERenderer )
+                {
+                    fX *= width;
+                    fY *= height;
+                }
+
+                foX = fX - _x;
+                foY = fY - _y;
+
+                if ( bLimit )
+                {
+                    foX = clamp_tpl( foX, 0.0f, float( nWindowWidth ) );
+                    foY = clamp_tpl( foY, 0.0f, float( nWindowHeight ) );
+                }
+
+                return;
+            }
+
             // make relative for scaling
             if ( bCERenderer )
             {
@@ -93,204 +136,552 @@ class CEFCryRenderHandler : public CefRenderHandler, public D3DPlugin::ID3DEvent
             //HTML5Plugin::gPlugin->LogAlways( "3: X %f Y %f", fX, fY );
 
             // finally transform into CEF/texture coordinates
-            foX = fX * _windowWidth;
-            foY = fY * _windowHeight;
+            foX = fX * nWindowWidth;
+            foY = fY * nWindowHeight;
 
             //HTML5Plugin::gPlugin->LogAlways( "4: X %f Y %f", foX, foY );
         }
 
-        // D3DPlugin::ID3DEventListener
-        virtual void OnPostPresent() {};
-        virtual void OnPreReset() {};
-        virtual void OnPostReset() {};
-        virtual void OnPostBeginScene() {};
+        /**
+        * @brief get the mapping of viewport pixels to view pixels, the linear part of ScaleCoordinates (unlimited)
+        * @param[out] fScaleX out = in * scale + offset
+        * @param[out] fOffsetX
+        * @param[out] fScaleY
+        * @param[out] fOffsetY
+        * @return false for world views, their mapping isn't linear
+        */
+        bool GetScreenTransform( float& fScaleX, float& fOffsetX, float& fScaleY, float& fOffsetY )
+        {
+            int x, y, width, height;
+            gEnv->pRenderer->GetViewport( &x, &y, &width, &height );
 
-        virtual void OnPrePresent()
+            if ( _world.IsEnabled() || width <= 0 || height <= 0 )
+            {
+                return false;
+            }
+
+            if ( IsFixedSize() )
+            {
+                fScaleX = fScaleY = 1.0f;
+                fOffsetX = -_x;
+                fOffsetY = -_y;
+            }
+
+            else
+            {
+                fScaleX = float( _windowSize.GetWidth() ) / width;
+                fScaleY = float( _windowSize.GetHeight() ) / height;
+                fOffsetX = fOffsetY = 0.0f;
+            }
+
+            return true;
+        }
+
+        /**
+        * @brief get the surface size for the current viewport
+        * @param[out] nWidth surface width in pixels
+        * @param[out] nHeight surface height in pixels
+        */
+        static void GetViewportSize( int& nWidth, int& nHeight )
         {
-//#ifdef _DEBUG
-//            profileFunc( "html5_dx_measurement", [&]()
-//            {
-//#endif
+            int x, y, width, height;
+            gEnv->pRenderer->GetViewport( &x, &y, &width, &height );
 
-                if ( HTML5Plugin::gPlugin->cm5_active == 0.0f )
-                {
-                    return;
-                }
+            float fScale = clamp_tpl( HTML5Plugin::gPlugin->cm5_scale, 0.1f, 2.0f );
 
-                // Create resources when they dont exist yet
-                if ( !_texture )
-                {
-                    CreateResources();
-                }
+            nWidth = clamp_tpl( int( width * fScale + 0.5f ), 16, 8192 );
+            nHeight = clamp_tpl( int( height * fScale + 0.5f ), 16, 8192 );
+        }
 
-                // When something to update exists
-                if ( _texture && _buffer && _srv && _dx2 > 0 && _dy2 > 0 )
-                {
-                    UpdateResources();
-                }
+        /**
+        * @brief get the surface size this view should have
+        * @param[out] nWidth surface width in pixels
+        * @param[out] nHeight surface height in pixels
+        */
+        void GetDesiredSize( int& nWidth, int& nHeight )
+        {
+            if ( _fixedWidth > 0 && _fixedHeight > 0 )
+            {
+                nWidth = _fixedWidth;
+                nHeight = _fixedHeight;
+            }
+
+            else
+            {
+                GetViewportSize( nWidth, nHeight );
+            }
+        }
+
+        /** @brief set the view size, 0 follows the viewport */
+        void SetSize( int nWidth, int nHeight )
+        {
+            _fixedWidth = clamp_tpl( nWidth, 0, 8192 );
+            _fixedHeight = clamp_tpl( nHeight, 0, 8192 );
+            _atlasFull = false;
+        }
+
+        /** @return true when the view has a fixed size and is shown at its position instead of covering the viewport */
+        bool IsFixedSize() const
+        {
+            return _fixedWidth > 0 && _fixedHeight > 0;
+        }
+
+        /** @brief set the position of a fixed size view in viewport pixels */
+        void SetPosition( float fX, float fY )
+        {
+            _x = fX;
+            _y = fY;
+        }
+
+        /** @brief show the view on a quad in the world (render thread or view lock held), a width of 0 shows it on the screen again */
+        void SetWorldQuad( const Matrix34& tm, float fWidth, float fHeight )
+        {
+            _world.Set( tm, fWidth, fHeight );
+        }
+
+        /** @return quad in the world the view is shown on */
+        const HTML5Plugin::CWorldQuad& GetWorldQuad() const
+        {
+            return _world;
+        }
+
+        /**
+        * @brief set the rects the virtual cursor snaps to (any thread)
+        * @param pRects x, y, width and height of each rect in view pixels
+        * @param nRects number of rects
+        */
+        void SetSnapRects( const float* pRects, int nRects )
+        {
+            std::vector<HTML5Plugin::SDirtyRect> rects( max( nRects, 0 ) );
 
-                // When something to draw exists
-                if ( _srv )
+            for ( int i = 0; i < nRects; ++i )
+            {
+                const float* pRect = pRects + i * 4;
+                rects[i] = HTML5Plugin::SDirtyRect( int( pRect[0] ), int( pRect[1] ), int( pRect[0] + pRect[2] ), int( pRect[1] + pRect[3] ) );
+            }
+
+            std::lock_guard<std::mutex> lock( _snapLock );
+            _snapGrid.Build( rects.empty() ? nullptr : &rects[0], nRects );
+        }
+
+        /**
+        * @brief find the element the virtual cursor snaps to (main thread)
+        * @param fX cursor position in viewport pixels
+        * @param fY
+        * @param fRadius largest distance to the element in view pixels
+        * @param[out] foX center of the element in viewport pixels
+        * @param[out] foY
+        * @return false when no element is close enough or the view is shown in the world
+        */
+        bool FindSnapTarget( float fX, float fY, float fRadius, float& foX, float& foY )
+        {
+            float fScaleX, fOffsetX, fScaleY, fOffsetY;
+
+            if ( !GetScreenTransform( fScaleX, fOffsetX, fScaleY, fOffsetY ) || fScaleX <= 0.0f || fScaleY <= 0.0f )
+            {
+                return false;
+            }
+
+            HTML5Plugin::SDirtyRect rect;
+            {
+                std::lock_guard<std::mutex> lock( _snapLock );
+
+                if ( !_snapGrid.FindNearest( fX * fScaleX + fOffsetX, fY * fScaleY + fOffsetY, fRadius, rect ) )
                 {
-                    _triangledrawer.Draw( _srv );
+                    return false;
                 }
+            }
 
-//#ifdef _DEBUG
-//            },
-//            HTML5Plugin::gPlugin->cm5_active == 2 );
-//#endif
-        };
+            foX = ( ( rect.x + rect.x2 ) * 0.5f - fOffsetX ) / fScaleX;
+            foY = ( ( rect.y + rect.y2 ) * 0.5f - fOffsetY ) / fScaleY;
+            return true;
+        }
+
+        /** @brief set the maximum frame rate of the view, less than 0 uses cm5_ui_fps */
+        void SetFrameRate( float fRate )
+        {
+            _rate = fRate;
+        }
 
-        /** @brief update the CryENGINE texture based on the last CEF frame */
-        void UpdateResources()
+        /** @brief set the view active (drawn and painted) */
+        void SetActive( bool bActive )
         {
-            ID3D11Device* pDevice = static_cast<ID3D11Device*>( HTML5Plugin::gD3DSystem->GetDevice() );
+            _active = bActive;
+        }
 
-            ID3D11Texture2D* pTexture = static_cast<ID3D11Texture2D*>( _texture );
+        /** @return true when the view is active */
+        bool IsActive() const
+        {
+            return _active && HTML5Plugin::gPlugin->cm5_active != 0.0f;
+        }
 
-            ID3D11DeviceContext* pContext = NULL;
-            pDevice->GetImmediateContext( &pContext );
+        /** @brief set the browser painting into this handler (CEF UI thread) */
+        void SetBrowser( CefRefPtr<CefBrowser> browser )
+        {
+            std::lock_guard<std::mutex> lock( _browserLock );
+            _browser = browser;
+        }
 
-            const int bytesPerRow = _windowWidth * 4;
+        /** @return the browser painting into this handler (nullptr until it was created) */
+        CefRefPtr<CefBrowser> GetBrowser()
+        {
+            std::lock_guard<std::mutex> lock( _browserLock );
+            return _browser;
+        }
 
-#ifdef USE_MAPPED
-            D3D11_MAPPED_SUBRESOURCE mapped;
-            HRESULT hr = pContext->Map( pTexture, 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped ); // D3D11_MAP_WRITE doesn't work so we will not update all so don't use USE_MAPPED
+        /** @return host of the browser painting into this handler (nullptr until it was created) */
+        CefRefPtr<CefBrowserHost> GetHost()
+        {
+            CefRefPtr<CefBrowser> browser = GetBrowser();
+            return browser.get() ? browser->GetHost() : CefRefPtr<CefBrowserHost>();
+        }
 
-            if ( FAILED( hr ) )
+        /** @brief tell CEF whether the surface is visible so it stops painting while hidden */
+        void SetHidden( bool bHidden )
+        {
+            if ( bHidden == _hidden )
             {
-                HTML5Plugin::gPlugin->LogAlways( "Fail Map hr=%d", hr );
+                return;
             }
 
-            else
+            CefRefPtr<CefBrowserHost> host = GetHost();
+
+            if ( host.get() != nullptr )
             {
-                int h = _dy2 - dy;
-                int w = _dx2 - dx;
+                _hidden = bHidden;
+                host->WasHidden( bHidden );
+            }
+        }
 
-                const int _pitchDst = mapped.RowPitch + _dx * 4;
-                int offsetDst = mapped.RowPitch * _dy;
-                char* pDest = static_cast<char*>( mapped.pData );
-                const char* pSrc = ( const char* )_buffer;
+        /** @brief resize the CEF surface when the viewport or scale changed and the new size was stable for cm5_resize_delay */
+        void UpdateSurfaceSize()
+        {
+            int nWidth, nHeight;
+            GetDesiredSize( nWidth, nHeight );
 
-                const size_t size = _windowWidth * _windowHeight * 4;
+            if ( !_windowSize.Update( nWidth, nHeight, gEnv->pTimer->GetAsyncCurTime(), HTML5Plugin::gPlugin->cm5_resize_delay ) )
+            {
+                return;
+            }
 
-                int offsetSrc = bytesPerRow * _dy;
+            CefRefPtr<CefBrowserHost> host = GetHost();
 
-                const int _bytesRow = w * 4;
-                const int _pitchSrc = bytesPerRow + _dx * 4;
+            if ( host.get() == nullptr )
+            {
+                return;
+            }
 
-                if ( _windowWidth * 4 == mapped.RowPitch && h == _windowHeight && w == _windowWidth )
-                {
-                    ::memcpy( pDest, pSrc, size );
-                }
+            HTML5Plugin::gPlugin->LogAlways( "Resize: %dx%d -> %dx%d", _windowSize.GetWidth(), _windowSize.GetHeight(), nWidth, nHeight );
 
-                else
-                {
-                    pSrc += _dy * bytesPerRow +  _dx * 4;
-                    pDest += _dy * mapped.RowPitch + _dx * 4;
+            // CEF asks GetViewRect for the new size and repaints, the texture follows once such a frame arrives
+            _windowSize.Apply();
+            host->WasResized();
+        }
+
+        /**
+        * @brief reduce the alpha coverage of the view to the rects worth drawing (render thread)
+        * @param nWidth size of the presented frame
+        * @param nHeight
+        * @return false when the whole surface should be drawn (coverage disabled, unknown or too high)
+        */
+        bool BuildCoveredRects( int nWidth, int nHeight )
+        {
+            const HTML5Plugin::CAlphaCoverage* pCoverage = _source->GetCoverage();
+            const float fMaxRatio = HTML5Plugin::gPlugin->cm5_partial;
+
+            if ( !pCoverage || fMaxRatio <= 0.0f )
+            {
+                return false;
+            }
+
+            pCoverage->GetCoveredTiles( _coveredTiles, 1 );
+
+            // the coverage follows the newest paint, during a resize it doesn't match the presented frame
+            if ( _coveredTiles.GetWidth() != nWidth || _coveredTiles.GetHeight() != nHeight )
+            {
+                return false;
+            }
+
+            return _coveredRects.Build( _coveredTiles, 64, fMaxRatio );
+        }
+
+        /**
+        * @brief swap the surface of a view that stopped changing for a BC3 copy encoded on the worker (render thread)
+        * The device goes back to the uncompressed texture by itself with the next upload.
+        */
+        void UpdateCompression()
+        {
+            const int nIdleFrames = HTML5Plugin::gPlugin->cm5_compress;
+            const HTML5Plugin::CFrameMailbox::SFrame& front = _pipeline.GetFront();
+
+            if ( _source != &_pipeline || front.nSequence != _idleSequence )
+            {
+                _idleSequence = front.nSequence;
+                _idleFrames = 0;
+                HTML5Plugin::CCompressionWorker::Cancel( _compressJob );
+                _compressJob.reset();
+                return;
+            }
 
-                    for ( int row = _dy; row < _dy2; ++row )
+            if ( _compressJob )
+            {
+                if ( _compressJob->IsDone() )
+                {
+                    // don't encode and copy the frame again every frame when the device can't take it
+                    if ( !_device.SetCompressed( &_compressJob->blocks[0], _compressJob->nWidth, _compressJob->nHeight ) )
                     {
-                        ::memcpy( pDest, pSrc, _bytesRow );
-                        pSrc += _pitchSrc;
-                        pDest += _pitchDst;
+                        _compressFailedWidth = _compressJob->nWidth;
+                        _compressFailedHeight = _compressJob->nHeight;
+                        _compressFailedSetting = nIdleFrames;
                     }
-                }
 
-                pContext->Unmap( pTexture, 0 );
+                    _compressJob.reset();
+                }
 
-                resetdirty();
+                return;
             }
 
-#else
-            D3D11_BOX box = {0}; // http://msdn.microsoft.com/en-us/library/windows/desktop/ff476486%28v=vs.85%29.aspx
-            box.front = 0;
-            box.back = 1;
+            if ( _compressFailedWidth > 0 )
+            {
+                if ( front.width == _compressFailedWidth && front.height == _compressFailedHeight && nIdleFrames == _compressFailedSetting )
+                {
+                    return;
+                }
 
-            box.left = _dx;
-            box.right = _dx2;
-            box.top = _dy;
-            box.bottom = _dy2;
+                _compressFailedWidth = 0;
+                _compressFailedHeight = 0;
+            }
 
-            //HTML5Plugin::gPlugin->LogAlways( " Update x(%d) y(%d), r(%d) b(%d)", box.left, box.top, box.right, box.bottom );
+            // block compression needs whole 4x4 blocks
+            if ( nIdleFrames <= 0 || _device.IsCompressed() || ++_idleFrames < nIdleFrames || front.buffer.empty() || ( front.width & 3 ) || ( front.height & 3 ) )
+            {
+                return;
+            }
 
-            resetdirty();
+            _compressJob = std::make_shared<HTML5Plugin::SCompressionJob>();
+            _compressJob->pixels = front.buffer;
+            _compressJob->nWidth = front.width;
+            _compressJob->nHeight = front.height;
+            _compressJob->nSequence = front.nSequence;
+            HTML5Plugin::gPlugin->m_compressor.Submit( _compressJob );
+        }
 
-            const char* pSrc = ( const char* )_buffer;
-            pSrc += box.top * bytesPerRow + box.left * 4;
+        /** @brief set the compositor whose atlas small fixed size views are packed into (once, before the view is rendered) */
+        void SetCompositor( HTML5Plugin::CD3D11Compositor* pCompositor )
+        {
+            _atlasDevice.SetCompositor( pCompositor );
+        }
 
-            pContext->UpdateSubresource( pTexture, 0, &box, ( void* )pSrc, bytesPerRow, 0 );
-#endif
+        /** @brief release the atlas area, the compositor can't be used after this (render thread or view lock held) */
+        void ReleaseAtlas()
+        {
+            _atlasDevice.SetCompositor( nullptr );
         }
 
-        /** @brief Creates the CryENGINE and Direct3D resource */
-        void CreateResources( )
+        /**
+        * @brief upload and draw the view (render thread)
+        * @param compositor draws fixed size views in batches, small ones are packed into its atlas
+        */
+        void Render( HTML5Plugin::CD3D11Compositor& compositor )
         {
-            ID3D11Device* pDevice = static_cast<ID3D11Device*>( HTML5Plugin::gD3DSystem->GetDevice() );
+            bool bVisible = IsActive();
+            float fRate = _rate < 0.0f ? HTML5Plugin::gPlugin->cm5_ui_fps : _rate;
+            HTML5Plugin::SClipQuad worldQuad;
 
-#ifdef USE_MAPPED
-            _itexture = HTML5Plugin::gD3DSystem->CreateTexture( ( void** )&_texture, _windowWidth, _windowHeight, 1,  eTF_X8R8G8B8, FT_USAGE_DYNAMIC | TEXTURE_FLAGS );
-#else
-            _itexture = HTML5Plugin::gD3DSystem->CreateTexture( ( void** )&_texture, _windowWidth, _windowHeight, 1,  eTF_X8R8G8B8, TEXTURE_FLAGS ); //FT_USAGE_RENDERTARGET?
-#endif
+            // world views are culled by distance and frustum, their rate drops with the part of the screen they cover
+            if ( bVisible && _world.IsEnabled() )
+            {
+                const CCamera& cam = gEnv->pSystem->GetViewCamera();
+
+                bVisible = _world.GetDistance( cam.GetPosition() ) <= HTML5Plugin::gPlugin->cm5_world_distance && cam.IsAABBVisible_F( _world.GetBounds() );
+
+                if ( bVisible )
+                {
+                    const float fCoverage = _world.Project( cam, worldQuad );
+                    const float fFullRate = fRate > 0.0f ? fRate : 60.0f;
+                    const float fScale = clamp_tpl( fCoverage / max( HTML5Plugin::gPlugin->cm5_world_coverage, 0.01f ), 0.0f, 1.0f );
+
+                    fRate = max( fFullRate * fScale, min( fFullRate, 2.0f ) );
+                }
+            }
+
+            // CEF doesn't need to paint while nothing is shown
+            SetHidden( !bVisible );
+
+            if ( !bVisible )
+            {
+                return;
+            }
+
+            UpdateSurfaceSize();
 
-            HTML5Plugin::gPlugin->LogAlways( "CreateTexture: %p, %p", _texture, _itexture );
+            const float fNow = gEnv->pTimer->GetAsyncCurTime();
 
-            if ( _texture )
+            if ( _source->GetPacer().Tick( fNow ) && HTML5Plugin::gPlugin->cm5_ui_stats )
             {
-                D3D11_TEXTURE2D_DESC texdesc = {0};
-                _texture->GetDesc( &texdesc );
+                const HTML5Plugin::CFramePacer::SStats& stats = _source->GetPacer().GetStats();
+                HTML5Plugin::gPlugin->LogAlways( "UI: paints(%u) dropped(%u) uploads(%u) KB(%u)", stats.nPaints, stats.nDropped, stats.nUploads, uint32( stats.nBytes / 1024 ) );
+            }
 
-                D3D11_SHADER_RESOURCE_VIEW_DESC srvdesc;
-                ZeroMemory( &srvdesc, sizeof( D3D11_SHADER_RESOURCE_VIEW_DESC ) );
+            _device.SetStagingSlots( HTML5Plugin::gPlugin->cm5_staging );
 
-                srvdesc.Format = texdesc.Format;
-                srvdesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
-                srvdesc.Texture2D.MipLevels = texdesc.MipLevels;
-                srvdesc.Texture2D.MostDetailedMip = texdesc.MipLevels - 1;
+            // small fixed size views share the atlas, switching releases the other surface so the pipeline uploads everything again (shared textures can't be packed)
+            const bool bAtlas = _source == &_pipeline && IsFixedSize() && !_atlasFull && compositor.GetPacker().CanPack( _windowSize.GetWidth(), _windowSize.GetHeight() );
 
-                HRESULT hr = pDevice->CreateShaderResourceView( _texture, &srvdesc, &_srv );
+            if ( bAtlas != _inAtlas )
+            {
+                _inAtlas = bAtlas;
+                _device.ReleaseSurface();
+                _atlasDevice.ReleaseSurface();
+            }
 
-                if ( SUCCEEDED( hr ) )
+            // When something to draw exists
+            if ( _inAtlas )
+            {
+                if ( !_source->Present( _atlasDevice, fNow, fRate ) )
                 {
-                    HTML5Plugin::gPlugin->LogAlways( "CreateShaderResourceView: %p", _srv );
+                    _atlasFull = true;
+                }
+
+                else if ( _world.IsEnabled() )
+                {
+                    _atlasDevice.Queue( worldQuad );
                 }
 
                 else
                 {
-                    HTML5Plugin::gPlugin->LogAlways( "Fail CreateShaderResourceView" );
+                    _atlasDevice.Queue( _x, _y );
                 }
             }
-        }
+
+            else if ( _source->Present( _device, fNow, fRate ) )
+            {
+                UpdateCompression();
+
+                const int nWidth = _source->GetWidth();
+                const int nHeight = _source->GetHeight();
+                const bool bNative = _device.IsShared();
+
+                if ( _world.IsEnabled() )
+                {
+                    compositor.QueueTexture( _device.GetSRV(), nWidth, nHeight, worldQuad, bNative );
+                }
+
+                else if ( IsFixedSize() )
+                {
+                    compositor.QueueTexture( _device.GetSRV(), nWidth, nHeight, _x, _y, bNative );
+                }
+
+                // the triangle drawer swaps red and blue for uploaded frames
+                else if ( bNative )
+                {
+                    compositor.QueueTexture( _device.GetSRV(), nWidth, nHeight, HTML5Plugin::SClipQuad::FromScreen( 0.0f, 0.0f, 1.0f, 1.0f, 1, 1 ), true );
+                }
+
+                // a mostly transparent view only blends the parts with visible pixels
+                else if ( BuildCoveredRects( nWidth, nHeight ) )
+                {
+                    const std::vector<HTML5Plugin::SDirtyRect>& rects = _coveredRects.GetRects();
+
+                    for ( size_t i = 0; i < rects.size(); ++i )
+                    {
+                        const HTML5Plugin::SDirtyRect& rect = rects[i];
+                        const HTML5Plugin::SClipQuad quad = HTML5Plugin::SClipQuad::FromScreen( float( rect.x ), float( rect.y ), float( rect.x2 - rect.x ), float( rect.y2 - rect.y ), nWidth, nHeight );
+                        compositor.QueueTextureRect( _device.GetSRV(), nWidth, nHeight, rect, quad );
+                    }
+                }
+
+                else
+                {
+                    const uint64 nStart = HTML5Plugin::GetTimestampUs();
+                    _triangledrawer.SetDrawMode( HTML5Plugin::gPlugin->cm5_draw_mode );
+                    _triangledrawer.Draw( _device.GetSRV() );
+
+                    HTML5Plugin::gPlugin->m_stats.Record( HTML5Plugin::eUIS_DrawTime, HTML5Plugin::GetTimestampUs() - nStart );
+                    HTML5Plugin::gPlugin->m_stats.Record( HTML5Plugin::eUIS_DrawCalls, _triangledrawer.GetCallCount().GetTotal() );
+                }
+            }
+        };
 
     public:
-        CEFCryRenderHandler( int windowWidth, int windowHeight )
+        CEFCryRenderHandler( int windowWidth, int windowHeight ) :
+            _windowSize( windowWidth, windowHeight ),
+            _pipeline( windowWidth, windowHeight, &HTML5Plugin::gPlugin->m_stats )
         {
-            _windowWidth = windowWidth;
-            _windowHeight = windowHeight;
+#if defined( HTML5_SHARED_TEXTURE )
+            _source = &_shared;
+#else
+            _source = &_pipeline;
+#endif
 
-            resetdirty();
-            _buffer = nullptr;
-            _texture = nullptr;
-            _itexture = nullptr;
-            _srv = nullptr;
+            _hidden = false;
+
+            _fixedWidth = 0;
+            _fixedHeight = 0;
+            _x = 0.0f;
+            _y = 0.0f;
+            _inAtlas = false;
+            _atlasFull = false;
+            _rate = -1.0f;
+            _active = true;
+            _idleSequence = 0;
+            _idleFrames = 0;
+            _compressFailedWidth = 0;
+            _compressFailedHeight = 0;
+            _compressFailedSetting = 0;
+        }
+
+        ~CEFCryRenderHandler()
+        {
+            HTML5Plugin::CCompressionWorker::Cancel( _compressJob );
         }
 
-        /** @brief get pixel color at position */
+        /**
+        * @brief check the alpha of the newest paint (safe to query from any thread)
+        * @return true when the alpha at x, y is at least nThreshold, frames without coverage are opaque on the whole surface
+        */
+        bool IsOpaque( int x, int y, uint8 nThreshold ) const
+        {
+            const HTML5Plugin::CAlphaCoverage* pCoverage = _source->GetCoverage();
+
+            if ( pCoverage )
+            {
+                return pCoverage->IsOpaque( x, y, nThreshold );
+            }
+
+            return x >= 0 && y >= 0 && x < _windowSize.GetWidth() && y < _windowSize.GetHeight();
+        }
+
+        /** @return true when any pixel of rect has an alpha of at least nThreshold (safe to query from any thread) */
+        bool IsRegionOpaque( const HTML5Plugin::SDirtyRect& rect, uint8 nThreshold ) const
+        {
+            const HTML5Plugin::CAlphaCoverage* pCoverage = _source->GetCoverage();
+
+            if ( pCoverage )
+            {
+                return pCoverage->IsRegionOpaque( rect, nThreshold );
+            }
+
+            return rect.x < _windowSize.GetWidth() && rect.y < _windowSize.GetHeight() && rect.x2 > 0 && rect.y2 > 0;
+        }
+
+        /** @brief get pixel color at position of the frame acquired last, transparent when frames never reach CPU memory (render thread) */
         virtual ColorB GetPixel( int x, int y )
         {
+            const uint8* pPixels = _source->GetPixels();
+
             // check if on surface
-            if ( x < 0 || y < 0 || x >= _windowWidth || y >= _windowHeight )
+            if ( !pPixels || x < 0 || y < 0 || x >= _source->GetWidth() || y >= _source->GetHeight() )
             {
                 return ColorB( 0, 0, 0, 0 );
             }
 
             // get pixel position in buffer
-            size_t nPos = _windowWidth * y + x;
-            uint8* pPos = &( ( uint8* )_buffer )[nPos];
+            size_t nPos = ( size_t( _source->GetWidth() ) * y + x ) * 4;
+            const uint8* pPos = &pPixels[nPos];
 
-            // CEF uses RGBA order
-            return ColorB( pPos[0], pPos[1], pPos[2], pPos[3] );
+            // CEF uses BGRA order
+            return ColorB( pPos[2], pPos[1], pPos[0], pPos[3] );
         }
 
         virtual bool GetRootScreenRect( CefRefPtr<CefBrowser> browser, CefRect& rect )
@@ -309,8 +700,7 @@ class CEFCryRenderHandler : public CefRenderHandler, public D3DPlugin::ID3DEvent
         {
             rect.x = 0;
             rect.y = 0;
-            rect.width = _windowWidth;
-            rect.height = _windowHeight;
+            _windowSize.GetSize( rect.width, rect.height );
             return true;
         }
 
@@ -329,14 +719,39 @@ class CEFCryRenderHandler : public CefRenderHandler, public D3DPlugin::ID3DEvent
 
             // HTML5Plugin::gPlugin->LogAlways( "OnPaint: %s, type(%d), %d, %dm %0x016p", SAFESTR( url.c_str() ), int( type ), width, height, buffer );
 
+            // popups are not composited yet
+            if ( type != PET_VIEW )
+            {
+                return;
+            }
+
+            HTML5Plugin::CDirtyRegion dirty;
+
             for ( auto iter = dirtyRects.begin(); iter != dirtyRects.end(); ++iter )
             {
-                dirtyarea( iter->x, iter->y, iter->width, iter->height );
+                dirty.Add( HTML5Plugin::SDirtyRect( iter->x, iter->y, iter->x + iter->width, iter->y + iter->height ) );
                 //HTML5Plugin::gPlugin->LogAlways( " Dirty x(%d) y(%d), w(%d) h(%d)", iter->x, iter->y, iter->width, iter->height );
             }
 
-            _buffer = buffer;
+            // CEF only guarantees the buffer during this call, the pipeline copies what changed
+            _source->Paint( static_cast<const uint8*>( buffer ), width, height, dirty, max( HTML5Plugin::gPlugin->cm5_tiled, 0 ) );
+        }
+
+#if defined( HTML5_SHARED_TEXTURE )
+        virtual void OnAcceleratedPaint( CefRefPtr<CefBrowser> browser, PaintElementType type, const RectList& dirtyRects, void* shared_handle ) override
+        {
+            // popups are not composited yet
+            if ( type != PET_VIEW )
+            {
+                return;
+            }
+
+            // the device opens the texture CEF rendered into, nothing passes through CPU memory
+            int nWidth, nHeight;
+            _windowSize.GetSize( nWidth, nHeight );
+            _source->PaintShared( shared_handle, nWidth, nHeight );
         }
+#endif
 
         virtual void OnCursorChange( CefRefPtr<CefBrowser> browser, CefCursorHandle cursor )
         {
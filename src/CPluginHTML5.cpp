@@ -5,6 +5,7 @@
 
 #include <CEFHandler.hpp>
 #include <CEFCryPak.hpp>
+#include <ScreenProjection.h>
 
 #include <PMUtils.hpp>
 
@@ -14,12 +15,15 @@ namespace HTML5Plugin
     D3DPlugin::IPluginD3D* gD3DSystem = NULL;
 
     CPluginHTML5::CPluginHTML5() :
-        m_refCEFHandler( nullptr ),
-        m_refCEFRequestContext( nullptr ),
-        m_refCEFFrame( nullptr )
+        m_hMainView( 0 ),
+        m_hFocusView( 0 ),
+        m_pInput( nullptr ),
+        m_refCEFRequestContext( nullptr )
     {
         gPlugin = this;
         gD3DSystem = nullptr;
+
+        m_views.Reserve( 16 );
     }
 
     CPluginHTML5::~CPluginHTML5()
@@ -131,6 +135,16 @@ namespace HTML5Plugin
         }
     };
 
+    void Command_Stats( IConsoleCmdArgs* pArgs )
+    {
+        gPlugin->DumpStats( pArgs->GetArgCount() > 1 ? pArgs->GetArg( 1 ) : nullptr );
+    };
+
+    void Command_CacheFlush( IConsoleCmdArgs* pArgs )
+    {
+        gPlugin->FlushResourceCache();
+    };
+
     bool CPluginHTML5::RegisterTypes( int nFactoryType, bool bUnregister )
     {
         // Note: Autoregister Flownodes will be automatically registered by the Base class
@@ -150,12 +164,52 @@ namespace HTML5Plugin
                     {
                         REGISTER_CVAR( cm5_active, 1.0f, VF_NULL, "CryHTML5 Rendering and systems active" );
                         REGISTER_CVAR( cm5_alphatest, 0.3f, VF_NULL, "CryHTML5 Alpha test threshold for cursor" );
+                        REGISTER_CVAR( cm5_tiled, 0, VF_NULL, "CryHTML5 Tile size in pixels for uploading only tiles with changed content (0 = upload dirty rects)" );
+                        REGISTER_CVAR( cm5_staging, 3, VF_NULL, "CryHTML5 Number of staging textures uploads rotate through (0 = update the texture directly, at most 4)" );
+                        REGISTER_CVAR( cm5_scale, 1.0f, VF_NULL, "CryHTML5 Surface resolution relative to the viewport" );
+                        REGISTER_CVAR( cm5_resize_delay, 0.25f, VF_NULL, "CryHTML5 Seconds a new viewport size has to be stable before the surface is resized" );
+                        REGISTER_CVAR( cm5_ui_fps, 0.0f, VF_NULL, "CryHTML5 Maximum UI frame rate, paints in between are coalesced (0 = every game frame)" );
+                        REGISTER_CVAR( cm5_ui_stats, 0, VF_NULL, "CryHTML5 Log paints received/dropped and bytes uploaded every second" );
+                        REGISTER_CVAR( cm5_atlas, 1024, VF_NULL, "CryHTML5 Atlas page size small fixed size views are packed into and drawn in batches from (0 = own texture per view)" );
+                        REGISTER_CVAR( cm5_draw_mode, 1, VF_NULL, "CryHTML5 How fullscreen draws keep the renderer state: 0 save/restore every slot, 1 only the changed state, 2 replay a command list" );
+                        REGISTER_CVAR( cm5_partial, 0.5f, VF_NULL, "CryHTML5 Covered part of the screen (0-1) up to which fullscreen views only draw their visible parts, 0 always draws the whole screen" );
+                        REGISTER_CVAR( cm5_compress, 0, VF_NULL, "CryHTML5 Frames a view has to stay unchanged before its surface is BC3 compressed on a worker thread, 0 never compresses" );
+                        REGISTER_CVAR( cm5_input_batch, 1, VF_NULL, "CryHTML5 Collapse consecutive mouse moves and wheel ticks of a frame into one browser call" );
+                        REGISTER_CVAR( cm5_cursor_speed, 1000.0f, VF_NULL, "CryHTML5 Virtual cursor speed in pixels per second at full stick deflection" );
+                        REGISTER_CVAR( cm5_cursor_deadzone, 0.2f, VF_NULL, "CryHTML5 Stick deflection (0-1) the virtual cursor ignores" );
+                        REGISTER_CVAR( cm5_cursor_curve, 2.0f, VF_NULL, "CryHTML5 Exponent of the virtual cursor response curve (1 = linear)" );
+                        REGISTER_CVAR( cm5_cursor_accel, 0.5f, VF_NULL, "CryHTML5 Seconds the stick has to be held until the virtual cursor reaches full speed" );
+                        REGISTER_CVAR( cm5_cursor_snap, 48.0f, VF_NULL, "CryHTML5 Distance in view pixels from which the virtual cursor snaps to an element when the stick is released, 0 disables snapping" );
+                        REGISTER_CVAR( cm5_pak_threads, 2, VF_NULL, "CryHTML5 Number of worker threads cry:// requests are opened and read on, applies after a restart" );
+                        REGISTER_CVAR( cm5_cache_size, 32, VF_NULL, "CryHTML5 Megabytes of cry:// files kept in memory for later requests, 0 disables the cache" );
+                        REGISTER_CVAR( cm5_world_distance, 50.0f, VF_NULL, "CryHTML5 Distance in meters beyond which world views are hidden" );
+                        REGISTER_CVAR( cm5_world_coverage, 0.25f, VF_NULL, "CryHTML5 Part of the screen a world view has to cover to paint at the full rate, smaller ones paint slower" );
                     }
 
                     else
                     {
                         gEnv->pConsole->UnregisterVariable( "cm5_active", true );
                         gEnv->pConsole->UnregisterVariable( "cm5_alphatest", true );
+                        gEnv->pConsole->UnregisterVariable( "cm5_tiled", true );
+                        gEnv->pConsole->UnregisterVariable( "cm5_staging", true );
+                        gEnv->pConsole->UnregisterVariable( "cm5_scale", true );
+                        gEnv->pConsole->UnregisterVariable( "cm5_resize_delay", true );
+                        gEnv->pConsole->UnregisterVariable( "cm5_ui_fps", true );
+                        gEnv->pConsole->UnregisterVariable( "cm5_ui_stats", true );
+                        gEnv->pConsole->UnregisterVariable( "cm5_atlas", true );
+                        gEnv->pConsole->UnregisterVariable( "cm5_draw_mode", true );
+                        gEnv->pConsole->UnregisterVariable( "cm5_partial", true );
+                        gEnv->pConsole->UnregisterVariable( "cm5_compress", true );
+                        gEnv->pConsole->UnregisterVariable( "cm5_input_batch", true );
+                        gEnv->pConsole->UnregisterVariable( "cm5_cursor_speed", true );
+                        gEnv->pConsole->UnregisterVariable( "cm5_cursor_deadzone", true );
+                        gEnv->pConsole->UnregisterVariable( "cm5_cursor_curve", true );
+                        gEnv->pConsole->UnregisterVariable( "cm5_cursor_accel", true );
+                        gEnv->pConsole->UnregisterVariable( "cm5_cursor_snap", true );
+                        gEnv->pConsole->UnregisterVariable( "cm5_pak_threads", true );
+                        gEnv->pConsole->UnregisterVariable( "cm5_cache_size", true );
+                        gEnv->pConsole->UnregisterVariable( "cm5_world_distance", true );
+                        gEnv->pConsole->UnregisterVariable( "cm5_world_coverage", true );
                     }
                 }
 
@@ -168,6 +222,8 @@ namespace HTML5Plugin
                         gEnv->pConsole->AddCommand( "cm5_url", Command_URL, VF_NULL, "Open the URL" );
                         gEnv->pConsole->AddCommand( "cm5_js", Command_JS, VF_NULL, "Execute the JavaScript" );
                         gEnv->pConsole->AddCommand( "cm5_input", Command_Input, VF_NULL, "Set Input mode" );
+                        gEnv->pConsole->AddCommand( "cm5_stats", Command_Stats, VF_NULL, "Log the UI instrumentation counters or append them as CSV to the file given" );
+                        gEnv->pConsole->AddCommand( "cm5_cache_flush", Command_CacheFlush, VF_NULL, "Log the cry:// resource cache counters and clear the cache" );
                     }
 
                     else
@@ -176,6 +232,8 @@ namespace HTML5Plugin
                         gEnv->pConsole->RemoveCommand( "cm5_url" );
                         gEnv->pConsole->RemoveCommand( "cm5_js" );
                         gEnv->pConsole->RemoveCommand( "cm5_input" );
+                        gEnv->pConsole->RemoveCommand( "cm5_stats" );
+                        gEnv->pConsole->RemoveCommand( "cm5_cache_flush" );
                     }
                 }
             }
@@ -232,6 +290,8 @@ namespace HTML5Plugin
     void CPluginHTML5::ShutdownDependencies()
     {
         // Shut Down All Dependencies Here.
+        m_compressor.Stop();
+        m_pakPool.Stop();
         ShutdownD3DPlugin();
 
         // End
@@ -298,8 +358,15 @@ namespace HTML5Plugin
         // Initialize Components
         if ( bSuccess )
         {
+            m_pakPool.SetThreadCount( cm5_pak_threads );
             CefRegisterSchemeHandlerFactory( "cry", "cry", new CEFCryPakHandlerFactory() );
 
+            // Input goes to the focused view
+            m_pInput = new CEFCryInputHandler();
+
+            // Render all views
+            gD3DSystem->RegisterListener( this );
+
             // Initialize a Browser
             bSuccess = InitializeCEFBrowser();
         }
@@ -309,32 +376,304 @@ namespace HTML5Plugin
 
     bool CPluginHTML5::InitializeCEFBrowser()
     {
-        // Client Handler
-        m_refCEFHandler = new CEFCryHandler( 1024, 1024 );
+        m_refCEFRequestContext = CefRequestContext::GetGlobalContext();
+
+        m_hMainView = CreateView( L"cry://UI/TestUI.html" );
+        //m_hMainView = CreateView( L"http://www.youtube.com/watch?v=3MteSlpxCpo" );
+        //m_hMainView = CreateView( L"http://webglsamples.googlecode.com/hg/aquarium/aquarium.html" );
+        //m_hMainView = CreateView( L"http://www.google.com" );
+
+        m_hFocusView = m_hMainView;
+
+        return m_hMainView != 0;
+    }
+
+    TViewHandle CPluginHTML5::CreateView( const wchar_t* sURL, int nWidth, int nHeight )
+    {
+        if ( !m_pInput )
+        {
+            return 0;
+        }
+
+        // Client Handler (the surface follows the viewport unless a size is given)
+        int nSurfaceWidth = nWidth, nSurfaceHeight = nHeight;
+
+        if ( nWidth <= 0 || nHeight <= 0 )
+        {
+            CEFCryRenderHandler::GetViewportSize( nSurfaceWidth, nSurfaceHeight );
+        }
+
+        CefRefPtr<CEFCryHandler> handler = new CEFCryHandler( nSurfaceWidth, nSurfaceHeight );
+        handler->_renderHandler->SetSize( nWidth, nHeight );
+
+        // a cm5_atlas change reconfigures the compositor, the atlas device notices its area is gone and allocates again
+        handler->_renderHandler->SetCompositor( &m_compositor );
+
+        TViewHandle hView;
+        {
+            std::lock_guard<std::mutex> lock( m_viewLock );
+            hView = m_views.Create( handler );
+            PublishCursorViews();
+        }
+
+        if ( !hView )
+        {
+            LogWarning( "CreateView failed: too many views" );
+            return 0;
+        }
 
         // Window Information
         CefWindowInfo info;
 
         info.SetAsOffScreen( HWND( gEnv->pRenderer->GetHWND() ) ); //info.SetAsOffScreen( NULL );
         info.SetTransparentPainting( TRUE );
-
-        // Register Listener for Render Handler
-        gD3DSystem->RegisterListener( m_refCEFHandler->_renderHandler.get() );
+#if defined( HTML5_SHARED_TEXTURE )
+        info.shared_texture_enabled = true;
+#endif
 
         // Browser Settings
         CefBrowserSettings browserSettings;
-        //browserSettings.accelerated_compositing = STATE_ENABLED; // For OSR always software is used this is an CEF restriction.
+        //browserSettings.accelerated_compositing = STATE_ENABLED; // For OSR always software is used this is an CEF restriction (define HTML5_SHARED_TEXTURE for builds with accelerated OSR).
         //browserSettings.webgl = STATE_ENABLED;
 
-        m_refCEFRequestContext = CefRequestContext::GetGlobalContext();
-
-        bool bSuccess = CefBrowserHost::CreateBrowser( info, m_refCEFHandler.get(), "cry://UI/TestUI.html", browserSettings, nullptr );
-        //bool bSuccess = CefBrowserHost::CreateBrowser( info, m_refCEFHandler.get(), "http://www.youtube.com/watch?v=3MteSlpxCpo", browserSettings, nullptr );
-        //bool bSuccess = CefBrowserHost::CreateBrowser( info, m_refCEFHandler.get(), "http://webglsamples.googlecode.com/hg/aquarium/aquarium.html", browserSettings, nullptr );
-        //bool bSuccess = CefBrowserHost::CreateBrowser( info, g_handler.get(), "http://www.google.com", browserSettings, nullptr );
+        bool bSuccess = CefBrowserHost::CreateBrowser( info, handler.get(), sURL, browserSettings, m_refCEFRequestContext );
 
         HTML5Plugin::gPlugin->LogAlways( "CreateBrowser %s", bSuccess ? "success" : "failed" );
-        return bSuccess;
+
+        if ( !bSuccess )
+        {
+            DestroyView( hView );
+            return 0;
+        }
+
+        return hView;
+    }
+
+    bool CPluginHTML5::DestroyView( TViewHandle hView )
+    {
+        CefRefPtr<CEFCryHandler> handler;
+
+        {
+            // CEF releases the handler later on its own thread, the atlas is only touched while rendering
+            std::lock_guard<std::mutex> lock( m_viewLock );
+            CefRefPtr<CEFCryHandler>* pHandler = m_views.Get( hView );
+
+            if ( !pHandler )
+            {
+                return false;
+            }
+
+            handler = *pHandler;
+            handler->_renderHandler->ReleaseAtlas();
+            m_views.Destroy( hView );
+            PublishCursorViews();
+
+            if ( m_hFocusView == hView )
+            {
+                m_hFocusView = m_hMainView != hView ? m_hMainView : 0;
+            }
+
+            if ( m_hMainView == hView )
+            {
+                m_hMainView = 0;
+            }
+        }
+
+        handler->Close();
+        return true;
+    }
+
+    CefRefPtr<CEFCryRenderHandler> CPluginHTML5::GetViewRenderer( TViewHandle hView )
+    {
+        std::lock_guard<std::mutex> lock( m_viewLock );
+        return FindViewRenderer( hView );
+    }
+
+    CEFCryRenderHandler* CPluginHTML5::FindViewRenderer( TViewHandle hView )
+    {
+        CefRefPtr<CEFCryHandler>* pHandler = m_views.Get( hView );
+        return pHandler ? ( *pHandler )->_renderHandler.get() : nullptr;
+    }
+
+    void CPluginHTML5::PublishCursorViews()
+    {
+        std::lock_guard<std::mutex> lock( m_cursorLock );
+        m_cursorViews.clear();
+
+        for ( size_t i = 0; i < m_views.GetCount(); ++i )
+        {
+            m_cursorViews.push_back( m_views.GetLive( i )->_renderHandler );
+        }
+    }
+
+    bool CPluginHTML5::SetViewURL( TViewHandle hView, const wchar_t* sURL )
+    {
+        CefRefPtr<CEFCryRenderHandler> pView = GetViewRenderer( hView );
+        CefRefPtr<CefBrowser> browser = pView ? pView->GetBrowser() : nullptr;
+
+        if ( browser.get() != nullptr )
+        {
+            browser->GetMainFrame()->LoadURL( sURL );
+            return true;
+        }
+
+        return false;
+    }
+
+    bool CPluginHTML5::ExecuteViewJS( TViewHandle hView, const wchar_t* sJS )
+    {
+        CefRefPtr<CEFCryRenderHandler> pView = GetViewRenderer( hView );
+        CefRefPtr<CefBrowser> browser = pView ? pView->GetBrowser() : nullptr;
+
+        if ( browser.get() != nullptr )
+        {
+            browser->GetMainFrame()->ExecuteJavaScript( sJS, CefString( "CryHTML" ), 0 );
+            return true;
+        }
+
+        return false;
+    }
+
+    void CPluginHTML5::SetViewSize( TViewHandle hView, int nWidth, int nHeight )
+    {
+        // the render thread reads the view settings while drawing
+        std::lock_guard<std::mutex> lock( m_viewLock );
+        CEFCryRenderHandler* pView = FindViewRenderer( hView );
+
+        if ( pView )
+        {
+            // the new size is picked up by the debounced resize
+            pView->SetSize( nWidth, nHeight );
+        }
+    }
+
+    void CPluginHTML5::SetViewFrameRate( TViewHandle hView, float fRate )
+    {
+        std::lock_guard<std::mutex> lock( m_viewLock );
+        CEFCryRenderHandler* pView = FindViewRenderer( hView );
+
+        if ( pView )
+        {
+            pView->SetFrameRate( fRate );
+        }
+    }
+
+    void CPluginHTML5::SetViewActive( TViewHandle hView, bool bActive )
+    {
+        std::lock_guard<std::mutex> lock( m_viewLock );
+        CEFCryRenderHandler* pView = FindViewRenderer( hView );
+
+        if ( pView )
+        {
+            pView->SetActive( bActive );
+        }
+    }
+
+    void CPluginHTML5::SetViewPosition( TViewHandle hView, float fX, float fY )
+    {
+        std::lock_guard<std::mutex> lock( m_viewLock );
+        CEFCryRenderHandler* pView = FindViewRenderer( hView );
+
+        if ( pView )
+        {
+            pView->SetPosition( fX, fY );
+        }
+    }
+
+    void CPluginHTML5::SetViewWorldQuad( TViewHandle hView, const Matrix34& tm, float fWidth, float fHeight )
+    {
+        // the render thread projects the quad
+        std::lock_guard<std::mutex> lock( m_viewLock );
+        CEFCryRenderHandler* pView = FindViewRenderer( hView );
+
+        if ( pView )
+        {
+            pView->SetWorldQuad( tm, fWidth, fHeight );
+        }
+    }
+
+    bool CPluginHTML5::RayHitView( TViewHandle hView, const Vec3& vOrigin, const Vec3& vDir, float& fX, float& fY )
+    {
+        std::lock_guard<std::mutex> lock( m_viewLock );
+        CEFCryRenderHandler* pView = FindViewRenderer( hView );
+
+        float fU, fV;
+
+        if ( !pView || !pView->GetWorldQuad().Intersect( vOrigin, vDir, fU, fV ) )
+        {
+            return false;
+        }
+
+        int nWidth, nHeight;
+        pView->GetDesiredSize( nWidth, nHeight );
+
+        fX = fU * nWidth;
+        fY = fV * nHeight;
+        return true;
+    }
+
+    void CPluginHTML5::SetViewSnapRects( TViewHandle hView, const float* pRects, int nRects )
+    {
+        std::lock_guard<std::mutex> lock( m_viewLock );
+        CEFCryRenderHandler* pView = FindViewRenderer( hView );
+
+        if ( pView )
+        {
+            pView->SetSnapRects( pRects, nRects );
+        }
+    }
+
+    void CPluginHTML5::OnPrePresent()
+    {
+        std::lock_guard<std::mutex> lock( m_viewLock );
+
+        m_compositor.Configure( max( cm5_atlas, 0 ), 8 );
+
+        // fullscreen views draw directly, fixed size views are queued and drawn in batches on top
+        for ( size_t i = 0; i < m_views.GetCount(); ++i )
+        {
+            m_views.GetLive( i )->_renderHandler->Render( m_compositor );
+        }
+
+        const uint64 nStart = GetTimestampUs();
+        m_compositor.Flush();
+
+        if ( m_compositor.GetBatches() )
+        {
+            m_stats.Record( eUIS_CompositeTime, GetTimestampUs() - nStart );
+        }
+    }
+
+    bool CPluginHTML5::SetFocusView( TViewHandle hView )
+    {
+        CefRefPtr<CEFCryRenderHandler> pView = GetViewRenderer( hView );
+
+        if ( !pView )
+        {
+            return false;
+        }
+
+        if ( hView != m_hFocusView )
+        {
+            CefRefPtr<CEFCryRenderHandler> pOld = GetViewRenderer( m_hFocusView );
+            CefRefPtr<CefBrowserHost> host = pOld ? pOld->GetHost() : nullptr;
+
+            if ( host.get() != nullptr )
+            {
+                host->SendFocusEvent( false );
+            }
+
+            host = pView->GetHost();
+
+            if ( host.get() != nullptr )
+            {
+                host->SendFocusEvent( true );
+            }
+
+            m_hFocusView = hView;
+        }
+
+        return true;
     }
 
     void CPluginHTML5::ShowDevTools()
@@ -373,10 +712,30 @@ namespace HTML5Plugin
     {
         gPlugin->LogAlways( "Shutting down" );
 
-        m_refCEFHandler->m_input.UnregisterListeners();
+        if ( m_pInput )
+        {
+            m_pInput->UnregisterListeners();
+            delete m_pInput;
+            m_pInput = nullptr;
+        }
+
+        // the D3D plugin is already shut down so only the browsers are closed
+        {
+            std::lock_guard<std::mutex> lock( m_viewLock );
+
+            while ( m_views.GetCount() )
+            {
+                const TViewHandle hView = m_views.GetHandle( m_views.GetCount() - 1 );
+                m_views.GetLive( m_views.GetCount() - 1 )->Close();
+                m_views.GetLive( m_views.GetCount() - 1 )->_renderHandler->ReleaseAtlas();
+                m_views.Destroy( hView );
+            }
+
+            PublishCursorViews();
+        }
 
-        m_refCEFFrame = nullptr;
-        m_refCEFHandler = nullptr;
+        m_hMainView = 0;
+        m_hFocusView = 0;
         m_refCEFRequestContext = nullptr;
 
         CefShutdown();
@@ -386,29 +745,17 @@ namespace HTML5Plugin
 
     bool CPluginHTML5::SetURL( const wchar_t* sURL )
     {
-        if ( m_refCEFFrame.get() != nullptr )
-        {
-            m_refCEFFrame->LoadURL( sURL );
-            return true;
-        }
-
-        return false;
+        return SetViewURL( m_hMainView, sURL );
     }
 
     bool CPluginHTML5::ExecuteJS( const wchar_t* sJS )
     {
-        if ( m_refCEFFrame.get() != nullptr )
-        {
-            m_refCEFFrame->ExecuteJavaScript( sJS, CefString( "CryHTML" ), 0 );
-            return true;
-        }
-
-        return false;
+        return ExecuteViewJS( m_hMainView, sJS );
     }
 
     bool CPluginHTML5::WorldPosToScreenPos( CCamera cam, Vec3 vWorld, Vec3& vScreen, Vec3 vOffset /*= Vec3( ZERO ) */ )
     {
-        if ( m_refCEFHandler.get() != nullptr && m_refCEFHandler->_renderHandler.get() != nullptr )
+        if ( GetViewRenderer( m_hMainView ).get() )
         {
             // get current camera matrix
             const Matrix34& camMat = cam.GetMatrix();
@@ -435,19 +782,40 @@ namespace HTML5Plugin
         return false;
     }
 
+    bool CPluginHTML5::WorldPosToScreenPosBatch( const CCamera& cam, const SWorldPosBatch& batch )
+    {
+        CefRefPtr<CEFCryRenderHandler> pView = GetViewRenderer( m_hMainView );
+        float fScaleX, fOffsetX, fScaleY, fOffsetY;
+
+        // the viewport is queried once for the whole batch
+        if ( !pView || !pView->GetScreenTransform( fScaleX, fOffsetX, fScaleY, fOffsetY ) )
+        {
+            return false;
+        }
+
+        CScreenProjection projection;
+        projection.SetCamera( cam );
+        projection.SetScreenTransform( fScaleX, fOffsetX, fScaleY, fOffsetY );
+        projection.Project( batch );
+
+        return true;
+    }
+
     void CPluginHTML5::ScaleCoordinates( float fX, float fY, float& foX, float& foY, bool bLimit /*= false*/, bool bCERenderer /*= true */ )
     {
-        if ( m_refCEFHandler.get() != nullptr )
+        CefRefPtr<CEFCryRenderHandler> pView = GetViewRenderer( m_hMainView );
+
+        if ( pView )
         {
-            m_refCEFHandler->_renderHandler->ScaleCoordinates( fX, fY, foX, foY, bLimit, bCERenderer );
+            pView->ScaleCoordinates( fX, fY, foX, foY, bLimit, bCERenderer );
         }
     }
 
     void CPluginHTML5::SetInputMode( int nMode, bool bExclusive )
     {
-        if ( m_refCEFHandler.get() != nullptr )
+        if ( m_pInput )
         {
-            m_refCEFHandler->m_input.SetInputMode( nMode, bExclusive );
+            m_pInput->SetInputMode( nMode, bExclusive );
         }
     }
 
@@ -456,14 +824,45 @@ namespace HTML5Plugin
         cm5_active = bActive ? 1.0f : 0.0f;
     }
 
+    /** @return the alpha the alpha test threshold corresponds to */
+    static uint8 GetAlphaThreshold( float fAlphaTest )
+    {
+        return uint8( clamp_tpl( int( ceil( fAlphaTest * 255 ) ), 0, 255 ) );
+    }
+
     bool CPluginHTML5::IsCursorOnSurface()
     {
-        if ( cm5_active > 0.0 && m_refCEFHandler.get() != nullptr )
+        if ( cm5_active > 0.0 && m_pInput )
         {
-            float fX = 0.0f, fY = 0.0f;
-            m_refCEFHandler->m_input.GetCursorPos( fX, fY );
+            float fCursorX = 0.0f, fCursorY = 0.0f;
+            m_pInput->GetCursorPos( fCursorX, fCursorY );
+
+            // OnPrePresent holds m_viewLock for the whole render pass, the copy of the views is only locked while copying it
+            std::vector< CefRefPtr<CEFCryRenderHandler> > views;
+            {
+                std::lock_guard<std::mutex> lock( m_cursorLock );
+                views = m_cursorViews;
+            }
+
+            // the cursor is on the surface when any visible view is opaque below it
+            for ( size_t i = 0; i < views.size(); ++i )
+            {
+                CEFCryRenderHandler* pView = views[i].get();
+
+                if ( !pView->IsActive() )
+                {
+                    continue;
+                }
 
-            return IsOpaque( fX, fY );
+                // cursor is in renderer coordinates
+                float fX, fY;
+                pView->ScaleCoordinates( fCursorX, fCursorY, fX, fY, false, true );
+
+                if ( pView->IsOpaque( int( fX ), int( fY ), GetAlphaThreshold( cm5_alphatest ) ) )
+                {
+                    return true;
+                }
+            }
         }
 
         return false;
@@ -471,14 +870,109 @@ namespace HTML5Plugin
 
     bool CPluginHTML5::IsOpaque( float fX, float fY )
     {
-        if ( cm5_active > 0.0 && m_refCEFHandler.get() != nullptr )
+        CefRefPtr<CEFCryRenderHandler> pView = GetViewRenderer( m_hFocusView );
+
+        if ( cm5_active > 0.0 && pView )
         {
-            const ColorB& color = m_refCEFHandler->_renderHandler->GetPixel( fX, fY );
+            return pView->IsOpaque( int( fX ), int( fY ), GetAlphaThreshold( cm5_alphatest ) );
+        }
 
-            return color.a >= ( cm5_alphatest * 255 );
+        return false;
+    }
+
+    bool CPluginHTML5::IsRegionOpaque( float fX, float fY, float fWidth, float fHeight )
+    {
+        CefRefPtr<CEFCryRenderHandler> pView = GetViewRenderer( m_hFocusView );
+
+        if ( cm5_active > 0.0 && pView )
+        {
+            SDirtyRect rect( int( floor( fX ) ), int( floor( fY ) ), int( ceil( fX + fWidth ) ), int( ceil( fY + fHeight ) ) );
+
+            return pView->IsRegionOpaque( rect, GetAlphaThreshold( cm5_alphatest ) );
         }
 
         return false;
     }
 
+    int CPluginHTML5::GetUIStats( SUIStat* pStats, int nMaxStats )
+    {
+        const int nStats = pStats ? clamp_tpl( nMaxStats, 0, int( eUIS_Count ) ) : 0;
+
+        for ( int i = 0; i < nStats; ++i )
+        {
+            SHistogramSummary summary;
+            m_stats.Summarize( EUIStat( i ), summary );
+
+            SUIStat& stat = pStats[i];
+            stat.sName = CUIStats::GetName( EUIStat( i ) );
+            stat.sUnit = CUIStats::GetUnit( EUIStat( i ) );
+            stat.nCount = summary.nCount;
+            stat.fMean = float( summary.fMean );
+            stat.fMin = float( summary.nMin );
+            stat.fP50 = float( summary.nP50 );
+            stat.fP90 = float( summary.nP90 );
+            stat.fP99 = float( summary.nP99 );
+            stat.fMax = float( summary.nMax );
+        }
+
+        return nStats;
+    }
+
+    void CPluginHTML5::DumpStats( const char* sFile )
+    {
+        if ( !sFile )
+        {
+            for ( int i = 0; i < eUIS_Count; ++i )
+            {
+                SHistogramSummary summary;
+                m_stats.Summarize( EUIStat( i ), summary );
+
+                LogAlways( "%s: count(%u) mean(%.1f) p50(%u) p90(%u) p99(%u) max(%u) %s", CUIStats::GetName( EUIStat( i ) ), summary.nCount, summary.fMean,
+                           uint32( summary.nP50 ), uint32( summary.nP90 ), uint32( summary.nP99 ), uint32( summary.nMax ), CUIStats::GetUnit( EUIStat( i ) ) );
+            }
+
+            CResourceCache::SCounters cache = m_resourceCache.GetCounters();
+            LogAlways( "resource_cache: hits(%u) misses(%u) evictions(%u) entries(%u) bytes(%u)", cache.nHits, cache.nMisses, cache.nEvictions, cache.nEntries, uint32( cache.nBytes ) );
+            return;
+        }
+
+        string sPath = PluginManager::pathWithSeperator( gPluginManager->GetDirectoryRoot() ) + sFile;
+
+        // a new file gets the header
+        FILE* pFile = fopen( sPath.c_str(), "r" );
+        bool bHeader = pFile == nullptr;
+
+        if ( pFile )
+        {
+            fclose( pFile );
+        }
+
+        pFile = fopen( sPath.c_str(), "a" );
+
+        if ( !pFile )
+        {
+            LogError( "Stats: Can't write %s", sPath.c_str() );
+            return;
+        }
+
+        char sLabel[32];
+        sprintf( sLabel, "%.3f", gEnv->pTimer->GetAsyncCurTime() );
+
+        std::string sCSV;
+        m_stats.FormatCSV( sCSV, sLabel, bHeader );
+
+        fputs( sCSV.c_str(), pFile );
+        fclose( pFile );
+
+        LogAlways( "Stats: appended to %s", sPath.c_str() );
+    }
+
+    void CPluginHTML5::FlushResourceCache()
+    {
+        CResourceCache::SCounters cache = m_resourceCache.GetCounters();
+        LogAlways( "Cache: flushed %u entries (%u bytes), hits(%u) misses(%u) evictions(%u)", cache.nEntries, uint32( cache.nBytes ), cache.nHits, cache.nMisses, cache.nEvictions );
+
+        m_resourceCache.Clear();
+    }
+
 }
\ No newline at end of file
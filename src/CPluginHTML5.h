@@ -17,7 +17,18 @@
 #include <cef_app.h>
 #include <cef_client.h>
 
+#include <mutex>
+
+#include <UIStats.h>
+#include <HandlePool.h>
+#include <D3D11Compositor.h>
+#include <CompressionWorker.h>
+#include <PakStream.h>
+#include <ResourceCache.h>
+
 class CEFCryHandler;
+class CEFCryRenderHandler;
+class CEFCryInputHandler;
 
 namespace HTML5Plugin
 {
@@ -26,7 +37,8 @@ namespace HTML5Plugin
     */
     class CPluginHTML5 :
         public PluginManager::CPluginBase,
-        public IPluginHTML5
+        public IPluginHTML5,
+        public D3DPlugin::ID3DEventListener
     {
         public:
             CPluginHTML5();
@@ -34,6 +46,28 @@ namespace HTML5Plugin
 
             float cm5_active; //!< cvar to activate the plugin
             float cm5_alphatest; //!< cvar for alpha test check
+            int cm5_tiled; //!< cvar for the tile size of tiled uploads (0 = upload dirty rects)
+            int cm5_staging; //!< cvar for the number of staging textures used for uploads (0 = update directly)
+            float cm5_scale; //!< cvar for the surface resolution relative to the viewport
+            float cm5_resize_delay; //!< cvar for the seconds a new viewport size has to be stable before resizing
+            float cm5_ui_fps; //!< cvar for the maximum UI frame rate (0 = every game frame)
+            int cm5_ui_stats; //!< cvar to log the UI paint and upload statistics every second
+            int cm5_atlas; //!< cvar for the atlas page size small fixed size views are packed into (0 = own texture per view)
+            int cm5_draw_mode; //!< cvar for how fullscreen draws keep the renderer state (EDX11DrawMode)
+            float cm5_partial; //!< cvar for the covered part of the screen up to which only visible parts of fullscreen views are drawn
+            int cm5_compress; //!< cvar for the frames a view has to stay unchanged before its surface is block compressed (0 = never)
+            int cm5_input_batch; //!< cvar to collapse consecutive mouse moves and wheel ticks of a frame before sending them
+            float cm5_cursor_speed; //!< cvar for the virtual cursor speed in pixels per second at full stick deflection
+            float cm5_cursor_deadzone; //!< cvar for the stick deflection the virtual cursor ignores
+            float cm5_cursor_curve; //!< cvar for the exponent of the virtual cursor response curve
+            float cm5_cursor_accel; //!< cvar for the seconds the stick has to be held until the virtual cursor reaches full speed
+            float cm5_cursor_snap; //!< cvar for the distance in view pixels the virtual cursor snaps to elements from (0 = off)
+            int cm5_pak_threads; //!< cvar for the number of threads cry:// requests are opened and read on
+            int cm5_cache_size; //!< cvar for the megabytes of cry:// files kept in memory (0 = no cache)
+            float cm5_world_distance; //!< cvar for the distance world views are culled at
+            float cm5_world_coverage; //!< cvar for the screen coverage world views paint at the full rate from
+
+            CUIStats m_stats; //!< instrumentation of the UI pipeline
 
             string m_sCEFBrowserProcess; //!< path to browser process
             string m_sCEFLog; //!< path to log file
@@ -41,9 +75,18 @@ namespace HTML5Plugin
             string m_sCEFLocalesDir;
             string m_sCEFDebugURL;
 
-            CefRefPtr<CEFCryHandler> m_refCEFHandler;
+            std::mutex m_viewLock; //!< guards m_views and the view settings the render thread reads, every access takes it (destroying a view moves others in the pool)
+            CHandlePool< CefRefPtr<CEFCryHandler> > m_views; //!< all offscreen browser views
+            std::mutex m_cursorLock; //!< guards m_cursorViews, only held to copy the list
+            std::vector< CefRefPtr<CEFCryRenderHandler> > m_cursorViews; //!< copy of the views for cursor tests, so input doesn't wait on rendering
+            CD3D11Compositor m_compositor; //!< draws the fixed size views (render thread)
+            CCompressionWorker m_compressor; //!< encodes the surfaces of views that stopped changing
+            CPakWorkerPool m_pakPool; //!< opens and reads cry:// requests off the CEF IO thread
+            CResourceCache m_resourceCache; //!< recently used cry:// files
+            TViewHandle m_hMainView; //!< view created with the plugin
+            TViewHandle m_hFocusView; //!< view receiving the input
+            CEFCryInputHandler* m_pInput; //!< input handler shared by all views
             CefRefPtr<CefRequestContext> m_refCEFRequestContext;
-            CefRefPtr<CefFrame> m_refCEFFrame;
 
             // IPluginBase
             bool Release( bool bForce = false )override;
@@ -126,6 +169,12 @@ namespace HTML5Plugin
             */
             void ShutdownD3DPlugin();
 
+            /** @return the render handler of a view or nullptr when the handle is invalid (m_viewLock has to be held) */
+            CEFCryRenderHandler* FindViewRenderer( TViewHandle hView );
+
+            /** @brief copy the views to m_cursorViews after m_views changed (m_viewLock has to be held) */
+            void PublishCursorViews();
+
         public:
             static void LaunchExternalBrowser( const string& url );
             void ShowDevTools();
@@ -136,6 +185,8 @@ namespace HTML5Plugin
 
             virtual bool WorldPosToScreenPos( CCamera cam, Vec3 vWorld, Vec3& vScreen, Vec3 vOffset = Vec3( ZERO ) );
 
+            virtual bool WorldPosToScreenPosBatch( const CCamera& cam, const SWorldPosBatch& batch );
+
             virtual void ScaleCoordinates( float fX, float fY, float& foX, float& foY, bool bLimit = false, bool bCERenderer = true );
 
             virtual void SetInputMode( int nMode = 0, bool bExclusive = false );
@@ -146,6 +197,63 @@ namespace HTML5Plugin
 
             virtual bool IsOpaque( float fX, float fY );
 
+            virtual bool IsRegionOpaque( float fX, float fY, float fWidth, float fHeight );
+
+            virtual int GetUIStats( SUIStat* pStats, int nMaxStats );
+
+            virtual TViewHandle CreateView( const wchar_t* sURL, int nWidth = 0, int nHeight = 0 );
+
+            virtual bool DestroyView( TViewHandle hView );
+
+            virtual TViewHandle GetMainView()
+            {
+                return m_hMainView;
+            }
+
+            virtual bool SetViewURL( TViewHandle hView, const wchar_t* sURL );
+
+            virtual bool ExecuteViewJS( TViewHandle hView, const wchar_t* sJS );
+
+            virtual void SetViewSize( TViewHandle hView, int nWidth, int nHeight );
+
+            virtual void SetViewFrameRate( TViewHandle hView, float fRate );
+
+            virtual void SetViewActive( TViewHandle hView, bool bActive );
+
+            virtual void SetViewPosition( TViewHandle hView, float fX, float fY );
+
+            virtual void SetViewWorldQuad( TViewHandle hView, const Matrix34& tm, float fWidth, float fHeight );
+
+            virtual bool RayHitView( TViewHandle hView, const Vec3& vOrigin, const Vec3& vDir, float& fX, float& fY );
+
+            virtual void SetViewSnapRects( TViewHandle hView, const float* pRects, int nRects );
+
+            virtual bool SetFocusView( TViewHandle hView );
+
+            virtual TViewHandle GetFocusView()
+            {
+                return m_hFocusView;
+            }
+
+            /** @return the render handler of a view or nullptr when the handle is invalid, the reference keeps it alive after the view is destroyed */
+            CefRefPtr<CEFCryRenderHandler> GetViewRenderer( TViewHandle hView );
+
+            // D3DPlugin::ID3DEventListener
+            virtual void OnPrePresent();
+            virtual void OnPostPresent() {};
+            virtual void OnPreReset() {};
+            virtual void OnPostReset() {};
+            virtual void OnPostBeginScene() {};
+
+            /**
+            * @brief log a summary of all UI counters or append it as CSV
+            * @param sFile CSV file (relative to the root directory) or nullptr to log
+            */
+            void DumpStats( const char* sFile );
+
+            /** @brief log the resource cache counters and drop all cached files */
+            void FlushResourceCache();
+
     };
 
     extern CPluginHTML5* gPlugin;
@@ -0,0 +1,91 @@
+/* CryHTML5 - for licensing and copyright see license.txt */
+
+#include "StdAfx.h"
+#include "CompressionWorker.h"
+#include "BlockCompression.h"
+
+namespace HTML5Plugin
+{
+    CCompressionWorker::CCompressionWorker()
+        : m_bStop( false )
+    {
+    }
+
+    CCompressionWorker::~CCompressionWorker()
+    {
+        Stop();
+    }
+
+    void CCompressionWorker::Submit( const std::shared_ptr<SCompressionJob>& pJob )
+    {
+        std::lock_guard<std::mutex> lock( m_lock );
+
+        if ( !m_thread.joinable() )
+        {
+            m_bStop = false;
+            m_thread = std::thread( &CCompressionWorker::Run, this );
+        }
+
+        m_jobs.push_back( pJob );
+        m_wake.notify_one();
+    }
+
+    void CCompressionWorker::Stop()
+    {
+        {
+            std::lock_guard<std::mutex> lock( m_lock );
+            m_bStop = true;
+
+            for ( size_t i = 0; i < m_jobs.size(); ++i )
+            {
+                Cancel( m_jobs[i] );
+            }
+
+            m_jobs.clear();
+            m_wake.notify_one();
+        }
+
+        if ( m_thread.joinable() )
+        {
+            m_thread.join();
+        }
+    }
+
+    void CCompressionWorker::Run()
+    {
+        for ( ;; )
+        {
+            std::shared_ptr<SCompressionJob> pJob;
+            {
+                std::unique_lock<std::mutex> lock( m_lock );
+
+                while ( !m_bStop && m_jobs.empty() )
+                {
+                    m_wake.wait( lock );
+                }
+
+                if ( m_bStop )
+                {
+                    return;
+                }
+
+                pJob = m_jobs.front();
+                m_jobs.pop_front();
+            }
+
+            if ( pJob->nState.load() != eCS_Pending )
+            {
+                continue;
+            }
+
+            pJob->blocks.resize( GetBC3Size( pJob->nWidth, pJob->nHeight ) );
+            EncodeBC3( &pJob->pixels[0], pJob->nWidth, pJob->nHeight, pJob->nWidth * 4, &pJob->blocks[0] );
+
+            // the frame copy isn't needed anymore, a cancel in between wins
+            std::vector<uint8>().swap( pJob->pixels );
+
+            int nExpected = eCS_Pending;
+            pJob->nState.compare_exchange_strong( nExpected, eCS_Done );
+        }
+    }
+}
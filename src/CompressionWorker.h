@@ -0,0 +1,83 @@
+/* CryHTML5 - for licensing and copyright see license.txt */
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace HTML5Plugin
+{
+    /** @brief states of a compression job */
+    enum ECompressionState
+    {
+        eCS_Pending = 0, //!< queued or being encoded
+        eCS_Done, //!< blocks are ready
+        eCS_Cancelled, //!< the frame changed, the result isn't wanted anymore
+    };
+
+    /** @brief a frame to be encoded into BC3, shared between the view and the worker */
+    struct SCompressionJob
+    {
+        std::vector<uint8> pixels; //!< copy of the frame (4 bytes per pixel, tightly packed)
+        int nWidth; //!< size of the frame
+        int nHeight;
+        uint32 nSequence; //!< paint sequence number of the frame
+        std::vector<uint8> blocks; //!< encoded frame, valid once done
+        std::atomic<int> nState; //!< ECompressionState
+
+        SCompressionJob()
+            : nWidth( 0 )
+            , nHeight( 0 )
+            , nSequence( 0 )
+            , nState( eCS_Pending )
+        {
+        }
+
+        /** @return true when the blocks are ready */
+        bool IsDone() const
+        {
+            return nState.load() == eCS_Done;
+        }
+    };
+
+    /**
+    * @brief Encodes frames of views that stopped changing on a background thread.
+    * Jobs are processed in submission order, cancelled jobs are skipped.
+    */
+    class CCompressionWorker
+    {
+        public:
+            CCompressionWorker();
+            ~CCompressionWorker();
+
+            /** @brief queue a job, the thread is started on first use */
+            void Submit( const std::shared_ptr<SCompressionJob>& pJob );
+
+            /** @brief cancel a job, the worker drops it or its result */
+            static void Cancel( const std::shared_ptr<SCompressionJob>& pJob )
+            {
+                if ( pJob )
+                {
+                    pJob->nState.store( eCS_Cancelled );
+                }
+            }
+
+            /** @brief drop all queued jobs and join the thread (call before the module unloads) */
+            void Stop();
+
+        private:
+            /** @brief thread function */
+            void Run();
+
+            std::mutex m_lock; //!< guards m_jobs and m_bStop
+            std::condition_variable m_wake; //!< signaled on new jobs and on stop
+            std::deque< std::shared_ptr<SCompressionJob> > m_jobs; //!< jobs waiting to be encoded
+            bool m_bStop; //!< the thread should exit
+            std::thread m_thread; //!< the worker thread
+    };
+}
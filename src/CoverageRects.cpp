@@ -0,0 +1,80 @@
+/* CryHTML5 - for licensing and copyright see license.txt */
+
+#include "StdAfx.h"
+#include "CoverageRects.h"
+
+namespace HTML5Plugin
+{
+    CCoverageRects::CCoverageRects()
+        : m_nArea( 0 )
+    {
+    }
+
+    bool CCoverageRects::Build( const CTileMask& mask, int nMaxRects, float fMaxRatio )
+    {
+        m_rects.clear();
+        m_open.clear();
+        m_next.clear();
+        m_nArea = 0;
+
+        const int nRows = mask.GetTilesY();
+        const int nColumns = mask.GetTilesX();
+
+        for ( int ty = 0; ty < nRows; ++ty )
+        {
+            // spans and the rects of the row above are both ordered by x, so one pass over each finds the matches
+            size_t nOpen = 0;
+            int tx = 0;
+
+            while ( tx < nColumns )
+            {
+                if ( !mask.Test( tx, ty ) )
+                {
+                    ++tx;
+                    continue;
+                }
+
+                int tx2 = tx + 1;
+
+                while ( tx2 < nColumns && mask.Test( tx2, ty ) )
+                {
+                    ++tx2;
+                }
+
+                const SDirtyRect span = mask.GetSpanRect( tx, tx2, ty );
+
+                while ( nOpen < m_open.size() && m_rects[m_open[nOpen]].x < span.x )
+                {
+                    ++nOpen;
+                }
+
+                if ( nOpen < m_open.size() && m_rects[m_open[nOpen]].x == span.x && m_rects[m_open[nOpen]].x2 == span.x2 )
+                {
+                    m_rects[m_open[nOpen]].y2 = span.y2;
+                    m_next.push_back( m_open[nOpen] );
+                    ++nOpen;
+                }
+
+                else
+                {
+                    m_next.push_back( m_rects.size() );
+                    m_rects.push_back( span );
+                }
+
+                tx = tx2;
+            }
+
+            m_open.swap( m_next );
+            m_next.clear();
+        }
+
+        for ( size_t i = 0; i < m_rects.size(); ++i )
+        {
+            m_nArea += m_rects[i].GetArea();
+        }
+
+        const float fSurface = float( mask.GetWidth() ) * mask.GetHeight();
+
+        return fSurface > 0.0f && int( m_rects.size() ) <= nMaxRects && m_nArea <= fSurface * fMaxRatio;
+    }
+}
@@ -0,0 +1,48 @@
+/* CryHTML5 - for licensing and copyright see license.txt */
+
+#pragma once
+
+#include <vector>
+
+#include <DirtyRegion.h>
+#include <TileTracker.h>
+
+namespace HTML5Plugin
+{
+    /**
+    * @brief Reduces the covered tiles of a surface to a short list of rects so only the visible parts are blended.
+    * Runs of tiles in a row become rects, rects of consecutive rows with the same horizontal extent are merged.
+    */
+    class CCoverageRects
+    {
+        public:
+            CCoverageRects();
+
+            /**
+            * @brief build the rects of the set tiles of a mask
+            * @param mask covered tiles
+            * @param nMaxRects more rects than this aren't worth the instances
+            * @param fMaxRatio covered part of the surface (0 - 1) above which a fullscreen draw is cheaper
+            * @return true when the rects should be drawn, false when the whole surface should be drawn instead
+            */
+            bool Build( const CTileMask& mask, int nMaxRects, float fMaxRatio );
+
+            /** @return rects of the last build in surface pixels, empty when nothing is covered */
+            const std::vector<SDirtyRect>& GetRects() const
+            {
+                return m_rects;
+            }
+
+            /** @return pixels covered by the rects of the last build */
+            int GetArea() const
+            {
+                return m_nArea;
+            }
+
+        private:
+            std::vector<SDirtyRect> m_rects; //!< merged rects
+            std::vector<size_t> m_open; //!< rects ending at the row above, ordered by x
+            std::vector<size_t> m_next; //!< rects ending at the current row, ordered by x
+            int m_nArea; //!< pixels covered by m_rects
+    };
+}
@@ -0,0 +1,547 @@
+/* CryHTML5 - for licensing and copyright see license.txt */
+
+#include "StdAfx.h"
+#include "D3D11Compositor.h"
+#include "CPluginHTML5.h"
+#include "DX11StateGuard.h"
+
+#include <d3d11.h>
+#include <d3dcompiler.h>
+
+#define TEXTURE_FLAGS FILTER_LINEAR | FT_DONT_STREAM | FT_NOMIPS // texture flags
+
+namespace HTML5Plugin
+{
+    /*
+    Compiled on first use, the quads come from a per instance vertex buffer so
+    every run of quads sharing a texture is a single DrawInstanced( 4, n ) call.
+    */
+    static const char s_sQuadShader[] =
+        "Texture2D txDiffuse : register(t0);\n"
+        "SamplerState texSampler : register(s0);\n"
+        "\n"
+        "struct SQuad\n"
+        "{\n"
+        "    float4 Corner0 : CORNER0;\n"
+        "    float4 Corner1 : CORNER1;\n"
+        "    float4 Corner2 : CORNER2;\n"
+        "    float4 Corner3 : CORNER3;\n"
+        "    float4 Source : SOURCE;\n"
+        "};\n"
+        "\n"
+        "struct VSQuadOutput\n"
+        "{\n"
+        "    float4 Position : SV_POSITION;\n"
+        "    float2 TexCoords0 : TEXCOORD0;\n"
+        "};\n"
+        "\n"
+        "VSQuadOutput VSMain( uint VertexID : SV_VertexID, SQuad quad )\n"
+        "{\n"
+        "    float2 corner = float2( VertexID & 1, VertexID >> 1 );\n"
+        "    float4 position[4] = { quad.Corner0, quad.Corner1, quad.Corner2, quad.Corner3 };\n"
+        "\n"
+        "    // clip space corners so projected world quads are perspective correct\n"
+        "    VSQuadOutput output;\n"
+        "    output.Position = position[VertexID];\n"
+        "    output.TexCoords0 = lerp( quad.Source.xy, quad.Source.zw, corner );\n"
+        "    return output;\n"
+        "}\n"
+        "\n"
+        "float4 PSMain( VSQuadOutput input ) : SV_Target\n"
+        "{\n"
+        "    // same channel order as the fullscreen triangle\n"
+        "    return txDiffuse.Sample( texSampler, input.TexCoords0 ).bgra;\n"
+        "}\n"
+        "\n"
+        "float4 PSMainNative( VSQuadOutput input ) : SV_Target\n"
+        "{\n"
+        "    // textures in BGRA format like the shared ones of accelerated rendering\n"
+        "    return txDiffuse.Sample( texSampler, input.TexCoords0 );\n"
+        "}\n";
+
+    /** @brief compile an entry point of the quad shader */
+    static ID3DBlob* CompileQuadShader( const char* sEntry, const char* sTarget )
+    {
+        ID3DBlob* pCode = NULL;
+        ID3DBlob* pErrors = NULL;
+
+        HRESULT hr = D3DCompile( s_sQuadShader, sizeof( s_sQuadShader ) - 1, "CryHTML5Quad", NULL, NULL, sEntry, sTarget, D3DCOMPILE_OPTIMIZATION_LEVEL3, 0, &pCode, &pErrors );
+
+        if ( FAILED( hr ) )
+        {
+            gPlugin->LogWarning( "Compiling %s failed: %s", sEntry, pErrors ? static_cast<const char*>( pErrors->GetBufferPointer() ) : "" );
+            SAFE_RELEASE( pCode );
+        }
+
+        SAFE_RELEASE( pErrors );
+        return pCode;
+    }
+
+    CD3D11Compositor::CD3D11Compositor()
+        : m_nBatches( 0 )
+        , m_bResources( false )
+        , m_pVertexShader( NULL )
+        , m_pPixelShader( NULL )
+        , m_pPixelShaderNative( NULL )
+        , m_pInputLayout( NULL )
+        , m_pBlendState( NULL )
+        , m_pInstanceBuffer( NULL )
+        , m_nInstanceCapacity( 0 )
+    {
+    }
+
+    CD3D11Compositor::~CD3D11Compositor()
+    {
+        // the renderer may already be shut down, its textures are left to it
+        for ( size_t i = 0; i < m_pages.size(); ++i )
+        {
+            SAFE_RELEASE( m_pages[i].pSRV );
+        }
+
+        SAFE_RELEASE( m_pVertexShader );
+        SAFE_RELEASE( m_pPixelShader );
+        SAFE_RELEASE( m_pPixelShaderNative );
+        SAFE_RELEASE( m_pInputLayout );
+        SAFE_RELEASE( m_pBlendState );
+        SAFE_RELEASE( m_pInstanceBuffer );
+    }
+
+    void CD3D11Compositor::Configure( int nPageSize, int nMaxPages )
+    {
+        if ( nPageSize == m_packer.GetPageSize() )
+        {
+            return;
+        }
+
+        ReleasePages();
+
+        // one pixel gap against bleeding when a quad is filtered
+        m_packer.Configure( nPageSize, nMaxPages, 1 );
+    }
+
+    void CD3D11Compositor::ReleasePages()
+    {
+        for ( size_t i = 0; i < m_pages.size(); ++i )
+        {
+            SAFE_RELEASE( m_pages[i].pSRV );
+
+            if ( m_pages[i].pITexture )
+            {
+                m_pages[i].pITexture->Release();
+            }
+        }
+
+        m_pages.clear();
+    }
+
+    CD3D11Compositor::SPage* CD3D11Compositor::GetPage( int nPage )
+    {
+        while ( int( m_pages.size() ) <= nPage )
+        {
+            SPage page = { NULL, NULL, NULL };
+            m_pages.push_back( page );
+        }
+
+        SPage& page = m_pages[nPage];
+
+        if ( page.pSRV )
+        {
+            return &page;
+        }
+
+        const int nSize = m_packer.GetPageSize();
+        page.pITexture = gD3DSystem->CreateTexture( ( void** )&page.pTexture, nSize, nSize, 1, eTF_X8R8G8B8, TEXTURE_FLAGS );
+
+        if ( !page.pTexture )
+        {
+            return nullptr;
+        }
+
+        D3D11_TEXTURE2D_DESC texdesc = {0};
+        page.pTexture->GetDesc( &texdesc );
+
+        D3D11_SHADER_RESOURCE_VIEW_DESC srvdesc;
+        ZeroMemory( &srvdesc, sizeof( D3D11_SHADER_RESOURCE_VIEW_DESC ) );
+
+        srvdesc.Format = texdesc.Format;
+        srvdesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
+        srvdesc.Texture2D.MipLevels = texdesc.MipLevels;
+        srvdesc.Texture2D.MostDetailedMip = texdesc.MipLevels - 1;
+
+        ID3D11Device* pDevice = static_cast<ID3D11Device*>( gD3DSystem->GetDevice() );
+        HRESULT hr = pDevice->CreateShaderResourceView( page.pTexture, &srvdesc, &page.pSRV );
+
+        if ( FAILED( hr ) )
+        {
+            gPlugin->LogWarning( "Atlas page %d: CreateShaderResourceView failed hr=%d", nPage, hr );
+
+            // try again with a new texture
+            page.pITexture->Release();
+            page.pITexture = NULL;
+            page.pTexture = NULL;
+            return nullptr;
+        }
+
+        gPlugin->LogAlways( "Atlas page %d: %dx%d", nPage, nSize, nSize );
+        return &page;
+    }
+
+    void CD3D11Compositor::Upload( THandle hEntry, const uint8* pSource, int nPitch, const SDirtyRect* pRects, int nRects )
+    {
+        const SAtlasEntry* pEntry = m_packer.Get( hEntry );
+        SPage* pPage = pEntry && pEntry->bPlaced ? GetPage( pEntry->nPage ) : nullptr;
+
+        if ( !pPage )
+        {
+            return;
+        }
+
+        ID3D11Device* pDevice = static_cast<ID3D11Device*>( gD3DSystem->GetDevice() );
+
+        ID3D11DeviceContext* pContext = NULL;
+        pDevice->GetImmediateContext( &pContext );
+
+        for ( int i = 0; i < nRects; ++i )
+        {
+            const SDirtyRect rect = pEntry->ToPage( pRects[i] );
+
+            if ( rect.IsEmpty() )
+            {
+                continue;
+            }
+
+            D3D11_BOX box = {0};
+            box.front = 0;
+            box.back = 1;
+
+            box.left = rect.x;
+            box.right = rect.x2;
+            box.top = rect.y;
+            box.bottom = rect.y2;
+
+            // source rows start at the unmapped rect
+            const uint8* pSrc = pSource + ( rect.y - pEntry->rect.y ) * nPitch + ( rect.x - pEntry->rect.x ) * 4;
+
+            pContext->UpdateSubresource( pPage->pTexture, 0, &box, pSrc, nPitch, 0 );
+        }
+
+        SAFE_RELEASE( pContext );
+    }
+
+    bool CD3D11Compositor::GetScreenQuad( float fX, float fY, int nWidth, int nHeight, SClipQuad& quad )
+    {
+        int x, y, width, height;
+        gEnv->pRenderer->GetViewport( &x, &y, &width, &height );
+
+        if ( width <= 0 || height <= 0 )
+        {
+            return false;
+        }
+
+        quad = SClipQuad::FromScreen( fX, fY, float( nWidth ), float( nHeight ), width, height );
+        return true;
+    }
+
+    void CD3D11Compositor::Queue( ID3D11ShaderResourceView* pSRV, bool bNative, const SDirtyRect& source, int nTextureWidth, int nTextureHeight, const SClipQuad& quad )
+    {
+        if ( nTextureWidth <= 0 || nTextureHeight <= 0 )
+        {
+            return;
+        }
+
+        SInstance instance;
+        instance.dest = quad;
+
+        instance.source[0] = float( source.x ) / nTextureWidth;
+        instance.source[1] = float( source.y ) / nTextureHeight;
+        instance.source[2] = float( source.x2 ) / nTextureWidth;
+        instance.source[3] = float( source.y2 ) / nTextureHeight;
+
+        m_instances.push_back( instance );
+        m_textures.push_back( pSRV );
+        m_native.push_back( bNative );
+    }
+
+    void CD3D11Compositor::QueueEntry( THandle hEntry, const SClipQuad& quad )
+    {
+        const SAtlasEntry* pEntry = m_packer.Get( hEntry );
+        SPage* pPage = pEntry && pEntry->bPlaced ? GetPage( pEntry->nPage ) : nullptr;
+
+        if ( pPage )
+        {
+            Queue( pPage->pSRV, false, pEntry->rect, m_packer.GetPageSize(), m_packer.GetPageSize(), quad );
+        }
+    }
+
+    void CD3D11Compositor::QueueEntry( THandle hEntry, float fX, float fY )
+    {
+        const SAtlasEntry* pEntry = m_packer.Get( hEntry );
+        SClipQuad quad;
+
+        if ( pEntry && GetScreenQuad( fX, fY, pEntry->nWidth, pEntry->nHeight, quad ) )
+        {
+            QueueEntry( hEntry, quad );
+        }
+    }
+
+    void CD3D11Compositor::QueueTexture( ID3D11ShaderResourceView* pSRV, int nWidth, int nHeight, const SClipQuad& quad, bool bNative )
+    {
+        if ( pSRV )
+        {
+            Queue( pSRV, bNative, SDirtyRect( 0, 0, nWidth, nHeight ), nWidth, nHeight, quad );
+        }
+    }
+
+    void CD3D11Compositor::QueueTextureRect( ID3D11ShaderResourceView* pSRV, int nWidth, int nHeight, const SDirtyRect& source, const SClipQuad& quad, bool bNative )
+    {
+        if ( pSRV )
+        {
+            Queue( pSRV, bNative, source, nWidth, nHeight, quad );
+        }
+    }
+
+    void CD3D11Compositor::QueueTexture( ID3D11ShaderResourceView* pSRV, int nWidth, int nHeight, float fX, float fY, bool bNative )
+    {
+        SClipQuad quad;
+
+        if ( GetScreenQuad( fX, fY, nWidth, nHeight, quad ) )
+        {
+            QueueTexture( pSRV, nWidth, nHeight, quad, bNative );
+        }
+    }
+
+    bool CD3D11Compositor::CreateResources()
+    {
+        if ( m_bResources )
+        {
+            return m_pVertexShader && m_pPixelShader && m_pPixelShaderNative && m_pInputLayout && m_pBlendState;
+        }
+
+        m_bResources = true;
+
+        ID3D11Device* pDevice = static_cast<ID3D11Device*>( gD3DSystem->GetDevice() );
+
+        ID3DBlob* pVS = CompileQuadShader( "VSMain", "vs_4_0" );
+        ID3DBlob* pPS = CompileQuadShader( "PSMain", "ps_4_0" );
+        ID3DBlob* pPSNative = CompileQuadShader( "PSMainNative", "ps_4_0" );
+
+        if ( pVS && pPS && pPSNative )
+        {
+            pDevice->CreateVertexShader( pVS->GetBufferPointer(), pVS->GetBufferSize(), NULL, &m_pVertexShader );
+            pDevice->CreatePixelShader( pPS->GetBufferPointer(), pPS->GetBufferSize(), NULL, &m_pPixelShader );
+            pDevice->CreatePixelShader( pPSNative->GetBufferPointer(), pPSNative->GetBufferSize(), NULL, &m_pPixelShaderNative );
+
+            D3D11_INPUT_ELEMENT_DESC layout[] =
+            {
+                { "CORNER", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 0, 0, D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+                { "CORNER", 1, DXGI_FORMAT_R32G32B32A32_FLOAT, 0, 16, D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+                { "CORNER", 2, DXGI_FORMAT_R32G32B32A32_FLOAT, 0, 32, D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+                { "CORNER", 3, DXGI_FORMAT_R32G32B32A32_FLOAT, 0, 48, D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+                { "SOURCE", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 0, 64, D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+            };
+
+            pDevice->CreateInputLayout( layout, 5, pVS->GetBufferPointer(), pVS->GetBufferSize(), &m_pInputLayout );
+        }
+
+        SAFE_RELEASE( pVS );
+        SAFE_RELEASE( pPS );
+        SAFE_RELEASE( pPSNative );
+
+        // Create a One/InvSrcAlpha blend state
+        D3D11_BLEND_DESC blendDesc = { 0 };
+        blendDesc.AlphaToCoverageEnable  = false;
+        blendDesc.IndependentBlendEnable = false;
+
+        blendDesc.RenderTarget[0].BlendEnable            = true;
+        blendDesc.RenderTarget[0].BlendOp                = D3D11_BLEND_OP_ADD;
+        blendDesc.RenderTarget[0].BlendOpAlpha           = D3D11_BLEND_OP_ADD;
+        blendDesc.RenderTarget[0].DestBlend              = D3D11_BLEND_INV_SRC_ALPHA;
+        blendDesc.RenderTarget[0].DestBlendAlpha         = D3D11_BLEND_ONE;
+        blendDesc.RenderTarget[0].RenderTargetWriteMask  = D3D11_COLOR_WRITE_ENABLE_ALL;
+        blendDesc.RenderTarget[0].SrcBlend               = D3D11_BLEND_ONE;
+        blendDesc.RenderTarget[0].SrcBlendAlpha          = D3D11_BLEND_ONE;
+
+        pDevice->CreateBlendState( &blendDesc, &m_pBlendState );
+
+        return m_pVertexShader && m_pPixelShader && m_pPixelShaderNative && m_pInputLayout && m_pBlendState;
+    }
+
+    void CD3D11Compositor::Flush()
+    {
+        m_nBatches = 0;
+
+        if ( m_instances.empty() || !CreateResources() )
+        {
+            m_instances.clear();
+            m_textures.clear();
+            m_native.clear();
+            return;
+        }
+
+        ID3D11Device* pDevice = static_cast<ID3D11Device*>( gD3DSystem->GetDevice() );
+        ID3D11DeviceContext* pContext = NULL;
+        pDevice->GetImmediateContext( &pContext );
+
+        // grow the instance buffer in powers of two
+        if ( m_instances.size() > m_nInstanceCapacity )
+        {
+            SAFE_RELEASE( m_pInstanceBuffer );
+
+            m_nInstanceCapacity = max( m_nInstanceCapacity, size_t( 64 ) );
+
+            while ( m_nInstanceCapacity < m_instances.size() )
+            {
+                m_nInstanceCapacity *= 2;
+            }
+
+            D3D11_BUFFER_DESC desc = { 0 };
+            desc.ByteWidth = UINT( m_nInstanceCapacity * sizeof( SInstance ) );
+            desc.Usage = D3D11_USAGE_DYNAMIC;
+            desc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+            desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+
+            if ( FAILED( pDevice->CreateBuffer( &desc, NULL, &m_pInstanceBuffer ) ) )
+            {
+                m_nInstanceCapacity = 0;
+            }
+        }
+
+        D3D11_MAPPED_SUBRESOURCE mapped;
+
+        if ( m_pInstanceBuffer && SUCCEEDED( pContext->Map( m_pInstanceBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped ) ) )
+        {
+            memcpy( mapped.pData, &m_instances[0], m_instances.size() * sizeof( SInstance ) );
+            pContext->Unmap( m_pInstanceBuffer, 0 );
+
+            CDX11MinimalStateGuard stateGuard( pContext );
+
+            const UINT nStride = sizeof( SInstance );
+            const UINT nOffset = 0;
+
+            pContext->IASetInputLayout( m_pInputLayout );
+            pContext->IASetIndexBuffer( NULL, DXGI_FORMAT_UNKNOWN, 0 );
+            pContext->IASetVertexBuffers( 0, 1, &m_pInstanceBuffer, &nStride, &nOffset );
+            pContext->IASetPrimitiveTopology( D3D11_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP );
+
+            pContext->VSSetShader( m_pVertexShader, NULL, 0 );
+            ID3D11SamplerState* pNullSampler[] = { NULL };
+            pContext->PSSetSamplers( 0, 1, pNullSampler );
+
+            pContext->OMSetBlendState( m_pBlendState, NULL, 0xFFFFFFFF );
+
+            // one call per run of quads sharing a texture, runs keep the queue order for overlapping quads
+            for ( size_t nStart = 0; nStart < m_instances.size(); )
+            {
+                size_t nEnd = nStart + 1;
+
+                while ( nEnd < m_instances.size() && m_textures[nEnd] == m_textures[nStart] && m_native[nEnd] == m_native[nStart] )
+                {
+                    ++nEnd;
+                }
+
+                if ( nStart == 0 || m_native[nStart] != m_native[nStart - 1] )
+                {
+                    pContext->PSSetShader( m_native[nStart] ? m_pPixelShaderNative : m_pPixelShader, NULL, 0 );
+                }
+
+                pContext->PSSetShaderResources( 0, 1, &m_textures[nStart] );
+                pContext->DrawInstanced( 4, UINT( nEnd - nStart ), 0, UINT( nStart ) );
+
+                ++m_nBatches;
+                nStart = nEnd;
+            }
+        }
+
+        SAFE_RELEASE( pContext );
+
+        m_instances.clear();
+        m_textures.clear();
+        m_native.clear();
+    }
+
+    CD3D11AtlasDevice::CD3D11AtlasDevice()
+        : m_pCompositor( nullptr )
+        , m_hEntry( 0 )
+        , m_nVersion( 0 )
+    {
+    }
+
+    CD3D11AtlasDevice::~CD3D11AtlasDevice()
+    {
+        ReleaseSurface();
+    }
+
+    void CD3D11AtlasDevice::SetCompositor( CD3D11Compositor* pCompositor )
+    {
+        if ( pCompositor != m_pCompositor )
+        {
+            ReleaseSurface();
+            m_pCompositor = pCompositor;
+        }
+    }
+
+    bool CD3D11AtlasDevice::CreateSurface( int nWidth, int nHeight )
+    {
+        if ( !m_pCompositor )
+        {
+            return false;
+        }
+
+        CAtlasPacker& packer = m_pCompositor->GetPacker();
+        const SAtlasEntry* pEntry = packer.Get( m_hEntry );
+
+        // moved by a repack, keep the place and upload everything again
+        if ( !pEntry || !pEntry->bPlaced || pEntry->nWidth != nWidth || pEntry->nHeight != nHeight )
+        {
+            ReleaseSurface();
+
+            m_hEntry = packer.Allocate( nWidth, nHeight );
+            pEntry = packer.Get( m_hEntry );
+        }
+
+        if ( !pEntry )
+        {
+            return false;
+        }
+
+        m_nVersion = pEntry->nVersion;
+        return true;
+    }
+
+    void CD3D11AtlasDevice::ReleaseSurface()
+    {
+        if ( m_pCompositor )
+        {
+            m_pCompositor->GetPacker().Free( m_hEntry );
+        }
+
+        m_hEntry = 0;
+    }
+
+    bool CD3D11AtlasDevice::HasSurface() const
+    {
+        const SAtlasEntry* pEntry = m_pCompositor ? m_pCompositor->GetPacker().Get( m_hEntry ) : nullptr;
+        return pEntry && pEntry->bPlaced && pEntry->nVersion == m_nVersion;
+    }
+
+    void CD3D11AtlasDevice::Upload( const uint8* pSource, int nPitch, const SDirtyRect* pRects, int nRects )
+    {
+        m_pCompositor->Upload( m_hEntry, pSource, nPitch, pRects, nRects );
+    }
+
+    void CD3D11AtlasDevice::Queue( float fX, float fY )
+    {
+        if ( m_pCompositor )
+        {
+            m_pCompositor->QueueEntry( m_hEntry, fX, fY );
+        }
+    }
+
+    void CD3D11AtlasDevice::Queue( const SClipQuad& quad )
+    {
+        if ( m_pCompositor )
+        {
+            m_pCompositor->QueueEntry( m_hEntry, quad );
+        }
+    }
+}
@@ -0,0 +1,186 @@
+/* CryHTML5 - for licensing and copyright see license.txt */
+
+#pragma once
+
+#include <vector>
+
+#include <SurfacePipeline.h>
+#include <AtlasPacker.h>
+#include <WorldQuad.h>
+
+struct ID3D11Texture2D;
+struct ID3D11ShaderResourceView;
+struct ID3D11VertexShader;
+struct ID3D11PixelShader;
+struct ID3D11InputLayout;
+struct ID3D11BlendState;
+struct ID3D11Buffer;
+struct ITexture;
+
+namespace HTML5Plugin
+{
+    /**
+    * @brief Draws view surfaces as screen rectangles or projected world quads in instanced batches.
+    * Small surfaces share atlas pages so consecutive quads of the same page are drawn with a single call.
+    */
+    class CD3D11Compositor
+    {
+        public:
+            typedef CAtlasPacker::THandle THandle;
+
+            CD3D11Compositor();
+            ~CD3D11Compositor();
+
+            /**
+            * @brief set the atlas layout, surfaces packed before are invalidated when it changed
+            * @param nPageSize width and height of an atlas page (0 disables the atlas)
+            * @param nMaxPages maximum number of atlas pages
+            */
+            void Configure( int nPageSize, int nMaxPages );
+
+            /** @return the atlas packer (placement and statistics) */
+            CAtlasPacker& GetPacker()
+            {
+                return m_packer;
+            }
+
+            /**
+            * @brief copy rects of a surface into its atlas area
+            * @param hEntry atlas surface
+            * @param pSource complete frame of the surface (4 bytes per pixel)
+            * @param nPitch bytes per row of pSource
+            * @param pRects rects in surface pixels
+            * @param nRects number of rects
+            */
+            void Upload( THandle hEntry, const uint8* pSource, int nPitch, const SDirtyRect* pRects, int nRects );
+
+            /**
+            * @brief queue a quad showing an atlas surface
+            * @param hEntry atlas surface
+            * @param fX left of the quad in viewport pixels
+            * @param fY top of the quad in viewport pixels
+            */
+            void QueueEntry( THandle hEntry, float fX, float fY );
+
+            /** @brief queue a quad in clip space showing an atlas surface */
+            void QueueEntry( THandle hEntry, const SClipQuad& quad );
+
+            /**
+            * @brief queue a quad showing a texture of its own
+            * @param pSRV texture to show
+            * @param nWidth size of the texture, the quad has the same size
+            * @param nHeight
+            * @param fX left of the quad in viewport pixels
+            * @param fY top of the quad in viewport pixels
+            * @param bNative the texture is in BGRA format (shared textures), otherwise red and blue are swapped like for uploaded frames
+            */
+            void QueueTexture( ID3D11ShaderResourceView* pSRV, int nWidth, int nHeight, float fX, float fY, bool bNative = false );
+
+            /** @brief queue a quad in clip space showing a texture of its own */
+            void QueueTexture( ID3D11ShaderResourceView* pSRV, int nWidth, int nHeight, const SClipQuad& quad, bool bNative = false );
+
+            /**
+            * @brief queue a quad in clip space showing part of a texture of its own
+            * @param pSRV texture to show
+            * @param nWidth size of the texture
+            * @param nHeight
+            * @param source part of the texture in pixels
+            * @param quad corners in clip space
+            * @param bNative the texture is in BGRA format
+            */
+            void QueueTextureRect( ID3D11ShaderResourceView* pSRV, int nWidth, int nHeight, const SDirtyRect& source, const SClipQuad& quad, bool bNative = false );
+
+            /** @brief draw all queued quads in queue order, one call per run of quads using the same texture */
+            void Flush();
+
+            /** @return draw calls issued by the last flush */
+            int GetBatches() const
+            {
+                return m_nBatches;
+            }
+
+        private:
+            /** @brief vertex buffer layout of a quad */
+            struct SInstance
+            {
+                SClipQuad dest; //!< corners in clip space
+                float source[4]; //!< left, top, right, bottom in texture coordinates
+            };
+
+            /** @brief texture of an atlas page */
+            struct SPage
+            {
+                ITexture* pITexture; //!< the CryENGINE texture
+                ID3D11Texture2D* pTexture; //!< the Direct3D 11 texture
+                ID3D11ShaderResourceView* pSRV; //!< the Direct3D 11 texture resource
+            };
+
+            bool CreateResources();
+            void ReleasePages();
+
+            /** @return the page texture, created on first use */
+            SPage* GetPage( int nPage );
+
+            /** @brief queue a quad */
+            void Queue( ID3D11ShaderResourceView* pSRV, bool bNative, const SDirtyRect& source, int nTextureWidth, int nTextureHeight, const SClipQuad& quad );
+
+            /**
+            * @brief get the clip space quad of a screen rectangle
+            * @return false without a viewport
+            */
+            static bool GetScreenQuad( float fX, float fY, int nWidth, int nHeight, SClipQuad& quad );
+
+            CAtlasPacker m_packer; //!< placement of the atlas surfaces
+            std::vector<SPage> m_pages; //!< atlas page textures
+
+            std::vector<SInstance> m_instances; //!< quads queued this frame
+            std::vector<ID3D11ShaderResourceView*> m_textures; //!< texture of each queued quad
+            std::vector<bool> m_native; //!< channel order of each queued quad (true = BGRA)
+            int m_nBatches; //!< draw calls of the last flush
+
+            bool m_bResources; //!< shader creation was tried
+            ID3D11VertexShader* m_pVertexShader;
+            ID3D11PixelShader* m_pPixelShader; //!< swaps red and blue of uploaded frames
+            ID3D11PixelShader* m_pPixelShaderNative; //!< reads BGRA textures as they are
+            ID3D11InputLayout* m_pInputLayout;
+            ID3D11BlendState* m_pBlendState;
+            ID3D11Buffer* m_pInstanceBuffer; //!< dynamic buffer of the quads
+            size_t m_nInstanceCapacity; //!< quads fitting into m_pInstanceBuffer
+    };
+
+    /** @brief surface device placing a surface into the atlas of a compositor */
+    class CD3D11AtlasDevice : public ISurfaceDevice
+    {
+        public:
+            CD3D11AtlasDevice();
+            ~CD3D11AtlasDevice();
+
+            /** @brief set the compositor owning the atlas, releases the current surface */
+            void SetCompositor( CD3D11Compositor* pCompositor );
+
+            /**
+            * @brief queue the surface for drawing
+            * @param fX left in viewport pixels
+            * @param fY top in viewport pixels
+            */
+            void Queue( float fX, float fY );
+
+            /** @brief queue the surface for drawing on a quad in clip space */
+            void Queue( const SClipQuad& quad );
+
+            // ISurfaceDevice
+            virtual bool CreateSurface( int nWidth, int nHeight ) override;
+            virtual bool OpenSharedSurface( void* /*hShared*/, int /*nWidth*/, int /*nHeight*/ ) override
+            {
+                return false; // shared textures can't be packed
+            }
+            virtual void ReleaseSurface() override;
+            virtual bool HasSurface() const override;
+            virtual void Upload( const uint8* pSource, int nPitch, const SDirtyRect* pRects, int nRects ) override;
+
+        private:
+            CD3D11Compositor* m_pCompositor; //!< compositor owning the atlas
+            CAtlasPacker::THandle m_hEntry; //!< atlas surface
+            uint32 m_nVersion; //!< version of the entry the content was uploaded for
+    };
+}
@@ -0,0 +1,124 @@
+/* CryHTML5 - for licensing and copyright see license.txt */
+
+#include "StdAfx.h"
+#include "D3D11StagingDevice.h"
+#include "CPluginHTML5.h"
+
+#include <d3d11.h>
+
+namespace HTML5Plugin
+{
+    CD3D11StagingDevice::CD3D11StagingDevice()
+        : m_pDevice( NULL )
+        , m_pContext( NULL )
+        , m_pTarget( NULL )
+    {
+    }
+
+    CD3D11StagingDevice::~CD3D11StagingDevice()
+    {
+        for ( size_t i = 0; i < m_staging.size(); ++i )
+        {
+            SAFE_RELEASE( m_staging[i] );
+        }
+
+        SAFE_RELEASE( m_pContext );
+    }
+
+    void CD3D11StagingDevice::SetTarget( ID3D11Device* pDevice, ID3D11DeviceContext* pContext, ID3D11Texture2D* pTarget )
+    {
+        if ( pContext )
+        {
+            pContext->AddRef();
+        }
+
+        SAFE_RELEASE( m_pContext );
+
+        m_pDevice = pDevice;
+        m_pContext = pContext;
+        m_pTarget = pTarget;
+    }
+
+    bool CD3D11StagingDevice::CreateStaging( int nSlot, int nWidth, int nHeight )
+    {
+        if ( !m_pDevice || !m_pTarget )
+        {
+            return false;
+        }
+
+        if ( nSlot >= int( m_staging.size() ) )
+        {
+            m_staging.resize( nSlot + 1, NULL );
+        }
+
+        SAFE_RELEASE( m_staging[nSlot] );
+
+        D3D11_TEXTURE2D_DESC desc = {0};
+        m_pTarget->GetDesc( &desc );
+
+        desc.Width = nWidth;
+        desc.Height = nHeight;
+        desc.MipLevels = 1;
+        desc.ArraySize = 1;
+        desc.Usage = D3D11_USAGE_STAGING;
+        desc.BindFlags = 0;
+        desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+        desc.MiscFlags = 0;
+
+        HRESULT hr = m_pDevice->CreateTexture2D( &desc, NULL, &m_staging[nSlot] );
+
+        if ( FAILED( hr ) )
+        {
+            gPlugin->LogWarning( "CreateStaging(%d) failed hr=%d", nSlot, hr );
+            return false;
+        }
+
+        return true;
+    }
+
+    void CD3D11StagingDevice::ReleaseStaging( int nSlot )
+    {
+        if ( nSlot < int( m_staging.size() ) )
+        {
+            SAFE_RELEASE( m_staging[nSlot] );
+        }
+    }
+
+    bool CD3D11StagingDevice::MapStaging( int nSlot, uint8*& pData, int& nPitch )
+    {
+        D3D11_MAPPED_SUBRESOURCE mapped;
+        HRESULT hr = m_pContext->Map( m_staging[nSlot], 0, D3D11_MAP_WRITE, D3D11_MAP_FLAG_DO_NOT_WAIT, &mapped );
+
+        if ( FAILED( hr ) )
+        {
+            if ( hr != DXGI_ERROR_WAS_STILL_DRAWING )
+            {
+                gPlugin->LogWarning( "MapStaging(%d) failed hr=%d", nSlot, hr );
+            }
+
+            return false;
+        }
+
+        pData = static_cast<uint8*>( mapped.pData );
+        nPitch = int( mapped.RowPitch );
+        return true;
+    }
+
+    void CD3D11StagingDevice::UnmapStaging( int nSlot )
+    {
+        m_pContext->Unmap( m_staging[nSlot], 0 );
+    }
+
+    void CD3D11StagingDevice::CopyToTarget( int nSlot, const SDirtyRect& rect )
+    {
+        D3D11_BOX box = {0};
+        box.left = rect.x;
+        box.right = rect.x2;
+        box.top = rect.y;
+        box.bottom = rect.y2;
+        box.front = 0;
+        box.back = 1;
+
+        m_pContext->CopySubresourceRegion( m_pTarget, 0, rect.x, rect.y, 0, m_staging[nSlot], 0, &box );
+    }
+}
@@ -0,0 +1,41 @@
+/* CryHTML5 - for licensing and copyright see license.txt */
+
+#pragma once
+
+#include <StagingRing.h>
+
+struct ID3D11Device;
+struct ID3D11DeviceContext;
+struct ID3D11Texture2D;
+
+namespace HTML5Plugin
+{
+    /** @brief Direct3D 11 staging textures copied into a default usage target texture */
+    class CD3D11StagingDevice : public IStagingDevice
+    {
+        public:
+            CD3D11StagingDevice();
+            ~CD3D11StagingDevice();
+
+            /**
+            * @brief set the texture the staging textures are copied into
+            * @param pDevice device to create the staging textures with
+            * @param pContext context to map and copy with
+            * @param pTarget default usage target texture (its format is used for the staging textures)
+            */
+            void SetTarget( ID3D11Device* pDevice, ID3D11DeviceContext* pContext, ID3D11Texture2D* pTarget );
+
+            // IStagingDevice
+            virtual bool CreateStaging( int nSlot, int nWidth, int nHeight ) override;
+            virtual void ReleaseStaging( int nSlot ) override;
+            virtual bool MapStaging( int nSlot, uint8*& pData, int& nPitch ) override;
+            virtual void UnmapStaging( int nSlot ) override;
+            virtual void CopyToTarget( int nSlot, const SDirtyRect& rect ) override;
+
+        private:
+            ID3D11Device* m_pDevice;
+            ID3D11DeviceContext* m_pContext;
+            ID3D11Texture2D* m_pTarget;
+            std::vector<ID3D11Texture2D*> m_staging; //!< staging texture per slot
+    };
+}
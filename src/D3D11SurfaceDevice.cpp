@@ -0,0 +1,237 @@
+/* CryHTML5 - for licensing and copyright see license.txt */
+
+#include "StdAfx.h"
+#include "D3D11SurfaceDevice.h"
+#include "CPluginHTML5.h"
+#include "BlockCompression.h"
+
+#include <d3d11.h>
+
+#define TEXTURE_FLAGS FILTER_LINEAR | FT_DONT_STREAM | FT_NOMIPS // texture flags
+
+namespace HTML5Plugin
+{
+    CD3D11SurfaceDevice::CD3D11SurfaceDevice()
+        : m_pTexture( NULL )
+        , m_pITexture( NULL )
+        , m_hShared( nullptr )
+        , m_pSRV( NULL )
+        , m_nWidth( 0 )
+        , m_nHeight( 0 )
+        , m_pCompressed( NULL )
+        , m_pCompressedSRV( NULL )
+        , m_nStagingSlots( 0 )
+        , m_nStagingWanted( 0 )
+    {
+    }
+
+    CD3D11SurfaceDevice::~CD3D11SurfaceDevice()
+    {
+        // the renderer may already be shut down, its texture is left to it
+        m_stagingRing.Release();
+        SAFE_RELEASE( m_pSRV );
+        SAFE_RELEASE( m_pCompressedSRV );
+        SAFE_RELEASE( m_pCompressed );
+
+        if ( m_hShared )
+        {
+            SAFE_RELEASE( m_pTexture );
+        }
+    }
+
+    bool CD3D11SurfaceDevice::CreateSurface( int nWidth, int nHeight )
+    {
+        m_pITexture = gD3DSystem->CreateTexture( ( void** )&m_pTexture, nWidth, nHeight, 1,  eTF_X8R8G8B8, TEXTURE_FLAGS ); //FT_USAGE_RENDERTARGET?
+        m_nWidth = nWidth;
+        m_nHeight = nHeight;
+
+        gPlugin->LogAlways( "CreateTexture: %p, %p", m_pTexture, m_pITexture );
+
+        if ( !m_pTexture )
+        {
+            return false;
+        }
+
+        return CreateSRV();
+    }
+
+    bool CD3D11SurfaceDevice::OpenSharedSurface( void* hShared, int nWidth, int nHeight )
+    {
+        if ( m_pSRV && hShared == m_hShared )
+        {
+            return true;
+        }
+
+        ReleaseSurface();
+
+        ID3D11Device* pDevice = static_cast<ID3D11Device*>( gD3DSystem->GetDevice() );
+        HRESULT hr = pDevice->OpenSharedResource( HANDLE( hShared ), __uuidof( ID3D11Texture2D ), ( void** )&m_pTexture );
+
+        if ( FAILED( hr ) || !m_pTexture )
+        {
+            gPlugin->LogWarning( "OpenSharedResource failed: %p", hShared );
+            m_pTexture = NULL;
+            return false;
+        }
+
+        m_hShared = hShared;
+        m_nWidth = nWidth;
+        m_nHeight = nHeight;
+
+        return CreateSRV();
+    }
+
+    bool CD3D11SurfaceDevice::CreateSRV()
+    {
+        ID3D11Device* pDevice = static_cast<ID3D11Device*>( gD3DSystem->GetDevice() );
+
+        D3D11_TEXTURE2D_DESC texdesc = {0};
+        m_pTexture->GetDesc( &texdesc );
+
+        D3D11_SHADER_RESOURCE_VIEW_DESC srvdesc;
+        ZeroMemory( &srvdesc, sizeof( D3D11_SHADER_RESOURCE_VIEW_DESC ) );
+
+        srvdesc.Format = texdesc.Format;
+        srvdesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
+        srvdesc.Texture2D.MipLevels = texdesc.MipLevels;
+        srvdesc.Texture2D.MostDetailedMip = texdesc.MipLevels - 1;
+
+        HRESULT hr = pDevice->CreateShaderResourceView( m_pTexture, &srvdesc, &m_pSRV );
+
+        if ( FAILED( hr ) )
+        {
+            gPlugin->LogAlways( "Fail CreateShaderResourceView" );
+
+            // try again with a new texture
+            ReleaseSurface();
+            return false;
+        }
+
+        gPlugin->LogAlways( "CreateShaderResourceView: %p", m_pSRV );
+        return true;
+    }
+
+    bool CD3D11SurfaceDevice::SetCompressed( const uint8* pBlocks, int nWidth, int nHeight )
+    {
+        if ( m_hShared || !HasSurface() || ( nWidth & 3 ) || ( nHeight & 3 ) )
+        {
+            return false;
+        }
+
+        ID3D11Device* pDevice = static_cast<ID3D11Device*>( gD3DSystem->GetDevice() );
+
+        D3D11_TEXTURE2D_DESC texdesc = {0};
+        texdesc.Width = nWidth;
+        texdesc.Height = nHeight;
+        texdesc.MipLevels = 1;
+        texdesc.ArraySize = 1;
+        texdesc.Format = DXGI_FORMAT_BC3_UNORM;
+        texdesc.SampleDesc.Count = 1;
+        texdesc.Usage = D3D11_USAGE_IMMUTABLE;
+        texdesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+
+        D3D11_SUBRESOURCE_DATA data = {0};
+        data.pSysMem = pBlocks;
+        data.SysMemPitch = ( nWidth / 4 ) * eBC3BlockBytes;
+
+        ID3D11Texture2D* pTexture = NULL;
+        ID3D11ShaderResourceView* pSRV = NULL;
+
+        if ( FAILED( pDevice->CreateTexture2D( &texdesc, &data, &pTexture ) ) || FAILED( pDevice->CreateShaderResourceView( pTexture, NULL, &pSRV ) ) )
+        {
+            gPlugin->LogWarning( "Compressed surface %dx%d failed", nWidth, nHeight );
+            SAFE_RELEASE( pTexture );
+            return false;
+        }
+
+        ReleaseSurface();
+
+        m_pCompressed = pTexture;
+        m_pCompressedSRV = pSRV;
+        m_nWidth = nWidth;
+        m_nHeight = nHeight;
+
+        gPlugin->LogAlways( "Compressed surface: %dx%d", nWidth, nHeight );
+        return true;
+    }
+
+    void CD3D11SurfaceDevice::ReleaseSurface()
+    {
+        m_stagingRing.Release();
+        m_nStagingSlots = 0;
+
+        SAFE_RELEASE( m_pSRV );
+        SAFE_RELEASE( m_pCompressedSRV );
+        SAFE_RELEASE( m_pCompressed );
+
+        if ( m_hShared )
+        {
+            SAFE_RELEASE( m_pTexture );
+        }
+
+        else if ( m_pITexture )
+        {
+            m_pITexture->Release();
+        }
+
+        m_pITexture = NULL;
+        m_pTexture = NULL;
+        m_hShared = nullptr;
+    }
+
+    void CD3D11SurfaceDevice::Upload( const uint8* pSource, int nPitch, const SDirtyRect* pRects, int nRects )
+    {
+        // the frame changed again, go back to the uncompressed texture with the complete frame
+        if ( m_pCompressed )
+        {
+            const SDirtyRect full( 0, 0, m_nWidth, m_nHeight );
+
+            ReleaseSurface();
+
+            if ( CreateSurface( full.x2, full.y2 ) )
+            {
+                Upload( pSource, nPitch, &full, 1 );
+            }
+
+            return;
+        }
+
+        ID3D11Device* pDevice = static_cast<ID3D11Device*>( gD3DSystem->GetDevice() );
+
+        ID3D11DeviceContext* pContext = NULL;
+        pDevice->GetImmediateContext( &pContext );
+
+        // (re)create the staging ring when its size changed
+        const int nSlots = clamp_tpl( m_nStagingWanted, 0, int( CStagingRing::eMaxSlots ) );
+
+        if ( nSlots != m_nStagingSlots )
+        {
+            m_nStagingSlots = nSlots;
+            m_stagingDevice.SetTarget( pDevice, pContext, m_pTexture );
+            m_stagingRing.Configure( &m_stagingDevice, nSlots, m_nWidth, m_nHeight );
+        }
+
+        // copy through a staging texture the GPU is done with, update directly when all are still in flight
+        bool bUploaded = m_stagingRing.GetSlots() > 0 && m_stagingRing.Upload( pSource, nPitch, pRects, nRects );
+
+        for ( int i = 0; !bUploaded && i < nRects; ++i )
+        {
+            const SDirtyRect& rect = pRects[i];
+
+            D3D11_BOX box = {0}; // http://msdn.microsoft.com/en-us/library/windows/desktop/ff476486%28v=vs.85%29.aspx
+            box.front = 0;
+            box.back = 1;
+
+            box.left = rect.x;
+            box.right = rect.x2;
+            box.top = rect.y;
+            box.bottom = rect.y2;
+
+            const uint8* pSrc = pSource + box.top * nPitch + box.left * 4;
+
+            pContext->UpdateSubresource( m_pTexture, 0, &box, pSrc, nPitch, 0 );
+        }
+
+        SAFE_RELEASE( pContext );
+    }
+}
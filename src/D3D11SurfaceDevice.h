@@ -0,0 +1,84 @@
+/* CryHTML5 - for licensing and copyright see license.txt */
+
+#pragma once
+
+#include <SurfacePipeline.h>
+#include <StagingRing.h>
+#include <D3D11StagingDevice.h>
+
+struct ID3D11ShaderResourceView;
+struct ITexture;
+
+namespace HTML5Plugin
+{
+    /** @brief CryENGINE texture with a Direct3D 11 shader resource view the surface is uploaded into, or a shared texture opened directly */
+    class CD3D11SurfaceDevice : public ISurfaceDevice
+    {
+        public:
+            CD3D11SurfaceDevice();
+            ~CD3D11SurfaceDevice();
+
+            /** @brief set the number of staging textures uploads rotate through (0 = update directly) */
+            void SetStagingSlots( int nSlots )
+            {
+                m_nStagingWanted = nSlots;
+            }
+
+            /** @return true when the surface is a shared texture (BGRA) */
+            bool IsShared() const
+            {
+                return m_hShared != nullptr;
+            }
+
+            /** @return true when the surface was replaced by a BC3 copy */
+            bool IsCompressed() const
+            {
+                return m_pCompressed != NULL;
+            }
+
+            /**
+            * @brief replace the surface by a BC3 copy and release the uncompressed texture,
+            * the next upload brings the uncompressed texture back with the complete frame
+            * @param pBlocks BC3 blocks of the surface
+            * @param nWidth size of the surface (multiples of 4)
+            * @param nHeight
+            * @return false when the texture can't be created, the surface stays as it is then
+            */
+            bool SetCompressed( const uint8* pBlocks, int nWidth, int nHeight );
+
+            /** @return the shader resource view of the surface */
+            ID3D11ShaderResourceView* GetSRV() const
+            {
+                return m_pCompressedSRV ? m_pCompressedSRV : m_pSRV;
+            }
+
+            // ISurfaceDevice
+            virtual bool CreateSurface( int nWidth, int nHeight ) override;
+            virtual bool OpenSharedSurface( void* hShared, int nWidth, int nHeight ) override;
+            virtual void ReleaseSurface() override;
+            virtual bool HasSurface() const override
+            {
+                return m_pTexture != NULL || m_pCompressed != NULL;
+            }
+            virtual void Upload( const uint8* pSource, int nPitch, const SDirtyRect* pRects, int nRects ) override;
+
+        private:
+            /** @brief create the shader resource view of m_pTexture */
+            bool CreateSRV();
+
+            ID3D11Texture2D* m_pTexture; //!< the Direct3D 11 texture
+            ITexture* m_pITexture; //!< the CryENGINE texture
+            void* m_hShared; //!< shared handle m_pTexture was opened from (it has no CryENGINE texture then)
+            ID3D11ShaderResourceView* m_pSRV; //!< the Direct3D 11 texture resource
+            int m_nWidth; //!< surface size
+            int m_nHeight;
+
+            ID3D11Texture2D* m_pCompressed; //!< BC3 copy of a surface that stopped changing
+            ID3D11ShaderResourceView* m_pCompressedSRV; //!< shader resource view of m_pCompressed
+
+            CD3D11StagingDevice m_stagingDevice; //!< staging textures for the upload ring
+            CStagingRing m_stagingRing; //!< ring uploading without stalling on textures in flight
+            int m_nStagingSlots; //!< ring size the ring was configured for
+            int m_nStagingWanted; //!< ring size requested
+    };
+}
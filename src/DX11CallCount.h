@@ -0,0 +1,44 @@
+/* CryHTML5 - for licensing and copyright see license.txt */
+
+#pragma once
+
+namespace HTML5Plugin
+{
+    /** @brief context calls made by a state guard (instrumentation) */
+    struct SDX11CallCount
+    {
+        uint32 nGets; //!< state queries
+        uint32 nSets; //!< state changes
+        uint32 nReleases; //!< references released
+
+        SDX11CallCount()
+            : nGets( 0 )
+            , nSets( 0 )
+            , nReleases( 0 )
+        {
+        }
+
+        uint32 GetTotal() const
+        {
+            return nGets + nSets + nReleases;
+        }
+    };
+
+    /** @brief count a state query right after making it (pCount may be nullptr) */
+    inline void CountGet( SDX11CallCount* pCount )
+    {
+        if ( pCount )
+        {
+            ++pCount->nGets;
+        }
+    }
+
+    /** @brief count a state change or draw right after making it (pCount may be nullptr) */
+    inline void CountSet( SDX11CallCount* pCount )
+    {
+        if ( pCount )
+        {
+            ++pCount->nSets;
+        }
+    }
+}
@@ -0,0 +1,123 @@
+/* CryHTML5 - for licensing and copyright see license.txt */
+
+#pragma once
+
+#include <DX11CallCount.h>
+
+// Needs the Direct3D 11 declarations (d3d11.h, or a mock context and types for tests)
+
+namespace HTML5Plugin
+{
+    /**
+    * @brief Saves and restores only the state a UI quad or triangle draw changes:
+    * input assembler (layout, index buffer, vertex buffer 0, topology), vertex and pixel shader,
+    * pixel shader sampler and resource 0 and the blend state.
+    * Shader class instances are not kept, the renderer doesn't use them.
+    * @tparam TContext ID3D11DeviceContext or a mock with the same methods
+    */
+    template<class TContext>
+    class CDX11MinimalStateGuardT
+    {
+        public:
+            /**
+            * @param pContext context the draw goes to, kept by the caller
+            * @param pCount receives the number of context calls (optional)
+            */
+            CDX11MinimalStateGuardT( TContext* pContext, SDX11CallCount* pCount = nullptr )
+                : m_pContext( pContext )
+                , m_pCount( pCount )
+            {
+                m_pContext->OMGetBlendState( &m_pBlendState, m_BlendFactor, &m_SampleMask );
+                CountGet( m_pCount );
+                m_pContext->IAGetPrimitiveTopology( &m_PrimitiveTopology );
+                CountGet( m_pCount );
+                m_pContext->IAGetIndexBuffer( &m_pIndexBuffer, &m_IndexBufferFormat, &m_IndexBufferOffset );
+                CountGet( m_pCount );
+                m_pContext->IAGetInputLayout( &m_pInputLayout );
+                CountGet( m_pCount );
+                m_pContext->IAGetVertexBuffers( 0, 1, &m_pVertexBuffer, &m_VertexBufferStride, &m_VertexBufferOffset );
+                CountGet( m_pCount );
+                m_pContext->VSGetShader( &m_pVertexShader, nullptr, nullptr );
+                CountGet( m_pCount );
+                m_pContext->PSGetShader( &m_pPixelShader, nullptr, nullptr );
+                CountGet( m_pCount );
+                m_pContext->PSGetSamplers( 0, 1, &m_pSampler );
+                CountGet( m_pCount );
+                m_pContext->PSGetShaderResources( 0, 1, &m_pResource );
+                CountGet( m_pCount );
+            }
+
+            ~CDX11MinimalStateGuardT()
+            {
+                m_pContext->OMSetBlendState( m_pBlendState, m_BlendFactor, m_SampleMask );
+                CountSet( m_pCount );
+                m_pContext->IASetPrimitiveTopology( m_PrimitiveTopology );
+                CountSet( m_pCount );
+                m_pContext->IASetIndexBuffer( m_pIndexBuffer, m_IndexBufferFormat, m_IndexBufferOffset );
+                CountSet( m_pCount );
+                m_pContext->IASetInputLayout( m_pInputLayout );
+                CountSet( m_pCount );
+                m_pContext->IASetVertexBuffers( 0, 1, &m_pVertexBuffer, &m_VertexBufferStride, &m_VertexBufferOffset );
+                CountSet( m_pCount );
+                m_pContext->VSSetShader( m_pVertexShader, nullptr, 0 );
+                CountSet( m_pCount );
+                m_pContext->PSSetShader( m_pPixelShader, nullptr, 0 );
+                CountSet( m_pCount );
+                m_pContext->PSSetSamplers( 0, 1, &m_pSampler );
+                CountSet( m_pCount );
+                m_pContext->PSSetShaderResources( 0, 1, &m_pResource );
+                CountSet( m_pCount );
+
+                Release( m_pBlendState );
+                Release( m_pIndexBuffer );
+                Release( m_pInputLayout );
+                Release( m_pVertexBuffer );
+                Release( m_pVertexShader );
+                Release( m_pPixelShader );
+                Release( m_pSampler );
+                Release( m_pResource );
+            }
+
+        private:
+            template<class T>
+            void Release( T*& pObject )
+            {
+                if ( pObject )
+                {
+                    pObject->Release();
+                    pObject = nullptr;
+
+                    if ( m_pCount )
+                    {
+                        ++m_pCount->nReleases;
+                    }
+                }
+            }
+
+            TContext* m_pContext;
+            SDX11CallCount* m_pCount;
+
+            ID3D11BlendState* m_pBlendState;
+            FLOAT m_BlendFactor[4];
+            UINT m_SampleMask;
+
+            ID3D11VertexShader* m_pVertexShader;
+            ID3D11PixelShader* m_pPixelShader;
+            ID3D11SamplerState* m_pSampler;
+            ID3D11ShaderResourceView* m_pResource;
+
+            ID3D11InputLayout* m_pInputLayout;
+
+            ID3D11Buffer* m_pIndexBuffer;
+            DXGI_FORMAT m_IndexBufferFormat;
+            UINT m_IndexBufferOffset;
+
+            ID3D11Buffer* m_pVertexBuffer;
+            UINT m_VertexBufferStride;
+            UINT m_VertexBufferOffset;
+
+            D3D11_PRIMITIVE_TOPOLOGY m_PrimitiveTopology;
+    };
+
+    typedef CDX11MinimalStateGuardT<ID3D11DeviceContext> CDX11MinimalStateGuard;
+}
@@ -0,0 +1,166 @@
+/* CryHTML5 - for licensing and copyright see license.txt */
+
+#pragma once
+
+#include <CPluginHTML5.h>
+
+#include <d3d11.h>
+
+#include <DX11MinimalStateGuard.h>
+
+namespace HTML5Plugin
+{
+    // An incomplete DX11 state guard class that saves and restores the
+    // states and resources that will be modified during the drawing in the hooked function
+    // (all slots, CDX11MinimalStateGuard only keeps the ones the UI draws use)
+    class CDX11StateGuard
+    {
+        public:
+            /** @param pCount receives the number of context calls (optional) */
+            CDX11StateGuard( SDX11CallCount* pCount = nullptr )
+                : m_pCount( pCount )
+                , m_VertexShaderClassInstancesCount( D3D11_SHADER_MAX_INTERFACES )
+                , m_PixelShaderClassInstancesCount( D3D11_SHADER_MAX_INTERFACES )
+            {
+                ID3D11Device* pDevice = static_cast<ID3D11Device*>( gD3DSystem->GetDevice() );
+                ID3D11DeviceContext* pContext = NULL;
+                pDevice->GetImmediateContext( &pContext );
+                CountGet( m_pCount );
+
+                pContext->OMGetBlendState( &m_pBlendState, m_BlendFactor, &m_SampleMask );
+                CountGet( m_pCount );
+                pContext->RSGetState( &m_pRasterizerState );
+                CountGet( m_pCount );
+                pContext->IAGetPrimitiveTopology( &m_PrimitiveTopology );
+                CountGet( m_pCount );
+                pContext->IAGetIndexBuffer( &m_pIndexBuffer, &m_IndexBufferFormat, &m_IndexBufferOffset );
+                CountGet( m_pCount );
+                pContext->IAGetInputLayout( &m_pInputLayout );
+                CountGet( m_pCount );
+                pContext->IAGetVertexBuffers( 0, D3D11_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT, m_pVertexBuffers, m_pVertexBufferStrides, m_pVertexBufferOffsets );
+                CountGet( m_pCount );
+                pContext->VSGetShader( &m_pVertexShader, m_ppVertexShaderClassInstances, &m_VertexShaderClassInstancesCount );
+                CountGet( m_pCount );
+                pContext->PSGetShader( &m_pPixelShader, m_ppPixelShaderClassInstances, &m_PixelShaderClassInstancesCount );
+                CountGet( m_pCount );
+                pContext->PSGetSamplers( 0, D3D11_COMMONSHADER_SAMPLER_SLOT_COUNT, m_ppPixelShaderSamplers );
+                CountGet( m_pCount );
+                pContext->PSGetShaderResources( 0, D3D11_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT, m_ppPixelShaderResources );
+                CountGet( m_pCount );
+
+                Release( pContext );
+            }
+
+            ~CDX11StateGuard()
+            {
+                ID3D11Device* pDevice = static_cast<ID3D11Device*>( gD3DSystem->GetDevice() );
+                ID3D11DeviceContext* pContext = NULL;
+                pDevice->GetImmediateContext( &pContext );
+                CountGet( m_pCount );
+
+                // Apply saved state
+                pContext->OMSetBlendState( m_pBlendState, m_BlendFactor, m_SampleMask );
+                CountSet( m_pCount );
+                pContext->RSSetState( m_pRasterizerState );
+                CountSet( m_pCount );
+                pContext->IASetPrimitiveTopology( m_PrimitiveTopology );
+                CountSet( m_pCount );
+                pContext->IASetIndexBuffer( m_pIndexBuffer, m_IndexBufferFormat, m_IndexBufferOffset );
+                CountSet( m_pCount );
+                pContext->IASetInputLayout( m_pInputLayout );
+                CountSet( m_pCount );
+                pContext->IASetVertexBuffers( 0, D3D11_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT, m_pVertexBuffers, m_pVertexBufferStrides, m_pVertexBufferOffsets );
+                CountSet( m_pCount );
+                pContext->VSSetShader( m_pVertexShader, m_ppVertexShaderClassInstances, m_VertexShaderClassInstancesCount );
+                CountSet( m_pCount );
+                pContext->PSSetShader( m_pPixelShader, m_ppPixelShaderClassInstances, m_PixelShaderClassInstancesCount );
+                CountSet( m_pCount );
+                pContext->PSSetSamplers( 0, D3D11_COMMONSHADER_SAMPLER_SLOT_COUNT, m_ppPixelShaderSamplers );
+                CountSet( m_pCount );
+                pContext->PSSetShaderResources( 0, D3D11_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT, m_ppPixelShaderResources );
+                CountSet( m_pCount );
+
+                // Release references
+                Release( pContext );
+                Release( m_pBlendState );
+                Release( m_pRasterizerState );
+                Release( m_pIndexBuffer );
+                Release( m_pInputLayout );
+
+                for ( UINT i = 0; i < D3D11_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT; ++i )
+                {
+                    Release( m_pVertexBuffers[i] );
+                }
+
+                Release( m_pVertexShader );
+
+                for ( UINT i = 0; i < m_VertexShaderClassInstancesCount; ++i )
+                {
+                    Release( m_ppVertexShaderClassInstances[i] );
+                }
+
+                Release( m_pPixelShader );
+
+                for ( UINT i = 0; i < m_PixelShaderClassInstancesCount; ++i )
+                {
+                    Release( m_ppPixelShaderClassInstances[i] );
+                }
+
+                for ( UINT i = 0; i < D3D11_COMMONSHADER_SAMPLER_SLOT_COUNT; ++i )
+                {
+                    Release( m_ppPixelShaderSamplers[i] );
+                }
+
+                for ( UINT i = 0; i < D3D11_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT; ++i )
+                {
+                    Release( m_ppPixelShaderResources[i] );
+                }
+            }
+
+        private:
+            template<class T>
+            void Release( T*& pObject )
+            {
+                if ( pObject )
+                {
+                    pObject->Release();
+                    pObject = NULL;
+
+                    if ( m_pCount )
+                    {
+                        ++m_pCount->nReleases;
+                    }
+                }
+            }
+
+            SDX11CallCount* m_pCount; //!< instrumentation (optional)
+
+            ID3D11BlendState* m_pBlendState;
+            FLOAT m_BlendFactor[4];
+            UINT m_SampleMask;
+
+            ID3D11RasterizerState* m_pRasterizerState;
+
+            ID3D11VertexShader* m_pVertexShader;
+            ID3D11ClassInstance* m_ppVertexShaderClassInstances[D3D11_SHADER_MAX_INTERFACES];
+            UINT m_VertexShaderClassInstancesCount;
+
+            ID3D11PixelShader* m_pPixelShader;
+            ID3D11ClassInstance* m_ppPixelShaderClassInstances[D3D11_SHADER_MAX_INTERFACES];
+            UINT m_PixelShaderClassInstancesCount;
+            ID3D11SamplerState* m_ppPixelShaderSamplers[D3D11_COMMONSHADER_SAMPLER_SLOT_COUNT];
+            ID3D11ShaderResourceView* m_ppPixelShaderResources[D3D11_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT];
+
+            ID3D11InputLayout* m_pInputLayout;
+
+            ID3D11Buffer* m_pIndexBuffer;
+            DXGI_FORMAT m_IndexBufferFormat;
+            UINT m_IndexBufferOffset;
+
+            ID3D11Buffer* m_pVertexBuffers[D3D11_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT];
+            UINT m_pVertexBufferStrides[D3D11_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT];
+            UINT m_pVertexBufferOffsets[D3D11_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT];
+
+            D3D11_PRIMITIVE_TOPOLOGY m_PrimitiveTopology;
+    };
+}
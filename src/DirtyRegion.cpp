@@ -0,0 +1,165 @@
+/* CryHTML5 - for licensing and copyright see license.txt */
+
+#include "StdAfx.h"
+#include "DirtyRegion.h"
+
+namespace HTML5Plugin
+{
+    static const int MAX_SPLIT_DEPTH = 2; //!< overlapping rects are only split this often, afterwards they get merged
+
+    CDirtyRegion::CDirtyRegion()
+        : m_nCount( 0 )
+        , m_nCallCost( eDefaultCallCost )
+    {
+    }
+
+    int CDirtyRegion::GetArea() const
+    {
+        int nArea = 0;
+
+        for ( int i = 0; i < m_nCount; ++i )
+        {
+            nArea += m_rects[i].GetArea();
+        }
+
+        return nArea;
+    }
+
+    SDirtyRect CDirtyRegion::GetBounds() const
+    {
+        SDirtyRect bounds;
+
+        for ( int i = 0; i < m_nCount; ++i )
+        {
+            bounds.Merge( m_rects[i] );
+        }
+
+        return bounds;
+    }
+
+    void CDirtyRegion::Add( const SDirtyRect& rect )
+    {
+        Insert( rect, 0 );
+    }
+
+    void CDirtyRegion::Add( const CDirtyRegion& region )
+    {
+        for ( int i = 0; i < region.m_nCount; ++i )
+        {
+            Insert( region.m_rects[i], 0 );
+        }
+    }
+
+    void CDirtyRegion::Clip( int nWidth, int nHeight )
+    {
+        for ( int i = m_nCount - 1; i >= 0; --i )
+        {
+            m_rects[i].Clip( nWidth, nHeight );
+
+            if ( m_rects[i].IsEmpty() )
+            {
+                Remove( i );
+            }
+        }
+    }
+
+    int CDirtyRegion::GetMergeWaste( const SDirtyRect& a, const SDirtyRect& b )
+    {
+        SDirtyRect bounds = a;
+        bounds.Merge( b );
+
+        int nCovered = a.GetArea() + b.GetArea();
+
+        if ( a.Overlaps( b ) )
+        {
+            SDirtyRect overlap( max( a.x, b.x ), max( a.y, b.y ), min( a.x2, b.x2 ), min( a.y2, b.y2 ) );
+            nCovered -= overlap.GetArea();
+        }
+
+        return bounds.GetArea() - nCovered;
+    }
+
+    void CDirtyRegion::Insert( SDirtyRect rect, int nDepth )
+    {
+        if ( rect.IsEmpty() )
+        {
+            return;
+        }
+
+        for ( int i = 0; i < m_nCount; ++i )
+        {
+            const SDirtyRect& existing = m_rects[i];
+
+            if ( existing.Contains( rect ) )
+            {
+                return;
+            }
+
+            bool bOverlaps = existing.Overlaps( rect );
+
+            if ( rect.Contains( existing ) || GetMergeWaste( existing, rect ) <= m_nCallCost || ( bOverlaps && nDepth >= MAX_SPLIT_DEPTH ) )
+            {
+                // absorb it, the bigger rect may now touch rects we already checked
+                rect.Merge( existing );
+                Remove( i );
+                i = -1;
+                continue;
+            }
+
+            if ( bOverlaps )
+            {
+                // keep the region disjoint by only adding the parts outside of the existing rect
+                const SDirtyRect e = existing;
+                const int nMidY = max( rect.y, e.y );
+                const int nMidY2 = min( rect.y2, e.y2 );
+
+                Insert( SDirtyRect( rect.x, rect.y, rect.x2, nMidY ), nDepth + 1 );
+                Insert( SDirtyRect( rect.x, nMidY2, rect.x2, rect.y2 ), nDepth + 1 );
+                Insert( SDirtyRect( rect.x, nMidY, min( rect.x2, e.x ), nMidY2 ), nDepth + 1 );
+                Insert( SDirtyRect( max( rect.x, e.x2 ), nMidY, rect.x2, nMidY2 ), nDepth + 1 );
+                return;
+            }
+        }
+
+        m_rects[m_nCount++] = rect;
+
+        if ( m_nCount > eMaxRects )
+        {
+            Reduce();
+        }
+    }
+
+    void CDirtyRegion::Reduce()
+    {
+        while ( m_nCount > eMaxRects )
+        {
+            int nBestA = 0;
+            int nBestB = 1;
+            int nBestWaste = INT_MAX;
+
+            for ( int a = 0; a < m_nCount; ++a )
+            {
+                for ( int b = a + 1; b < m_nCount; ++b )
+                {
+                    int nWaste = GetMergeWaste( m_rects[a], m_rects[b] );
+
+                    if ( nWaste < nBestWaste )
+                    {
+                        nBestWaste = nWaste;
+                        nBestA = a;
+                        nBestB = b;
+                    }
+                }
+            }
+
+            SDirtyRect merged = m_rects[nBestA];
+            merged.Merge( m_rects[nBestB] );
+
+            // nBestB > nBestA so removing it first keeps nBestA valid
+            Remove( nBestB );
+            Remove( nBestA );
+
+            Insert( merged, MAX_SPLIT_DEPTH );
+        }
+    }
+}
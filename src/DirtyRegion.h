@@ -0,0 +1,165 @@
+/* CryHTML5 - for licensing and copyright see license.txt */
+
+#pragma once
+
+#include <climits>
+
+namespace HTML5Plugin
+{
+    /** @brief axis aligned rectangle in surface pixels (x2/y2 exclusive) */
+    struct SDirtyRect
+    {
+        int x; //!< start x
+        int y; //!< start y
+        int x2; //!< end x
+        int y2; //!< end y
+
+        SDirtyRect()
+        {
+            Reset();
+        }
+
+        SDirtyRect( int _x, int _y, int _x2, int _y2 )
+            : x( _x ), y( _y ), x2( _x2 ), y2( _y2 )
+        {
+        }
+
+        /** @brief make the rect empty */
+        void Reset()
+        {
+            x = y = INT_MAX;
+            x2 = y2 = 0;
+        }
+
+        /** @return true when no pixel is covered */
+        bool IsEmpty() const
+        {
+            return x2 <= x || y2 <= y;
+        }
+
+        /** @return covered pixels */
+        int GetArea() const
+        {
+            return IsEmpty() ? 0 : ( x2 - x ) * ( y2 - y );
+        }
+
+        /** @return true when both rects share at least one pixel */
+        bool Overlaps( const SDirtyRect& r ) const
+        {
+            return x < r.x2 && r.x < x2 && y < r.y2 && r.y < y2;
+        }
+
+        /** @return true when r lies completely inside this rect */
+        bool Contains( const SDirtyRect& r ) const
+        {
+            return x <= r.x && y <= r.y && r.x2 <= x2 && r.y2 <= y2;
+        }
+
+        /** @brief grow the rect so it also covers r */
+        void Merge( const SDirtyRect& r )
+        {
+            if ( r.IsEmpty() )
+            {
+                return;
+            }
+
+            x = min( x, r.x );
+            y = min( y, r.y );
+            x2 = max( x2, r.x2 );
+            y2 = max( y2, r.y2 );
+        }
+
+        /** @brief limit the rect to a surface of the given size */
+        void Clip( int nWidth, int nHeight )
+        {
+            x = max( x, 0 );
+            y = max( y, 0 );
+            x2 = min( x2, nWidth );
+            y2 = min( y2, nHeight );
+        }
+    };
+
+    /**
+    * @brief Dirty area kept as a small set of disjoint rects.
+    * Rects are merged when the pixels wasted by their bounding box cost less than the additional upload call.
+    */
+    class CDirtyRegion
+    {
+        public:
+            enum
+            {
+                eMaxRects = 8, //!< upper bound of upload calls per region
+                eDefaultCallCost = 64 * 64, //!< pixels an extra upload call is worth
+            };
+
+            CDirtyRegion();
+
+            /** @brief remove all rects */
+            void Reset()
+            {
+                m_nCount = 0;
+            }
+
+            /** @return true when nothing is dirty */
+            bool IsEmpty() const
+            {
+                return m_nCount == 0;
+            }
+
+            /** @return number of disjoint rects */
+            int GetCount() const
+            {
+                return m_nCount;
+            }
+
+            /** @return the rect at nIndex */
+            const SDirtyRect& operator[]( int nIndex ) const
+            {
+                return m_rects[nIndex];
+            }
+
+            /** @return sum of all rect areas (pixels that will be uploaded) */
+            int GetArea() const;
+
+            /** @return the bounding box of all rects */
+            SDirtyRect GetBounds() const;
+
+            /** @brief mark a rect dirty */
+            void Add( const SDirtyRect& rect );
+
+            /** @brief mark everything of another region dirty */
+            void Add( const CDirtyRegion& region );
+
+            /** @brief limit all rects to a surface of the given size */
+            void Clip( int nWidth, int nHeight );
+
+            /**
+            * @brief set how many pixels one upload call is worth when deciding to merge
+            * @param nPixels higher values produce fewer but larger rects
+            */
+            void SetCallCost( int nPixels )
+            {
+                m_nCallCost = nPixels;
+            }
+
+        private:
+            /** @return pixels uploaded needlessly when a and b are replaced by their bounding box */
+            static int GetMergeWaste( const SDirtyRect& a, const SDirtyRect& b );
+
+            /** @brief add a rect that may overlap existing ones, depth limits the splitting */
+            void Insert( SDirtyRect rect, int nDepth );
+
+            /** @brief remove the rect at nIndex (order is not preserved) */
+            void Remove( int nIndex )
+            {
+                m_rects[nIndex] = m_rects[--m_nCount];
+            }
+
+            /** @brief merge the cheapest pair until the rects fit */
+            void Reduce();
+
+            SDirtyRect m_rects[eMaxRects + 1]; //!< one spare slot before reducing
+            int m_nCount; //!< used rects
+            int m_nCallCost; //!< see SetCallCost
+    };
+}
@@ -0,0 +1,167 @@
+/* CryHTML5 - for licensing and copyright see license.txt */
+
+#include "StdAfx.h"
+#include "FrameMailbox.h"
+#include "PixelKernels.h"
+
+namespace HTML5Plugin
+{
+    CFrameMailbox::CFrameMailbox( int nWidth, int nHeight )
+        : m_nMiddle( 1 )
+        , m_nWidth( nWidth )
+        , m_nHeight( nHeight )
+        , m_nBack( 0 )
+        , m_nSequence( 0 )
+        , m_bUnconsumedTiled( true )
+        , m_nFront( 2 )
+    {
+        for ( int i = 0; i < 3; ++i )
+        {
+            m_frames[i].buffer.resize( size_t( nWidth ) * nHeight * 4, 0 );
+            m_frames[i].width = nWidth;
+            m_frames[i].height = nHeight;
+            m_frames[i].nSequence = 0;
+            m_frames[i].nPaintTime = 0;
+            m_frames[i].bTiled = false;
+        }
+    }
+
+    bool CFrameMailbox::Publish( const void* pSource, int nWidth, int nHeight, const CDirtyRegion& dirty, uint64 nPaintTime, const CTileMask* pTiles )
+    {
+        if ( !pSource || nWidth <= 0 || nHeight <= 0 )
+        {
+            return false;
+        }
+
+        // the surface was resized, every slot has to receive the complete paint
+        if ( nWidth != m_nWidth || nHeight != m_nHeight )
+        {
+            m_nWidth = nWidth;
+            m_nHeight = nHeight;
+
+            for ( int i = 0; i < 3; ++i )
+            {
+                m_pending[i].Reset();
+                m_pending[i].Add( SDirtyRect( 0, 0, nWidth, nHeight ) );
+            }
+
+            // changes of paints at other sizes don't fit this one, the render thread may still hold a frame of this size
+            m_unconsumed.Reset();
+            m_unconsumed.Add( SDirtyRect( 0, 0, nWidth, nHeight ) );
+            m_unconsumedTiles.Clear();
+            m_bUnconsumedTiled = false;
+        }
+
+        // slots are resized once they come back as back buffer
+        SFrame& back = m_frames[m_nBack];
+
+        if ( back.width != nWidth || back.height != nHeight )
+        {
+            back.buffer.resize( size_t( nWidth ) * nHeight * 4 );
+            back.width = nWidth;
+            back.height = nHeight;
+        }
+
+        CDirtyRegion region = dirty;
+        region.Clip( nWidth, nHeight );
+
+        // every slot now lags behind by this paint
+        for ( int i = 0; i < 3; ++i )
+        {
+            m_pending[i].Add( region );
+        }
+
+        // bring the back buffer up to date, this includes changes it missed while owned by the render thread
+        CopyRegion( back, static_cast<const uint8*>( pSource ), m_pending[m_nBack] );
+        m_pending[m_nBack].Reset();
+
+        // the render thread already took the last frame so only this paint is new to it
+        if ( !( m_nMiddle.load() & eFresh ) )
+        {
+            m_unconsumed.Reset();
+            m_unconsumedTiles.Clear();
+            m_bUnconsumedTiled = true;
+        }
+
+        m_unconsumed.Add( region );
+
+        if ( pTiles && ( m_unconsumedTiles.IsCompatible( *pTiles ) || m_unconsumedTiles.IsEmpty() ) )
+        {
+            if ( !m_unconsumedTiles.IsCompatible( *pTiles ) )
+            {
+                m_unconsumedTiles = *pTiles;
+            }
+
+            else
+            {
+                m_unconsumedTiles.Or( *pTiles );
+            }
+        }
+
+        else
+        {
+            m_bUnconsumedTiled = false;
+        }
+
+        back.upload = m_unconsumed;
+        back.bTiled = m_bUnconsumedTiled;
+
+        if ( back.bTiled )
+        {
+            back.uploadTiles = m_unconsumedTiles;
+        }
+        back.nSequence = ++m_nSequence;
+        back.nPaintTime = nPaintTime;
+
+        // publish, we get the old middle slot back as new back buffer
+        uint32 nOld = m_nMiddle.exchange( m_nBack | eFresh );
+        m_nBack = nOld & eSlotMask;
+
+        return true;
+    }
+
+    const CFrameMailbox::SFrame* CFrameMailbox::Acquire()
+    {
+        if ( !( m_nMiddle.load() & eFresh ) )
+        {
+            return nullptr;
+        }
+
+        // swap our front slot with the published one
+        uint32 nOld = m_nMiddle.exchange( m_nFront );
+        m_nFront = nOld & eSlotMask;
+
+        return &m_frames[m_nFront];
+    }
+
+    void CFrameMailbox::CopyRegion( SFrame& frame, const uint8* pSource, const CDirtyRegion& region )
+    {
+        const size_t nPitch = size_t( frame.width ) * 4;
+        const SPixelKernels& kernels = GetPixelKernels();
+
+        for ( int i = 0; i < region.GetCount(); ++i )
+        {
+            const SDirtyRect& rect = region[i];
+
+            const size_t nOffset = rect.y * nPitch + rect.x * 4;
+            const size_t nRowBytes = size_t( rect.x2 - rect.x ) * 4;
+
+            uint8* pDest = &frame.buffer[0] + nOffset;
+            const uint8* pSrc = pSource + nOffset;
+
+            // full rows are contiguous
+            if ( nRowBytes == nPitch )
+            {
+                kernels.CopyRow( pDest, pSrc, nPitch * ( rect.y2 - rect.y ) );
+                continue;
+            }
+
+            for ( int row = rect.y; row < rect.y2; ++row )
+            {
+                kernels.CopyRow( pDest, pSrc, nRowBytes );
+                pDest += nPitch;
+                pSrc += nPitch;
+            }
+        }
+    }
+}
@@ -0,0 +1,87 @@
+/* CryHTML5 - for licensing and copyright see license.txt */
+
+#pragma once
+
+#include <atomic>
+#include <vector>
+
+#include <DirtyRegion.h>
+#include <TileTracker.h>
+
+namespace HTML5Plugin
+{
+    /**
+    * @brief Lock-free triple buffered frame handoff between the CEF paint thread and the render thread.
+    * The paint thread copies only the rows that changed into its back buffer and publishes it with an atomic swap,
+    * the render thread always picks up the newest complete frame without blocking.
+    */
+    class CFrameMailbox
+    {
+        public:
+            /** @brief a complete frame owned by exactly one side at a time */
+            struct SFrame
+            {
+                std::vector<uint8> buffer; //!< BGRA pixels as delivered by CEF
+                int width; //!< frame width in pixels
+                int height; //!< frame height in pixels
+                CDirtyRegion upload; //!< area that changed since the last frame the render thread acquired
+                CTileMask uploadTiles; //!< the same area as tiles, only valid when bTiled is set
+                bool bTiled; //!< true when uploadTiles covers every change since the last acquired frame
+                uint32 nSequence; //!< paint sequence number
+                uint64 nPaintTime; //!< timestamp of the paint in microseconds
+            };
+
+            CFrameMailbox( int nWidth, int nHeight );
+
+            /**
+            * @brief copy a CEF paint into the back buffer and publish it (paint thread)
+            * @param pSource the complete CEF frame buffer
+            * @param nWidth width of pSource
+            * @param nHeight height of pSource
+            * @param dirty area of pSource that changed with this paint
+            * @param nPaintTime timestamp of the paint in microseconds, passed on with the frame
+            * @param pTiles the same area as tiles (optional, enables tiled uploads)
+            * @return false when there was nothing to publish
+            * @remark a paint of a different size resizes the mailbox, the complete paint is copied then
+            */
+            bool Publish( const void* pSource, int nWidth, int nHeight, const CDirtyRegion& dirty, uint64 nPaintTime, const CTileMask* pTiles = nullptr );
+
+            /**
+            * @brief take the newest published frame (render thread)
+            * @return the new front frame or nullptr when nothing was published since the last call
+            */
+            const SFrame* Acquire();
+
+            /** @return the frame acquired last (render thread) */
+            const SFrame& GetFront() const
+            {
+                return m_frames[m_nFront];
+            }
+
+        private:
+            enum
+            {
+                eSlotMask = 0x3, //!< slot index bits of m_nMiddle
+                eFresh = 0x4, //!< set while the middle slot holds a frame the render thread hasn't seen
+            };
+
+            /** @brief copy the rows of all rects from the CEF buffer into the frame */
+            static void CopyRegion( SFrame& frame, const uint8* pSource, const CDirtyRegion& region );
+
+            SFrame m_frames[3]; //!< back, middle and front frames
+            std::atomic<uint32> m_nMiddle; //!< slot waiting for the render thread (and the eFresh flag)
+
+            // paint thread only
+            int m_nWidth; //!< size of the last published paint
+            int m_nHeight;
+            uint32 m_nBack; //!< slot being written
+            uint32 m_nSequence; //!< number of published paints
+            CDirtyRegion m_pending[3]; //!< per slot: area that lags behind the newest CEF frame
+            CDirtyRegion m_unconsumed; //!< area changed since the last frame the render thread acquired
+            CTileMask m_unconsumedTiles; //!< m_unconsumed as tiles
+            bool m_bUnconsumedTiled; //!< false once a paint without tiles was added to m_unconsumed
+
+            // render thread only
+            uint32 m_nFront; //!< slot being read
+    };
+}
@@ -0,0 +1,56 @@
+/* CryHTML5 - for licensing and copyright see license.txt */
+
+#include "StdAfx.h"
+#include "FramePacer.h"
+
+namespace HTML5Plugin
+{
+    CFramePacer::CFramePacer()
+        : m_nPaints( 0 )
+        , m_fWindowStart( -1.0f )
+        , m_fNextUpload( 0.0f )
+        , m_nSequence( 0 )
+    {
+        memset( &m_current, 0, sizeof( m_current ) );
+        memset( &m_last, 0, sizeof( m_last ) );
+    }
+
+    bool CFramePacer::Tick( float fNow )
+    {
+        if ( m_fWindowStart < 0.0f )
+        {
+            m_fWindowStart = fNow;
+        }
+
+        if ( fNow - m_fWindowStart < 1.0f )
+        {
+            return false;
+        }
+
+        m_current.nPaints = m_nPaints.exchange( 0 );
+        m_last = m_current;
+        memset( &m_current, 0, sizeof( m_current ) );
+
+        m_fWindowStart = fNow;
+        return true;
+    }
+
+    void CFramePacer::OnAcquired( uint32 nSequence, float fNow, float fRate )
+    {
+        // every paint between the last acquired frame and this one was coalesced
+        if ( nSequence > m_nSequence + 1 )
+        {
+            m_current.nDropped += nSequence - m_nSequence - 1;
+        }
+
+        m_nSequence = nSequence;
+
+        if ( fRate > 0.0f )
+        {
+            const float fInterval = 1.0f / fRate;
+
+            // keep the cadence but don't try to catch up after a stall
+            m_fNextUpload = max( m_fNextUpload + fInterval, fNow + fInterval * 0.5f );
+        }
+    }
+}
@@ -0,0 +1,79 @@
+/* CryHTML5 - for licensing and copyright see license.txt */
+
+#pragma once
+
+#include <atomic>
+
+namespace HTML5Plugin
+{
+    /**
+    * @brief Paces texture uploads to a target UI frame rate and counts paints and uploads per second.
+    * Paints arriving between two uploads are coalesced by the frame mailbox, only the newest frame gets uploaded.
+    */
+    class CFramePacer
+    {
+        public:
+            /** @brief counters of one second */
+            struct SStats
+            {
+                uint32 nPaints; //!< paints received from CEF
+                uint32 nDropped; //!< paints superseded by a newer paint before they were uploaded
+                uint32 nUploads; //!< texture updates
+                uint64 nBytes; //!< bytes uploaded
+            };
+
+            CFramePacer();
+
+            /** @brief count a paint (paint thread) */
+            void OnPaint()
+            {
+                ++m_nPaints;
+            }
+
+            /**
+            * @brief advance the statistics window (render thread, once per game frame)
+            * @param fNow current time in seconds
+            * @return true when a second was completed, GetStats returns it then
+            */
+            bool Tick( float fNow );
+
+            /**
+            * @brief check if the next frame should be uploaded (render thread)
+            * @param fNow current time in seconds
+            * @param fRate target UI frame rate, 0 or less uploads every game frame
+            */
+            bool IsUploadDue( float fNow, float fRate ) const
+            {
+                return fRate <= 0.0f || fNow >= m_fNextUpload;
+            }
+
+            /**
+            * @brief a frame was taken for upload (render thread)
+            * @param nSequence paint sequence number of the frame
+            * @param fNow current time in seconds
+            * @param fRate target UI frame rate
+            */
+            void OnAcquired( uint32 nSequence, float fNow, float fRate );
+
+            /** @brief count uploaded bytes (render thread) */
+            void OnUploaded( uint64 nBytes )
+            {
+                ++m_current.nUploads;
+                m_current.nBytes += nBytes;
+            }
+
+            /** @return counters of the last completed second */
+            const SStats& GetStats() const
+            {
+                return m_last;
+            }
+
+        private:
+            std::atomic<uint32> m_nPaints; //!< paints since the window started
+            SStats m_current; //!< counters of the running second
+            SStats m_last; //!< counters of the last completed second
+            float m_fWindowStart; //!< start of the running second
+            float m_fNextUpload; //!< earliest time of the next upload
+            uint32 m_nSequence; //!< sequence number of the last acquired frame
+    };
+}
@@ -0,0 +1,63 @@
+/* CryHTML5 - for licensing and copyright see license.txt */
+
+#include "StdAfx.h"
+#include "FrameSource.h"
+
+namespace HTML5Plugin
+{
+    CSharedFrameSource::CSharedFrameSource()
+        : m_nWidth( 0 )
+        , m_nHeight( 0 )
+    {
+        m_pending.hShared = nullptr;
+        m_pending.nWidth = 0;
+        m_pending.nHeight = 0;
+        m_pending.nSequence = 0;
+        m_front = m_pending;
+    }
+
+    void CSharedFrameSource::PaintShared( void* hShared, int nWidth, int nHeight )
+    {
+        m_pacer.OnPaint();
+
+        std::lock_guard<std::mutex> lock( m_lock );
+        m_pending.hShared = hShared;
+        m_pending.nWidth = nWidth;
+        m_pending.nHeight = nHeight;
+        ++m_pending.nSequence;
+    }
+
+    bool CSharedFrameSource::Present( ISurfaceDevice& device, float fNow, float fRate )
+    {
+        // CEF usually renders into the same texture again, the handle only changes with the size or a new texture pool
+        if ( m_pacer.IsUploadDue( fNow, fRate ) )
+        {
+            SSharedFrame pending;
+            {
+                std::lock_guard<std::mutex> lock( m_lock );
+                pending = m_pending;
+            }
+
+            if ( pending.nSequence != m_front.nSequence )
+            {
+                m_front = pending;
+                m_pacer.OnAcquired( m_front.nSequence, fNow, fRate );
+                m_pacer.OnUploaded( 0 );
+            }
+        }
+
+        if ( !m_front.hShared )
+        {
+            return false;
+        }
+
+        if ( !device.OpenSharedSurface( m_front.hShared, m_front.nWidth, m_front.nHeight ) )
+        {
+            return false;
+        }
+
+        m_nWidth = m_front.nWidth;
+        m_nHeight = m_front.nHeight;
+        return true;
+    }
+}
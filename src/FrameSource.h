@@ -0,0 +1,157 @@
+/* CryHTML5 - for licensing and copyright see license.txt */
+
+#pragma once
+
+#include <mutex>
+
+#include <DirtyRegion.h>
+#include <AlphaCoverage.h>
+#include <FramePacer.h>
+
+namespace HTML5Plugin
+{
+    /** @brief the texture a frame source brings its frames onto (implemented for D3D11 and by headless devices) */
+    struct ISurfaceDevice
+    {
+        virtual ~ISurfaceDevice() {}
+
+        /**
+        * @brief create the surface texture
+        * @return true when the surface can receive uploads
+        */
+        virtual bool CreateSurface( int nWidth, int nHeight ) = 0;
+
+        /**
+        * @brief use a texture shared by another device as surface instead of an own one, opening the open texture again does nothing
+        * @param hShared shared handle of the texture
+        * @param nWidth size of the texture
+        * @param nHeight
+        * @return false when the texture can't be opened or the device doesn't support shared textures
+        */
+        virtual bool OpenSharedSurface( void* hShared, int nWidth, int nHeight ) = 0;
+
+        /** @brief release the surface texture */
+        virtual void ReleaseSurface() = 0;
+
+        /** @return true when a surface was created */
+        virtual bool HasSurface() const = 0;
+
+        /**
+        * @brief copy rects of a frame into the surface
+        * @param pSource complete frame (4 bytes per pixel)
+        * @param nPitch bytes per row of pSource
+        * @param pRects rects to copy
+        * @param nRects number of rects (at least 1)
+        */
+        virtual void Upload( const uint8* pSource, int nPitch, const SDirtyRect* pRects, int nRects ) = 0;
+    };
+
+    /**
+    * @brief Where the frames of a view come from, independent of CEF and the renderer.
+    * CEF delivers frames either as CPU buffers (software rendering) or as shared textures (accelerated rendering),
+    * a source handles one kind and ignores the other.
+    */
+    struct IFrameSource
+    {
+        virtual ~IFrameSource() {}
+
+        /**
+        * @brief take a paint in CPU memory (paint thread)
+        * @param pBuffer complete BGRA frame, only valid during the call
+        * @param nWidth width of pBuffer
+        * @param nHeight height of pBuffer
+        * @param dirty area that changed with this paint
+        * @param nTileSize tile size for tiled uploads (0 uploads the dirty rects)
+        */
+        virtual void Paint( const uint8* pBuffer, int nWidth, int nHeight, const CDirtyRegion& dirty, int nTileSize ) = 0;
+
+        /**
+        * @brief take a paint into a shared texture (paint thread)
+        * @param hShared shared handle of the texture
+        * @param nWidth size of the texture
+        * @param nHeight
+        */
+        virtual void PaintShared( void* hShared, int nWidth, int nHeight ) = 0;
+
+        /**
+        * @brief bring the newest frame onto the device when one is due (render thread)
+        * @param device device owning the surface
+        * @param fNow current time in seconds
+        * @param fRate target UI frame rate (0 = every call)
+        * @return true when the surface can be drawn
+        */
+        virtual bool Present( ISurfaceDevice& device, float fNow, float fRate ) = 0;
+
+        /** @return width of the frame presented last (render thread) */
+        virtual int GetWidth() const = 0;
+
+        /** @return height of the frame presented last (render thread) */
+        virtual int GetHeight() const = 0;
+
+        /** @return BGRA pixels of the frame presented last, nullptr when frames never reach CPU memory (render thread) */
+        virtual const uint8* GetPixels() const = 0;
+
+        /** @return alpha coverage of the newest paint, nullptr when frames never reach CPU memory (any thread) */
+        virtual const CAlphaCoverage* GetCoverage() const = 0;
+
+        /** @return upload pacing and per second statistics (render thread) */
+        virtual CFramePacer& GetPacer() = 0;
+    };
+
+    /**
+    * @brief Frame source for accelerated rendering, the device opens the shared texture CEF renders into.
+    * Frames never pass through CPU memory, so there is no alpha coverage and the atlas can't be used.
+    */
+    class CSharedFrameSource : public IFrameSource
+    {
+        public:
+            CSharedFrameSource();
+
+            // IFrameSource
+            virtual void Paint( const uint8* /*pBuffer*/, int /*nWidth*/, int /*nHeight*/, const CDirtyRegion& /*dirty*/, int /*nTileSize*/ ) override
+            {
+            }
+            virtual void PaintShared( void* hShared, int nWidth, int nHeight ) override;
+            virtual bool Present( ISurfaceDevice& device, float fNow, float fRate ) override;
+            virtual int GetWidth() const override
+            {
+                return m_nWidth;
+            }
+            virtual int GetHeight() const override
+            {
+                return m_nHeight;
+            }
+            virtual const uint8* GetPixels() const override
+            {
+                return nullptr;
+            }
+            virtual const CAlphaCoverage* GetCoverage() const override
+            {
+                return nullptr;
+            }
+            virtual CFramePacer& GetPacer() override
+            {
+                return m_pacer;
+            }
+
+        private:
+            /** @brief a shared texture handed over from the paint thread */
+            struct SSharedFrame
+            {
+                void* hShared; //!< shared handle of the texture
+                int nWidth; //!< size of the texture
+                int nHeight;
+                uint32 nSequence; //!< paint sequence number
+            };
+
+            std::mutex m_lock; //!< guards m_pending
+            SSharedFrame m_pending; //!< newest paint
+
+            CFramePacer m_pacer; //!< pacing and statistics
+
+            // render thread
+            SSharedFrame m_front; //!< frame presented last
+            int m_nWidth; //!< size of m_front
+            int m_nHeight;
+    };
+}
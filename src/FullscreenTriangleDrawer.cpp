@@ -3,6 +3,8 @@
 #include "StdAfx.h"
 #include "FullscreenTriangleDrawer.h"
 #include "CPluginHTML5.h"
+#include "DX11StateGuard.h"
+#include "DX11MinimalStateGuard.h"
 
 #include <d3d9.h>
 #include <dxgi.h>
@@ -11,116 +13,6 @@
 
 namespace HTML5Plugin
 {
-    // An incomplete DX11 state guard class that saves and restores the
-    // states and resources that will be modified during the drawing in the hooked function
-    class CDX11StateGuard
-    {
-        public:
-            CDX11StateGuard()
-                : m_VertexShaderClassInstancesCount( D3D11_SHADER_MAX_INTERFACES )
-                , m_PixelShaderClassInstancesCount( D3D11_SHADER_MAX_INTERFACES )
-            {
-                ID3D11Device* pDevice = static_cast<ID3D11Device*>( gD3DSystem->GetDevice() );
-                ID3D11DeviceContext* pContext = NULL;
-                pDevice->GetImmediateContext( &pContext );
-
-                pContext->OMGetBlendState( &m_pBlendState, m_BlendFactor, &m_SampleMask );
-                pContext->RSGetState( &m_pRasterizerState );
-                pContext->IAGetPrimitiveTopology( &m_PrimitiveTopology );
-                pContext->IAGetIndexBuffer( &m_pIndexBuffer, &m_IndexBufferFormat, &m_IndexBufferOffset );
-                pContext->IAGetInputLayout( &m_pInputLayout );
-                pContext->IAGetVertexBuffers( 0, D3D11_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT, m_pVertexBuffers, m_pVertexBufferStrides, m_pVertexBufferOffsets );
-                pContext->VSGetShader( &m_pVertexShader, m_ppVertexShaderClassInstances, &m_VertexShaderClassInstancesCount );
-                pContext->PSGetShader( &m_pPixelShader, m_ppPixelShaderClassInstances, &m_PixelShaderClassInstancesCount );
-                pContext->PSGetSamplers( 0, D3D11_COMMONSHADER_SAMPLER_SLOT_COUNT, m_ppPixelShaderSamplers );
-                pContext->PSGetShaderResources( 0, D3D11_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT, m_ppPixelShaderResources );
-            }
-
-            ~CDX11StateGuard()
-            {
-                ID3D11Device* pDevice = static_cast<ID3D11Device*>( gD3DSystem->GetDevice() );
-                ID3D11DeviceContext* pContext = NULL;
-                pDevice->GetImmediateContext( &pContext );
-
-                // Apply saved state
-                pContext->OMSetBlendState( m_pBlendState, m_BlendFactor, m_SampleMask );
-                pContext->RSSetState( m_pRasterizerState );
-                pContext->IASetPrimitiveTopology( m_PrimitiveTopology );
-                pContext->IASetIndexBuffer( m_pIndexBuffer, m_IndexBufferFormat, m_IndexBufferOffset );
-                pContext->IASetInputLayout( m_pInputLayout );
-                pContext->IASetVertexBuffers( 0, D3D11_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT, m_pVertexBuffers, m_pVertexBufferStrides, m_pVertexBufferOffsets );
-                pContext->VSSetShader( m_pVertexShader, m_ppVertexShaderClassInstances, m_VertexShaderClassInstancesCount );
-                pContext->PSSetShader( m_pPixelShader, m_ppPixelShaderClassInstances, m_PixelShaderClassInstancesCount );
-                pContext->PSSetSamplers( 0, D3D11_COMMONSHADER_SAMPLER_SLOT_COUNT, m_ppPixelShaderSamplers );
-                pContext->PSSetShaderResources( 0, D3D11_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT, m_ppPixelShaderResources );
-
-                // Release references
-                SAFE_RELEASE( m_pBlendState );
-                SAFE_RELEASE( m_pRasterizerState );
-                SAFE_RELEASE( m_pIndexBuffer );
-                SAFE_RELEASE( m_pInputLayout );
-
-                for ( UINT i = 0; i < D3D11_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT; ++i )
-                {
-                    SAFE_RELEASE( m_pVertexBuffers[i] );
-                }
-
-                SAFE_RELEASE( m_pVertexShader );
-
-                for ( UINT i = 0; i < m_VertexShaderClassInstancesCount; ++i )
-                {
-                    SAFE_RELEASE( m_ppVertexShaderClassInstances[i] );
-                }
-
-                SAFE_RELEASE( m_pPixelShader );
-
-                for ( UINT i = 0; i < m_PixelShaderClassInstancesCount; ++i )
-                {
-                    SAFE_RELEASE( m_ppPixelShaderClassInstances[i] );
-                }
-
-                for ( UINT i = 0; i < D3D11_COMMONSHADER_SAMPLER_SLOT_COUNT; ++i )
-                {
-                    SAFE_RELEASE( m_ppPixelShaderSamplers[i] );
-                }
-
-                for ( UINT i = 0; i < D3D11_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT; ++i )
-                {
-                    SAFE_RELEASE( m_ppPixelShaderResources[i] );
-                }
-            }
-
-        private:
-            ID3D11BlendState* m_pBlendState;
-            FLOAT m_BlendFactor[4];
-            UINT m_SampleMask;
-
-            ID3D11RasterizerState* m_pRasterizerState;
-
-            ID3D11VertexShader* m_pVertexShader;
-            ID3D11ClassInstance* m_ppVertexShaderClassInstances[D3D11_SHADER_MAX_INTERFACES];
-            UINT m_VertexShaderClassInstancesCount;
-
-            ID3D11PixelShader* m_pPixelShader;
-            ID3D11ClassInstance* m_ppPixelShaderClassInstances[D3D11_SHADER_MAX_INTERFACES];
-            UINT m_PixelShaderClassInstancesCount;
-            ID3D11SamplerState* m_ppPixelShaderSamplers[D3D11_COMMONSHADER_SAMPLER_SLOT_COUNT];
-            ID3D11ShaderResourceView* m_ppPixelShaderResources[D3D11_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT];
-
-            ID3D11InputLayout* m_pInputLayout;
-
-            ID3D11Buffer* m_pIndexBuffer;
-            DXGI_FORMAT m_IndexBufferFormat;
-            UINT m_IndexBufferOffset;
-
-            ID3D11Buffer* m_pVertexBuffers[D3D11_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT];
-            UINT m_pVertexBufferStrides[D3D11_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT];
-            UINT m_pVertexBufferOffsets[D3D11_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT];
-
-            D3D11_PRIMITIVE_TOPOLOGY m_PrimitiveTopology;
-    };
-
-
     CFullscreenTriangleDrawer::CFullscreenTriangleDrawer()
         : m_pVertexDeclaration( NULL )
         , m_pVertexBuffer( NULL )
@@ -130,7 +22,16 @@ namespace HTML5Plugin
         , m_pVertexShader11( NULL )
         , m_pPixelShader11( NULL )
         , m_pBlendState11( NULL )
+        , m_pContext11( NULL )
+        , m_nDrawMode( eDM_MinimalGuard )
+        , m_pDeferred11( NULL )
+        , m_pRasterizerState11( NULL )
+        , m_pCommandList11( NULL )
+        , m_pRecordedSRV( NULL )
+        , m_pRecordedRTV( NULL )
     {
+        memset( m_fRecordedViewport, 0, sizeof( m_fRecordedViewport ) );
+
         switch ( gD3DSystem->GetType() )
         {
             case D3DPlugin::D3D_DX9:
@@ -478,6 +379,8 @@ namespace HTML5Plugin
 
         hr = pDevice->CreateBlendState( &blendDesc, &m_pBlendState11 );
         CRY_ASSERT( SUCCEEDED( hr ) );
+
+        pDevice->GetImmediateContext( &m_pContext11 );
     }
 
     CFullscreenTriangleDrawer::~CFullscreenTriangleDrawer()
@@ -491,6 +394,9 @@ namespace HTML5Plugin
         SAFE_RELEASE( m_pVertexShader11 );
         SAFE_RELEASE( m_pPixelShader11 );
         SAFE_RELEASE( m_pBlendState11 );
+
+        ReleaseCommandList();
+        SAFE_RELEASE( m_pContext11 );
     }
 
     void CFullscreenTriangleDrawer::Draw( void* pTexture )
@@ -541,27 +447,133 @@ namespace HTML5Plugin
 
     void CFullscreenTriangleDrawer::DrawDX11( ID3D11ShaderResourceView* pTextureSRV )
     {
-        ID3D11Device* pDevice = static_cast<ID3D11Device*>( gD3DSystem->GetDevice() );
-        ID3D11DeviceContext* pContext = NULL;
-        pDevice->GetImmediateContext( &pContext );
+        m_calls = SDX11CallCount();
 
-        CDX11StateGuard stateGuard;
+        if ( !m_pContext11 )
+        {
+            return;
+        }
+
+        switch ( m_nDrawMode )
+        {
+            case eDM_FullGuard:
+                {
+                    CDX11StateGuard stateGuard( &m_calls );
+                    SetupAndDrawDX11( m_pContext11, pTextureSRV );
+                    break;
+                }
+
+            case eDM_CommandList:
+                {
+                    DrawDX11CommandList( pTextureSRV );
+                    break;
+                }
+
+            default:
+                {
+                    CDX11MinimalStateGuard stateGuard( m_pContext11, &m_calls );
+                    SetupAndDrawDX11( m_pContext11, pTextureSRV );
+                    break;
+                }
+        }
+    }
+
+    void CFullscreenTriangleDrawer::DrawDX11CommandList( ID3D11ShaderResourceView* pTextureSRV )
+    {
+        // the command list starts from default state, so render target and viewport are part of the recording
+        ID3D11RenderTargetView* pRTV = NULL;
+        m_pContext11->OMGetRenderTargets( 1, &pRTV, NULL );
+        CountGet( &m_calls );
+
+        UINT nViewports = 1;
+        D3D11_VIEWPORT viewport = { 0 };
+        m_pContext11->RSGetViewports( &nViewports, &viewport );
+        CountGet( &m_calls );
+
+        if ( !m_pCommandList11 || pTextureSRV != m_pRecordedSRV || pRTV != m_pRecordedRTV || memcmp( &viewport, m_fRecordedViewport, sizeof( m_fRecordedViewport ) ) != 0 )
+        {
+            ReleaseCommandList();
+
+            ID3D11Device* pDevice = static_cast<ID3D11Device*>( gD3DSystem->GetDevice() );
+
+            D3D11_RASTERIZER_DESC rasterizerDesc = { D3D11_FILL_SOLID, D3D11_CULL_NONE };
+            rasterizerDesc.DepthClipEnable = TRUE;
+
+            if ( SUCCEEDED( pDevice->CreateDeferredContext( 0, &m_pDeferred11 ) ) && SUCCEEDED( pDevice->CreateRasterizerState( &rasterizerDesc, &m_pRasterizerState11 ) ) )
+            {
+                m_pDeferred11->OMSetRenderTargets( 1, &pRTV, NULL );
+                m_pDeferred11->RSSetViewports( 1, &viewport );
+                m_pDeferred11->RSSetState( m_pRasterizerState11 );
+                SetupAndDrawDX11( m_pDeferred11, pTextureSRV );
+                m_pDeferred11->FinishCommandList( FALSE, &m_pCommandList11 );
+            }
+
+            m_pRecordedSRV = pTextureSRV;
+            m_pRecordedRTV = pRTV;
+            memcpy( m_fRecordedViewport, &viewport, sizeof( m_fRecordedViewport ) );
+        }
+
+        if ( pRTV )
+        {
+            pRTV->Release();
+            ++m_calls.nReleases;
+        }
+
+        // restores the state of the immediate context afterwards
+        if ( m_pCommandList11 )
+        {
+            m_pContext11->ExecuteCommandList( m_pCommandList11, TRUE );
+            CountSet( &m_calls );
+        }
+
+        // drivers without command list support emulate them, draw directly when recording failed
+        else
+        {
+            CDX11MinimalStateGuard stateGuard( m_pContext11, &m_calls );
+            SetupAndDrawDX11( m_pContext11, pTextureSRV );
+        }
+    }
+
+    void CFullscreenTriangleDrawer::ReleaseCommandList()
+    {
+        SAFE_RELEASE( m_pCommandList11 );
+        SAFE_RELEASE( m_pRasterizerState11 );
+        SAFE_RELEASE( m_pDeferred11 );
+
+        m_pRecordedSRV = NULL;
+        m_pRecordedRTV = NULL;
+    }
+
+    void CFullscreenTriangleDrawer::SetupAndDrawDX11( ID3D11DeviceContext* pContext, ID3D11ShaderResourceView* pTextureSRV )
+    {
+        // state changes and the draw itself, calls recorded into a command list don't reach the immediate context
+        SDX11CallCount* pCount = pContext == m_pContext11 ? &m_calls : NULL;
 
         pContext->IASetInputLayout( NULL );
+        CountSet( pCount );
         pContext->IASetIndexBuffer( NULL, DXGI_FORMAT_UNKNOWN, 0 );
+        CountSet( pCount );
         pContext->IASetVertexBuffers( 0, 0, NULL, NULL, NULL );
+        CountSet( pCount );
         pContext->IASetPrimitiveTopology( D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST );
+        CountSet( pCount );
 
         pContext->VSSetShader( m_pVertexShader11, NULL, 0 );
+        CountSet( pCount );
         pContext->PSSetShader( m_pPixelShader11, NULL, 0 );
+        CountSet( pCount );
         ID3D11SamplerState* pNullSampler[] = { NULL };
         pContext->PSSetSamplers( 0, 1, pNullSampler );
+        CountSet( pCount );
 
         pContext->PSSetShaderResources( 0, 1, &pTextureSRV );
+        CountSet( pCount );
 
         pContext->OMSetBlendState( m_pBlendState11, NULL, 0xFFFFFFFF );
+        CountSet( pCount );
 
         // Draw
         pContext->Draw( 3, 0 );
+        CountSet( pCount );
     }
 }
@@ -2,6 +2,8 @@
 
 #pragma once
 
+#include <DX11CallCount.h>
+
 struct IDirect3DTexture9;
 struct IDirect3DVertexDeclaration9;
 struct IDirect3DVertexBuffer9;
@@ -12,10 +14,22 @@ struct ID3D11ShaderResourceView;
 struct ID3D11VertexShader;
 struct ID3D11PixelShader;
 struct ID3D11BlendState;
+struct ID3D11RasterizerState;
+struct ID3D11DeviceContext;
+struct ID3D11CommandList;
+struct ID3D11RenderTargetView;
 
 namespace HTML5Plugin
 {
 
+    /** @brief how the DX11 draw keeps the renderer state intact */
+    enum EDX11DrawMode
+    {
+        eDM_FullGuard = 0, //!< save and restore every slot
+        eDM_MinimalGuard, //!< save and restore only the state the draw changes
+        eDM_CommandList, //!< replay a command list recorded on a deferred context, the runtime restores the state
+    };
+
     class CFullscreenTriangleDrawer
     {
         public:
@@ -24,6 +38,18 @@ namespace HTML5Plugin
 
             void Draw( void* pTexture );
 
+            /** @brief set how DX11 draws keep the renderer state (EDX11DrawMode) */
+            void SetDrawMode( int nMode )
+            {
+                m_nDrawMode = nMode;
+            }
+
+            /** @return context calls of the last DX11 draw (instrumentation) */
+            const SDX11CallCount& GetCallCount() const
+            {
+                return m_calls;
+            }
+
         private:
             void CreateDX9Resources();
             void CreateDX11Resources();
@@ -31,6 +57,15 @@ namespace HTML5Plugin
             void DrawDX9( IDirect3DTexture9* pTexture );
             void DrawDX11( ID3D11ShaderResourceView* pTexture );
 
+            /** @brief set the state and draw on a context */
+            void SetupAndDrawDX11( ID3D11DeviceContext* pContext, ID3D11ShaderResourceView* pTextureSRV );
+
+            /** @brief draw through a command list, recorded again when texture, render target or viewport changed */
+            void DrawDX11CommandList( ID3D11ShaderResourceView* pTextureSRV );
+
+            /** @brief release the command list and its deferred context */
+            void ReleaseCommandList();
+
         private:
             // DX9
             IDirect3DVertexDeclaration9* m_pVertexDeclaration;
@@ -43,6 +78,17 @@ namespace HTML5Plugin
             ID3D11VertexShader* m_pVertexShader11;
             ID3D11PixelShader* m_pPixelShader11;
             ID3D11BlendState* m_pBlendState11;
+            ID3D11DeviceContext* m_pContext11; //!< immediate context, kept instead of queried every draw
+            int m_nDrawMode; //!< EDX11DrawMode
+            SDX11CallCount m_calls; //!< context calls of the last draw
+
+            // DX11 command list
+            ID3D11DeviceContext* m_pDeferred11; //!< context the draw is recorded on
+            ID3D11RasterizerState* m_pRasterizerState11; //!< deferred contexts start with default state, this one doesn't cull
+            ID3D11CommandList* m_pCommandList11; //!< the recorded draw
+            ID3D11ShaderResourceView* m_pRecordedSRV; //!< texture the command list draws (held by the list)
+            ID3D11RenderTargetView* m_pRecordedRTV; //!< render target the command list draws to (held by the list)
+            float m_fRecordedViewport[6]; //!< viewport the command list was recorded with
     };
 
 }
@@ -0,0 +1,155 @@
+/* CryHTML5 - for licensing and copyright see license.txt */
+
+#pragma once
+
+#include <vector>
+
+namespace HTML5Plugin
+{
+    /**
+    * @brief Pool of objects addressed by generation checked handles.
+    * Slots are reused through a free list and live objects are kept in a dense list for iteration,
+    * so creating, destroying and iterating doesn't allocate once the pool reached its peak size.
+    * Handles are (generation << 16) | (index + 1), 0 is never a valid handle.
+    */
+    template<class T>
+    class CHandlePool
+    {
+        public:
+            typedef uint32 THandle;
+
+            /** @brief preallocate storage for nCount objects */
+            void Reserve( size_t nCount )
+            {
+                m_slots.reserve( nCount );
+                m_free.reserve( nCount );
+                m_live.reserve( nCount );
+            }
+
+            /**
+            * @brief store an object
+            * @return handle of the object, 0 when the pool is full
+            */
+            THandle Create( const T& value )
+            {
+                uint32 nIndex;
+
+                if ( !m_free.empty() )
+                {
+                    nIndex = m_free.back();
+                    m_free.pop_back();
+                }
+
+                else
+                {
+                    if ( m_slots.size() >= eMaxSlots )
+                    {
+                        return 0;
+                    }
+
+                    nIndex = uint32( m_slots.size() );
+                    m_slots.push_back( SSlot() );
+                }
+
+                SSlot& slot = m_slots[nIndex];
+                slot.value = value;
+                slot.bUsed = true;
+                slot.nLive = uint32( m_live.size() );
+                m_live.push_back( nIndex );
+
+                return ( uint32( slot.nGeneration ) << 16 ) | ( nIndex + 1 );
+            }
+
+            /**
+            * @brief remove an object, its handle becomes invalid
+            * @return false when the handle was invalid
+            */
+            bool Destroy( THandle hHandle )
+            {
+                SSlot* pSlot = GetSlot( hHandle );
+
+                if ( !pSlot )
+                {
+                    return false;
+                }
+
+                // swap the last live object into the gap
+                const uint32 nMoved = m_live.back();
+                m_live[pSlot->nLive] = nMoved;
+                m_slots[nMoved].nLive = pSlot->nLive;
+                m_live.pop_back();
+
+                pSlot->value = T();
+                pSlot->bUsed = false;
+                pSlot->nGeneration = uint16( pSlot->nGeneration == 0xffff ? 1 : pSlot->nGeneration + 1 );
+
+                m_free.push_back( ( hHandle & 0xffff ) - 1 );
+                return true;
+            }
+
+            /** @return the object of a handle or nullptr when the handle is invalid */
+            T* Get( THandle hHandle )
+            {
+                SSlot* pSlot = GetSlot( hHandle );
+                return pSlot ? &pSlot->value : nullptr;
+            }
+
+            /** @return number of live objects */
+            size_t GetCount() const
+            {
+                return m_live.size();
+            }
+
+            /** @return handle of the n-th live object (order changes when objects are destroyed) */
+            THandle GetHandle( size_t n ) const
+            {
+                const uint32 nIndex = m_live[n];
+                return ( uint32( m_slots[nIndex].nGeneration ) << 16 ) | ( nIndex + 1 );
+            }
+
+            /** @return the n-th live object */
+            T& GetLive( size_t n )
+            {
+                return m_slots[m_live[n]].value;
+            }
+
+        private:
+            enum
+            {
+                eMaxSlots = 0xffff, //!< index part of a handle
+            };
+
+            struct SSlot
+            {
+                T value; //!< the object
+                uint32 nLive; //!< position in m_live
+                uint16 nGeneration; //!< incremented on every destroy, never 0
+                bool bUsed; //!< true while the slot holds an object
+
+                SSlot()
+                    : nLive( 0 )
+                    , nGeneration( 1 )
+                    , bUsed( false )
+                {
+                }
+            };
+
+            /** @return the slot of a handle or nullptr when the handle is invalid */
+            SSlot* GetSlot( THandle hHandle )
+            {
+                const uint32 nIndex = ( hHandle & 0xffff ) - 1;
+
+                if ( nIndex >= m_slots.size() )
+                {
+                    return nullptr;
+                }
+
+                SSlot& slot = m_slots[nIndex];
+                return slot.bUsed && slot.nGeneration == ( hHandle >> 16 ) ? &slot : nullptr;
+            }
+
+            std::vector<SSlot> m_slots; //!< all slots ever used
+            std::vector<uint32> m_free; //!< unused slot indices
+            std::vector<uint32> m_live; //!< used slot indices
+    };
+}
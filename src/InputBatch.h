@@ -0,0 +1,61 @@
+/* CryHTML5 - for licensing and copyright see license.txt */
+
+#pragma once
+
+namespace HTML5Plugin
+{
+    /** @brief how the batching treats an input event */
+    enum EInputBatchKind
+    {
+        eIBK_Other = 0, //!< kept as it is (clicks, keys, focus)
+        eIBK_Move, //!< absolute pointer position, only the last of a run matters
+        eIBK_Wheel, //!< relative wheel delta, a run adds up
+    };
+
+    /**
+    * @brief Collapse the input events of a frame before they are sent to the browser, in place.
+    * A run of consecutive moves becomes the last move and a run of consecutive wheel events one event with the summed delta.
+    * Runs never reach across another event, so clicks, keys and wheel events still see the position the pointer had at their time
+    * and the order between different kinds is kept.
+    * @param pEvents events in arrival order
+    * @param nEvents number of events
+    * @param kind kind( const T& ) returns the EInputBatchKind of an event
+    * @param mergeWheel mergeWheel( T& into, const T& next ) adds the delta of next to into
+    * @return number of events left at the start of pEvents
+    */
+    template<class T, class FKind, class FMergeWheel>
+    size_t BatchInput( T* pEvents, size_t nEvents, FKind kind, FMergeWheel mergeWheel )
+    {
+        size_t nOut = 0;
+        EInputBatchKind eLast = eIBK_Other;
+
+        for ( size_t i = 0; i < nEvents; ++i )
+        {
+            const EInputBatchKind eKind = kind( pEvents[i] );
+
+            if ( nOut > 0 && eKind == eLast && eKind == eIBK_Move )
+            {
+                pEvents[nOut - 1] = pEvents[i];
+            }
+
+            else if ( nOut > 0 && eKind == eLast && eKind == eIBK_Wheel )
+            {
+                mergeWheel( pEvents[nOut - 1], pEvents[i] );
+            }
+
+            else
+            {
+                if ( nOut != i )
+                {
+                    pEvents[nOut] = pEvents[i];
+                }
+
+                ++nOut;
+            }
+
+            eLast = eKind;
+        }
+
+        return nOut;
+    }
+}
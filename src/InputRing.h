@@ -0,0 +1,232 @@
+/* CryHTML5 - for licensing and copyright see license.txt */
+
+#pragma once
+
+#include <atomic>
+
+namespace HTML5Plugin
+{
+    /** @brief what a full input ring does with a new event */
+    enum EInputOverflowPolicy
+    {
+        eIOP_DropNewest = 0, //!< the new event is dropped
+        eIOP_DropOldest, //!< the oldest queued event is dropped to make room
+    };
+
+    /**
+    * @brief Bounded lock-free queue of value type events, many producers and one consumer.
+    * Every cell carries a sequence number telling whether it is free for the push or filled for the pop
+    * of the current lap, so producers only race on the enqueue position and nothing is allocated after construction.
+    * @tparam T event type (default constructible and copyable)
+    * @tparam nCapacity number of cells, a power of two
+    */
+    template<class T, uint32 nCapacity>
+    class CInputRing
+    {
+        public:
+            /** @brief event counters since construction */
+            struct SCounters
+            {
+                uint32 nPushed; //!< events queued
+                uint32 nPopped; //!< events taken by the consumer
+                uint32 nDropped; //!< events lost to the overflow policy
+                uint32 nPeak; //!< most events queued at once
+            };
+
+            CInputRing( EInputOverflowPolicy ePolicy = eIOP_DropNewest )
+                : m_ePolicy( ePolicy )
+                , m_nEnqueue( 0 )
+                , m_nDequeue( 0 )
+                , m_nPushed( 0 )
+                , m_nPopped( 0 )
+                , m_nDropped( 0 )
+                , m_nPeak( 0 )
+            {
+                static_assert( nCapacity >= 2 && ( nCapacity & ( nCapacity - 1 ) ) == 0, "capacity must be a power of two" );
+
+                for ( uint32 i = 0; i < nCapacity; ++i )
+                {
+                    m_cells[i].nSequence.store( i, std::memory_order_relaxed );
+                }
+            }
+
+            /** @brief set the overflow policy */
+            void SetPolicy( EInputOverflowPolicy ePolicy )
+            {
+                m_ePolicy = ePolicy;
+            }
+
+            /**
+            * @brief queue an event (any thread)
+            * @return false when the event was dropped
+            */
+            bool Push( const T& item )
+            {
+                while ( !TryPush( item ) )
+                {
+                    T oldest;
+
+                    // drop the oldest, a failed pop means the consumer just made room
+                    if ( m_ePolicy != eIOP_DropOldest )
+                    {
+                        m_nDropped.fetch_add( 1, std::memory_order_relaxed );
+                        return false;
+                    }
+
+                    if ( TryPop( oldest ) )
+                    {
+                        m_nDropped.fetch_add( 1, std::memory_order_relaxed );
+                    }
+                }
+
+                m_nPushed.fetch_add( 1, std::memory_order_relaxed );
+                return true;
+            }
+
+            /**
+            * @brief take the oldest event (consumer thread)
+            * @return false when the ring is empty
+            */
+            bool Pop( T& item )
+            {
+                if ( !TryPop( item ) )
+                {
+                    return false;
+                }
+
+                m_nPopped.fetch_add( 1, std::memory_order_relaxed );
+                return true;
+            }
+
+            /** @brief drop all queued events (consumer thread) */
+            void Clear()
+            {
+                T item;
+
+                while ( Pop( item ) )
+                {
+                }
+            }
+
+            /** @return the counters, each read atomically but not as a whole */
+            SCounters GetCounters() const
+            {
+                SCounters counters;
+                counters.nPushed = m_nPushed.load( std::memory_order_relaxed );
+                counters.nPopped = m_nPopped.load( std::memory_order_relaxed );
+                counters.nDropped = m_nDropped.load( std::memory_order_relaxed );
+                counters.nPeak = m_nPeak.load( std::memory_order_relaxed );
+                return counters;
+            }
+
+            /** @return the number of cells */
+            static uint32 GetCapacity()
+            {
+                return nCapacity;
+            }
+
+        private:
+            enum
+            {
+                eMask = nCapacity - 1,
+                eCacheLine = 64,
+            };
+
+            struct SCell
+            {
+                std::atomic<uint32> nSequence; //!< position the cell is free for (push) or position + 1 once filled (pop)
+                T item; //!< the event
+            };
+
+            bool TryPush( const T& item )
+            {
+                uint32 nPos = m_nEnqueue.load( std::memory_order_relaxed );
+
+                for ( ;; )
+                {
+                    SCell& cell = m_cells[nPos & eMask];
+                    const int32 nDiff = int32( cell.nSequence.load( std::memory_order_acquire ) - nPos );
+
+                    if ( nDiff == 0 )
+                    {
+                        if ( m_nEnqueue.compare_exchange_weak( nPos, nPos + 1, std::memory_order_relaxed ) )
+                        {
+                            cell.item = item;
+                            cell.nSequence.store( nPos + 1, std::memory_order_release );
+                            UpdatePeak( nPos + 1 );
+                            return true;
+                        }
+                    }
+
+                    // the cell of this lap wasn't popped yet
+                    else if ( nDiff < 0 )
+                    {
+                        return false;
+                    }
+
+                    else
+                    {
+                        nPos = m_nEnqueue.load( std::memory_order_relaxed );
+                    }
+                }
+            }
+
+            bool TryPop( T& item )
+            {
+                uint32 nPos = m_nDequeue.load( std::memory_order_relaxed );
+
+                for ( ;; )
+                {
+                    SCell& cell = m_cells[nPos & eMask];
+                    const int32 nDiff = int32( cell.nSequence.load( std::memory_order_acquire ) - ( nPos + 1 ) );
+
+                    if ( nDiff == 0 )
+                    {
+                        if ( m_nDequeue.compare_exchange_weak( nPos, nPos + 1, std::memory_order_relaxed ) )
+                        {
+                            item = cell.item;
+                            cell.nSequence.store( nPos + nCapacity, std::memory_order_release );
+                            return true;
+                        }
+                    }
+
+                    // the cell wasn't filled yet
+                    else if ( nDiff < 0 )
+                    {
+                        return false;
+                    }
+
+                    else
+                    {
+                        nPos = m_nDequeue.load( std::memory_order_relaxed );
+                    }
+                }
+            }
+
+            /** @brief track the fill level after a push ending at nEnd */
+            void UpdatePeak( uint32 nEnd )
+            {
+                const uint32 nFill = nEnd - m_nDequeue.load( std::memory_order_relaxed );
+                uint32 nPeak = m_nPeak.load( std::memory_order_relaxed );
+
+                while ( nFill > nPeak && nFill <= nCapacity && !m_nPeak.compare_exchange_weak( nPeak, nFill, std::memory_order_relaxed ) )
+                {
+                }
+            }
+
+            SCell m_cells[nCapacity]; //!< the ring
+            EInputOverflowPolicy m_ePolicy; //!< what a full ring does
+
+            // producers and the consumer advance their positions on separate cache lines
+            char m_pad0[eCacheLine];
+            std::atomic<uint32> m_nEnqueue; //!< next position to push
+            char m_pad1[eCacheLine - sizeof( std::atomic<uint32> )];
+            std::atomic<uint32> m_nDequeue; //!< next position to pop
+            char m_pad2[eCacheLine - sizeof( std::atomic<uint32> )];
+
+            std::atomic<uint32> m_nPushed; //!< counters
+            std::atomic<uint32> m_nPopped;
+            std::atomic<uint32> m_nDropped;
+            std::atomic<uint32> m_nPeak;
+    };
+}
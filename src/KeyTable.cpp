@@ -0,0 +1,168 @@
+/* CryHTML5 - for licensing and copyright see license.txt */
+
+#include "StdAfx.h"
+#include "KeyTable.h"
+
+namespace HTML5Plugin
+{
+    namespace
+    {
+        // in HTML5_DEFAULT_KEYS order, the windows virtual key names are in the comments
+        const SDefaultKey s_defaultKeys[eDK_Count] =
+        {
+            { eDK_Backspace, 0x08, false }, // VK_BACK
+            { eDK_Tab, 0x09, true }, // VK_TAB
+            { eDK_Enter, 0x0D, true }, // VK_RETURN
+            { eDK_NP_Enter, 0x0D, true }, // VK_RETURN, windows doesn't tell the keypad enter apart
+            { eDK_Escape, 0x1B, false }, // VK_ESCAPE
+            { eDK_Space, 0x20, true }, // VK_SPACE
+            { eDK_LShift, 0xA0, false }, // VK_LSHIFT
+            { eDK_RShift, 0xA1, false }, // VK_RSHIFT
+            { eDK_LCtrl, 0xA2, false }, // VK_LCONTROL
+            { eDK_RCtrl, 0xA3, false }, // VK_RCONTROL
+            { eDK_LAlt, 0xA4, false }, // VK_LMENU
+            { eDK_RAlt, 0xA5, false }, // VK_RMENU
+            { eDK_LWin, 0x5B, false }, // VK_LWIN
+            { eDK_RWin, 0x5C, false }, // VK_RWIN
+            { eDK_CapsLock, 0x14, false }, // VK_CAPITAL
+            { eDK_NumLock, 0x90, false }, // VK_NUMLOCK
+            { eDK_ScrollLock, 0x91, false }, // VK_SCROLL
+            { eDK_Pause, 0x13, false }, // VK_PAUSE
+            { eDK_Left, 0x25, false }, // VK_LEFT
+            { eDK_Up, 0x26, false }, // VK_UP
+            { eDK_Right, 0x27, false }, // VK_RIGHT
+            { eDK_Down, 0x28, false }, // VK_DOWN
+            { eDK_Home, 0x24, false }, // VK_HOME
+            { eDK_End, 0x23, false }, // VK_END
+            { eDK_PgUp, 0x21, false }, // VK_PRIOR
+            { eDK_PgDn, 0x22, false }, // VK_NEXT
+            { eDK_Insert, 0x2D, false }, // VK_INSERT
+            { eDK_Delete, 0x2E, false }, // VK_DELETE
+            { eDK_F1, 0x70, false }, // VK_F1 to VK_F12
+            { eDK_F2, 0x71, false },
+            { eDK_F3, 0x72, false },
+            { eDK_F4, 0x73, false },
+            { eDK_F5, 0x74, false },
+            { eDK_F6, 0x75, false },
+            { eDK_F7, 0x76, false },
+            { eDK_F8, 0x77, false },
+            { eDK_F9, 0x78, false },
+            { eDK_F10, 0x79, false },
+            { eDK_F11, 0x7A, false },
+            { eDK_F12, 0x7B, false },
+            { eDK_0, '0', true },
+            { eDK_1, '1', true },
+            { eDK_2, '2', true },
+            { eDK_3, '3', true },
+            { eDK_4, '4', true },
+            { eDK_5, '5', true },
+            { eDK_6, '6', true },
+            { eDK_7, '7', true },
+            { eDK_8, '8', true },
+            { eDK_9, '9', true },
+            { eDK_A, 'A', true },
+            { eDK_B, 'B', true },
+            { eDK_C, 'C', true },
+            { eDK_D, 'D', true },
+            { eDK_E, 'E', true },
+            { eDK_F, 'F', true },
+            { eDK_G, 'G', true },
+            { eDK_H, 'H', true },
+            { eDK_I, 'I', true },
+            { eDK_J, 'J', true },
+            { eDK_K, 'K', true },
+            { eDK_L, 'L', true },
+            { eDK_M, 'M', true },
+            { eDK_N, 'N', true },
+            { eDK_O, 'O', true },
+            { eDK_P, 'P', true },
+            { eDK_Q, 'Q', true },
+            { eDK_R, 'R', true },
+            { eDK_S, 'S', true },
+            { eDK_T, 'T', true },
+            { eDK_U, 'U', true },
+            { eDK_V, 'V', true },
+            { eDK_W, 'W', true },
+            { eDK_X, 'X', true },
+            { eDK_Y, 'Y', true },
+            { eDK_Z, 'Z', true },
+            { eDK_NP_0, 0x60, true }, // VK_NUMPAD0 to VK_NUMPAD9
+            { eDK_NP_1, 0x61, true },
+            { eDK_NP_2, 0x62, true },
+            { eDK_NP_3, 0x63, true },
+            { eDK_NP_4, 0x64, true },
+            { eDK_NP_5, 0x65, true },
+            { eDK_NP_6, 0x66, true },
+            { eDK_NP_7, 0x67, true },
+            { eDK_NP_8, 0x68, true },
+            { eDK_NP_9, 0x69, true },
+            { eDK_NP_Multiply, 0x6A, true }, // VK_MULTIPLY
+            { eDK_NP_Add, 0x6B, true }, // VK_ADD
+            { eDK_NP_Substract, 0x6D, true }, // VK_SUBTRACT
+            { eDK_NP_Period, 0x6E, true }, // VK_DECIMAL
+            { eDK_NP_Divide, 0x6F, true }, // VK_DIVIDE
+            { eDK_Minus, 0xBD, true }, // VK_OEM_MINUS
+            { eDK_Equals, 0xBB, true }, // VK_OEM_PLUS
+            { eDK_LBracket, 0xDB, true }, // VK_OEM_4
+            { eDK_RBracket, 0xDD, true }, // VK_OEM_6
+            { eDK_Semicolon, 0xBA, true }, // VK_OEM_1
+            { eDK_Apostrophe, 0xDE, true }, // VK_OEM_7
+            { eDK_Tilde, 0xC0, true }, // VK_OEM_3
+            { eDK_Backslash, 0xDC, true }, // VK_OEM_5
+            { eDK_Comma, 0xBC, true }, // VK_OEM_COMMA
+            { eDK_Period, 0xBE, true }, // VK_OEM_PERIOD
+            { eDK_Slash, 0xBF, true }, // VK_OEM_2
+        };
+    }
+
+    const SDefaultKey& GetDefaultKey( EDefaultKey eKey )
+    {
+        CRY_ASSERT( eKey >= 0 && eKey < eDK_Count && s_defaultKeys[eKey].eKey == eKey );
+        return s_defaultKeys[eKey];
+    }
+
+    uint32 GetModifierFlags( uint32 nModifiers )
+    {
+        uint32 nFlags = 0;
+        nFlags |= ( nModifiers & ( eKM_LShift | eKM_RShift ) ) ? eKEF_ShiftDown : 0;
+        nFlags |= ( nModifiers & ( eKM_LCtrl | eKM_RCtrl ) ) ? eKEF_ControlDown : 0;
+        nFlags |= ( nModifiers & ( eKM_LAlt | eKM_RAlt ) ) ? eKEF_AltDown : 0;
+        nFlags |= ( nModifiers & eKM_CapsLock ) ? eKEF_CapsLockOn : 0;
+        nFlags |= ( nModifiers & eKM_NumLock ) ? eKEF_NumLockOn : 0;
+
+        nFlags |= ( nModifiers & ( eKM_LShift | eKM_LCtrl | eKM_LAlt ) ) ? eKEF_IsLeft : 0;
+        nFlags |= ( nModifiers & ( eKM_RShift | eKM_RCtrl | eKM_RAlt ) ) ? eKEF_IsRight : 0;
+        return nFlags;
+    }
+
+    CKeyTable::CKeyTable()
+    {
+        m_unknown.nKeyCode = 0;
+        m_unknown.bPrintable = true;
+
+        for ( uint32 i = 0; i < eMaxKeys; ++i )
+        {
+            m_keys[i] = m_unknown;
+        }
+
+        memset( m_modifiers, 0, sizeof( m_modifiers ) );
+    }
+
+    void CKeyTable::SetKey( uint32 nKey, uint16 nKeyCode, bool bPrintable )
+    {
+        if ( nKey < eMaxKeys )
+        {
+            m_keys[nKey].nKeyCode = nKeyCode;
+            m_keys[nKey].bPrintable = bPrintable;
+        }
+    }
+
+    void CKeyTable::SetDefaultKeys( const uint32 keyIds[eDK_Count] )
+    {
+        for ( int i = 0; i < eDK_Count; ++i )
+        {
+            const SDefaultKey& key = GetDefaultKey( EDefaultKey( i ) );
+            SetKey( keyIds[i], key.nKeyCode, key.bPrintable );
+        }
+    }
+}
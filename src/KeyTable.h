@@ -0,0 +1,151 @@
+/* CryHTML5 - for licensing and copyright see license.txt */
+
+#pragma once
+
+/**
+* @brief Keys with a fixed translation, KEY( name ) per key.
+* name is the CryENGINE key id without its eKI_ prefix, so the engine side expands the list to its key ids.
+*/
+#define HTML5_DEFAULT_KEYS( KEY ) \
+    KEY( Backspace ) KEY( Tab ) KEY( Enter ) KEY( NP_Enter ) KEY( Escape ) KEY( Space ) \
+    KEY( LShift ) KEY( RShift ) KEY( LCtrl ) KEY( RCtrl ) KEY( LAlt ) KEY( RAlt ) KEY( LWin ) KEY( RWin ) \
+    KEY( CapsLock ) KEY( NumLock ) KEY( ScrollLock ) KEY( Pause ) \
+    KEY( Left ) KEY( Up ) KEY( Right ) KEY( Down ) KEY( Home ) KEY( End ) KEY( PgUp ) KEY( PgDn ) KEY( Insert ) KEY( Delete ) \
+    KEY( F1 ) KEY( F2 ) KEY( F3 ) KEY( F4 ) KEY( F5 ) KEY( F6 ) KEY( F7 ) KEY( F8 ) KEY( F9 ) KEY( F10 ) KEY( F11 ) KEY( F12 ) \
+    KEY( 0 ) KEY( 1 ) KEY( 2 ) KEY( 3 ) KEY( 4 ) KEY( 5 ) KEY( 6 ) KEY( 7 ) KEY( 8 ) KEY( 9 ) \
+    KEY( A ) KEY( B ) KEY( C ) KEY( D ) KEY( E ) KEY( F ) KEY( G ) KEY( H ) KEY( I ) KEY( J ) KEY( K ) KEY( L ) KEY( M ) \
+    KEY( N ) KEY( O ) KEY( P ) KEY( Q ) KEY( R ) KEY( S ) KEY( T ) KEY( U ) KEY( V ) KEY( W ) KEY( X ) KEY( Y ) KEY( Z ) \
+    KEY( NP_0 ) KEY( NP_1 ) KEY( NP_2 ) KEY( NP_3 ) KEY( NP_4 ) KEY( NP_5 ) KEY( NP_6 ) KEY( NP_7 ) KEY( NP_8 ) KEY( NP_9 ) \
+    KEY( NP_Multiply ) KEY( NP_Add ) KEY( NP_Substract ) KEY( NP_Period ) KEY( NP_Divide ) \
+    KEY( Minus ) KEY( Equals ) KEY( LBracket ) KEY( RBracket ) KEY( Semicolon ) KEY( Apostrophe ) KEY( Tilde ) \
+    KEY( Backslash ) KEY( Comma ) KEY( Period ) KEY( Slash )
+
+namespace HTML5Plugin
+{
+    /** @brief index of a key in HTML5_DEFAULT_KEYS */
+    enum EDefaultKey
+    {
+#define HTML5_DEFAULT_KEY_ENUM( name ) eDK_##name,
+        HTML5_DEFAULT_KEYS( HTML5_DEFAULT_KEY_ENUM )
+#undef HTML5_DEFAULT_KEY_ENUM
+        eDK_Count,
+    };
+
+    /** @brief modifier bits of a CryENGINE modifier mask (EModifierMask) */
+    enum EKeyModifier
+    {
+        eKM_LCtrl = 1 << 0,
+        eKM_LShift = 1 << 1,
+        eKM_LAlt = 1 << 2,
+        eKM_LWin = 1 << 3,
+        eKM_RCtrl = 1 << 4,
+        eKM_RShift = 1 << 5,
+        eKM_RAlt = 1 << 6,
+        eKM_RWin = 1 << 7,
+        eKM_NumLock = 1 << 8,
+        eKM_CapsLock = 1 << 9,
+        eKM_ScrollLock = 1 << 10,
+    };
+
+    /** @brief CEF key event flags (cef_event_flags_t) */
+    enum EKeyEventFlag
+    {
+        eKEF_CapsLockOn = 1 << 0,
+        eKEF_ShiftDown = 1 << 1,
+        eKEF_ControlDown = 1 << 2,
+        eKEF_AltDown = 1 << 3,
+        eKEF_NumLockOn = 1 << 8,
+        eKEF_IsLeft = 1 << 10,
+        eKEF_IsRight = 1 << 11,
+    };
+
+    /** @brief translation of a default key */
+    struct SDefaultKey
+    {
+        EDefaultKey eKey; //!< the key
+        uint16 nKeyCode; //!< windows virtual key code
+        bool bPrintable; //!< the key produces a character event
+    };
+
+    /** @return translation of a default key */
+    const SDefaultKey& GetDefaultKey( EDefaultKey eKey );
+
+    /** @return CEF event flags of a CryENGINE modifier mask, scroll lock and the windows keys have none */
+    uint32 GetModifierFlags( uint32 nModifiers );
+
+    /** @brief translation of one key */
+    struct SKeyInfo
+    {
+        uint16 nKeyCode; //!< windows virtual key code, 0 for keys not in the table
+        bool bPrintable; //!< the key produces a character event
+    };
+
+    /**
+    * @brief Lookup tables for key events, filled once and read with a single indexed load per event.
+    * Keys are indexed by their id relative to the first keyboard key, modifier flags by the modifier mask.
+    */
+    class CKeyTable
+    {
+        public:
+            enum
+            {
+                eMaxKeys = 256, //!< key ids from 0 to eMaxKeys - 1
+                eModifierBits = 11, //!< modifier masks below 1 << eModifierBits are tabled
+            };
+
+            CKeyTable();
+
+            /**
+            * @brief set the translation of a key
+            * @param nKey key id relative to the first keyboard key
+            * @param nKeyCode windows virtual key code (not 0)
+            * @param bPrintable the key produces a character event
+            */
+            void SetKey( uint32 nKey, uint16 nKeyCode, bool bPrintable );
+
+            /**
+            * @brief set the translation of every default key
+            * @param keyIds key id relative to the first keyboard key per default key
+            */
+            void SetDefaultKeys( const uint32 keyIds[eDK_Count] );
+
+            /** @return translation of a key, nKeyCode is 0 for keys not in the table */
+            const SKeyInfo& GetKey( uint32 nKey ) const
+            {
+                return nKey < eMaxKeys ? m_keys[nKey] : m_unknown;
+            }
+
+            /**
+            * @brief fill the modifier table
+            * @param toFlags toFlags( nMask ) returns the event flags of a modifier mask, called for every tabled mask
+            */
+            template<class F>
+            void SetModifiers( F toFlags )
+            {
+                for ( uint32 nMask = 0; nMask < ( 1u << eModifierBits ); ++nMask )
+                {
+                    m_modifiers[nMask] = toFlags( nMask );
+                }
+            }
+
+            /**
+            * @brief get the event flags of a modifier mask
+            * @return false when the mask isn't tabled
+            */
+            bool GetModifiers( uint32 nMask, uint32& nFlags ) const
+            {
+                if ( nMask >= ( 1u << eModifierBits ) )
+                {
+                    return false;
+                }
+
+                nFlags = m_modifiers[nMask];
+                return true;
+            }
+
+        private:
+            SKeyInfo m_keys[eMaxKeys]; //!< translation per key id
+            SKeyInfo m_unknown; //!< returned for ids outside of the table
+            uint32 m_modifiers[1 << eModifierBits]; //!< event flags per modifier mask
+    };
+}
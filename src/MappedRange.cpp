@@ -0,0 +1,130 @@
+/* CryHTML5 - for licensing and copyright see license.txt */
+
+#include "StdAfx.h"
+#include "MappedRange.h"
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace HTML5Plugin
+{
+    /** @return alignment the offset of a view has to have */
+    static uint64 GetGranularity()
+    {
+#if defined(_WIN32)
+        SYSTEM_INFO info;
+        GetSystemInfo( &info );
+        return info.dwAllocationGranularity;
+#else
+        return uint64( sysconf( _SC_PAGESIZE ) );
+#endif
+    }
+
+    CMappedRange::CMappedRange()
+        : m_pView( nullptr )
+        , m_nViewSize( 0 )
+        , m_pData( nullptr )
+        , m_nSize( 0 )
+    {
+    }
+
+    CMappedRange::~CMappedRange()
+    {
+        Unmap();
+    }
+
+    bool CMappedRange::Map( const char* sFile, uint64 nOffset, size_t nSize )
+    {
+        Unmap();
+
+        if ( nSize == 0 )
+        {
+            return false;
+        }
+
+        const uint64 nViewOffset = nOffset - nOffset % GetGranularity();
+        const size_t nViewSize = size_t( nOffset - nViewOffset ) + nSize;
+        void* pView = nullptr;
+
+#if defined(_WIN32)
+        // the pak stays open in CryPak, share it both ways
+        HANDLE hFile = CreateFileA( sFile, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr );
+
+        if ( hFile == INVALID_HANDLE_VALUE )
+        {
+            return false;
+        }
+
+        LARGE_INTEGER fileSize;
+
+        if ( GetFileSizeEx( hFile, &fileSize ) && uint64( fileSize.QuadPart ) >= nOffset + nSize )
+        {
+            // the view keeps the mapping object alive, neither handle is needed afterwards
+            HANDLE hMapping = CreateFileMappingA( hFile, nullptr, PAGE_READONLY, 0, 0, nullptr );
+
+            if ( hMapping )
+            {
+                pView = MapViewOfFile( hMapping, FILE_MAP_READ, DWORD( nViewOffset >> 32 ), DWORD( nViewOffset & 0xFFFFFFFF ), nViewSize );
+                CloseHandle( hMapping );
+            }
+        }
+
+        CloseHandle( hFile );
+#else
+        int nFile = open( sFile, O_RDONLY );
+
+        if ( nFile < 0 )
+        {
+            return false;
+        }
+
+        struct stat status;
+
+        if ( fstat( nFile, &status ) == 0 && uint64( status.st_size ) >= nOffset + nSize )
+        {
+            pView = mmap( nullptr, nViewSize, PROT_READ, MAP_SHARED, nFile, off_t( nViewOffset ) );
+
+            if ( pView == MAP_FAILED )
+            {
+                pView = nullptr;
+            }
+        }
+
+        close( nFile );
+#endif
+
+        if ( !pView )
+        {
+            return false;
+        }
+
+        m_pView = pView;
+        m_nViewSize = nViewSize;
+        m_pData = static_cast<const uint8*>( pView ) + ( nOffset - nViewOffset );
+        m_nSize = nSize;
+        return true;
+    }
+
+    void CMappedRange::Unmap()
+    {
+        if ( m_pView )
+        {
+#if defined(_WIN32)
+            UnmapViewOfFile( m_pView );
+#else
+            munmap( m_pView, m_nViewSize );
+#endif
+        }
+
+        m_pView = nullptr;
+        m_nViewSize = 0;
+        m_pData = nullptr;
+        m_nSize = 0;
+    }
+}
@@ -0,0 +1,52 @@
+/* CryHTML5 - for licensing and copyright see license.txt */
+
+#pragma once
+
+namespace HTML5Plugin
+{
+    /**
+    * @brief Read only memory mapping of a byte range of a file (Win32 file mappings or POSIX mmap).
+    * The view starts at the allocation granularity boundary below the offset, GetData points at the offset itself.
+    * The file may stay open elsewhere, pages are only read from disk when touched.
+    */
+    class CMappedRange
+    {
+        public:
+            CMappedRange();
+            ~CMappedRange();
+
+            /**
+            * @brief map a range, a previous mapping is released first
+            * @param sFile path of the file
+            * @param nOffset first byte of the range
+            * @param nSize bytes in the range (at least 1)
+            * @return false when the file can't be opened, is too short for the range or can't be mapped
+            */
+            bool Map( const char* sFile, uint64 nOffset, size_t nSize );
+
+            /** @brief release the mapping */
+            void Unmap();
+
+            /** @return first byte of the range, nullptr when nothing is mapped */
+            const uint8* GetData() const
+            {
+                return m_pData;
+            }
+
+            /** @return bytes in the range */
+            size_t GetSize() const
+            {
+                return m_nSize;
+            }
+
+        private:
+            // not copyable
+            CMappedRange( const CMappedRange& );
+            CMappedRange& operator=( const CMappedRange& );
+
+            void* m_pView; //!< start of the mapped view (granularity aligned)
+            size_t m_nViewSize; //!< bytes in the view
+            const uint8* m_pData; //!< start of the range inside the view
+            size_t m_nSize; //!< bytes in the range
+    };
+}
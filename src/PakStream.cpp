@@ -0,0 +1,511 @@
+/* CryHTML5 - for licensing and copyright see license.txt */
+
+#include "StdAfx.h"
+#include "PakStream.h"
+
+namespace HTML5Plugin
+{
+    CPakWorkerPool::CPakWorkerPool()
+        : m_nSequence( 0 )
+        , m_nThreadCount( 2 )
+        , m_bStop( false )
+    {
+    }
+
+    CPakWorkerPool::~CPakWorkerPool()
+    {
+        Stop();
+    }
+
+    void CPakWorkerPool::SetThreadCount( int nThreads )
+    {
+        std::lock_guard<std::mutex> lock( m_lock );
+        m_nThreadCount = max( nThreads, 1 );
+    }
+
+    void CPakWorkerPool::Submit( int nPriority, const TJob& job )
+    {
+        std::lock_guard<std::mutex> lock( m_lock );
+
+        if ( m_threads.empty() )
+        {
+            m_bStop = false;
+
+            for ( int i = 0; i < m_nThreadCount; ++i )
+            {
+                m_threads.push_back( std::thread( &CPakWorkerPool::Run, this ) );
+            }
+        }
+
+        SJob queued;
+        queued.nPriority = nPriority;
+        queued.nSequence = m_nSequence++;
+        queued.job = job;
+        m_jobs.push( queued );
+        m_wake.notify_one();
+    }
+
+    void CPakWorkerPool::Stop()
+    {
+        std::vector<std::thread> threads;
+        {
+            std::lock_guard<std::mutex> lock( m_lock );
+            m_bStop = true;
+            m_jobs = std::priority_queue<SJob>();
+            m_threads.swap( threads );
+            m_wake.notify_all();
+        }
+
+        for ( size_t i = 0; i < threads.size(); ++i )
+        {
+            threads[i].join();
+        }
+    }
+
+    size_t CPakWorkerPool::GetQueued()
+    {
+        std::lock_guard<std::mutex> lock( m_lock );
+        return m_jobs.size();
+    }
+
+    void CPakWorkerPool::Run()
+    {
+        for ( ;; )
+        {
+            TJob job;
+            {
+                std::unique_lock<std::mutex> lock( m_lock );
+
+                while ( !m_bStop && m_jobs.empty() )
+                {
+                    m_wake.wait( lock );
+                }
+
+                if ( m_bStop )
+                {
+                    return;
+                }
+
+                job = m_jobs.top().job;
+                m_jobs.pop();
+            }
+
+            job();
+        }
+    }
+
+    CPakStream::CPakStream( const std::shared_ptr<IPakFiles>& pFiles, CPakWorkerPool& pool, const char* sPath, int nPriority, CResourceCache* pCache )
+        : m_pFiles( pFiles )
+        , m_pool( pool )
+        , m_sPath( sPath )
+        , m_nPriority( nPriority )
+        , m_pCache( pCache )
+        , m_eState( eS_Idle )
+        , m_hFile( nullptr )
+        , m_nSize( 0 )
+        , m_nRequested( 0 )
+        , m_nChunkPos( 0 )
+        , m_pData( nullptr )
+        , m_nDataPos( 0 )
+        , m_nDataReady( 0 )
+        , m_bBusy( false )
+        , m_bCancelled( false )
+    {
+    }
+
+    CPakStream::~CPakStream()
+    {
+        // only reached once no job holds the stream anymore
+        if ( m_hFile )
+        {
+            m_pFiles->Close( m_hFile );
+        }
+    }
+
+    void CPakStream::Open( const TNotify& onOpened )
+    {
+        {
+            std::lock_guard<std::mutex> lock( m_lock );
+
+            if ( m_eState != eS_Idle || m_bCancelled )
+            {
+                return;
+            }
+
+            m_eState = eS_Opening;
+            m_bBusy = true;
+            m_notify = onOpened;
+        }
+
+        std::shared_ptr<CPakStream> pSelf = shared_from_this();
+        m_pool.Submit( m_nPriority, [pSelf]()
+        {
+            pSelf->RunOpen();
+        } );
+    }
+
+    bool CPakStream::IsOpen()
+    {
+        std::lock_guard<std::mutex> lock( m_lock );
+        return m_eState == eS_Open;
+    }
+
+    bool CPakStream::IsMissing()
+    {
+        std::lock_guard<std::mutex> lock( m_lock );
+        return m_eState == eS_Missing;
+    }
+
+    size_t CPakStream::GetSize()
+    {
+        std::lock_guard<std::mutex> lock( m_lock );
+        return m_nSize;
+    }
+
+    bool CPakStream::Read( void* pDest, int nBytes, int& nRead, const TNotify& onReady )
+    {
+        nRead = 0;
+        {
+            std::lock_guard<std::mutex> lock( m_lock );
+
+            if ( m_bCancelled || m_eState != eS_Open )
+            {
+                return false;
+            }
+
+            // served in place from the shared buffer or the mapping
+            if ( m_pData )
+            {
+                if ( m_nDataPos < m_nDataReady )
+                {
+                    const size_t nCopy = min( m_nDataReady - m_nDataPos, size_t( max( nBytes, 0 ) ) );
+                    memcpy( pDest, m_pData + m_nDataPos, nCopy );
+                    m_nDataPos += nCopy;
+                    nRead = int( nCopy );
+                    return true;
+                }
+
+                if ( m_nDataPos >= m_nSize )
+                {
+                    return false;
+                }
+            }
+
+            else if ( m_nChunkPos < m_chunk.size() )
+            {
+                const size_t nCopy = min( m_chunk.size() - m_nChunkPos, size_t( max( nBytes, 0 ) ) );
+                memcpy( pDest, &m_chunk[m_nChunkPos], nCopy );
+                m_nChunkPos += nCopy;
+                nRead = int( nCopy );
+                return true;
+            }
+
+            else if ( m_nRequested >= m_nSize )
+            {
+                CloseIdle();
+                return false;
+            }
+
+            m_notify = onReady;
+
+            // the chunk in flight notifies the newest callback
+            if ( m_bBusy )
+            {
+                return true;
+            }
+
+            m_bBusy = true;
+        }
+
+        std::shared_ptr<CPakStream> pSelf = shared_from_this();
+
+        if ( m_pData )
+        {
+            m_pool.Submit( m_nPriority, [pSelf]()
+            {
+                pSelf->RunTouch();
+            } );
+        }
+
+        else
+        {
+            m_pool.Submit( m_nPriority, [pSelf]()
+            {
+                pSelf->RunRead();
+            } );
+        }
+
+        return true;
+    }
+
+    void CPakStream::Cancel()
+    {
+        std::lock_guard<std::mutex> lock( m_lock );
+        m_bCancelled = true;
+        m_notify = TNotify();
+        CloseIdle();
+    }
+
+    void CPakStream::RunOpen()
+    {
+        void* hFile = nullptr;
+        size_t nSize = 0;
+        {
+            std::lock_guard<std::mutex> lock( m_lock );
+
+            if ( m_bCancelled )
+            {
+                m_bBusy = false;
+                return;
+            }
+        }
+
+        hFile = m_pFiles->Open( m_sPath.c_str() );
+
+        TResourceBuffer pBuffer;
+        std::shared_ptr<CMappedRange> pMapping;
+        std::vector<uint8> head;
+        bool bFound = hFile != nullptr;
+
+        if ( hFile )
+        {
+            nSize = m_pFiles->GetSize( hFile );
+            pBuffer = LoadCached( hFile, nSize );
+
+            if ( pBuffer )
+            {
+                nSize = pBuffer->size();
+            }
+
+            else if ( nSize >= eMapMinSize )
+            {
+                pMapping = MapRange( hFile, nSize, head );
+            }
+
+            // the file isn't needed anymore once its bytes are in memory
+            if ( pBuffer || pMapping )
+            {
+                m_pFiles->Close( hFile );
+                hFile = nullptr;
+            }
+        }
+
+        TNotify notify;
+        {
+            std::lock_guard<std::mutex> lock( m_lock );
+            m_hFile = hFile;
+            m_nSize = nSize;
+            m_pBuffer = pBuffer;
+            m_pMapping = pMapping;
+
+            if ( pBuffer )
+            {
+                m_pData = pBuffer->empty() ? nullptr : &( *pBuffer )[0];
+                m_nDataReady = nSize;
+            }
+
+            else if ( pMapping )
+            {
+                // comparing the head faulted it in already
+                m_pData = pMapping->GetData();
+                m_nDataReady = head.size();
+            }
+
+            else
+            {
+                m_nRequested = head.size();
+                m_chunk.swap( head );
+            }
+
+            m_eState = bFound ? eS_Open : eS_Missing;
+            m_bBusy = false;
+
+            if ( m_bCancelled )
+            {
+                CloseIdle();
+                return;
+            }
+
+            notify.swap( m_notify );
+        }
+
+        if ( notify )
+        {
+            notify();
+        }
+    }
+
+    TResourceBuffer CPakStream::LoadCached( void* hFile, size_t nSize )
+    {
+        if ( !m_pCache )
+        {
+            return TResourceBuffer();
+        }
+
+        const uint64 nStamp = m_pFiles->GetStamp( hFile );
+        TResourceBuffer pBuffer = m_pCache->Find( m_sPath.c_str(), nStamp );
+
+        if ( pBuffer || nSize > m_pCache->GetMaxEntrySize() )
+        {
+            return pBuffer;
+        }
+
+        std::shared_ptr< std::vector<uint8> > pRead = std::make_shared< std::vector<uint8> >( nSize );
+        const size_t nRead = nSize > 0 ? m_pFiles->Read( hFile, &( *pRead )[0], nSize ) : 0;
+
+        // a short read is served as far as it got but not kept
+        if ( nRead < nSize )
+        {
+            pRead->resize( nRead );
+            return pRead;
+        }
+
+        m_pCache->Insert( m_sPath.c_str(), nStamp, pRead );
+        return pRead;
+    }
+
+    std::shared_ptr<CMappedRange> CPakStream::MapRange( void* hFile, size_t nSize, std::vector<uint8>& head )
+    {
+        std::string sArchive;
+        uint64 nOffset = 0;
+
+        if ( !m_pFiles->FindRange( hFile, m_sPath.c_str(), sArchive, nOffset ) )
+        {
+            return std::shared_ptr<CMappedRange>();
+        }
+
+        std::shared_ptr<CMappedRange> pMapping = std::make_shared<CMappedRange>();
+
+        if ( !pMapping->Map( sArchive.c_str(), nOffset, nSize ) )
+        {
+            return std::shared_ptr<CMappedRange>();
+        }
+
+        // the pak decides what the bytes are, a mapping of an encrypted entry or a wrong offset is dropped
+        head.resize( min( nSize, size_t( eVerifySize ) ) );
+        const size_t nExpected = head.size();
+        head.resize( m_pFiles->Read( hFile, &head[0], nExpected ) );
+
+        if ( head.size() != nExpected || memcmp( pMapping->GetData(), &head[0], nExpected ) != 0 )
+        {
+            return std::shared_ptr<CMappedRange>();
+        }
+
+        return pMapping;
+    }
+
+    void CPakStream::RunTouch()
+    {
+        const uint8* pData = nullptr;
+        size_t nFrom = 0;
+        size_t nTo = 0;
+        {
+            std::lock_guard<std::mutex> lock( m_lock );
+
+            if ( m_bCancelled )
+            {
+                m_bBusy = false;
+                return;
+            }
+
+            pData = m_pData;
+            nFrom = m_nDataReady;
+            nTo = min( m_nSize, m_nDataReady + size_t( eMapSlice ) );
+        }
+
+        // one read per page brings the slice in, the sum keeps the reads from being optimized away
+        volatile uint8 nSum = 0;
+
+        for ( size_t i = nFrom; i < nTo; i += 4096 )
+        {
+            nSum += pData[i];
+        }
+
+        nSum += pData[nTo - 1];
+
+        TNotify notify;
+        {
+            std::lock_guard<std::mutex> lock( m_lock );
+            m_nDataReady = nTo;
+            m_bBusy = false;
+
+            if ( m_bCancelled )
+            {
+                return;
+            }
+
+            notify.swap( m_notify );
+        }
+
+        if ( notify )
+        {
+            notify();
+        }
+    }
+
+    void CPakStream::RunRead()
+    {
+        void* hFile = nullptr;
+        size_t nWanted = 0;
+        std::vector<uint8> chunk;
+        {
+            std::lock_guard<std::mutex> lock( m_lock );
+
+            if ( m_bCancelled )
+            {
+                m_bBusy = false;
+                CloseIdle();
+                return;
+            }
+
+            hFile = m_hFile;
+            nWanted = min( m_nSize - m_nRequested, size_t( eChunkSize ) );
+
+            // reuse the buffer of the chunk that was used up
+            chunk.swap( m_chunk );
+            m_nChunkPos = 0;
+        }
+
+        chunk.resize( nWanted );
+        const size_t nRead = nWanted > 0 ? m_pFiles->Read( hFile, &chunk[0], nWanted ) : 0;
+        chunk.resize( nRead );
+
+        TNotify notify;
+        {
+            std::lock_guard<std::mutex> lock( m_lock );
+            m_chunk.swap( chunk );
+            m_nChunkPos = 0;
+            m_nRequested += nRead;
+
+            // a short read ends the file where it stopped
+            if ( nRead < nWanted )
+            {
+                m_nSize = m_nRequested;
+            }
+
+            m_bBusy = false;
+
+            if ( m_bCancelled )
+            {
+                CloseIdle();
+                return;
+            }
+
+            notify.swap( m_notify );
+        }
+
+        if ( notify )
+        {
+            notify();
+        }
+    }
+
+    void CPakStream::CloseIdle()
+    {
+        if ( m_hFile && !m_bBusy )
+        {
+            m_pFiles->Close( m_hFile );
+            m_hFile = nullptr;
+        }
+    }
+}
@@ -0,0 +1,236 @@
+/* CryHTML5 - for licensing and copyright see license.txt */
+
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <ResourceCache.h>
+#include <MappedRange.h>
+
+namespace HTML5Plugin
+{
+    /** @brief file access the pak streams run on (implemented over CryPak and by fake paks) */
+    struct IPakFiles
+    {
+        virtual ~IPakFiles() {}
+
+        /**
+        * @brief open a file for reading
+        * @return handle, nullptr when the file doesn't exist
+        */
+        virtual void* Open( const char* sPath ) = 0;
+
+        /** @return size of an open file in bytes */
+        virtual size_t GetSize( void* hFile ) = 0;
+
+        /** @return modification stamp of an open file, changes whenever the file or the pak holding it changes */
+        virtual uint64 GetStamp( void* hFile ) = 0;
+
+        /**
+        * @brief find where an open file is stored as is
+        * @param hFile the file
+        * @param sPath path it was opened with
+        * @param sArchive receives the path of the file holding the bytes
+        * @param nOffset receives the offset of the first byte inside sArchive
+        * @return false when the file is compressed, encrypted or can't be located
+        */
+        virtual bool FindRange( void* hFile, const char* sPath, std::string& sArchive, uint64& nOffset ) = 0;
+
+        /**
+        * @brief read from the current position of an open file
+        * @return bytes read, less than nBytes only at the end of the file or on errors
+        */
+        virtual size_t Read( void* hFile, void* pDest, size_t nBytes ) = 0;
+
+        /** @brief close an open file */
+        virtual void Close( void* hFile ) = 0;
+    };
+
+    /** @brief scheduling priorities of pak requests, higher ones are served first */
+    enum EPakPriority
+    {
+        ePP_Background = 0, //!< media and anything the page doesn't wait for
+        ePP_Image, //!< images
+        ePP_Layout, //!< stylesheets, scripts and fonts the layout waits for
+        ePP_Document, //!< frames
+    };
+
+    /**
+    * @brief Bounded pool of threads running pak opens and reads, so the CEF IO thread never waits for the disk.
+    * Jobs run by priority and in submission order within a priority.
+    */
+    class CPakWorkerPool
+    {
+        public:
+            typedef std::function<void()> TJob;
+
+            CPakWorkerPool();
+            ~CPakWorkerPool();
+
+            /** @brief set the number of threads started on the first submit (at least 1, takes effect after a stop) */
+            void SetThreadCount( int nThreads );
+
+            /** @brief queue a job, the threads are started on first use */
+            void Submit( int nPriority, const TJob& job );
+
+            /** @brief drop all queued jobs and join the threads (call before the module unloads) */
+            void Stop();
+
+            /** @return number of jobs waiting for a thread */
+            size_t GetQueued();
+
+        private:
+            /** @brief a queued job */
+            struct SJob
+            {
+                int nPriority; //!< EPakPriority or higher
+                uint64 nSequence; //!< submission order
+                TJob job; //!< the work
+
+                /** @brief order for std::priority_queue, which serves the largest element first */
+                bool operator<( const SJob& other ) const
+                {
+                    if ( nPriority != other.nPriority )
+                    {
+                        return nPriority < other.nPriority;
+                    }
+
+                    return nSequence > other.nSequence;
+                }
+            };
+
+            /** @brief thread function */
+            void Run();
+
+            std::mutex m_lock; //!< guards everything below
+            std::condition_variable m_wake; //!< signaled on new jobs and on stop
+            std::priority_queue<SJob> m_jobs; //!< jobs waiting for a thread
+            uint64 m_nSequence; //!< sequence number of the next job
+            int m_nThreadCount; //!< threads started on first use
+            bool m_bStop; //!< the threads should exit
+            std::vector<std::thread> m_threads; //!< the worker threads
+    };
+
+    /**
+    * @brief One file streamed from a pak through the worker pool.
+    * The open and every read run as pool jobs, a notification tells the caller when a request can continue.
+    * Read copies out of the chunk read last and queues the next chunk once it is used up, so at most one job per stream is in flight.
+    * With a cache, files small enough for it are read completely with the open and served from the shared buffer, hits skip the read.
+    * Larger files stored uncompressed are mapped, workers only fault in the next slice and Read copies straight from the mapping.
+    * Jobs keep the stream alive, a cancelled stream closes its file as soon as no job uses it.
+    */
+    class CPakStream : public std::enable_shared_from_this<CPakStream>
+    {
+        public:
+            typedef std::function<void()> TNotify;
+
+            /**
+            * @param pFiles file access, kept alive by the stream
+            * @param pool pool running the jobs, has to outlive the jobs (stopping it drops them)
+            * @param sPath path of the file
+            * @param nPriority scheduling priority (EPakPriority)
+            * @param pCache cache the file is looked up in and added to (optional), has to outlive the jobs
+            */
+            CPakStream( const std::shared_ptr<IPakFiles>& pFiles, CPakWorkerPool& pool, const char* sPath, int nPriority, CResourceCache* pCache = nullptr );
+            ~CPakStream();
+
+            /**
+            * @brief queue the open (call once)
+            * @param onOpened called from a worker once IsOpen or IsMissing tell the result
+            */
+            void Open( const TNotify& onOpened );
+
+            /** @return true once the file is open */
+            bool IsOpen();
+
+            /** @return true once the open failed */
+            bool IsMissing();
+
+            /** @return size of the file, valid once open */
+            size_t GetSize();
+
+            /**
+            * @brief take the next bytes of the file
+            * @param pDest receives up to nBytes bytes
+            * @param nBytes size of pDest
+            * @param nRead bytes copied, 0 when the data isn't there yet and onReady will be called
+            * @param onReady called from a worker once the next chunk can be taken
+            * @return false at the end of the file or when the stream failed or was cancelled
+            */
+            bool Read( void* pDest, int nBytes, int& nRead, const TNotify& onReady );
+
+            /** @brief stop the stream, pending notifications are dropped */
+            void Cancel();
+
+        private:
+            enum EState
+            {
+                eS_Idle = 0, //!< Open wasn't called yet
+                eS_Opening, //!< open queued
+                eS_Open, //!< file is open
+                eS_Missing, //!< the file doesn't exist
+            };
+
+            enum
+            {
+                eChunkSize = 256 * 1024, //!< most bytes a read job brings in at once
+                eMapMinSize = 256 * 1024, //!< smaller files are read, mapping them costs more than it saves
+                eMapSlice = 1024 * 1024, //!< bytes of a mapping a touch job faults in at once
+                eVerifySize = 4096, //!< bytes compared between the mapping and the pak before the mapping is used
+            };
+
+            /** @brief open job */
+            void RunOpen();
+
+            /**
+            * @brief look up an open file in the cache or read it into the cache (worker)
+            * @return contents of the file, empty when it is streamed
+            */
+            TResourceBuffer LoadCached( void* hFile, size_t nSize );
+
+            /**
+            * @brief map an open file when it is stored as is (worker)
+            * @param head receives the first bytes read from the file to check the mapping, the stream continues after them when it isn't used
+            * @return the mapping, empty when the file is streamed
+            */
+            std::shared_ptr<CMappedRange> MapRange( void* hFile, size_t nSize, std::vector<uint8>& head );
+
+            /** @brief touch job, faults in the next slice of the mapping */
+            void RunTouch();
+
+            /** @brief read job */
+            void RunRead();
+
+            /** @brief close the file unless a job still uses it (m_lock held) */
+            void CloseIdle();
+
+            std::shared_ptr<IPakFiles> m_pFiles; //!< file access
+            CPakWorkerPool& m_pool; //!< runs the jobs
+            std::string m_sPath; //!< path of the file
+            int m_nPriority; //!< scheduling priority
+            CResourceCache* m_pCache; //!< cache of small files (optional)
+
+            std::mutex m_lock; //!< guards everything below
+            EState m_eState; //!< progress of the open
+            void* m_hFile; //!< open file, nullptr when closed
+            size_t m_nSize; //!< size of the file
+            size_t m_nRequested; //!< bytes read from the file so far
+            std::vector<uint8> m_chunk; //!< bytes read last
+            size_t m_nChunkPos; //!< bytes of m_chunk already taken
+            TResourceBuffer m_pBuffer; //!< owns m_pData when the file came from the cache
+            std::shared_ptr<CMappedRange> m_pMapping; //!< owns m_pData when the file is mapped
+            const uint8* m_pData; //!< the whole file in memory, nullptr when it is read in chunks
+            size_t m_nDataPos; //!< bytes of m_pData already taken
+            size_t m_nDataReady; //!< bytes of m_pData that can be taken without waiting for the disk
+            bool m_bBusy; //!< a job is in flight
+            bool m_bCancelled; //!< Cancel was called
+            TNotify m_notify; //!< notification of the job in flight
+    };
+}
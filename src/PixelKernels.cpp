@@ -0,0 +1,382 @@
+/* CryHTML5 - for licensing and copyright see license.txt */
+
+#include "StdAfx.h"
+#include "PixelKernels.h"
+
+#include <emmintrin.h>
+#include <immintrin.h>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define PK_TARGET_AVX2
+#else
+#include <cpuid.h>
+#define PK_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+namespace HTML5Plugin
+{
+    // Scalar reference implementations
+
+    static void CopyRowScalar( uint8* pDest, const uint8* pSrc, size_t nBytes )
+    {
+        memcpy( pDest, pSrc, nBytes );
+    }
+
+    static void SwizzleScalar( uint8* pDest, const uint8* pSrc, size_t nPixels )
+    {
+        for ( size_t i = 0; i < nPixels; ++i, pDest += 4, pSrc += 4 )
+        {
+            uint8 c0 = pSrc[0];
+            pDest[0] = pSrc[2];
+            pDest[1] = pSrc[1];
+            pDest[2] = c0;
+            pDest[3] = pSrc[3];
+        }
+    }
+
+    /** @return c * a / 255 rounded like the SIMD versions */
+    static inline uint8 MulDiv255( uint32 c, uint32 a )
+    {
+        uint32 t = c * a + 128;
+        return uint8( ( t + ( t >> 8 ) ) >> 8 );
+    }
+
+    static void PremultiplyScalar( uint8* pDest, const uint8* pSrc, size_t nPixels )
+    {
+        for ( size_t i = 0; i < nPixels; ++i, pDest += 4, pSrc += 4 )
+        {
+            uint32 a = pSrc[3];
+            pDest[0] = MulDiv255( pSrc[0], a );
+            pDest[1] = MulDiv255( pSrc[1], a );
+            pDest[2] = MulDiv255( pSrc[2], a );
+            pDest[3] = uint8( a );
+        }
+    }
+
+    static void AlphaRangeScalar( const uint8* pSrc, size_t nPixels, uint8& nMin, uint8& nMax )
+    {
+        uint8 a = 255;
+        uint8 b = 0;
+
+        for ( size_t i = 0; i < nPixels; ++i )
+        {
+            uint8 alpha = pSrc[i * 4 + 3];
+            a = min( a, alpha );
+            b = max( b, alpha );
+        }
+
+        nMin = a;
+        nMax = b;
+    }
+
+    // SSE2 (4 pixels per step)
+
+    static void CopyRowSSE2( uint8* pDest, const uint8* pSrc, size_t nBytes )
+    {
+        size_t i = 0;
+
+        for ( ; i + 64 <= nBytes; i += 64 )
+        {
+            __m128i a = _mm_loadu_si128( ( const __m128i* )( pSrc + i ) );
+            __m128i b = _mm_loadu_si128( ( const __m128i* )( pSrc + i + 16 ) );
+            __m128i c = _mm_loadu_si128( ( const __m128i* )( pSrc + i + 32 ) );
+            __m128i d = _mm_loadu_si128( ( const __m128i* )( pSrc + i + 48 ) );
+            _mm_storeu_si128( ( __m128i* )( pDest + i ), a );
+            _mm_storeu_si128( ( __m128i* )( pDest + i + 16 ), b );
+            _mm_storeu_si128( ( __m128i* )( pDest + i + 32 ), c );
+            _mm_storeu_si128( ( __m128i* )( pDest + i + 48 ), d );
+        }
+
+        for ( ; i + 16 <= nBytes; i += 16 )
+        {
+            _mm_storeu_si128( ( __m128i* )( pDest + i ), _mm_loadu_si128( ( const __m128i* )( pSrc + i ) ) );
+        }
+
+        memcpy( pDest + i, pSrc + i, nBytes - i );
+    }
+
+    static void SwizzleSSE2( uint8* pDest, const uint8* pSrc, size_t nPixels )
+    {
+        const __m128i maskGA = _mm_set1_epi32( 0xFF00FF00 );
+        const __m128i maskLow = _mm_set1_epi32( 0x000000FF );
+        const __m128i maskHigh = _mm_set1_epi32( 0x00FF0000 );
+
+        size_t i = 0;
+
+        for ( ; i + 4 <= nPixels; i += 4 )
+        {
+            __m128i v = _mm_loadu_si128( ( const __m128i* )( pSrc + i * 4 ) );
+            __m128i r = _mm_and_si128( v, maskGA );
+            r = _mm_or_si128( r, _mm_and_si128( _mm_srli_epi32( v, 16 ), maskLow ) );
+            r = _mm_or_si128( r, _mm_and_si128( _mm_slli_epi32( v, 16 ), maskHigh ) );
+            _mm_storeu_si128( ( __m128i* )( pDest + i * 4 ), r );
+        }
+
+        SwizzleScalar( pDest + i * 4, pSrc + i * 4, nPixels - i );
+    }
+
+    /** @brief premultiply 2 pixels widened to 16 bit */
+    static inline __m128i PremultiplyHalfSSE2( __m128i v, __m128i round )
+    {
+        __m128i alpha = _mm_shufflehi_epi16( _mm_shufflelo_epi16( v, _MM_SHUFFLE( 3, 3, 3, 3 ) ), _MM_SHUFFLE( 3, 3, 3, 3 ) );
+        __m128i t = _mm_add_epi16( _mm_mullo_epi16( v, alpha ), round );
+        return _mm_srli_epi16( _mm_add_epi16( t, _mm_srli_epi16( t, 8 ) ), 8 );
+    }
+
+    static void PremultiplySSE2( uint8* pDest, const uint8* pSrc, size_t nPixels )
+    {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i round = _mm_set1_epi16( 128 );
+        const __m128i maskAlpha = _mm_set1_epi32( 0xFF000000 );
+
+        size_t i = 0;
+
+        for ( ; i + 4 <= nPixels; i += 4 )
+        {
+            __m128i v = _mm_loadu_si128( ( const __m128i* )( pSrc + i * 4 ) );
+            __m128i lo = PremultiplyHalfSSE2( _mm_unpacklo_epi8( v, zero ), round );
+            __m128i hi = PremultiplyHalfSSE2( _mm_unpackhi_epi8( v, zero ), round );
+            __m128i r = _mm_packus_epi16( lo, hi );
+
+            // keep the original alpha
+            r = _mm_or_si128( _mm_andnot_si128( maskAlpha, r ), _mm_and_si128( maskAlpha, v ) );
+            _mm_storeu_si128( ( __m128i* )( pDest + i * 4 ), r );
+        }
+
+        PremultiplyScalar( pDest + i * 4, pSrc + i * 4, nPixels - i );
+    }
+
+    static void AlphaRangeSSE2( const uint8* pSrc, size_t nPixels, uint8& nMin, uint8& nMax )
+    {
+        const __m128i maskAlpha = _mm_set1_epi32( 0xFF000000 );
+        const __m128i maskColor = _mm_set1_epi32( 0x00FFFFFF );
+
+        __m128i vMin = _mm_set1_epi8( char( 0xFF ) );
+        __m128i vMax = _mm_setzero_si128();
+
+        size_t i = 0;
+
+        for ( ; i + 4 <= nPixels; i += 4 )
+        {
+            __m128i v = _mm_loadu_si128( ( const __m128i* )( pSrc + i * 4 ) );
+            vMin = _mm_min_epu8( vMin, _mm_or_si128( v, maskColor ) );
+            vMax = _mm_max_epu8( vMax, _mm_and_si128( v, maskAlpha ) );
+        }
+
+        uint8 aMin[16], aMax[16];
+        _mm_storeu_si128( ( __m128i* )aMin, vMin );
+        _mm_storeu_si128( ( __m128i* )aMax, vMax );
+
+        uint8 a = min( min( aMin[3], aMin[7] ), min( aMin[11], aMin[15] ) );
+        uint8 b = max( max( aMax[3], aMax[7] ), max( aMax[11], aMax[15] ) );
+
+        if ( i < nPixels )
+        {
+            uint8 c, d;
+            AlphaRangeScalar( pSrc + i * 4, nPixels - i, c, d );
+            a = min( a, c );
+            b = max( b, d );
+        }
+
+        nMin = a;
+        nMax = b;
+    }
+
+    // AVX2 (8 pixels per step)
+
+    PK_TARGET_AVX2 static void CopyRowAVX2( uint8* pDest, const uint8* pSrc, size_t nBytes )
+    {
+        size_t i = 0;
+
+        for ( ; i + 128 <= nBytes; i += 128 )
+        {
+            __m256i a = _mm256_loadu_si256( ( const __m256i* )( pSrc + i ) );
+            __m256i b = _mm256_loadu_si256( ( const __m256i* )( pSrc + i + 32 ) );
+            __m256i c = _mm256_loadu_si256( ( const __m256i* )( pSrc + i + 64 ) );
+            __m256i d = _mm256_loadu_si256( ( const __m256i* )( pSrc + i + 96 ) );
+            _mm256_storeu_si256( ( __m256i* )( pDest + i ), a );
+            _mm256_storeu_si256( ( __m256i* )( pDest + i + 32 ), b );
+            _mm256_storeu_si256( ( __m256i* )( pDest + i + 64 ), c );
+            _mm256_storeu_si256( ( __m256i* )( pDest + i + 96 ), d );
+        }
+
+        for ( ; i + 32 <= nBytes; i += 32 )
+        {
+            _mm256_storeu_si256( ( __m256i* )( pDest + i ), _mm256_loadu_si256( ( const __m256i* )( pSrc + i ) ) );
+        }
+
+        _mm256_zeroupper();
+        memcpy( pDest + i, pSrc + i, nBytes - i );
+    }
+
+    PK_TARGET_AVX2 static void SwizzleAVX2( uint8* pDest, const uint8* pSrc, size_t nPixels )
+    {
+        const __m256i shuffle = _mm256_setr_epi8(
+                                    2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15,
+                                    2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15 );
+
+        size_t i = 0;
+
+        for ( ; i + 8 <= nPixels; i += 8 )
+        {
+            __m256i v = _mm256_loadu_si256( ( const __m256i* )( pSrc + i * 4 ) );
+            _mm256_storeu_si256( ( __m256i* )( pDest + i * 4 ), _mm256_shuffle_epi8( v, shuffle ) );
+        }
+
+        _mm256_zeroupper();
+        SwizzleSSE2( pDest + i * 4, pSrc + i * 4, nPixels - i );
+    }
+
+    PK_TARGET_AVX2 static void PremultiplyAVX2( uint8* pDest, const uint8* pSrc, size_t nPixels )
+    {
+        const __m256i zero = _mm256_setzero_si256();
+        const __m256i round = _mm256_set1_epi16( 128 );
+        const __m256i maskAlpha = _mm256_set1_epi32( 0xFF000000 );
+
+        size_t i = 0;
+
+        for ( ; i + 8 <= nPixels; i += 8 )
+        {
+            __m256i v = _mm256_loadu_si256( ( const __m256i* )( pSrc + i * 4 ) );
+
+            // unpack and pack work per 128 bit lane so the pixel order is preserved
+            __m256i lo = _mm256_unpacklo_epi8( v, zero );
+            __m256i hi = _mm256_unpackhi_epi8( v, zero );
+
+            __m256i alphaLo = _mm256_shufflehi_epi16( _mm256_shufflelo_epi16( lo, _MM_SHUFFLE( 3, 3, 3, 3 ) ), _MM_SHUFFLE( 3, 3, 3, 3 ) );
+            __m256i alphaHi = _mm256_shufflehi_epi16( _mm256_shufflelo_epi16( hi, _MM_SHUFFLE( 3, 3, 3, 3 ) ), _MM_SHUFFLE( 3, 3, 3, 3 ) );
+
+            __m256i t = _mm256_add_epi16( _mm256_mullo_epi16( lo, alphaLo ), round );
+            lo = _mm256_srli_epi16( _mm256_add_epi16( t, _mm256_srli_epi16( t, 8 ) ), 8 );
+            t = _mm256_add_epi16( _mm256_mullo_epi16( hi, alphaHi ), round );
+            hi = _mm256_srli_epi16( _mm256_add_epi16( t, _mm256_srli_epi16( t, 8 ) ), 8 );
+
+            __m256i r = _mm256_packus_epi16( lo, hi );
+            r = _mm256_or_si256( _mm256_andnot_si256( maskAlpha, r ), _mm256_and_si256( maskAlpha, v ) );
+            _mm256_storeu_si256( ( __m256i* )( pDest + i * 4 ), r );
+        }
+
+        _mm256_zeroupper();
+        PremultiplySSE2( pDest + i * 4, pSrc + i * 4, nPixels - i );
+    }
+
+    PK_TARGET_AVX2 static void AlphaRangeAVX2( const uint8* pSrc, size_t nPixels, uint8& nMin, uint8& nMax )
+    {
+        const __m256i maskAlpha = _mm256_set1_epi32( 0xFF000000 );
+        const __m256i maskColor = _mm256_set1_epi32( 0x00FFFFFF );
+
+        __m256i vMin = _mm256_set1_epi8( char( 0xFF ) );
+        __m256i vMax = _mm256_setzero_si256();
+
+        size_t i = 0;
+
+        for ( ; i + 8 <= nPixels; i += 8 )
+        {
+            __m256i v = _mm256_loadu_si256( ( const __m256i* )( pSrc + i * 4 ) );
+            vMin = _mm256_min_epu8( vMin, _mm256_or_si256( v, maskColor ) );
+            vMax = _mm256_max_epu8( vMax, _mm256_and_si256( v, maskAlpha ) );
+        }
+
+        uint8 aMin[32], aMax[32];
+        _mm256_storeu_si256( ( __m256i* )aMin, vMin );
+        _mm256_storeu_si256( ( __m256i* )aMax, vMax );
+        _mm256_zeroupper();
+
+        uint8 a = 255;
+        uint8 b = 0;
+
+        for ( int n = 3; n < 32; n += 4 )
+        {
+            a = min( a, aMin[n] );
+            b = max( b, aMax[n] );
+        }
+
+        if ( i < nPixels )
+        {
+            uint8 c, d;
+            AlphaRangeSSE2( pSrc + i * 4, nPixels - i, c, d );
+            a = min( a, c );
+            b = max( b, d );
+        }
+
+        nMin = a;
+        nMax = b;
+    }
+
+    // Dispatch
+
+    static void CpuId( int regs[4], int nLeaf, int nSubLeaf )
+    {
+#if defined(_MSC_VER)
+        __cpuidex( regs, nLeaf, nSubLeaf );
+#else
+        unsigned int a, b, c, d;
+        __cpuid_count( nLeaf, nSubLeaf, a, b, c, d );
+        regs[0] = int( a );
+        regs[1] = int( b );
+        regs[2] = int( c );
+        regs[3] = int( d );
+#endif
+    }
+
+    static uint64 GetXCR0()
+    {
+#if defined(_MSC_VER)
+        return _xgetbv( 0 );
+#else
+        unsigned int a, d;
+        __asm__ volatile( "xgetbv" : "=a"( a ), "=d"( d ) : "c"( 0 ) );
+        return ( uint64( d ) << 32 ) | a;
+#endif
+    }
+
+    EPixelKernelLevel DetectPixelKernelLevel()
+    {
+        int regs[4];
+        CpuId( regs, 0, 0 );
+        const int nMaxLeaf = regs[0];
+
+        CpuId( regs, 1, 0 );
+        const bool bSSE2 = ( regs[3] & ( 1 << 26 ) ) != 0;
+        const bool bOSXSave = ( regs[2] & ( 1 << 27 ) ) != 0;
+        const bool bAVX = ( regs[2] & ( 1 << 28 ) ) != 0;
+
+        if ( !bSSE2 )
+        {
+            return ePKL_Scalar;
+        }
+
+        // AVX2 needs the OS to save the YMM registers
+        if ( nMaxLeaf >= 7 && bOSXSave && bAVX && ( GetXCR0() & 6 ) == 6 )
+        {
+            CpuId( regs, 7, 0 );
+
+            if ( regs[1] & ( 1 << 5 ) )
+            {
+                return ePKL_AVX2;
+            }
+        }
+
+        return ePKL_SSE2;
+    }
+
+    static const SPixelKernels s_kernels[] =
+    {
+        { CopyRowScalar, SwizzleScalar, PremultiplyScalar, AlphaRangeScalar, ePKL_Scalar },
+        { CopyRowSSE2, SwizzleSSE2, PremultiplySSE2, AlphaRangeSSE2, ePKL_SSE2 },
+        { CopyRowAVX2, SwizzleAVX2, PremultiplyAVX2, AlphaRangeAVX2, ePKL_AVX2 },
+    };
+
+    static const EPixelKernelLevel s_supported = DetectPixelKernelLevel(); //!< detected once when the module is loaded
+
+    const SPixelKernels& GetPixelKernels( EPixelKernelLevel level )
+    {
+        return s_kernels[min( level, s_supported )];
+    }
+
+    const SPixelKernels& GetPixelKernels()
+    {
+        return s_kernels[s_supported];
+    }
+}
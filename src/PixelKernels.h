@@ -0,0 +1,55 @@
+/* CryHTML5 - for licensing and copyright see license.txt */
+
+#pragma once
+
+namespace HTML5Plugin
+{
+    /** @brief instruction set levels the pixel kernels are available for */
+    enum EPixelKernelLevel
+    {
+        ePKL_Scalar = 0,
+        ePKL_SSE2,
+        ePKL_AVX2,
+    };
+
+    /**
+    * @brief Pixel kernels used on the frame staging path.
+    * All kernels operate on 4 byte pixels and accept unaligned pointers, source and destination must not overlap.
+    */
+    struct SPixelKernels
+    {
+        /** @brief copy nBytes of one row */
+        void ( *CopyRow )( uint8* pDest, const uint8* pSrc, size_t nBytes );
+
+        /** @brief swap the first and third channel (BGRA <-> RGBA) of nPixels */
+        void ( *Swizzle )( uint8* pDest, const uint8* pSrc, size_t nPixels );
+
+        /** @brief multiply the color channels of nPixels with their alpha (straight to premultiplied alpha) */
+        void ( *Premultiply )( uint8* pDest, const uint8* pSrc, size_t nPixels );
+
+        /** @brief get the smallest and largest alpha of nPixels (nPixels > 0) */
+        void ( *AlphaRange )( const uint8* pSrc, size_t nPixels, uint8& nMin, uint8& nMax );
+
+        EPixelKernelLevel level; //!< instruction set of this kernel table
+    };
+
+    /** @return the best instruction set level supported by the CPU and OS */
+    EPixelKernelLevel DetectPixelKernelLevel();
+
+    /**
+    * @brief get a kernel table
+    * @param level requested level, clamped to what the CPU supports
+    */
+    const SPixelKernels& GetPixelKernels( EPixelKernelLevel level );
+
+    /** @return the kernel table for the best supported level */
+    const SPixelKernels& GetPixelKernels();
+
+    /** @return true when all nPixels have an alpha of 255 */
+    inline bool IsOpaqueSpan( const uint8* pSrc, size_t nPixels )
+    {
+        uint8 nMin, nMax;
+        GetPixelKernels().AlphaRange( pSrc, nPixels, nMin, nMax );
+        return nMin == 255;
+    }
+}
@@ -0,0 +1,44 @@
+/* CryHTML5 - for licensing and copyright see license.txt */
+
+#pragma once
+
+// The engine's basic types and helpers for the modules that don't depend on CryENGINE, used when they are built without it (tests and benchmarks)
+
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <vector>
+#include <memory>
+#include <list>
+#include <functional>
+#include <limits>
+
+typedef int8_t int8;
+typedef int16_t int16;
+typedef int32_t int32;
+typedef int64_t int64;
+typedef uint8_t uint8;
+typedef uint16_t uint16;
+typedef uint32_t uint32;
+typedef uint64_t uint64;
+typedef float f32;
+
+template<class T> inline T min( T a, T b )
+{
+    return a < b ? a : b;
+}
+
+template<class T> inline T max( T a, T b )
+{
+    return a > b ? a : b;
+}
+
+template<class T> inline T clamp_tpl( T x, T lo, T hi )
+{
+    return x < lo ? lo : ( x > hi ? hi : x );
+}
+
+#define CRY_ASSERT( x ) assert( x )
@@ -0,0 +1,39 @@
+/* CryHTML5 - for licensing and copyright see license.txt */
+
+#include "StdAfx.h"
+#include "ResizeDebounce.h"
+
+namespace HTML5Plugin
+{
+    CResizeDebounce::CResizeDebounce( int nWidth, int nHeight )
+        : m_nSize( Pack( nWidth, nHeight ) )
+        , m_nPendingWidth( nWidth )
+        , m_nPendingHeight( nHeight )
+        , m_fPendingTime( 0.0f )
+    {
+    }
+
+    bool CResizeDebounce::Update( int nWidth, int nHeight, float fNow, float fDelay )
+    {
+        int nCurrentWidth, nCurrentHeight;
+        GetSize( nCurrentWidth, nCurrentHeight );
+
+        if ( nWidth == nCurrentWidth && nHeight == nCurrentHeight )
+        {
+            m_nPendingWidth = nWidth;
+            m_nPendingHeight = nHeight;
+            return false;
+        }
+
+        // still dragging, wait until the size settles
+        if ( nWidth != m_nPendingWidth || nHeight != m_nPendingHeight )
+        {
+            m_nPendingWidth = nWidth;
+            m_nPendingHeight = nHeight;
+            m_fPendingTime = fNow;
+            return false;
+        }
+
+        return fNow - m_fPendingTime >= fDelay;
+    }
+}
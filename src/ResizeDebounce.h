@@ -0,0 +1,66 @@
+/* CryHTML5 - for licensing and copyright see license.txt */
+
+#pragma once
+
+#include <atomic>
+
+namespace HTML5Plugin
+{
+    /**
+    * @brief Size of a view surface that only follows the requested size once it was stable for a while (no resize per frame while dragging).
+    * The render thread requests sizes and applies them, the current size can be read from any thread (CEF asks for it on its UI thread).
+    */
+    class CResizeDebounce
+    {
+        public:
+            /** @param nWidth initial surface size */
+            CResizeDebounce( int nWidth, int nHeight );
+
+            /**
+            * @brief request a surface size (render thread, once per frame)
+            * @param nWidth size the surface should have now
+            * @param nHeight
+            * @param fNow current time in seconds
+            * @param fDelay seconds the requested size has to be unchanged
+            * @return true when the requested size is due, call Apply to take it over
+            */
+            bool Update( int nWidth, int nHeight, float fNow, float fDelay );
+
+            /** @brief take over the requested size (render thread) */
+            void Apply()
+            {
+                m_nSize = Pack( m_nPendingWidth, m_nPendingHeight );
+            }
+
+            /** @brief get width and height of the same size (any thread) */
+            void GetSize( int& nWidth, int& nHeight ) const
+            {
+                const uint64 nSize = m_nSize;
+                nWidth = int( uint32( nSize >> 32 ) );
+                nHeight = int( uint32( nSize ) );
+            }
+
+            /** @return current width (any thread) */
+            int GetWidth() const
+            {
+                return int( uint32( m_nSize >> 32 ) );
+            }
+
+            /** @return current height (any thread) */
+            int GetHeight() const
+            {
+                return int( uint32( m_nSize ) );
+            }
+
+        private:
+            static uint64 Pack( int nWidth, int nHeight )
+            {
+                return ( uint64( uint32( nWidth ) ) << 32 ) | uint32( nHeight );
+            }
+
+            std::atomic<uint64> m_nSize; //!< current width and height in one word so readers never see half a resize
+            int m_nPendingWidth; //!< size requested last
+            int m_nPendingHeight;
+            float m_fPendingTime; //!< time the requested size last changed
+    };
+}
@@ -0,0 +1,161 @@
+/* CryHTML5 - for licensing and copyright see license.txt */
+
+#include "StdAfx.h"
+#include "ResourceCache.h"
+
+namespace HTML5Plugin
+{
+    CResourceCache::CResourceCache()
+        : m_nBudget( 32 << 20 )
+        , m_nBytes( 0 )
+        , m_nHits( 0 )
+        , m_nMisses( 0 )
+        , m_nEvictions( 0 )
+    {
+    }
+
+    void CResourceCache::SetBudget( size_t nBytes )
+    {
+        std::lock_guard<std::mutex> lock( m_lock );
+
+        if ( nBytes != m_nBudget )
+        {
+            m_nBudget = nBytes;
+            Trim( 0 );
+        }
+    }
+
+    size_t CResourceCache::GetMaxEntrySize()
+    {
+        // one file may not push out most of the others
+        std::lock_guard<std::mutex> lock( m_lock );
+        return m_nBudget / 4;
+    }
+
+    TResourceBuffer CResourceCache::Find( const char* sPath, uint64 nStamp )
+    {
+        const std::string sKey = NormalizePath( sPath );
+
+        std::lock_guard<std::mutex> lock( m_lock );
+        std::unordered_map<std::string, TEntries::iterator>::iterator found = m_index.find( sKey );
+
+        if ( found == m_index.end() )
+        {
+            ++m_nMisses;
+            return TResourceBuffer();
+        }
+
+        // the pak was changed, the new version replaces this one
+        if ( found->second->nStamp != nStamp )
+        {
+            ++m_nMisses;
+            Remove( found->second );
+            return TResourceBuffer();
+        }
+
+        ++m_nHits;
+        m_entries.splice( m_entries.begin(), m_entries, found->second );
+        return found->second->pBuffer;
+    }
+
+    void CResourceCache::Insert( const char* sPath, uint64 nStamp, const TResourceBuffer& pBuffer )
+    {
+        SEntry entry;
+        entry.sKey = NormalizePath( sPath );
+        entry.nStamp = nStamp;
+        entry.pBuffer = pBuffer;
+
+        std::lock_guard<std::mutex> lock( m_lock );
+
+        if ( !pBuffer || pBuffer->size() > m_nBudget / 4 )
+        {
+            return;
+        }
+
+        // requests that missed at the same time insert the same file
+        std::unordered_map<std::string, TEntries::iterator>::iterator found = m_index.find( entry.sKey );
+
+        if ( found != m_index.end() )
+        {
+            Remove( found->second );
+        }
+
+        Trim( pBuffer->size() );
+
+        m_entries.push_front( entry );
+        m_index[entry.sKey] = m_entries.begin();
+        m_nBytes += pBuffer->size();
+    }
+
+    void CResourceCache::Clear()
+    {
+        std::lock_guard<std::mutex> lock( m_lock );
+        m_entries.clear();
+        m_index.clear();
+        m_nBytes = 0;
+    }
+
+    CResourceCache::SCounters CResourceCache::GetCounters()
+    {
+        std::lock_guard<std::mutex> lock( m_lock );
+
+        SCounters counters;
+        counters.nHits = m_nHits;
+        counters.nMisses = m_nMisses;
+        counters.nEvictions = m_nEvictions;
+        counters.nEntries = uint32( m_entries.size() );
+        counters.nBytes = m_nBytes;
+        return counters;
+    }
+
+    std::string CResourceCache::NormalizePath( const char* sPath )
+    {
+        std::string sKey;
+        sKey.reserve( strlen( sPath ) );
+
+        for ( const char* p = sPath; *p; ++p )
+        {
+            char c = *p == '\\' ? '/' : *p;
+
+            if ( c >= 'A' && c <= 'Z' )
+            {
+                c += 'a' - 'A';
+            }
+
+            // at the start of a segment: skip repeated slashes and ./
+            const bool bSegmentStart = sKey.empty() || sKey[sKey.size() - 1] == '/';
+
+            if ( bSegmentStart && c == '/' )
+            {
+                continue;
+            }
+
+            if ( bSegmentStart && c == '.' && ( p[1] == '/' || p[1] == '\\' ) )
+            {
+                ++p;
+                continue;
+            }
+
+            sKey.push_back( c );
+        }
+
+        return sKey;
+    }
+
+    void CResourceCache::Remove( TEntries::iterator it )
+    {
+        m_nBytes -= it->pBuffer->size();
+        m_index.erase( it->sKey );
+        m_entries.erase( it );
+    }
+
+    void CResourceCache::Trim( size_t nBytes )
+    {
+        while ( !m_entries.empty() && m_nBytes + nBytes > m_nBudget )
+        {
+            TEntries::iterator oldest = m_entries.end();
+            Remove( --oldest );
+            ++m_nEvictions;
+        }
+    }
+}
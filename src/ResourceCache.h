@@ -0,0 +1,95 @@
+/* CryHTML5 - for licensing and copyright see license.txt */
+
+#pragma once
+
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace HTML5Plugin
+{
+    /** @brief immutable file contents shared by the cache and the requests serving it */
+    typedef std::shared_ptr< const std::vector<uint8> > TResourceBuffer;
+
+    /**
+    * @brief Byte budgeted LRU cache of cry:// files, so pages returning to the same stylesheets, fonts and images don't read the pak again.
+    * Entries are keyed by the normalized path and checked against the modification stamp of the file, a changed file is a miss.
+    * Buffers are handed out by reference, an evicted buffer lives on until the last request serving it finished.
+    * All methods are thread safe.
+    */
+    class CResourceCache
+    {
+        public:
+            /** @brief counters since construction */
+            struct SCounters
+            {
+                uint32 nHits; //!< lookups served from the cache
+                uint32 nMisses; //!< lookups that went to the pak
+                uint32 nEvictions; //!< entries dropped to stay within the budget
+                uint32 nEntries; //!< entries cached now
+                size_t nBytes; //!< bytes cached now
+            };
+
+            CResourceCache();
+
+            /** @brief set the budget in bytes, evicting the least recently used entries above it (0 disables the cache) */
+            void SetBudget( size_t nBytes );
+
+            /** @return size up to which a file is cached, larger ones are only streamed */
+            size_t GetMaxEntrySize();
+
+            /**
+            * @brief look up a file and mark it as used
+            * @param sPath path of the file
+            * @param nStamp modification stamp of the file
+            * @return the cached contents, empty on a miss
+            */
+            TResourceBuffer Find( const char* sPath, uint64 nStamp );
+
+            /**
+            * @brief add a file, replacing an older version of it
+            * @param sPath path of the file
+            * @param nStamp modification stamp of the file
+            * @param pBuffer contents, not changed anymore afterwards
+            */
+            void Insert( const char* sPath, uint64 nStamp, const TResourceBuffer& pBuffer );
+
+            /** @brief drop all entries, buffers in use stay valid */
+            void Clear();
+
+            /** @return the counters */
+            SCounters GetCounters();
+
+            /** @return the path as cache key: lower case, forward slashes, without leading slashes and ./ segments */
+            static std::string NormalizePath( const char* sPath );
+
+        private:
+            /** @brief a cached file */
+            struct SEntry
+            {
+                std::string sKey; //!< normalized path
+                uint64 nStamp; //!< modification stamp
+                TResourceBuffer pBuffer; //!< contents
+            };
+
+            typedef std::list<SEntry> TEntries;
+
+            /** @brief drop an entry (m_lock held) */
+            void Remove( TEntries::iterator it );
+
+            /** @brief evict the least recently used entries until nBytes fit into the budget (m_lock held) */
+            void Trim( size_t nBytes );
+
+            std::mutex m_lock; //!< guards everything below
+            TEntries m_entries; //!< most recently used first
+            std::unordered_map<std::string, TEntries::iterator> m_index; //!< entries by key
+            size_t m_nBudget; //!< most bytes cached
+            size_t m_nBytes; //!< bytes cached
+            uint32 m_nHits; //!< counters
+            uint32 m_nMisses;
+            uint32 m_nEvictions;
+    };
+}
@@ -0,0 +1,211 @@
+/* CryHTML5 - for licensing and copyright see license.txt */
+
+#include "StdAfx.h"
+#include "ScreenProjection.h"
+
+#include <xmmintrin.h>
+
+namespace HTML5Plugin
+{
+    static const float fProjectionEpsilon = 1e-6f;
+
+    CScreenProjection::CScreenProjection()
+        : m_fProjX( 1.0f )
+        , m_fProjY( 1.0f )
+        , m_fSurfaceWidth( 1.0f )
+        , m_fSurfaceHeight( 1.0f )
+        , m_fScaleX( 1.0f )
+        , m_fOffsetX( 0.0f )
+        , m_fScaleY( 1.0f )
+        , m_fOffsetY( 0.0f )
+    {
+        memset( m_vPos, 0, sizeof( m_vPos ) );
+        memset( m_vRight, 0, sizeof( m_vRight ) );
+        memset( m_vForward, 0, sizeof( m_vForward ) );
+        memset( m_vUp, 0, sizeof( m_vUp ) );
+        memset( m_vFacing, 0, sizeof( m_vFacing ) );
+    }
+
+#if !defined( HTML5_PORTABLE )
+    void CScreenProjection::SetCamera( const CCamera& cam )
+    {
+        // CryENGINE cameras look along y with z up
+        const Matrix34& camMat = cam.GetMatrix();
+        const Vec3 vPos = camMat.GetTranslation();
+        const Vec3 vRight = camMat.GetColumn0();
+        const Vec3 vForward = camMat.GetColumn1();
+        const Vec3 vUp = camMat.GetColumn2();
+
+        const float pos[3] = { vPos.x, vPos.y, vPos.z };
+        const float right[3] = { vRight.x, vRight.y, vRight.z };
+        const float forward[3] = { vForward.x, vForward.y, vForward.z };
+        const float up[3] = { vUp.x, vUp.y, vUp.z };
+
+        SetView( pos, right, forward, up, cam.GetFov(), cam.GetProjRatio(), cam.GetViewSurfaceX(), cam.GetViewSurfaceZ() );
+    }
+#endif
+
+    void CScreenProjection::SetView( const float vPos[3], const float vRight[3], const float vForward[3], const float vUp[3], float fFov, float fProjRatio, int nSurfaceWidth, int nSurfaceHeight )
+    {
+        for ( int i = 0; i < 3; ++i )
+        {
+            m_vPos[i] = vPos[i];
+            m_vRight[i] = vRight[i];
+            m_vForward[i] = vForward[i];
+            m_vUp[i] = vUp[i];
+            m_vFacing[i] = vPos[i] - vForward[i] * 1000.0f;
+        }
+
+        m_fProjY = 1.0f / tanf( fFov * 0.5f );
+        m_fProjX = m_fProjY / fProjRatio;
+        m_fSurfaceWidth = float( nSurfaceWidth );
+        m_fSurfaceHeight = float( nSurfaceHeight );
+    }
+
+    void CScreenProjection::SetScreenTransform( float fScaleX, float fOffsetX, float fScaleY, float fOffsetY )
+    {
+        m_fScaleX = fScaleX;
+        m_fOffsetX = fOffsetX;
+        m_fScaleY = fScaleY;
+        m_fOffsetY = fOffsetY;
+    }
+
+    CScreenProjection::SNdcTransform CScreenProjection::GetNdcTransform() const
+    {
+        // camera pixels are ( 1 + x ) * width / 2 and ( 1 - y ) * height / 2 like CCamera::Project
+        SNdcTransform ndc;
+        ndc.kx = 0.5f * m_fSurfaceWidth * m_fScaleX;
+        ndc.bx = ndc.kx + m_fOffsetX;
+        ndc.ky = -0.5f * m_fSurfaceHeight * m_fScaleY;
+        ndc.by = -ndc.ky + m_fOffsetY;
+        return ndc;
+    }
+
+    void CScreenProjection::ProjectOne( const SWorldPosBatch& batch, const SNdcTransform& ndc, unsigned int n ) const
+    {
+        float x = batch.pWorldX[n];
+        float y = batch.pWorldY[n];
+        float z = batch.pWorldZ[n];
+
+        // offsets: x sideways to the camera, y away from it, z up
+        if ( batch.pOffsetX )
+        {
+            const float dx = x - m_vFacing[0];
+            const float dy = y - m_vFacing[1];
+            const float dz = z - m_vFacing[2];
+            const float fInvLength = 1.0f / sqrtf( max( dx * dx + dy * dy + dz * dz, fProjectionEpsilon ) );
+            const float fSide = batch.pOffsetX[n] / sqrtf( max( dx * dx + dy * dy, fProjectionEpsilon ) );
+            const float fAway = batch.pOffsetY[n] * fInvLength;
+
+            x += dy * fSide + dx * fAway;
+            y += -dx * fSide + dy * fAway;
+            z += dz * fAway + batch.pOffsetZ[n];
+        }
+
+        const float rx = x - m_vPos[0];
+        const float ry = y - m_vPos[1];
+        const float rz = z - m_vPos[2];
+
+        const float vx = rx * m_vRight[0] + ry * m_vRight[1] + rz * m_vRight[2];
+        const float vy = rx * m_vForward[0] + ry * m_vForward[1] + rz * m_vForward[2];
+        const float vz = rx * m_vUp[0] + ry * m_vUp[1] + rz * m_vUp[2];
+        const float fInvW = 1.0f / max( vy, fProjectionEpsilon );
+        const float fDepth = sqrtf( rx * rx + ry * ry + rz * rz );
+
+        batch.pScreenX[n] = vx * m_fProjX * fInvW * ndc.kx + ndc.bx;
+        batch.pScreenY[n] = vz * m_fProjY * fInvW * ndc.ky + ndc.by;
+        batch.pDepth[n] = vy > 0.0f ? fDepth : -fDepth;
+    }
+
+    void CScreenProjection::ProjectScalar( const SWorldPosBatch& batch ) const
+    {
+        const SNdcTransform ndc = GetNdcTransform();
+
+        for ( unsigned int n = 0; n < batch.nCount; ++n )
+        {
+            ProjectOne( batch, ndc, n );
+        }
+    }
+
+    /** @return 1 / sqrt( v ) with one newton step on the estimate */
+    static inline __m128 InvSqrt( __m128 v )
+    {
+        const __m128 e = _mm_rsqrt_ps( v );
+        const __m128 ee = _mm_mul_ps( _mm_mul_ps( v, e ), e );
+        return _mm_mul_ps( _mm_mul_ps( _mm_set1_ps( 0.5f ), e ), _mm_sub_ps( _mm_set1_ps( 3.0f ), ee ) );
+    }
+
+    void CScreenProjection::Project( const SWorldPosBatch& batch ) const
+    {
+        const SNdcTransform ndc = GetNdcTransform();
+        const unsigned int nSimd = batch.nCount & ~3u;
+
+        const __m128 epsilon = _mm_set1_ps( fProjectionEpsilon );
+        const __m128 signMask = _mm_set1_ps( -0.0f );
+        const __m128 facingX = _mm_set1_ps( m_vFacing[0] );
+        const __m128 facingY = _mm_set1_ps( m_vFacing[1] );
+        const __m128 facingZ = _mm_set1_ps( m_vFacing[2] );
+        const __m128 posX = _mm_set1_ps( m_vPos[0] );
+        const __m128 posY = _mm_set1_ps( m_vPos[1] );
+        const __m128 posZ = _mm_set1_ps( m_vPos[2] );
+        const __m128 kx = _mm_set1_ps( m_fProjX * ndc.kx );
+        const __m128 bx = _mm_set1_ps( ndc.bx );
+        const __m128 ky = _mm_set1_ps( m_fProjY * ndc.ky );
+        const __m128 by = _mm_set1_ps( ndc.by );
+
+        __m128 axes[3][3];
+
+        for ( int i = 0; i < 3; ++i )
+        {
+            axes[0][i] = _mm_set1_ps( m_vRight[i] );
+            axes[1][i] = _mm_set1_ps( m_vForward[i] );
+            axes[2][i] = _mm_set1_ps( m_vUp[i] );
+        }
+
+        for ( unsigned int n = 0; n < nSimd; n += 4 )
+        {
+            __m128 x = _mm_loadu_ps( batch.pWorldX + n );
+            __m128 y = _mm_loadu_ps( batch.pWorldY + n );
+            __m128 z = _mm_loadu_ps( batch.pWorldZ + n );
+
+            if ( batch.pOffsetX )
+            {
+                const __m128 dx = _mm_sub_ps( x, facingX );
+                const __m128 dy = _mm_sub_ps( y, facingY );
+                const __m128 dz = _mm_sub_ps( z, facingZ );
+                const __m128 flat = _mm_add_ps( _mm_mul_ps( dx, dx ), _mm_mul_ps( dy, dy ) );
+                const __m128 full = _mm_add_ps( flat, _mm_mul_ps( dz, dz ) );
+                const __m128 side = _mm_mul_ps( _mm_loadu_ps( batch.pOffsetX + n ), InvSqrt( _mm_max_ps( flat, epsilon ) ) );
+                const __m128 away = _mm_mul_ps( _mm_loadu_ps( batch.pOffsetY + n ), InvSqrt( _mm_max_ps( full, epsilon ) ) );
+
+                x = _mm_add_ps( x, _mm_add_ps( _mm_mul_ps( dy, side ), _mm_mul_ps( dx, away ) ) );
+                y = _mm_add_ps( y, _mm_sub_ps( _mm_mul_ps( dy, away ), _mm_mul_ps( dx, side ) ) );
+                z = _mm_add_ps( z, _mm_add_ps( _mm_mul_ps( dz, away ), _mm_loadu_ps( batch.pOffsetZ + n ) ) );
+            }
+
+            const __m128 rx = _mm_sub_ps( x, posX );
+            const __m128 ry = _mm_sub_ps( y, posY );
+            const __m128 rz = _mm_sub_ps( z, posZ );
+
+            __m128 view[3];
+
+            for ( int i = 0; i < 3; ++i )
+            {
+                view[i] = _mm_add_ps( _mm_add_ps( _mm_mul_ps( rx, axes[i][0] ), _mm_mul_ps( ry, axes[i][1] ) ), _mm_mul_ps( rz, axes[i][2] ) );
+            }
+
+            const __m128 invW = _mm_div_ps( _mm_set1_ps( 1.0f ), _mm_max_ps( view[1], epsilon ) );
+            const __m128 depth = _mm_sqrt_ps( _mm_add_ps( _mm_add_ps( _mm_mul_ps( rx, rx ), _mm_mul_ps( ry, ry ) ), _mm_mul_ps( rz, rz ) ) );
+            const __m128 behind = _mm_and_ps( _mm_cmple_ps( view[1], _mm_setzero_ps() ), signMask );
+
+            _mm_storeu_ps( batch.pScreenX + n, _mm_add_ps( _mm_mul_ps( _mm_mul_ps( view[0], invW ), kx ), bx ) );
+            _mm_storeu_ps( batch.pScreenY + n, _mm_add_ps( _mm_mul_ps( _mm_mul_ps( view[2], invW ), ky ), by ) );
+            _mm_storeu_ps( batch.pDepth + n, _mm_xor_ps( depth, behind ) );
+        }
+
+        for ( unsigned int n = nSimd; n < batch.nCount; ++n )
+        {
+            ProjectOne( batch, ndc, n );
+        }
+    }
+}
@@ -0,0 +1,79 @@
+/* CryHTML5 - for licensing and copyright see license.txt */
+
+#pragma once
+
+#include <WorldPosBatch.h>
+
+namespace HTML5Plugin
+{
+    /**
+    * @brief Projects world positions onto the screen like WorldPosToScreenPos, four at a time with SSE.
+    * The camera and the screen transform are prepared once per batch so the loop only does arithmetic.
+    */
+    class CScreenProjection
+    {
+        public:
+            CScreenProjection();
+
+#if !defined( HTML5_PORTABLE )
+            /** @brief take position, orientation and projection of a camera */
+            void SetCamera( const CCamera& cam );
+#endif
+
+            /**
+            * @brief set position, orientation and projection of the camera (what SetCamera takes from a CCamera)
+            * @param vPos camera position
+            * @param vRight camera axes, the camera looks along vForward with vUp up
+            * @param vForward
+            * @param vUp
+            * @param fFov vertical field of view in radians
+            * @param fProjRatio width / height of the projection
+            * @param nSurfaceWidth camera surface size in pixels
+            * @param nSurfaceHeight
+            */
+            void SetView( const float vPos[3], const float vRight[3], const float vForward[3], const float vUp[3], float fFov, float fProjRatio, int nSurfaceWidth, int nSurfaceHeight );
+
+            /**
+            * @brief set the mapping from camera pixels to output coordinates (out = in * scale + offset)
+            * @param fScaleX horizontal scale
+            * @param fOffsetX horizontal offset
+            * @param fScaleY vertical scale
+            * @param fOffsetY vertical offset
+            */
+            void SetScreenTransform( float fScaleX, float fOffsetX, float fScaleY, float fOffsetY );
+
+            /** @brief project a batch with SSE, the remainder of four positions is projected scalar */
+            void Project( const SWorldPosBatch& batch ) const;
+
+            /** @brief project a batch one position at a time (reference implementation) */
+            void ProjectScalar( const SWorldPosBatch& batch ) const;
+
+        private:
+            /** @brief normalized device coordinates to output coordinates (out = ndc * k + b) */
+            struct SNdcTransform
+            {
+                float kx, bx, ky, by;
+            };
+
+            SNdcTransform GetNdcTransform() const;
+
+            /** @brief project position n of a batch */
+            void ProjectOne( const SWorldPosBatch& batch, const SNdcTransform& ndc, unsigned int n ) const;
+
+            float m_vPos[3]; //!< camera position
+            float m_vRight[3]; //!< camera axes
+            float m_vForward[3];
+            float m_vUp[3];
+            float m_vFacing[3]; //!< point far behind the camera the offsets are oriented from
+
+            float m_fProjX; //!< view space to normalized device coordinates
+            float m_fProjY;
+            float m_fSurfaceWidth; //!< camera surface size in pixels
+            float m_fSurfaceHeight;
+
+            float m_fScaleX; //!< camera pixels to output coordinates
+            float m_fOffsetX;
+            float m_fScaleY;
+            float m_fOffsetY;
+    };
+}
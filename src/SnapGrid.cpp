@@ -0,0 +1,152 @@
+/* CryHTML5 - for licensing and copyright see license.txt */
+
+#include "StdAfx.h"
+#include "SnapGrid.h"
+
+namespace HTML5Plugin
+{
+    CSnapGrid::CSnapGrid()
+        : m_nCellSize( 64 )
+        , m_nOriginX( 0 )
+        , m_nOriginY( 0 )
+        , m_nCellsX( 0 )
+        , m_nCellsY( 0 )
+    {
+    }
+
+    void CSnapGrid::Clear()
+    {
+        m_rects.clear();
+        m_cellStart.clear();
+        m_entries.clear();
+        m_nCellsX = 0;
+        m_nCellsY = 0;
+    }
+
+    void CSnapGrid::Build( const SDirtyRect* pRects, int nRects, int nCellSize )
+    {
+        Clear();
+        m_nCellSize = max( nCellSize, 1 );
+
+        SDirtyRect bounds;
+
+        for ( int i = 0; i < nRects; ++i )
+        {
+            if ( !pRects[i].IsEmpty() )
+            {
+                m_rects.push_back( pRects[i] );
+                bounds.Merge( pRects[i] );
+            }
+        }
+
+        if ( m_rects.empty() )
+        {
+            return;
+        }
+
+        m_nOriginX = bounds.x;
+        m_nOriginY = bounds.y;
+        m_nCellsX = ( bounds.x2 - bounds.x + m_nCellSize - 1 ) / m_nCellSize;
+        m_nCellsY = ( bounds.y2 - bounds.y + m_nCellSize - 1 ) / m_nCellSize;
+
+        // count the entries per cell, then place them (cells stay in one array)
+        m_cellStart.assign( m_nCellsX * m_nCellsY + 1, 0 );
+
+        for ( int pass = 0; pass < 2; ++pass )
+        {
+            if ( pass == 1 )
+            {
+                for ( size_t c = 1; c < m_cellStart.size(); ++c )
+                {
+                    m_cellStart[c] += m_cellStart[c - 1];
+                }
+
+                m_entries.resize( m_cellStart.back() );
+            }
+
+            for ( size_t i = 0; i < m_rects.size(); ++i )
+            {
+                const SDirtyRect& rect = m_rects[i];
+
+                for ( int cy = ( rect.y - m_nOriginY ) / m_nCellSize; cy <= ( rect.y2 - 1 - m_nOriginY ) / m_nCellSize; ++cy )
+                {
+                    for ( int cx = ( rect.x - m_nOriginX ) / m_nCellSize; cx <= ( rect.x2 - 1 - m_nOriginX ) / m_nCellSize; ++cx )
+                    {
+                        const int nCell = cy * m_nCellsX + cx;
+
+                        if ( pass == 0 )
+                        {
+                            ++m_cellStart[nCell + 1];
+                        }
+
+                        else
+                        {
+                            m_entries[--m_cellStart[nCell + 1]] = int( i );
+                        }
+                    }
+                }
+            }
+        }
+
+        // placing counted the end of each cell down to its start, entry c + 1 holds the start of cell c now
+        for ( size_t c = 0; c + 1 < m_cellStart.size(); ++c )
+        {
+            m_cellStart[c] = m_cellStart[c + 1];
+        }
+
+        m_cellStart.back() = int( m_entries.size() );
+    }
+
+    bool CSnapGrid::FindNearest( float fX, float fY, float fRadius, SDirtyRect& rect ) const
+    {
+        if ( m_rects.empty() )
+        {
+            return false;
+        }
+
+        // rects end at x2, y2 but are only listed in the cells up to x2 - 1, y2 - 1
+        const float fCell = float( m_nCellSize );
+        const int cx = max( int( floorf( ( fX - fRadius - 1.0f - m_nOriginX ) / fCell ) ), 0 );
+        const int cy = max( int( floorf( ( fY - fRadius - 1.0f - m_nOriginY ) / fCell ) ), 0 );
+        const int cx2 = min( int( floorf( ( fX + fRadius - m_nOriginX ) / fCell ) ), m_nCellsX - 1 );
+        const int cy2 = min( int( floorf( ( fY + fRadius - m_nOriginY ) / fCell ) ), m_nCellsY - 1 );
+
+        int nBest = -1;
+        float fBest = fRadius * fRadius;
+        int nBestArea = 0;
+
+        for ( int y = cy; y <= cy2; ++y )
+        {
+            for ( int x = cx; x <= cx2; ++x )
+            {
+                const int nCell = y * m_nCellsX + x;
+
+                for ( int e = m_cellStart[nCell]; e < m_cellStart[nCell + 1]; ++e )
+                {
+                    const SDirtyRect& candidate = m_rects[m_entries[e]];
+
+                    // distance from the point to the rect, 0 inside
+                    const float dx = max( max( float( candidate.x ) - fX, fX - float( candidate.x2 ) ), 0.0f );
+                    const float dy = max( max( float( candidate.y ) - fY, fY - float( candidate.y2 ) ), 0.0f );
+                    const float fDistance = dx * dx + dy * dy;
+                    const int nArea = candidate.GetArea();
+
+                    if ( fDistance < fBest || ( fDistance == fBest && ( nBest < 0 || nArea < nBestArea ) ) )
+                    {
+                        nBest = m_entries[e];
+                        fBest = fDistance;
+                        nBestArea = nArea;
+                    }
+                }
+            }
+        }
+
+        if ( nBest < 0 )
+        {
+            return false;
+        }
+
+        rect = m_rects[nBest];
+        return true;
+    }
+}
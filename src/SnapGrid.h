@@ -0,0 +1,57 @@
+/* CryHTML5 - for licensing and copyright see license.txt */
+
+#pragma once
+
+#include <vector>
+
+#include <DirtyRegion.h>
+
+namespace HTML5Plugin
+{
+    /**
+    * @brief Uniform grid over the rects of focusable elements for nearest target queries of the virtual cursor.
+    * Every rect is listed in the cells it overlaps, a query only visits the cells within its radius.
+    */
+    class CSnapGrid
+    {
+        public:
+            CSnapGrid();
+
+            /**
+            * @brief replace the rects
+            * @param pRects rects in view pixels, empty ones are ignored
+            * @param nRects number of rects
+            * @param nCellSize edge length of a grid cell in pixels
+            */
+            void Build( const SDirtyRect* pRects, int nRects, int nCellSize = 64 );
+
+            /** @brief remove all rects */
+            void Clear();
+
+            /** @return number of rects */
+            int GetCount() const
+            {
+                return int( m_rects.size() );
+            }
+
+            /**
+            * @brief find the rect closest to a point
+            * @param fX point in view pixels
+            * @param fY
+            * @param fRadius largest distance from the point to the rect (0 only finds rects containing the point)
+            * @param[out] rect the closest rect, the smallest one when several contain the point
+            * @return false when no rect is within the radius
+            */
+            bool FindNearest( float fX, float fY, float fRadius, SDirtyRect& rect ) const;
+
+        private:
+            std::vector<SDirtyRect> m_rects; //!< all rects
+            std::vector<int> m_cellStart; //!< first entry of each cell in m_entries, one more than cells for the end
+            std::vector<int> m_entries; //!< rect indices ordered by cell
+            int m_nCellSize; //!< cell edge length in pixels
+            int m_nOriginX; //!< pixel position of cell 0, 0
+            int m_nOriginY;
+            int m_nCellsX; //!< cells per row
+            int m_nCellsY; //!< cell rows
+    };
+}
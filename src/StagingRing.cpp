@@ -0,0 +1,106 @@
+/* CryHTML5 - for licensing and copyright see license.txt */
+
+#include "StdAfx.h"
+#include "StagingRing.h"
+#include "PixelKernels.h"
+
+namespace HTML5Plugin
+{
+    CStagingRing::CStagingRing()
+        : m_pDevice( nullptr )
+        , m_nNext( 0 )
+    {
+        memset( &m_stats, 0, sizeof( m_stats ) );
+    }
+
+    CStagingRing::~CStagingRing()
+    {
+        Release();
+    }
+
+    int CStagingRing::Configure( IStagingDevice* pDevice, int nSlots, int nWidth, int nHeight )
+    {
+        if ( m_pDevice )
+        {
+            for ( size_t i = 0; i < m_slots.size(); ++i )
+            {
+                m_pDevice->ReleaseStaging( m_slots[i] );
+            }
+        }
+
+        m_slots.clear();
+        m_nNext = 0;
+        m_pDevice = pDevice;
+
+        if ( !m_pDevice )
+        {
+            return 0;
+        }
+
+        nSlots = clamp_tpl( nSlots, 0, int( eMaxSlots ) );
+
+        for ( int i = 0; i < nSlots; ++i )
+        {
+            if ( m_pDevice->CreateStaging( i, nWidth, nHeight ) )
+            {
+                m_slots.push_back( i );
+            }
+        }
+
+        return GetSlots();
+    }
+
+    bool CStagingRing::Upload( const uint8* pSource, int nSourcePitch, const SDirtyRect* pRects, int nRects )
+    {
+        const size_t nSlots = m_slots.size();
+
+        for ( size_t n = 0; n < nSlots; ++n )
+        {
+            const size_t nIndex = ( m_nNext + n ) % nSlots;
+            const int nSlot = m_slots[nIndex];
+
+            uint8* pData = nullptr;
+            int nPitch = 0;
+
+            if ( !m_pDevice->MapStaging( nSlot, pData, nPitch ) )
+            {
+                // the GPU still reads this one, try the next instead of waiting
+                ++m_stats.nBusySkips;
+                continue;
+            }
+
+            // only the uploaded rects have to be valid in the staging texture
+            const SPixelKernels& kernels = GetPixelKernels();
+
+            for ( int i = 0; i < nRects; ++i )
+            {
+                const SDirtyRect& rect = pRects[i];
+                const size_t nRowBytes = size_t( rect.x2 - rect.x ) * 4;
+
+                const uint8* pSrc = pSource + rect.y * nSourcePitch + rect.x * 4;
+                uint8* pDest = pData + rect.y * nPitch + rect.x * 4;
+
+                for ( int row = rect.y; row < rect.y2; ++row )
+                {
+                    kernels.CopyRow( pDest, pSrc, nRowBytes );
+                    pSrc += nSourcePitch;
+                    pDest += nPitch;
+                }
+            }
+
+            m_pDevice->UnmapStaging( nSlot );
+
+            for ( int i = 0; i < nRects; ++i )
+            {
+                m_pDevice->CopyToTarget( nSlot, pRects[i] );
+            }
+
+            m_nNext = nIndex + 1;
+            ++m_stats.nUploads;
+            return true;
+        }
+
+        ++m_stats.nFallbacks;
+        return false;
+    }
+}
@@ -0,0 +1,107 @@
+/* CryHTML5 - for licensing and copyright see license.txt */
+
+#pragma once
+
+#include <vector>
+
+#include <DirtyRegion.h>
+
+namespace HTML5Plugin
+{
+    /** @brief the device operations the staging ring needs (implemented for D3D11 and by fakes) */
+    struct IStagingDevice
+    {
+        virtual ~IStagingDevice() {}
+
+        /**
+        * @brief create the CPU writable staging texture of a slot
+        * @return true if successful
+        */
+        virtual bool CreateStaging( int nSlot, int nWidth, int nHeight ) = 0;
+
+        /** @brief release the staging texture of a slot */
+        virtual void ReleaseStaging( int nSlot ) = 0;
+
+        /**
+        * @brief map a staging texture without waiting for the GPU
+        * @param[out] pData start of the mapped texture
+        * @param[out] nPitch bytes per row of the mapped texture
+        * @return false when the texture is still in use by the GPU (or mapping failed)
+        */
+        virtual bool MapStaging( int nSlot, uint8*& pData, int& nPitch ) = 0;
+
+        /** @brief unmap a staging texture */
+        virtual void UnmapStaging( int nSlot ) = 0;
+
+        /** @brief queue a GPU copy of rect from the staging texture into the target texture */
+        virtual void CopyToTarget( int nSlot, const SDirtyRect& rect ) = 0;
+    };
+
+    /**
+    * @brief Ring of staging textures for uploading dirty rects without stalling the CPU.
+    * Every upload writes into the next staging texture the GPU is done with and queues copies into the target texture,
+    * busy textures are skipped. When all are busy the caller should fall back to a direct upload.
+    */
+    class CStagingRing
+    {
+        public:
+            enum
+            {
+                eMaxSlots = 4, //!< more textures only add memory, the GPU is rarely more than a few frames behind
+            };
+
+            CStagingRing();
+            ~CStagingRing();
+
+            /**
+            * @brief (re)create the ring
+            * @param pDevice device to create and map the textures with
+            * @param nSlots number of staging textures (clamped to eMaxSlots), 0 releases everything
+            * @param nWidth target texture width
+            * @param nHeight target texture height
+            * @return number of slots that could be created
+            */
+            int Configure( IStagingDevice* pDevice, int nSlots, int nWidth, int nHeight );
+
+            /** @brief release all staging textures */
+            void Release()
+            {
+                Configure( m_pDevice, 0, 0, 0 );
+            }
+
+            /** @return number of usable slots */
+            int GetSlots() const
+            {
+                return int( m_slots.size() );
+            }
+
+            /**
+            * @brief upload rects of a frame
+            * @param pSource complete frame (4 bytes per pixel)
+            * @param nSourcePitch bytes per row of pSource
+            * @param pRects rects to upload
+            * @param nRects number of rects
+            * @return false when no staging texture was available, nothing was uploaded then
+            */
+            bool Upload( const uint8* pSource, int nSourcePitch, const SDirtyRect* pRects, int nRects );
+
+            /** @brief upload statistics */
+            struct SStats
+            {
+                uint32 nUploads; //!< uploads done through the ring
+                uint32 nBusySkips; //!< slots skipped because the GPU still used them
+                uint32 nFallbacks; //!< uploads rejected because every slot was busy
+            };
+
+            const SStats& GetStats() const
+            {
+                return m_stats;
+            }
+
+        private:
+            IStagingDevice* m_pDevice; //!< device of the current slots
+            std::vector<int> m_slots; //!< created slot ids
+            size_t m_nNext; //!< index into m_slots to try first
+            SStats m_stats; //!< upload statistics
+    };
+}
@@ -2,6 +2,13 @@
 
 #pragma once
 
+#if defined(HTML5_PORTABLE)
+
+// Engine independent modules only (Linux tests and benchmarks, see CMakeLists.txt)
+#include <PortableTypes.h>
+
+#else
+
 // Insert your headers here
 #include <platform.h>
 #include <algorithm>
@@ -30,7 +37,12 @@
 #define HTML5PLUGIN_EXPORTS
 #endif
 
+// Define when the CEF build supports accelerated offscreen rendering into shared textures (CefRenderHandler::OnAcceleratedPaint)
+//#define HTML5_SHARED_TEXTURE
+
 #pragma warning(disable: 4018)  // conditional expression is constant
 
+#endif
+
 //{{AFX_INSERT_LOCATION}}
 // Microsoft Visual C++ will insert additional declarations immediately before the previous line.
@@ -0,0 +1,159 @@
+/* CryHTML5 - for licensing and copyright see license.txt */
+
+#include "StdAfx.h"
+#include "SurfacePipeline.h"
+
+namespace HTML5Plugin
+{
+    CSurfacePipeline::CSurfacePipeline( int nWidth, int nHeight, CUIStats* pStats )
+        : m_pStats( pStats )
+        , m_mailbox( nWidth, nHeight )
+        , m_nSurfaceWidth( 0 )
+        , m_nSurfaceHeight( 0 )
+    {
+    }
+
+    void CSurfacePipeline::Paint( const uint8* pBuffer, int nWidth, int nHeight, const CDirtyRegion& dirty, int nTileSize )
+    {
+        const uint64 nPaintTime = GetTimestampUs();
+        m_pacer.OnPaint();
+
+        if ( m_pStats )
+        {
+            m_pStats->Record( eUIS_DirtyRects, dirty.GetCount() );
+            m_pStats->Record( eUIS_DirtyArea, dirty.GetArea() );
+        }
+
+        m_coverage.Update( pBuffer, nWidth, nHeight, dirty );
+
+        // tiled mode: only hand over tiles whose content really changed
+        if ( nTileSize != m_tiles.GetTileSize() || nWidth != m_tiles.GetWidth() || nHeight != m_tiles.GetHeight() )
+        {
+            m_tiles.Configure( nWidth, nHeight, nTileSize );
+        }
+
+        // the buffer is only valid during this call so hand a copy to the render thread
+        if ( m_tiles.IsEnabled() )
+        {
+            CDirtyRegion changed;
+            m_tiles.Diff( pBuffer, dirty, m_changedTiles, changed );
+
+            if ( !changed.IsEmpty() )
+            {
+                m_mailbox.Publish( pBuffer, nWidth, nHeight, changed, nPaintTime, &m_changedTiles );
+            }
+        }
+
+        else
+        {
+            m_mailbox.Publish( pBuffer, nWidth, nHeight, dirty, nPaintTime );
+        }
+    }
+
+    bool CSurfacePipeline::Present( ISurfaceDevice& device, float fNow, float fRate )
+    {
+        // take the newest frame only when an upload is due, the mailbox coalesces the paints in between
+        const CFrameMailbox::SFrame* pFrame = nullptr;
+
+        if ( m_pacer.IsUploadDue( fNow, fRate ) )
+        {
+            pFrame = m_mailbox.Acquire();
+
+            if ( pFrame )
+            {
+                m_pacer.OnAcquired( pFrame->nSequence, fNow, fRate );
+            }
+        }
+
+        const CFrameMailbox::SFrame& front = m_mailbox.GetFront();
+
+        // recreate the surface lazily once a frame of another size arrived
+        if ( device.HasSurface() && ( front.width != m_nSurfaceWidth || front.height != m_nSurfaceHeight ) )
+        {
+            device.ReleaseSurface();
+        }
+
+        // a new surface needs the complete frame
+        bool bFull = false;
+
+        if ( !device.HasSurface() )
+        {
+            if ( !device.CreateSurface( front.width, front.height ) )
+            {
+                return false;
+            }
+
+            m_nSurfaceWidth = front.width;
+            m_nSurfaceHeight = front.height;
+            bFull = true;
+        }
+
+        if ( bFull || ( pFrame && !pFrame->upload.IsEmpty() ) )
+        {
+            const uint64 nStart = GetTimestampUs();
+            Upload( device, front, bFull );
+            const uint64 nEnd = GetTimestampUs();
+
+            if ( m_pStats )
+            {
+                m_pStats->Record( eUIS_UpdateTime, nEnd - nStart );
+
+                if ( pFrame )
+                {
+                    m_pStats->Record( eUIS_PaintLatency, nEnd - pFrame->nPaintTime );
+                }
+            }
+        }
+
+        return true;
+    }
+
+    void CSurfacePipeline::Upload( ISurfaceDevice& device, const CFrameMailbox::SFrame& frame, bool bFull )
+    {
+        m_uploadRects.clear();
+
+        if ( bFull )
+        {
+            m_uploadRects.push_back( SDirtyRect( 0, 0, frame.width, frame.height ) );
+        }
+
+        else if ( frame.bTiled )
+        {
+            // one upload per run of changed tiles
+            frame.uploadTiles.ForEachSpan( [&]( const SDirtyRect & rect )
+            {
+                m_uploadRects.push_back( rect );
+            } );
+        }
+
+        else
+        {
+            // one upload per disjoint rect
+            for ( int i = 0; i < frame.upload.GetCount(); ++i )
+            {
+                m_uploadRects.push_back( frame.upload[i] );
+            }
+        }
+
+        if ( m_uploadRects.empty() )
+        {
+            return;
+        }
+
+        device.Upload( &frame.buffer[0], frame.width * 4, &m_uploadRects[0], int( m_uploadRects.size() ) );
+
+        uint64 nBytes = 0;
+
+        for ( size_t i = 0; i < m_uploadRects.size(); ++i )
+        {
+            nBytes += uint64( m_uploadRects[i].GetArea() ) * 4;
+        }
+
+        m_pacer.OnUploaded( nBytes );
+
+        if ( m_pStats )
+        {
+            m_pStats->Record( eUIS_UploadBytes, nBytes );
+        }
+    }
+}
@@ -0,0 +1,101 @@
+/* CryHTML5 - for licensing and copyright see license.txt */
+
+#pragma once
+
+#include <vector>
+
+#include <FrameSource.h>
+#include <FrameMailbox.h>
+#include <TileTracker.h>
+#include <UIStats.h>
+
+namespace HTML5Plugin
+{
+    /**
+    * @brief Paint to texture pipeline of a CEF surface, the frame source for software rendering.
+    * Paints are diffed, handed over to the render thread, paced and uploaded to an ISurfaceDevice.
+    */
+    class CSurfacePipeline : public IFrameSource
+    {
+        public:
+            /**
+            * @param nWidth initial surface width
+            * @param nHeight initial surface height
+            * @param pStats receives the instrumentation (optional)
+            */
+            CSurfacePipeline( int nWidth, int nHeight, CUIStats* pStats = nullptr );
+
+            /**
+            * @brief take a paint (paint thread)
+            * @param pBuffer complete BGRA frame, only valid during the call
+            * @param nWidth width of pBuffer
+            * @param nHeight height of pBuffer
+            * @param dirty area that changed with this paint
+            * @param nTileSize tile size for tiled uploads (0 uploads the dirty rects)
+            */
+            virtual void Paint( const uint8* pBuffer, int nWidth, int nHeight, const CDirtyRegion& dirty, int nTileSize ) override;
+
+            /** @brief shared textures are not used by software rendering */
+            virtual void PaintShared( void* /*hShared*/, int /*nWidth*/, int /*nHeight*/ ) override
+            {
+            }
+
+            /**
+            * @brief upload the newest frame when one is due (render thread)
+            * @param device device owning the surface, recreated when the frame size changes
+            * @param fNow current time in seconds
+            * @param fRate target UI frame rate (0 = every call)
+            * @return true when the surface can be drawn
+            */
+            virtual bool Present( ISurfaceDevice& device, float fNow, float fRate ) override;
+
+            /** @return the frame acquired last (render thread) */
+            const CFrameMailbox::SFrame& GetFront() const
+            {
+                return m_mailbox.GetFront();
+            }
+
+            // IFrameSource
+            virtual int GetWidth() const override
+            {
+                return m_mailbox.GetFront().width;
+            }
+            virtual int GetHeight() const override
+            {
+                return m_mailbox.GetFront().height;
+            }
+            virtual const uint8* GetPixels() const override
+            {
+                const CFrameMailbox::SFrame& front = m_mailbox.GetFront();
+                return front.buffer.empty() ? nullptr : &front.buffer[0];
+            }
+            virtual const CAlphaCoverage* GetCoverage() const override
+            {
+                return &m_coverage;
+            }
+            virtual CFramePacer& GetPacer() override
+            {
+                return m_pacer;
+            }
+
+        private:
+            /** @brief upload the changes of frame, or all of it */
+            void Upload( ISurfaceDevice& device, const CFrameMailbox::SFrame& frame, bool bFull );
+
+            CUIStats* m_pStats; //!< instrumentation (optional)
+
+            // paint thread
+            CTileTracker m_tiles; //!< content diffing for tiled uploads
+            CTileMask m_changedTiles; //!< tiles changed by the current paint
+
+            // shared
+            CFrameMailbox m_mailbox; //!< frames handed over from the paint thread
+            CAlphaCoverage m_coverage; //!< alpha of the newest paint for hit testing
+            CFramePacer m_pacer; //!< upload pacing
+
+            // render thread
+            int m_nSurfaceWidth; //!< size the surface was created with
+            int m_nSurfaceHeight;
+            std::vector<SDirtyRect> m_uploadRects; //!< rects of the current upload
+    };
+}
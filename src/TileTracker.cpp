@@ -0,0 +1,152 @@
+/* CryHTML5 - for licensing and copyright see license.txt */
+
+#include "StdAfx.h"
+#include "TileTracker.h"
+
+namespace HTML5Plugin
+{
+    void CTileMask::Configure( int nWidth, int nHeight, int nTileSize )
+    {
+        m_nWidth = nWidth;
+        m_nHeight = nHeight;
+        m_nTileSize = nTileSize;
+        m_nTilesX = nTileSize > 0 ? ( nWidth + nTileSize - 1 ) / nTileSize : 0;
+        m_nTilesY = nTileSize > 0 ? ( nHeight + nTileSize - 1 ) / nTileSize : 0;
+
+        m_bits.assign( ( m_nTilesX * m_nTilesY + 31 ) / 32, 0 );
+    }
+
+    void CTileMask::Or( const CTileMask& other )
+    {
+        for ( size_t i = 0; i < m_bits.size(); ++i )
+        {
+            m_bits[i] |= other.m_bits[i];
+        }
+    }
+
+    bool CTileMask::IsEmpty() const
+    {
+        for ( size_t i = 0; i < m_bits.size(); ++i )
+        {
+            if ( m_bits[i] )
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    CTileTracker::CTileTracker()
+        : m_nWidth( 0 )
+        , m_nHeight( 0 )
+    {
+    }
+
+    void CTileTracker::Configure( int nWidth, int nHeight, int nTileSize )
+    {
+        m_nWidth = nWidth;
+        m_nHeight = nHeight;
+
+        m_touched.Configure( nWidth, nHeight, nTileSize );
+        m_hashes.assign( m_touched.GetTilesX() * m_touched.GetTilesY(), 0 );
+    }
+
+    void CTileTracker::Diff( const uint8* pSource, const CDirtyRegion& dirty, CTileMask& changed, CDirtyRegion& changedRegion )
+    {
+        const int nTileSize = m_touched.GetTileSize();
+
+        if ( !changed.IsCompatible( m_touched ) )
+        {
+            changed.Configure( m_nWidth, m_nHeight, nTileSize );
+        }
+
+        else
+        {
+            changed.Clear();
+        }
+
+        // mark the touched tiles
+        for ( int i = 0; i < dirty.GetCount(); ++i )
+        {
+            SDirtyRect rect = dirty[i];
+            rect.Clip( m_nWidth, m_nHeight );
+
+            if ( rect.IsEmpty() )
+            {
+                continue;
+            }
+
+            for ( int ty = rect.y / nTileSize; ty <= ( rect.y2 - 1 ) / nTileSize; ++ty )
+            {
+                for ( int tx = rect.x / nTileSize; tx <= ( rect.x2 - 1 ) / nTileSize; ++tx )
+                {
+                    m_touched.Set( tx, ty );
+                }
+            }
+        }
+
+        // hash them and keep those with new content
+        for ( int ty = 0; ty < m_touched.GetTilesY(); ++ty )
+        {
+            for ( int tx = 0; tx < m_touched.GetTilesX(); ++tx )
+            {
+                if ( !m_touched.Test( tx, ty ) )
+                {
+                    continue;
+                }
+
+                uint64 nHash = HashTile( pSource, tx, ty );
+                uint64& nLast = m_hashes[ty * m_touched.GetTilesX() + tx];
+
+                if ( nHash != nLast )
+                {
+                    nLast = nHash;
+                    changed.Set( tx, ty );
+                }
+            }
+        }
+
+        m_touched.Clear();
+
+        changedRegion.Reset();
+        changed.AddToRegion( changedRegion );
+    }
+
+    uint64 CTileTracker::HashTile( const uint8* pSource, int tx, int ty ) const
+    {
+        const SDirtyRect rect = m_touched.GetSpanRect( tx, tx + 1, ty );
+        const size_t nPitch = size_t( m_nWidth ) * 4;
+        const size_t nWords = size_t( rect.x2 - rect.x ) / 2; // 2 pixels per word
+        const bool bOdd = ( ( rect.x2 - rect.x ) & 1 ) != 0;
+
+        uint64 nHash = 0xcbf29ce484222325ULL;
+
+        for ( int row = rect.y; row < rect.y2; ++row )
+        {
+            const uint8* pRow = pSource + row * nPitch + rect.x * 4;
+
+            for ( size_t i = 0; i < nWords; ++i )
+            {
+                uint64 nWord;
+                memcpy( &nWord, pRow + i * 8, 8 );
+
+                nHash ^= nWord;
+                nHash *= 0x100000001b3ULL;
+                nHash ^= nHash >> 29;
+            }
+
+            if ( bOdd )
+            {
+                uint32 nPixel;
+                memcpy( &nPixel, pRow + nWords * 8, 4 );
+
+                nHash ^= nPixel;
+                nHash *= 0x100000001b3ULL;
+            }
+        }
+
+        // 0 is reserved for unknown content
+        return nHash | 1;
+    }
+}
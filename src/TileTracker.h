@@ -0,0 +1,202 @@
+/* CryHTML5 - for licensing and copyright see license.txt */
+
+#pragma once
+
+#include <vector>
+
+#include <DirtyRegion.h>
+
+namespace HTML5Plugin
+{
+    /** @brief one bit per tile of a surface */
+    class CTileMask
+    {
+        public:
+            CTileMask()
+                : m_nTilesX( 0 )
+                , m_nTilesY( 0 )
+                , m_nTileSize( 0 )
+                , m_nWidth( 0 )
+                , m_nHeight( 0 )
+            {
+            }
+
+            /**
+            * @brief set up the mask for a surface, clears all bits
+            * @param nWidth surface width in pixels
+            * @param nHeight surface height in pixels
+            * @param nTileSize edge length of a tile in pixels
+            */
+            void Configure( int nWidth, int nHeight, int nTileSize );
+
+            /** @brief clear all bits */
+            void Clear()
+            {
+                std::fill( m_bits.begin(), m_bits.end(), 0 );
+            }
+
+            /** @brief set the bit of tile tx, ty */
+            void Set( int tx, int ty )
+            {
+                int nIndex = ty * m_nTilesX + tx;
+                m_bits[nIndex >> 5] |= 1u << ( nIndex & 31 );
+            }
+
+            /** @return true when the bit of tile tx, ty is set */
+            bool Test( int tx, int ty ) const
+            {
+                int nIndex = ty * m_nTilesX + tx;
+                return ( m_bits[nIndex >> 5] & ( 1u << ( nIndex & 31 ) ) ) != 0;
+            }
+
+            /** @brief set all bits that are set in other (same layout required) */
+            void Or( const CTileMask& other );
+
+            /** @return true when no bit is set */
+            bool IsEmpty() const;
+
+            /** @return true when both masks describe the same tiling */
+            bool IsCompatible( const CTileMask& other ) const
+            {
+                return m_nTilesX == other.m_nTilesX && m_nTilesY == other.m_nTilesY && m_nTileSize == other.m_nTileSize;
+            }
+
+            /** @return pixel rect of tiles tx to tx2 (exclusive) in row ty, clipped to the surface */
+            SDirtyRect GetSpanRect( int tx, int tx2, int ty ) const
+            {
+                SDirtyRect rect( tx * m_nTileSize, ty * m_nTileSize, tx2 * m_nTileSize, ( ty + 1 ) * m_nTileSize );
+                rect.Clip( m_nWidth, m_nHeight );
+                return rect;
+            }
+
+            /** @brief call f( rect ) for every horizontal run of set tiles */
+            template<class F>
+            void ForEachSpan( F f ) const
+            {
+                for ( int ty = 0; ty < m_nTilesY; ++ty )
+                {
+                    int tx = 0;
+
+                    while ( tx < m_nTilesX )
+                    {
+                        if ( !Test( tx, ty ) )
+                        {
+                            ++tx;
+                            continue;
+                        }
+
+                        int tx2 = tx + 1;
+
+                        while ( tx2 < m_nTilesX && Test( tx2, ty ) )
+                        {
+                            ++tx2;
+                        }
+
+                        f( GetSpanRect( tx, tx2, ty ) );
+                        tx = tx2;
+                    }
+                }
+            }
+
+            /** @brief add every horizontal run of set tiles to region */
+            void AddToRegion( CDirtyRegion& region ) const
+            {
+                ForEachSpan( [&region]( const SDirtyRect & rect )
+                {
+                    region.Add( rect );
+                } );
+            }
+
+            int GetTilesX() const
+            {
+                return m_nTilesX;
+            }
+
+            int GetTilesY() const
+            {
+                return m_nTilesY;
+            }
+
+            int GetTileSize() const
+            {
+                return m_nTileSize;
+            }
+
+            int GetWidth() const
+            {
+                return m_nWidth;
+            }
+
+            int GetHeight() const
+            {
+                return m_nHeight;
+            }
+
+        private:
+            std::vector<uint32> m_bits; //!< row major tile bits
+            int m_nTilesX; //!< tiles per row
+            int m_nTilesY; //!< tile rows
+            int m_nTileSize; //!< tile edge length in pixels
+            int m_nWidth; //!< surface width in pixels
+            int m_nHeight; //!< surface height in pixels
+    };
+
+    /**
+    * @brief Detects which tiles of a surface really changed.
+    * Tiles touched by a paint are hashed and only reported when the hash differs from the last one,
+    * so areas CEF repaints with identical pixels don't get uploaded.
+    */
+    class CTileTracker
+    {
+        public:
+            CTileTracker();
+
+            /**
+            * @brief set up the tiling, forgets all hashes so the next diff reports every touched tile
+            * @param nTileSize edge length of a tile in pixels, 0 disables tracking
+            */
+            void Configure( int nWidth, int nHeight, int nTileSize );
+
+            /** @return true when tracking is configured */
+            bool IsEnabled() const
+            {
+                return m_touched.GetTileSize() > 0;
+            }
+
+            /** @return the tile edge length in pixels */
+            int GetTileSize() const
+            {
+                return m_touched.GetTileSize();
+            }
+
+            /** @return surface width the tracker was configured for */
+            int GetWidth() const
+            {
+                return m_nWidth;
+            }
+
+            /** @return surface height the tracker was configured for */
+            int GetHeight() const
+            {
+                return m_nHeight;
+            }
+
+            /**
+            * @brief find the tiles a paint really changed
+            * @param pSource complete frame (4 bytes per pixel, tightly packed rows)
+            * @param dirty area CEF reported dirty
+            * @param[out] changed the tiles whose content differs from the last diff
+            * @param[out] changedRegion the same tiles as rects
+            */
+            void Diff( const uint8* pSource, const CDirtyRegion& dirty, CTileMask& changed, CDirtyRegion& changedRegion );
+
+        private:
+            /** @return content hash of tile tx, ty (never 0) */
+            uint64 HashTile( const uint8* pSource, int tx, int ty ) const;
+
+            CTileMask m_touched; //!< tiles touched by the current paint
+            std::vector<uint64> m_hashes; //!< last content hash per tile, 0 when unknown
+            int m_nWidth; //!< surface width in pixels
+            int m_nHeight; //!< surface height in pixels
+    };
+}
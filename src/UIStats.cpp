@@ -0,0 +1,211 @@
+/* CryHTML5 - for licensing and copyright see license.txt */
+
+#include "StdAfx.h"
+#include "UIStats.h"
+
+#include <cstdio>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+namespace HTML5Plugin
+{
+#if defined(_WIN32)
+    static LONGLONG QueryFrequency()
+    {
+        LARGE_INTEGER frequency;
+        QueryPerformanceFrequency( &frequency );
+        return frequency.QuadPart;
+    }
+
+    static const LONGLONG s_nFrequency = QueryFrequency(); //!< performance counter ticks per second (initialized on module load)
+#endif
+
+    uint64 GetTimestampUs()
+    {
+#if defined(_WIN32)
+        LARGE_INTEGER counter;
+        QueryPerformanceCounter( &counter );
+
+        return uint64( counter.QuadPart / s_nFrequency ) * 1000000 + uint64( counter.QuadPart % s_nFrequency ) * 1000000 / s_nFrequency;
+#else
+        timespec now;
+        clock_gettime( CLOCK_MONOTONIC, &now );
+
+        return uint64( now.tv_sec ) * 1000000 + now.tv_nsec / 1000;
+#endif
+    }
+
+    CHistogram::CHistogram()
+        : m_nCount( 0 )
+        , m_nSum( 0 )
+        , m_nMin( ~uint64( 0 ) )
+        , m_nMax( 0 )
+    {
+        for ( int i = 0; i < eBuckets; ++i )
+        {
+            m_counts[i].store( 0, std::memory_order_relaxed );
+        }
+    }
+
+    int CHistogram::GetBucket( uint64 nValue )
+    {
+        if ( nValue < eLinear )
+        {
+            return int( nValue );
+        }
+
+        int nExponent = 4;
+
+        while ( nExponent < 32 && ( nValue >> ( nExponent + 1 ) ) )
+        {
+            ++nExponent;
+        }
+
+        if ( nExponent >= 32 )
+        {
+            return eBuckets - 1;
+        }
+
+        // 4 buckets per power of two
+        return eLinear + ( nExponent - 4 ) * 4 + int( ( nValue >> ( nExponent - 2 ) ) & 3 );
+    }
+
+    uint64 CHistogram::GetBucketValue( int nBucket )
+    {
+        if ( nBucket < eLinear )
+        {
+            return uint64( nBucket );
+        }
+
+        const int nExponent = 4 + ( nBucket - eLinear ) / 4;
+        const int nStep = ( nBucket - eLinear ) % 4;
+
+        // middle of the bucket
+        return ( ( uint64( 4 + nStep ) * 2 + 1 ) ) << ( nExponent - 3 );
+    }
+
+    void CHistogram::Record( uint64 nValue )
+    {
+        // single writer, so load and store are enough
+        std::atomic<uint32>& bucket = m_counts[GetBucket( nValue )];
+        bucket.store( bucket.load( std::memory_order_relaxed ) + 1, std::memory_order_relaxed );
+
+        m_nSum.store( m_nSum.load( std::memory_order_relaxed ) + nValue, std::memory_order_relaxed );
+
+        if ( nValue < m_nMin.load( std::memory_order_relaxed ) )
+        {
+            m_nMin.store( nValue, std::memory_order_relaxed );
+        }
+
+        if ( nValue > m_nMax.load( std::memory_order_relaxed ) )
+        {
+            m_nMax.store( nValue, std::memory_order_relaxed );
+        }
+
+        m_nCount.store( m_nCount.load( std::memory_order_relaxed ) + 1, std::memory_order_release );
+    }
+
+    void CHistogram::Summarize( SHistogramSummary& summary ) const
+    {
+        memset( &summary, 0, sizeof( summary ) );
+
+        uint32 counts[eBuckets];
+        uint32 nTotal = 0;
+
+        summary.nCount = m_nCount.load( std::memory_order_acquire );
+
+        for ( int i = 0; i < eBuckets; ++i )
+        {
+            counts[i] = m_counts[i].load( std::memory_order_relaxed );
+            nTotal += counts[i];
+        }
+
+        if ( !summary.nCount || !nTotal )
+        {
+            return;
+        }
+
+        summary.fMean = double( m_nSum.load( std::memory_order_relaxed ) ) / summary.nCount;
+        summary.nMin = m_nMin.load( std::memory_order_relaxed );
+        summary.nMax = m_nMax.load( std::memory_order_relaxed );
+
+        const uint32 nRanks[3] = { ( nTotal * 50 + 99 ) / 100, ( nTotal * 90 + 99 ) / 100, ( nTotal * 99 + 99 ) / 100 };
+        uint64* pResults[3] = { &summary.nP50, &summary.nP90, &summary.nP99 };
+
+        uint32 nSeen = 0;
+        int nRank = 0;
+
+        for ( int i = 0; i < eBuckets && nRank < 3; ++i )
+        {
+            nSeen += counts[i];
+
+            while ( nRank < 3 && nSeen >= nRanks[nRank] )
+            {
+                // clamp into the observed range, the bucket middle may lie outside of it
+                *pResults[nRank++] = min( max( GetBucketValue( i ), summary.nMin ), summary.nMax );
+            }
+        }
+    }
+
+    const char* CUIStats::GetName( EUIStat eStat )
+    {
+        static const char* s_names[eUIS_Count] =
+        {
+            "paint_latency",
+            "update_time",
+            "upload_bytes",
+            "dirty_rects",
+            "dirty_area",
+            "draw_time",
+            "input_events",
+            "draw_calls",
+            "input_sent",
+            "composite_time",
+        };
+
+        return s_names[eStat];
+    }
+
+    const char* CUIStats::GetUnit( EUIStat eStat )
+    {
+        static const char* s_units[eUIS_Count] =
+        {
+            "us",
+            "us",
+            "bytes",
+            "rects",
+            "pixels",
+            "us",
+            "events",
+            "calls",
+            "events",
+            "us",
+        };
+
+        return s_units[eStat];
+    }
+
+    void CUIStats::FormatCSV( std::string& sOut, const char* sLabel, bool bHeader ) const
+    {
+        if ( bHeader )
+        {
+            sOut += "label,stat,unit,count,mean,min,p50,p90,p99,max\n";
+        }
+
+        for ( int i = 0; i < eUIS_Count; ++i )
+        {
+            SHistogramSummary summary;
+            Summarize( EUIStat( i ), summary );
+
+            char sRow[256];
+            sprintf( sRow, "%s,%s,%s,%u,%.1f,%llu,%llu,%llu,%llu,%llu\n", sLabel, GetName( EUIStat( i ) ), GetUnit( EUIStat( i ) ), summary.nCount, summary.fMean,
+                     ( unsigned long long )summary.nMin, ( unsigned long long )summary.nP50, ( unsigned long long )summary.nP90, ( unsigned long long )summary.nP99, ( unsigned long long )summary.nMax );
+
+            sOut += sRow;
+        }
+    }
+}
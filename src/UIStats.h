@@ -0,0 +1,109 @@
+/* CryHTML5 - for licensing and copyright see license.txt */
+
+#pragma once
+
+#include <atomic>
+#include <string>
+
+namespace HTML5Plugin
+{
+    /** @return monotonic timestamp in microseconds */
+    uint64 GetTimestampUs();
+
+    /** @brief instrumentation counters of the UI pipeline */
+    enum EUIStat
+    {
+        eUIS_PaintLatency = 0, //!< microseconds from a paint arriving to its upload (render thread)
+        eUIS_UpdateTime, //!< microseconds spent in UpdateResources (render thread)
+        eUIS_UploadBytes, //!< bytes uploaded per update (render thread)
+        eUIS_DirtyRects, //!< dirty rects per paint (paint thread)
+        eUIS_DirtyArea, //!< dirty pixels per paint (paint thread)
+        eUIS_DrawTime, //!< microseconds spent drawing a fullscreen view (render thread)
+        eUIS_InputEvents, //!< input events drained per frame (main thread)
+        eUIS_DrawCalls, //!< device context calls per fullscreen draw (render thread)
+        eUIS_InputSent, //!< input events sent to the browser per frame after batching (main thread)
+        eUIS_CompositeTime, //!< microseconds spent flushing the batched fixed size views (render thread)
+        eUIS_Count,
+    };
+
+    /** @brief summary of a histogram */
+    struct SHistogramSummary
+    {
+        uint32 nCount; //!< recorded samples
+        double fMean; //!< average value
+        uint64 nMin; //!< smallest value
+        uint64 nMax; //!< largest value
+        uint64 nP50; //!< median (bucket accuracy)
+        uint64 nP90; //!< 90th percentile (bucket accuracy)
+        uint64 nP99; //!< 99th percentile (bucket accuracy)
+    };
+
+    /**
+    * @brief Lock-free histogram with log-linear buckets (4 buckets per power of two, about 25% accuracy).
+    * Each histogram has a single writer thread which records with plain atomic stores, any thread may read.
+    */
+    class CHistogram
+    {
+        public:
+            enum
+            {
+                eLinear = 16, //!< values below are counted exactly
+                eBuckets = eLinear + 28 * 4, //!< values up to 2^32, larger ones are clamped into the last bucket
+            };
+
+            CHistogram();
+
+            /** @brief record a value (owning thread only) */
+            void Record( uint64 nValue );
+
+            /** @brief summarize the current contents (any thread, may be slightly torn while written) */
+            void Summarize( SHistogramSummary& summary ) const;
+
+        private:
+            /** @return bucket of a value */
+            static int GetBucket( uint64 nValue );
+
+            /** @return value representing a bucket */
+            static uint64 GetBucketValue( int nBucket );
+
+            std::atomic<uint32> m_counts[eBuckets]; //!< samples per bucket
+            std::atomic<uint32> m_nCount; //!< samples
+            std::atomic<uint64> m_nSum; //!< sum of all samples
+            std::atomic<uint64> m_nMin; //!< smallest sample
+            std::atomic<uint64> m_nMax; //!< largest sample
+    };
+
+    /** @brief the histograms of all UI counters */
+    class CUIStats
+    {
+        public:
+            /** @brief record a value of a counter (from the thread owning the counter) */
+            void Record( EUIStat eStat, uint64 nValue )
+            {
+                m_histograms[eStat].Record( nValue );
+            }
+
+            /** @brief summarize a counter */
+            void Summarize( EUIStat eStat, SHistogramSummary& summary ) const
+            {
+                m_histograms[eStat].Summarize( summary );
+            }
+
+            /** @return name of a counter */
+            static const char* GetName( EUIStat eStat );
+
+            /** @return unit of a counter */
+            static const char* GetUnit( EUIStat eStat );
+
+            /**
+            * @brief append the summaries as CSV rows
+            * @param sOut receives the rows
+            * @param sLabel first column of every row (e.g. a timestamp or build label)
+            * @param bHeader prepend the header row
+            */
+            void FormatCSV( std::string& sOut, const char* sLabel, bool bHeader ) const;
+
+        private:
+            CHistogram m_histograms[eUIS_Count];
+    };
+}
@@ -0,0 +1,87 @@
+/* CryHTML5 - for licensing and copyright see license.txt */
+
+#include "StdAfx.h"
+#include "VirtualCursor.h"
+
+namespace HTML5Plugin
+{
+    CVirtualCursor::CVirtualCursor()
+        : m_fStickX( 0.0f )
+        , m_fStickY( 0.0f )
+        , m_fHeldTime( 0.0f )
+        , m_fMinX( 0.0f )
+        , m_fMinY( 0.0f )
+        , m_fMaxX( -1.0f )
+        , m_fMaxY( -1.0f )
+        , m_bReleased( false )
+    {
+    }
+
+    float CVirtualCursor::GetResponse( float fDeflection ) const
+    {
+        const float fDeadZone = clamp_tpl( m_settings.fDeadZone, 0.0f, 0.99f );
+
+        if ( fDeflection <= fDeadZone )
+        {
+            return 0.0f;
+        }
+
+        // rescale so the response starts at 0 on the edge of the dead zone
+        const float fLinear = min( ( fDeflection - fDeadZone ) / ( 1.0f - fDeadZone ), 1.0f );
+        return powf( fLinear, max( m_settings.fCurve, 0.1f ) );
+    }
+
+    void CVirtualCursor::Clamp( float& fX, float& fY ) const
+    {
+        if ( m_fMaxX >= m_fMinX && m_fMaxY >= m_fMinY )
+        {
+            fX = clamp_tpl( fX, m_fMinX, m_fMaxX );
+            fY = clamp_tpl( fY, m_fMinY, m_fMaxY );
+        }
+    }
+
+    bool CVirtualCursor::Update( float fDeltaTime, float& fX, float& fY )
+    {
+        const float fDeflection = sqrtf( m_fStickX * m_fStickX + m_fStickY * m_fStickY );
+        const float fResponse = GetResponse( fDeflection );
+
+        if ( fResponse <= 0.0f )
+        {
+            // a held stick is only released once it is back past the hysteresis band
+            if ( m_fHeldTime > 0.0f && fDeflection > m_settings.fDeadZone - m_settings.fHysteresis )
+            {
+                return false;
+            }
+
+            if ( m_fHeldTime > 0.0f )
+            {
+                m_bReleased = true;
+            }
+
+            m_fHeldTime = 0.0f;
+            return false;
+        }
+
+        m_fHeldTime += fDeltaTime;
+
+        float fAccel = 1.0f;
+
+        if ( m_settings.fAccelTime > 0.0f )
+        {
+            const float fRamp = min( m_fHeldTime / m_settings.fAccelTime, 1.0f );
+            fAccel = m_settings.fMinAccel + ( 1.0f - m_settings.fMinAccel ) * fRamp;
+        }
+
+        // the direction comes from the raw stick, the dead zone and curve only shape the speed
+        const float fStep = m_settings.fMaxSpeed * fResponse * fAccel * fDeltaTime / fDeflection;
+
+        const float fOldX = fX;
+        const float fOldY = fY;
+        fX += m_fStickX * fStep;
+        fY += m_fStickY * fStep;
+        Clamp( fX, fY );
+
+        // pushing against an edge doesn't move it
+        return fX != fOldX || fY != fOldY;
+    }
+}
@@ -0,0 +1,115 @@
+/* CryHTML5 - for licensing and copyright see license.txt */
+
+#pragma once
+
+namespace HTML5Plugin
+{
+    /** @brief response of the virtual cursor to the stick */
+    struct SVirtualCursorSettings
+    {
+        float fDeadZone; //!< stick deflection (0 - 1) ignored around the center
+        float fCurve; //!< exponent applied to the deflection outside of the dead zone (1 = linear)
+        float fMaxSpeed; //!< pixels per second at full deflection and full acceleration
+        float fAccelTime; //!< seconds the stick has to be held until the full speed is reached (0 = immediately)
+        float fMinAccel; //!< part of the speed available right after the stick left the dead zone
+        float fHysteresis; //!< deflection below the dead zone the stick has to fall to count as released, so jitter on the edge doesn't snap again and again
+
+        SVirtualCursorSettings()
+            : fDeadZone( 0.2f )
+            , fCurve( 2.0f )
+            , fMaxSpeed( 1000.0f )
+            , fAccelTime( 0.5f )
+            , fMinAccel( 0.35f )
+            , fHysteresis( 0.05f )
+        {
+        }
+    };
+
+    /**
+    * @brief Pointer driven by an analog stick, integrated once per frame.
+    * The stick deflection passes a radial dead zone and a response curve, holding it ramps the speed up.
+    */
+    class CVirtualCursor
+    {
+        public:
+            CVirtualCursor();
+
+            /** @brief set the stick response */
+            void SetSettings( const SVirtualCursorSettings& settings )
+            {
+                m_settings = settings;
+            }
+
+            /** @return the stick response */
+            const SVirtualCursorSettings& GetSettings() const
+            {
+                return m_settings;
+            }
+
+            /** @brief set the stick deflection (-1 - 1 per axis, y down) */
+            void SetStick( float fX, float fY )
+            {
+                m_fStickX = fX;
+                m_fStickY = fY;
+            }
+
+            /**
+            * @brief keep the cursor inside a rect
+            * @param fMinX left edge in pixels
+            * @param fMinY top edge
+            * @param fMaxX right edge, less than fMinX doesn't clamp
+            * @param fMaxY bottom edge
+            */
+            void SetBounds( float fMinX, float fMinY, float fMaxX, float fMaxY )
+            {
+                m_fMinX = fMinX;
+                m_fMinY = fMinY;
+                m_fMaxX = fMaxX;
+                m_fMaxY = fMaxY;
+            }
+
+            /** @brief clamp a position into the bounds */
+            void Clamp( float& fX, float& fY ) const;
+
+            /**
+            * @brief move the cursor by the stick for one frame
+            * @param fDeltaTime frame time in seconds
+            * @param[in,out] fX cursor position in pixels, kept inside the bounds
+            * @param[in,out] fY
+            * @return true when the cursor moved
+            */
+            bool Update( float fDeltaTime, float& fX, float& fY );
+
+            /** @return true once after the stick fell below the dead zone minus the hysteresis following a movement, the time to snap */
+            bool ConsumeRelease()
+            {
+                const bool bReleased = m_bReleased;
+                m_bReleased = false;
+                return bReleased;
+            }
+
+            /** @return true from when the stick leaves the dead zone until it is released */
+            bool IsActive() const
+            {
+                return m_fHeldTime > 0.0f;
+            }
+
+            /**
+            * @brief get the speed factor of a stick deflection without acceleration
+            * @param fDeflection length of the stick vector (0 - 1)
+            * @return 0 - 1
+            */
+            float GetResponse( float fDeflection ) const;
+
+        private:
+            SVirtualCursorSettings m_settings; //!< stick response
+            float m_fStickX; //!< current stick deflection
+            float m_fStickY;
+            float m_fHeldTime; //!< seconds the stick is held, 0 once released
+            float m_fMinX; //!< bounds the cursor is kept in
+            float m_fMinY;
+            float m_fMaxX;
+            float m_fMaxY;
+            bool m_bReleased; //!< the stick returned into the dead zone since the last ConsumeRelease
+    };
+}
@@ -0,0 +1,176 @@
+/* CryHTML5 - for licensing and copyright see license.txt */
+
+#include "StdAfx.h"
+#include "WorldQuad.h"
+
+namespace HTML5Plugin
+{
+    SClipQuad SClipQuad::FromScreen( float fX, float fY, float fWidth, float fHeight, int nViewportWidth, int nViewportHeight )
+    {
+        const float fLeft = fX / nViewportWidth * 2.0f - 1.0f;
+        const float fRight = ( fX + fWidth ) / nViewportWidth * 2.0f - 1.0f;
+        const float fTop = 1.0f - fY / nViewportHeight * 2.0f;
+        const float fBottom = 1.0f - ( fY + fHeight ) / nViewportHeight * 2.0f;
+
+        SClipQuad quad;
+
+        for ( int n = 0; n < 4; ++n )
+        {
+            quad.v[n][0] = ( n & 1 ) ? fRight : fLeft;
+            quad.v[n][1] = ( n & 2 ) ? fBottom : fTop;
+            quad.v[n][2] = 0.0f;
+            quad.v[n][3] = 1.0f;
+        }
+
+        return quad;
+    }
+
+    CWorldQuad::CWorldQuad()
+        : m_vCenter( ZERO )
+        , m_vRight( 1.0f, 0.0f, 0.0f )
+        , m_vUp( 0.0f, 0.0f, 1.0f )
+        , m_fWidth( 0.0f )
+        , m_fHeight( 0.0f )
+    {
+    }
+
+    void CWorldQuad::Set( const Matrix34& tm, float fWidth, float fHeight )
+    {
+        m_vCenter = tm.GetTranslation();
+        m_vRight = tm.GetColumn0().GetNormalizedSafe( Vec3( 1.0f, 0.0f, 0.0f ) );
+        m_vUp = tm.GetColumn2().GetNormalizedSafe( Vec3( 0.0f, 0.0f, 1.0f ) );
+        m_fWidth = max( fWidth, 0.0f );
+        m_fHeight = max( fHeight, 0.0f );
+    }
+
+    Vec3 CWorldQuad::GetCorner( int n ) const
+    {
+        const float fX = ( n & 1 ) ? 0.5f : -0.5f;
+        const float fY = ( n & 2 ) ? -0.5f : 0.5f;
+        return m_vCenter + m_vRight * ( fX * m_fWidth ) + m_vUp * ( fY * m_fHeight );
+    }
+
+    AABB CWorldQuad::GetBounds() const
+    {
+        AABB bounds( AABB::RESET );
+
+        for ( int n = 0; n < 4; ++n )
+        {
+            bounds.Add( GetCorner( n ) );
+        }
+
+        return bounds;
+    }
+
+    float CWorldQuad::GetDistance( const Vec3& vPos ) const
+    {
+        // clamp the position into the rectangle
+        const Vec3 vDelta = vPos - m_vCenter;
+        const float fX = clamp_tpl( vDelta.Dot( m_vRight ), -0.5f * m_fWidth, 0.5f * m_fWidth );
+        const float fY = clamp_tpl( vDelta.Dot( m_vUp ), -0.5f * m_fHeight, 0.5f * m_fHeight );
+
+        return ( m_vCenter + m_vRight * fX + m_vUp * fY - vPos ).GetLength();
+    }
+
+    float CWorldQuad::Project( const CCamera& cam, SClipQuad& quad ) const
+    {
+        // CryENGINE cameras look along y with z up
+        const Matrix34& camMat = cam.GetMatrix();
+        const Vec3 vPos = camMat.GetTranslation();
+        const Vec3 vRight = camMat.GetColumn0();
+        const Vec3 vForward = camMat.GetColumn1();
+        const Vec3 vUp = camMat.GetColumn2();
+
+        const float fNear = cam.GetNearPlane();
+        const float fFar = cam.GetFarPlane();
+        const float fScaleY = 1.0f / tanf( cam.GetFov() * 0.5f );
+        const float fScaleX = fScaleY / cam.GetProjRatio();
+        const float fDepthScale = fFar / ( fFar - fNear );
+
+        bool bBehind = false;
+        float ndc[4][2];
+
+        for ( int n = 0; n < 4; ++n )
+        {
+            const Vec3 vDelta = GetCorner( n ) - vPos;
+            const float fDepth = vDelta.Dot( vForward );
+
+            quad.v[n][0] = vDelta.Dot( vRight ) * fScaleX;
+            quad.v[n][1] = vDelta.Dot( vUp ) * fScaleY;
+            quad.v[n][2] = ( fDepth - fNear ) * fDepthScale;
+            quad.v[n][3] = fDepth;
+
+            if ( fDepth <= fNear )
+            {
+                bBehind = true;
+                continue;
+            }
+
+            ndc[n][0] = quad.v[n][0] / fDepth;
+            ndc[n][1] = quad.v[n][1] / fDepth;
+        }
+
+        // the rasterizer clips the quad, the estimate can't
+        if ( bBehind )
+        {
+            return 1.0f;
+        }
+
+        // area of the polygon top left, top right, bottom right, bottom left (clip space spans 2x2)
+        static const int order[4] = { 0, 1, 3, 2 };
+        float fArea = 0.0f;
+
+        for ( int i = 0; i < 4; ++i )
+        {
+            const float* a = ndc[order[i]];
+            const float* b = ndc[order[( i + 1 ) % 4]];
+            fArea += a[0] * b[1] - b[0] * a[1];
+        }
+
+        return clamp_tpl( fabsf( fArea ) * 0.5f / 4.0f, 0.0f, 1.0f );
+    }
+
+    bool CWorldQuad::Intersect( const Vec3& vOrigin, const Vec3& vDir, float& fU, float& fV ) const
+    {
+        fU = fV = -1.0f;
+
+        if ( !IsEnabled() )
+        {
+            return false;
+        }
+
+        const Vec3 vNormal = m_vRight.Cross( m_vUp );
+        const float fDenom = vDir.Dot( vNormal );
+
+        if ( fabsf( fDenom ) < 1e-6f )
+        {
+            return false;
+        }
+
+        const float t = ( m_vCenter - vOrigin ).Dot( vNormal ) / fDenom;
+
+        if ( t < 0.0f )
+        {
+            return false;
+        }
+
+        const Vec3 vHit = vOrigin + vDir * t - m_vCenter;
+        fU = vHit.Dot( m_vRight ) / m_fWidth + 0.5f;
+        fV = 0.5f - vHit.Dot( m_vUp ) / m_fHeight;
+
+        return fU >= 0.0f && fU <= 1.0f && fV >= 0.0f && fV <= 1.0f;
+    }
+
+    void CWorldQuad::GetCameraRay( const CCamera& cam, float fX, float fY, int nViewportWidth, int nViewportHeight, Vec3& vOrigin, Vec3& vDir )
+    {
+        const Matrix34& camMat = cam.GetMatrix();
+
+        const float fTanY = tanf( cam.GetFov() * 0.5f );
+        const float fTanX = fTanY * cam.GetProjRatio();
+        const float fNdcX = fX / nViewportWidth * 2.0f - 1.0f;
+        const float fNdcY = 1.0f - fY / nViewportHeight * 2.0f;
+
+        vOrigin = camMat.GetTranslation();
+        vDir = camMat.GetColumn1() + camMat.GetColumn0() * ( fNdcX * fTanX ) + camMat.GetColumn2() * ( fNdcY * fTanY );
+    }
+}
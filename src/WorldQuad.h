@@ -0,0 +1,93 @@
+/* CryHTML5 - for licensing and copyright see license.txt */
+
+#pragma once
+
+namespace HTML5Plugin
+{
+    /** @brief corners of a quad in clip space (top left, top right, bottom left, bottom right; x, y, z, w) */
+    struct SClipQuad
+    {
+        float v[4][4];
+
+        /**
+        * @brief quad of a screen rectangle
+        * @param fX left in viewport pixels
+        * @param fY top in viewport pixels
+        * @param fWidth width in viewport pixels
+        * @param fHeight height in viewport pixels
+        * @param nViewportWidth viewport size
+        * @param nViewportHeight
+        */
+        static SClipQuad FromScreen( float fX, float fY, float fWidth, float fHeight, int nViewportWidth, int nViewportHeight );
+    };
+
+    /**
+    * @brief Rectangle in the world a view is shown on (terminals, billboards).
+    * Handles the projection into clip space, visibility and mapping rays to surface coordinates.
+    */
+    class CWorldQuad
+    {
+        public:
+            CWorldQuad();
+
+            /**
+            * @brief place the quad
+            * @param tm center and orientation, the surface spans the x (right) and z (up) axes and faces -y
+            * @param fWidth width in meters (0 removes the quad)
+            * @param fHeight height in meters
+            */
+            void Set( const Matrix34& tm, float fWidth, float fHeight );
+
+            /** @return true when the quad is placed */
+            bool IsEnabled() const
+            {
+                return m_fWidth > 0.0f && m_fHeight > 0.0f;
+            }
+
+            /** @return bounding box of the quad */
+            AABB GetBounds() const;
+
+            /** @return distance of the camera to the closest point of the quad */
+            float GetDistance( const Vec3& vPos ) const;
+
+            /**
+            * @brief project the quad
+            * @param cam camera to project with
+            * @param[out] quad corners in clip space
+            * @return part of the viewport the quad covers (0..1), 1 when it reaches behind the camera
+            */
+            float Project( const CCamera& cam, SClipQuad& quad ) const;
+
+            /**
+            * @brief intersect a ray with the quad (both sides)
+            * @param vOrigin ray start
+            * @param vDir ray direction
+            * @param[out] fU horizontal position on the quad (0..1 from the left, also set when the plane is hit outside)
+            * @param[out] fV vertical position on the quad (0..1 from the top)
+            * @return true when the ray hits the quad in front of its origin
+            */
+            bool Intersect( const Vec3& vOrigin, const Vec3& vDir, float& fU, float& fV ) const;
+
+            /**
+            * @brief get the ray through a viewport position
+            * @param cam camera of the viewport
+            * @param fX horizontal position in viewport pixels
+            * @param fY vertical position in viewport pixels
+            * @param nViewportWidth viewport size
+            * @param nViewportHeight
+            * @param[out] vOrigin ray start
+            * @param[out] vDir ray direction (not normalized)
+            */
+            static void GetCameraRay( const CCamera& cam, float fX, float fY, int nViewportWidth, int nViewportHeight, Vec3& vOrigin, Vec3& vDir );
+
+        private:
+            /** @brief get corner n (top left, top right, bottom left, bottom right) */
+            Vec3 GetCorner( int n ) const;
+
+            Vec3 m_vCenter; //!< center of the quad
+            Vec3 m_vRight; //!< unit vector to the right edge
+            Vec3 m_vUp; //!< unit vector to the top edge
+            float m_fWidth; //!< size in meters
+            float m_fHeight;
+    };
+}
@@ -0,0 +1,29 @@
+/* CryHTML5 - for licensing and copyright see license.txt */
+
+#pragma once
+
+#include <cstdio>
+
+namespace HTML5Test
+{
+    /** @return number of failed checks so far */
+    inline int& GetFailures()
+    {
+        static int nFailures = 0;
+        return nFailures;
+    }
+}
+
+/** @brief report a failed condition and keep going */
+#define TEST_CHECK( x ) \
+    do \
+    { \
+        if ( !( x ) ) \
+        { \
+            printf( "%s(%d): check failed: %s\n", __FILE__, __LINE__, #x ); \
+            ++HTML5Test::GetFailures(); \
+        } \
+    } while ( 0 )
+
+/** @brief exit code of a test: 0 when every check passed */
+#define TEST_RESULT() ( HTML5Test::GetFailures() == 0 ? 0 : 1 )
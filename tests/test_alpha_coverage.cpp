@@ -0,0 +1,268 @@
+/* CryHTML5 - for licensing and copyright see license.txt */
+
+// Alpha coverage queries against a brute force scan of the frame, over many incremental updates and while another thread queries.
+
+#include "StdAfx.h"
+#include "AlphaCoverage.h"
+#include "TestCheck.h"
+
+#include <atomic>
+#include <thread>
+
+using namespace HTML5Plugin;
+
+namespace
+{
+    /** @brief small deterministic generator so failures reproduce */
+    struct SRandom
+    {
+        uint32 nState;
+
+        explicit SRandom( uint32 nSeed )
+            : nState( nSeed )
+        {
+        }
+
+        int Next( int nRange )
+        {
+            nState = nState * 1664525u + 1013904223u;
+            return int( ( nState >> 8 ) % uint32( nRange ) );
+        }
+    };
+
+    /** @brief BGRA frame with the alpha kept separately for the reference answers */
+    struct SFrame
+    {
+        int nWidth;
+        int nHeight;
+        std::vector<uint8> pixels;
+
+        SFrame( int nW, int nH )
+            : nWidth( nW )
+            , nHeight( nH )
+            , pixels( nW * nH * 4, 0 )
+        {
+        }
+
+        uint8 GetAlpha( int x, int y ) const
+        {
+            return pixels[( y * nWidth + x ) * 4 + 3];
+        }
+
+        /** @brief fill rect with one alpha, the color channels get noise */
+        void Fill( const SDirtyRect& rect, uint8 nAlpha )
+        {
+            for ( int y = rect.y; y < rect.y2; ++y )
+            {
+                for ( int x = rect.x; x < rect.x2; ++x )
+                {
+                    uint8* p = &pixels[( y * nWidth + x ) * 4];
+                    p[0] = uint8( x );
+                    p[1] = uint8( y );
+                    p[2] = uint8( x ^ y );
+                    p[3] = nAlpha;
+                }
+            }
+        }
+
+        bool IsRegionOpaque( const SDirtyRect& rect, uint8 nThreshold ) const
+        {
+            SDirtyRect clipped = rect;
+            clipped.Clip( nWidth, nHeight );
+
+            for ( int y = clipped.y; y < clipped.y2; ++y )
+            {
+                for ( int x = clipped.x; x < clipped.x2; ++x )
+                {
+                    if ( GetAlpha( x, y ) >= nThreshold )
+                    {
+                        return true;
+                    }
+                }
+            }
+
+            return false;
+        }
+    };
+
+    /** @brief random rect inside the frame, mostly small widgets */
+    SDirtyRect GetRandomRect( SRandom& random, int nWidth, int nHeight )
+    {
+        const int nMax = random.Next( 6 ) == 0 ? 120 : 20;
+        const int x = random.Next( nWidth + 20 ) - 10;
+        const int y = random.Next( nHeight + 20 ) - 10;
+        SDirtyRect rect( x, y, x + 1 + random.Next( nMax ), y + 1 + random.Next( nMax ) );
+        rect.Clip( nWidth, nHeight );
+        return rect;
+    }
+
+    /** @return number of random queries answered differently than the brute force scan */
+    int CountMismatches( const CAlphaCoverage& coverage, const SFrame& frame, SRandom& random )
+    {
+        static const uint8 thresholds[] = { 1, 100, 128, 255 };
+        int nFailed = 0;
+
+        for ( int i = 0; i < 200; ++i )
+        {
+            const uint8 nThreshold = thresholds[random.Next( 4 )];
+
+            const int x = random.Next( frame.nWidth + 4 ) - 2;
+            const int y = random.Next( frame.nHeight + 4 ) - 2;
+            const bool bInside = x >= 0 && y >= 0 && x < frame.nWidth && y < frame.nHeight;
+            nFailed += coverage.GetAlpha( x, y ) == ( bInside ? frame.GetAlpha( x, y ) : 0 ) ? 0 : 1;
+            nFailed += coverage.IsOpaque( x, y, nThreshold ) == ( bInside && frame.GetAlpha( x, y ) >= nThreshold ) ? 0 : 1;
+
+            SDirtyRect rect = GetRandomRect( random, frame.nWidth, frame.nHeight );
+            rect.x -= 3;
+            rect.y2 += 3;
+            nFailed += coverage.IsRegionOpaque( rect, nThreshold ) == frame.IsRegionOpaque( rect, nThreshold ) ? 0 : 1;
+        }
+
+        CTileMask tiles;
+        coverage.GetCoveredTiles( tiles, 128 );
+
+        for ( int ty = 0; ty < tiles.GetTilesY(); ++ty )
+        {
+            for ( int tx = 0; tx < tiles.GetTilesX(); ++tx )
+            {
+                const int nTile = 1 << CAlphaCoverage::eTileShift;
+                const SDirtyRect tile( tx * nTile, ty * nTile, ( tx + 1 ) * nTile, ( ty + 1 ) * nTile );
+                nFailed += tiles.Test( tx, ty ) == frame.IsRegionOpaque( tile, 128 ) ? 0 : 1;
+            }
+        }
+
+        return nFailed;
+    }
+
+    void TestIncrementalUpdates()
+    {
+        // odd size so the last tiles of every level are partial
+        SFrame frame( 203, 117 );
+        CAlphaCoverage coverage;
+        SRandom random( 4711 );
+        int nFailed = 0;
+
+        for ( int nPaint = 0; nPaint < 300; ++nPaint )
+        {
+            CDirtyRegion dirty;
+            const int nRects = 1 + random.Next( 4 );
+
+            for ( int i = 0; i < nRects; ++i )
+            {
+                const SDirtyRect rect = GetRandomRect( random, frame.nWidth, frame.nHeight );
+                static const uint8 alphas[] = { 0, 0, 40, 128, 200, 255, 255 };
+                frame.Fill( rect, alphas[random.Next( 7 )] );
+                dirty.Add( rect );
+            }
+
+            coverage.Update( &frame.pixels[0], frame.nWidth, frame.nHeight, dirty );
+            TEST_CHECK( coverage.GetWidth() == frame.nWidth && coverage.GetHeight() == frame.nHeight );
+            nFailed += CountMismatches( coverage, frame, random );
+        }
+
+        TEST_CHECK( nFailed == 0 );
+    }
+
+    void TestPointAndRegion()
+    {
+        SFrame frame( 64, 64 );
+        frame.Fill( SDirtyRect( 10, 10, 20, 12 ), 255 );
+        frame.Fill( SDirtyRect( 40, 40, 41, 41 ), 90 );
+
+        CAlphaCoverage coverage;
+        TEST_CHECK( !coverage.IsRegionOpaque( SDirtyRect( 0, 0, 64, 64 ), 1 ) );
+        coverage.Update( &frame.pixels[0], 64, 64, CDirtyRegion() );
+
+        TEST_CHECK( coverage.IsOpaque( 10, 10, 255 ) && coverage.IsOpaque( 19, 11, 255 ) );
+        TEST_CHECK( !coverage.IsOpaque( 20, 11, 1 ) && !coverage.IsOpaque( 9, 10, 1 ) );
+        TEST_CHECK( coverage.IsOpaque( 0, 0, 0 ) );
+        TEST_CHECK( coverage.GetAlpha( 40, 40 ) == 90 && coverage.GetAlpha( -1, 5 ) == 0 && coverage.GetAlpha( 64, 5 ) == 0 );
+
+        // the single pixel is found inside a large region, but only with a threshold it reaches
+        TEST_CHECK( coverage.IsRegionOpaque( SDirtyRect( 30, 30, 64, 64 ), 90 ) );
+        TEST_CHECK( !coverage.IsRegionOpaque( SDirtyRect( 30, 30, 64, 64 ), 91 ) );
+        TEST_CHECK( !coverage.IsRegionOpaque( SDirtyRect( 41, 30, 64, 64 ), 1 ) );
+        TEST_CHECK( !coverage.IsRegionOpaque( SDirtyRect( 100, 100, 200, 200 ), 0 ) );
+
+        // a new size replaces everything, even with an empty dirty region
+        SFrame larger( 80, 20 );
+        larger.Fill( SDirtyRect( 70, 0, 80, 20 ), 255 );
+        coverage.Update( &larger.pixels[0], 80, 20, CDirtyRegion() );
+        TEST_CHECK( coverage.GetWidth() == 80 && coverage.GetHeight() == 20 );
+        TEST_CHECK( !coverage.IsOpaque( 10, 10, 1 ) && coverage.IsOpaque( 75, 19, 255 ) );
+    }
+
+    void TestQueriesDuringUpdates()
+    {
+        // the frame alternates between fully transparent and fully opaque, a query must see one or the other, never a mix
+        const int nWidth = 256;
+        const int nHeight = 128;
+        SFrame clear( nWidth, nHeight );
+        SFrame opaque( nWidth, nHeight );
+        opaque.Fill( SDirtyRect( 0, 0, nWidth, nHeight ), 255 );
+
+        CAlphaCoverage coverage;
+        coverage.Update( &clear.pixels[0], nWidth, nHeight, CDirtyRegion() );
+
+        std::atomic<bool> bDone( false );
+        std::atomic<int> nMixed( 0 );
+        std::atomic<int> nQueries( 0 );
+
+        std::thread reader( [&]()
+        {
+            while ( !bDone )
+            {
+                CTileMask tiles;
+                coverage.GetCoveredTiles( tiles, 1 );
+
+                int nSet = 0;
+
+                for ( int ty = 0; ty < tiles.GetTilesY(); ++ty )
+                {
+                    for ( int tx = 0; tx < tiles.GetTilesX(); ++tx )
+                    {
+                        nSet += tiles.Test( tx, ty ) ? 1 : 0;
+                    }
+                }
+
+                if ( nSet != 0 && nSet != tiles.GetTilesX() * tiles.GetTilesY() )
+                {
+                    ++nMixed;
+                }
+
+                ++nQueries;
+            }
+        } );
+
+        CDirtyRegion full;
+        full.Add( SDirtyRect( 0, 0, nWidth, nHeight ) );
+
+        for ( int i = 0; i < 2000; ++i )
+        {
+            const SFrame& frame = ( i & 1 ) ? clear : opaque;
+            coverage.Update( &frame.pixels[0], nWidth, nHeight, full );
+
+            if ( i % 16 == 0 )
+            {
+                std::this_thread::yield();
+            }
+        }
+
+        bDone = true;
+        reader.join();
+
+        printf( "concurrent: %d queries, %d mixed\n", nQueries.load(), nMixed.load() );
+        TEST_CHECK( nMixed == 0 );
+
+        // the last paint was the clear frame
+        TEST_CHECK( !coverage.IsRegionOpaque( SDirtyRect( 0, 0, nWidth, nHeight ), 1 ) );
+    }
+}
+
+int main()
+{
+    TestPointAndRegion();
+    TestIncrementalUpdates();
+    TestQueriesDuringUpdates();
+    return TEST_RESULT();
+}
@@ -0,0 +1,293 @@
+/* CryHTML5 - for licensing and copyright see license.txt */
+
+// Atlas packing under random churn: padded surfaces never overlap or leave their page, freed space is reclaimed by repacking and handles survive it.
+
+#include "StdAfx.h"
+#include "AtlasPacker.h"
+#include "TestCheck.h"
+
+using namespace HTML5Plugin;
+
+namespace
+{
+    /** @brief small deterministic generator so failures reproduce */
+    struct SRandom
+    {
+        uint32 nState;
+
+        explicit SRandom( uint32 nSeed )
+            : nState( nSeed )
+        {
+        }
+
+        int Next( int nRange )
+        {
+            nState = nState * 1664525u + 1013904223u;
+            return int( ( nState >> 8 ) % uint32( nRange ) );
+        }
+    };
+
+    enum
+    {
+        ePageSize = 1024,
+        eMaxPages = 4,
+        ePadding = 1,
+    };
+
+    /** @return area a surface takes on its page, padding included */
+    SDirtyRect GetPadded( const SAtlasEntry& entry )
+    {
+        return SDirtyRect( entry.rect.x, entry.rect.y, entry.rect.x2 + ePadding, entry.rect.y2 + ePadding );
+    }
+
+    /** @return number of placed surfaces that have the wrong size, leave their page or overlap another one */
+    int CheckLayout( CAtlasPacker& packer, const std::vector<CAtlasPacker::THandle>& handles )
+    {
+        const SDirtyRect page( 0, 0, ePageSize, ePageSize );
+        int nWrong = 0;
+
+        for ( size_t a = 0; a < handles.size(); ++a )
+        {
+            const SAtlasEntry* pA = packer.Get( handles[a] );
+
+            if ( !pA )
+            {
+                ++nWrong;
+                continue;
+            }
+
+            if ( !pA->bPlaced )
+            {
+                continue;
+            }
+
+            const SDirtyRect rect = GetPadded( *pA );
+            nWrong += pA->rect.x2 - pA->rect.x == pA->nWidth && pA->rect.y2 - pA->rect.y == pA->nHeight ? 0 : 1;
+            nWrong += page.Contains( rect ) && pA->nPage >= 0 && pA->nPage < packer.GetPageCount() ? 0 : 1;
+
+            for ( size_t b = a + 1; b < handles.size(); ++b )
+            {
+                const SAtlasEntry* pB = packer.Get( handles[b] );
+
+                if ( pB && pB->bPlaced && pB->nPage == pA->nPage && rect.Overlaps( GetPadded( *pB ) ) )
+                {
+                    ++nWrong;
+                }
+            }
+        }
+
+        return nWrong;
+    }
+
+    void TestChurn()
+    {
+        CAtlasPacker packer;
+        packer.Configure( ePageSize, eMaxPages, ePadding );
+
+        SRandom random( 7 );
+        std::vector<CAtlasPacker::THandle> live;
+        std::vector<CAtlasPacker::THandle> freed;
+        int nWrong = 0;
+        int nFailed = 0;
+
+        for ( int i = 0; i < 20000; ++i )
+        {
+            if ( live.empty() || random.Next( 3 ) )
+            {
+                const CAtlasPacker::THandle hEntry = packer.Allocate( 16 + random.Next( 240 ), 16 + random.Next( 96 ) );
+                nFailed += hEntry ? 0 : 1;
+
+                if ( hEntry )
+                {
+                    live.push_back( hEntry );
+                }
+            }
+
+            else
+            {
+                const size_t n = size_t( random.Next( int( live.size() ) ) );
+                packer.Free( live[n] );
+                freed.push_back( live[n] );
+                live[n] = live.back();
+                live.pop_back();
+            }
+
+            if ( i % 500 == 0 )
+            {
+                nWrong += CheckLayout( packer, live );
+            }
+        }
+
+        nWrong += CheckLayout( packer, live );
+        TEST_CHECK( nWrong == 0 );
+
+        // the churn filled the atlas and made it repack
+        const CAtlasPacker::SStats stats = packer.GetStats();
+        TEST_CHECK( nFailed > 0 && stats.nRepacks > 0 );
+        TEST_CHECK( stats.nEntries == live.size() && int( stats.nPages ) <= eMaxPages );
+
+        // freed handles stay invalid even though their slots are reused
+        int nValid = 0;
+
+        for ( size_t i = 0; i < freed.size(); ++i )
+        {
+            nValid += packer.Get( freed[i] ) ? 1 : 0;
+        }
+
+        TEST_CHECK( nValid == 0 );
+    }
+
+    void TestReclaim()
+    {
+        CAtlasPacker packer;
+        packer.Configure( 256, 1, ePadding );
+
+        // 15 x 15 padded cells of 17 pixels fill the page
+        std::vector<CAtlasPacker::THandle> handles;
+        CAtlasPacker::THandle hEntry;
+
+        while ( ( hEntry = packer.Allocate( 16, 16 ) ) != 0 )
+        {
+            handles.push_back( hEntry );
+        }
+
+        TEST_CHECK( handles.size() == 15 * 15 );
+        TEST_CHECK( packer.GetStats().nRepacks == 0 );
+
+        // the skyline can't reuse the holes, the repack on the next failed allocation does
+        std::vector<CAtlasPacker::THandle> kept;
+
+        for ( size_t i = 0; i < handles.size(); ++i )
+        {
+            if ( i % 2 )
+            {
+                packer.Free( handles[i] );
+            }
+
+            else
+            {
+                kept.push_back( handles[i] );
+            }
+        }
+
+        int nAllocated = 0;
+
+        while ( ( hEntry = packer.Allocate( 16, 16 ) ) != 0 )
+        {
+            kept.push_back( hEntry );
+            ++nAllocated;
+        }
+
+        TEST_CHECK( nAllocated == int( handles.size() - handles.size() / 2 ) - 1 );
+        TEST_CHECK( packer.GetStats().nRepacks == 1 );
+        TEST_CHECK( CheckLayout( packer, kept ) == 0 );
+
+        // nothing was freed since, a full atlas doesn't repack on every request
+        TEST_CHECK( !packer.Allocate( 16, 16 ) );
+        TEST_CHECK( packer.GetStats().nRepacks == 1 );
+        TEST_CHECK( packer.GetFragmentation() < 0.01f );
+    }
+
+    void TestRepackKeepsHandles()
+    {
+        CAtlasPacker packer;
+        packer.Configure( ePageSize, eMaxPages, ePadding );
+
+        SRandom random( 3 );
+        std::vector<CAtlasPacker::THandle> handles;
+
+        for ( int i = 0; i < 200; ++i )
+        {
+            handles.push_back( packer.Allocate( 8 + random.Next( 200 ), 8 + random.Next( 120 ) ) );
+        }
+
+        std::vector<CAtlasPacker::THandle> live;
+
+        for ( size_t i = 0; i < handles.size(); ++i )
+        {
+            if ( random.Next( 3 ) == 0 )
+            {
+                packer.Free( handles[i] );
+            }
+
+            else
+            {
+                live.push_back( handles[i] );
+            }
+        }
+
+        std::vector<SAtlasEntry> before;
+
+        for ( size_t i = 0; i < live.size(); ++i )
+        {
+            before.push_back( *packer.Get( live[i] ) );
+        }
+
+        packer.Repack();
+
+        // every live handle still resolves, surfaces that moved have to be uploaded again and the others don't
+        int nWrong = 0;
+        uint32 nMoved = 0;
+
+        for ( size_t i = 0; i < live.size(); ++i )
+        {
+            const SAtlasEntry* pEntry = packer.Get( live[i] );
+
+            if ( !pEntry || !pEntry->bPlaced || pEntry->nWidth != before[i].nWidth || pEntry->nHeight != before[i].nHeight )
+            {
+                ++nWrong;
+                continue;
+            }
+
+            const bool bMoved = pEntry->nPage != before[i].nPage || pEntry->rect.x != before[i].rect.x || pEntry->rect.y != before[i].rect.y;
+            nWrong += pEntry->nVersion == before[i].nVersion + ( bMoved ? 1 : 0 ) ? 0 : 1;
+            nMoved += bMoved ? 1 : 0;
+        }
+
+        TEST_CHECK( nWrong == 0 );
+        TEST_CHECK( nMoved > 0 && packer.GetStats().nMoves == nMoved && packer.GetStats().nRepacks == 1 );
+        TEST_CHECK( CheckLayout( packer, live ) == 0 );
+
+        // repacking again places everything the same way
+        packer.Repack();
+        TEST_CHECK( packer.GetStats().nMoves == nMoved );
+    }
+
+    void TestConfigure()
+    {
+        CAtlasPacker packer;
+        TEST_CHECK( !packer.Allocate( 16, 16 ) );
+
+        packer.Configure( 512, 2, ePadding );
+        TEST_CHECK( packer.CanPack( 511, 511 ) && !packer.CanPack( 512, 16 ) && !packer.CanPack( 0, 16 ) );
+        TEST_CHECK( !packer.Allocate( 600, 10 ) );
+
+        const CAtlasPacker::THandle hEntry = packer.Allocate( 100, 50 );
+        TEST_CHECK( packer.Get( hEntry ) );
+
+        // the same layout keeps the surfaces, a different one invalidates them
+        packer.Configure( 512, 2, ePadding );
+        TEST_CHECK( packer.Get( hEntry ) );
+
+        packer.Configure( 512, 2, 2 );
+        TEST_CHECK( !packer.Get( hEntry ) && packer.GetPageCount() == 0 );
+
+        // surface rects map into the page and are clipped to the surface
+        SAtlasEntry entry;
+        entry.nWidth = 100;
+        entry.nHeight = 50;
+        entry.rect = SDirtyRect( 10, 20, 110, 70 );
+
+        const SDirtyRect mapped = entry.ToPage( SDirtyRect( 90, 40, 200, 60 ) );
+        TEST_CHECK( mapped.x == 100 && mapped.y == 60 && mapped.x2 == 110 && mapped.y2 == 70 );
+    }
+}
+
+int main()
+{
+    TestChurn();
+    TestReclaim();
+    TestRepackKeepsHandles();
+    TestConfigure();
+    return TEST_RESULT();
+}
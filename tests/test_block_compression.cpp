@@ -0,0 +1,329 @@
+/* CryHTML5 - for licensing and copyright see license.txt */
+
+// BC3 encoding decoded again like the hardware does: solid, gradient and edge blocks stay within their error bounds, surfaces keep their layout.
+
+#include "StdAfx.h"
+#include "BlockCompression.h"
+#include "TestCheck.h"
+
+using namespace HTML5Plugin;
+
+namespace
+{
+    /** @brief small deterministic generator so failures reproduce */
+    struct SRandom
+    {
+        uint32 nState;
+
+        explicit SRandom( uint32 nSeed )
+            : nState( nSeed )
+        {
+        }
+
+        int Next( int nRange )
+        {
+            nState = nState * 1664525u + 1013904223u;
+            return int( ( nState >> 8 ) % uint32( nRange ) );
+        }
+    };
+
+    /** @brief expand a 5:6:5 color to 8 bit channels */
+    void Unpack565( uint16 nPacked, int color[3] )
+    {
+        const int r = ( nPacked >> 11 ) & 31;
+        const int g = ( nPacked >> 5 ) & 63;
+        const int b = nPacked & 31;
+
+        color[0] = ( r << 3 ) | ( r >> 2 );
+        color[1] = ( g << 2 ) | ( g >> 4 );
+        color[2] = ( b << 3 ) | ( b >> 2 );
+    }
+
+    /** @brief reference BC3 decoder following the Direct3D block layout, writes 4x4 pixels with a pitch of 16 bytes */
+    void DecodeBC3Block( const uint8* pBlock, uint8 pixels[16][4] )
+    {
+        // alpha: two endpoints, 8 levels when a0 > a1, else 6 levels plus 0 and 255
+        const int a0 = pBlock[0];
+        const int a1 = pBlock[1];
+        int alpha[8] = { a0, a1 };
+
+        if ( a0 > a1 )
+        {
+            for ( int i = 1; i < 7; ++i )
+            {
+                alpha[i + 1] = ( ( 7 - i ) * a0 + i * a1 ) / 7;
+            }
+        }
+
+        else
+        {
+            for ( int i = 1; i < 5; ++i )
+            {
+                alpha[i + 1] = ( ( 5 - i ) * a0 + i * a1 ) / 5;
+            }
+
+            alpha[6] = 0;
+            alpha[7] = 255;
+        }
+
+        uint64 nAlphaBits = 0;
+
+        for ( int i = 0; i < 6; ++i )
+        {
+            nAlphaBits |= uint64( pBlock[2 + i] ) << ( i * 8 );
+        }
+
+        // color: the color block of BC3 always decodes in the 4 color mode
+        int colors[4][3];
+        Unpack565( uint16( pBlock[8] | ( pBlock[9] << 8 ) ), colors[0] );
+        Unpack565( uint16( pBlock[10] | ( pBlock[11] << 8 ) ), colors[1] );
+
+        for ( int c = 0; c < 3; ++c )
+        {
+            colors[2][c] = ( 2 * colors[0][c] + colors[1][c] ) / 3;
+            colors[3][c] = ( colors[0][c] + 2 * colors[1][c] ) / 3;
+        }
+
+        const uint32 nColorBits = pBlock[12] | ( pBlock[13] << 8 ) | ( pBlock[14] << 16 ) | ( uint32( pBlock[15] ) << 24 );
+
+        for ( int i = 0; i < 16; ++i )
+        {
+            const int* pColor = colors[( nColorBits >> ( i * 2 ) ) & 3];
+            pixels[i][0] = uint8( pColor[0] );
+            pixels[i][1] = uint8( pColor[1] );
+            pixels[i][2] = uint8( pColor[2] );
+            pixels[i][3] = uint8( alpha[( nAlphaBits >> ( i * 3 ) ) & 7] );
+        }
+    }
+
+    /** @brief encode and decode one block */
+    void RoundTrip( const uint8 source[16][4], uint8 decoded[16][4] )
+    {
+        uint8 block[eBC3BlockBytes];
+        EncodeBC3Block( &source[0][0], 16, block );
+        DecodeBC3Block( block, decoded );
+    }
+
+    /** @return largest difference of a channel over the visible pixels (all pixels for the alpha channel) */
+    int GetMaxError( const uint8 source[16][4], const uint8 decoded[16][4], int nChannel )
+    {
+        int nError = 0;
+
+        for ( int i = 0; i < 16; ++i )
+        {
+            if ( nChannel == 3 || source[i][3] != 0 )
+            {
+                nError = max( nError, abs( int( source[i][nChannel] ) - int( decoded[i][nChannel] ) ) );
+            }
+        }
+
+        return nError;
+    }
+
+    /** @return difference between the largest and smallest value of a channel over the visible pixels */
+    int GetRange( const uint8 source[16][4], int nChannel )
+    {
+        int nMin = 255;
+        int nMax = 0;
+
+        for ( int i = 0; i < 16; ++i )
+        {
+            if ( nChannel == 3 || source[i][3] != 0 )
+            {
+                nMin = min( nMin, int( source[i][nChannel] ) );
+                nMax = max( nMax, int( source[i][nChannel] ) );
+            }
+        }
+
+        return nMax >= nMin ? nMax - nMin : 0;
+    }
+
+    void TestSolidBlocks()
+    {
+        SRandom random( 11 );
+        int nFailed = 0;
+
+        for ( int nRun = 0; nRun < 1000; ++nRun )
+        {
+            uint8 source[16][4];
+            const uint8 color[4] = { uint8( random.Next( 256 ) ), uint8( random.Next( 256 ) ), uint8( random.Next( 256 ) ), uint8( 1 + random.Next( 255 ) ) };
+
+            for ( int i = 0; i < 16; ++i )
+            {
+                memcpy( source[i], color, 4 );
+            }
+
+            uint8 decoded[16][4];
+            RoundTrip( source, decoded );
+
+            // only the 5:6:5 truncation is lost, alpha is exact
+            const bool bOk = GetMaxError( source, decoded, 0 ) <= 7 && GetMaxError( source, decoded, 1 ) <= 3 && GetMaxError( source, decoded, 2 ) <= 7
+                             && GetMaxError( source, decoded, 3 ) == 0;
+            nFailed += bOk ? 0 : 1;
+        }
+
+        TEST_CHECK( nFailed == 0 );
+    }
+
+    void TestGradientBlocks()
+    {
+        SRandom random( 23 );
+        int nFailed = 0;
+
+        for ( int nRun = 0; nRun < 2000; ++nRun )
+        {
+            // pixels on a line between two colors, like the gradients and anti aliased edges of a UI
+            int from[4], to[4];
+
+            for ( int c = 0; c < 4; ++c )
+            {
+                from[c] = random.Next( 256 );
+                to[c] = random.Next( 256 );
+            }
+
+            uint8 source[16][4];
+
+            for ( int i = 0; i < 16; ++i )
+            {
+                const int t = random.Next( 16 );
+
+                for ( int c = 0; c < 4; ++c )
+                {
+                    source[i][c] = uint8( from[c] + ( to[c] - from[c] ) * t / 15 );
+                }
+
+                source[i][3] = max( source[i][3], uint8( 1 ) );
+            }
+
+            uint8 decoded[16][4];
+            RoundTrip( source, decoded );
+
+            // color: half a step of the 3 intervals, the 1/16 inset and the 5:6:5 truncation
+            bool bOk = true;
+
+            for ( int c = 0; c < 3; ++c )
+            {
+                const int nRange = GetRange( source, c );
+                bOk = bOk && GetMaxError( source, decoded, c ) <= nRange / 6 + nRange / 16 + 8;
+            }
+
+            // alpha: half a step of the 7 intervals
+            bOk = bOk && GetMaxError( source, decoded, 3 ) <= GetRange( source, 3 ) / 14 + 1;
+
+            nFailed += bOk ? 0 : 1;
+        }
+
+        TEST_CHECK( nFailed == 0 );
+    }
+
+    void TestTransparentPixels()
+    {
+        // a widget edge: transparent pixels keep alpha 0 exactly and don't pull the colors of the visible ones
+        uint8 source[16][4];
+
+        for ( int i = 0; i < 16; ++i )
+        {
+            const bool bVisible = ( i % 4 ) >= 2;
+            source[i][0] = bVisible ? 200 : 0;
+            source[i][1] = bVisible ? 100 : 255;
+            source[i][2] = bVisible ? 50 : 0;
+            source[i][3] = bVisible ? 255 : 0;
+        }
+
+        uint8 decoded[16][4];
+        RoundTrip( source, decoded );
+
+        bool bAlphaExact = true;
+
+        for ( int i = 0; i < 16; ++i )
+        {
+            bAlphaExact = bAlphaExact && decoded[i][3] == source[i][3];
+        }
+
+        TEST_CHECK( bAlphaExact );
+        TEST_CHECK( GetMaxError( source, decoded, 0 ) <= 7 && GetMaxError( source, decoded, 1 ) <= 3 && GetMaxError( source, decoded, 2 ) <= 7 );
+
+        // nothing visible at all
+        memset( source, 0, sizeof( source ) );
+        RoundTrip( source, decoded );
+        TEST_CHECK( GetMaxError( source, decoded, 3 ) == 0 );
+    }
+
+    void TestSurfaceLayout()
+    {
+        // 10x7 leaves partial blocks on the right and bottom
+        const int nWidth = 10;
+        const int nHeight = 7;
+        const int nPitch = nWidth * 4 + 8;
+        SRandom random( 5 );
+
+        std::vector<uint8> surface( nPitch * nHeight, 0xCD );
+
+        for ( int y = 0; y < nHeight; ++y )
+        {
+            for ( int x = 0; x < nWidth; ++x )
+            {
+                // one solid color per block, so every decoded pixel can be told apart
+                uint8* pPixel = &surface[y * nPitch + x * 4];
+                pPixel[0] = uint8( ( x / 4 ) * 100 );
+                pPixel[1] = uint8( ( y / 4 ) * 200 );
+                pPixel[2] = uint8( 40 + random.Next( 2 ) );
+                pPixel[3] = 255;
+            }
+        }
+
+        const size_t nSize = GetBC3Size( nWidth, nHeight );
+        TEST_CHECK( nSize == size_t( 3 * 2 * eBC3BlockBytes ) );
+
+        // a guard behind the blocks catches writes past the end
+        std::vector<uint8> blocks( nSize + 16, 0xEE );
+        EncodeBC3( &surface[0], nWidth, nHeight, nPitch, &blocks[0] );
+
+        bool bGuard = true;
+
+        for ( size_t i = nSize; i < blocks.size(); ++i )
+        {
+            bGuard = bGuard && blocks[i] == 0xEE;
+        }
+
+        TEST_CHECK( bGuard );
+
+        bool bOk = true;
+
+        for ( int by = 0; by < 2; ++by )
+        {
+            for ( int bx = 0; bx < 3; ++bx )
+            {
+                uint8 decoded[16][4];
+                DecodeBC3Block( &blocks[( by * 3 + bx ) * eBC3BlockBytes], decoded );
+
+                for ( int i = 0; i < 16; ++i )
+                {
+                    // pixels over the edge repeat the last row and column, so they decode like the pixel they copy
+                    const int x = min( bx * 4 + i % 4, nWidth - 1 );
+                    const int y = min( by * 4 + i / 4, nHeight - 1 );
+                    const uint8* pPixel = &surface[y * nPitch + x * 4];
+
+                    bOk = bOk && abs( decoded[i][0] - pPixel[0] ) <= 7 && abs( decoded[i][1] - pPixel[1] ) <= 3 && abs( decoded[i][2] - pPixel[2] ) <= 7
+                          && decoded[i][3] == 255;
+                }
+            }
+        }
+
+        TEST_CHECK( bOk );
+
+        // whole blocks are the same as encoding them one by one
+        uint8 single[eBC3BlockBytes];
+        EncodeBC3Block( &surface[4 * 4], nPitch, single );
+        TEST_CHECK( memcmp( single, &blocks[eBC3BlockBytes], eBC3BlockBytes ) == 0 );
+    }
+}
+
+int main()
+{
+    TestSolidBlocks();
+    TestGradientBlocks();
+    TestTransparentPixels();
+    TestSurfaceLayout();
+    return TEST_RESULT();
+}
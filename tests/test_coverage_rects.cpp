@@ -0,0 +1,192 @@
+/* CryHTML5 - for licensing and copyright see license.txt */
+
+// Covered tile masks to blend rects: random masks against the pixels they cover, vertical merging and the fullscreen fallback thresholds.
+
+#include "StdAfx.h"
+#include "CoverageRects.h"
+#include "TestCheck.h"
+
+using namespace HTML5Plugin;
+
+namespace
+{
+    /** @brief small deterministic generator so failures reproduce */
+    struct SRandom
+    {
+        uint32 nState;
+
+        explicit SRandom( uint32 nSeed )
+            : nState( nSeed )
+        {
+        }
+
+        int Next( int nRange )
+        {
+            nState = nState * 1664525u + 1013904223u;
+            return int( ( nState >> 8 ) % uint32( nRange ) );
+        }
+    };
+
+    /** @brief the rects are disjoint, inside the surface and cover exactly the pixels of the set tiles */
+    bool CheckRects( const CCoverageRects& coverage, const CTileMask& mask, int nWidth, int nHeight, int nTileSize )
+    {
+        const std::vector<SDirtyRect>& rects = coverage.GetRects();
+        std::vector<uint8> covered( size_t( nWidth ) * nHeight, 0 );
+        bool bOk = true;
+        int nArea = 0;
+
+        for ( size_t i = 0; i < rects.size(); ++i )
+        {
+            const SDirtyRect& rect = rects[i];
+            bOk = bOk && !rect.IsEmpty() && rect.x >= 0 && rect.y >= 0 && rect.x2 <= nWidth && rect.y2 <= nHeight;
+            nArea += rect.GetArea();
+
+            for ( int y = max( rect.y, 0 ); y < min( rect.y2, nHeight ); ++y )
+            {
+                for ( int x = max( rect.x, 0 ); x < min( rect.x2, nWidth ); ++x )
+                {
+                    bOk = bOk && !covered[y * nWidth + x];
+                    covered[y * nWidth + x] = 1;
+                }
+            }
+        }
+
+        for ( int y = 0; y < nHeight; ++y )
+        {
+            for ( int x = 0; x < nWidth; ++x )
+            {
+                bOk = bOk && ( covered[y * nWidth + x] != 0 ) == mask.Test( x / nTileSize, y / nTileSize );
+            }
+        }
+
+        return bOk && nArea == coverage.GetArea();
+    }
+
+    void TestRandomMasks()
+    {
+        SRandom random( 777 );
+        CCoverageRects coverage;
+        int nFailed = 0;
+
+        for ( int nRun = 0; nRun < 200; ++nRun )
+        {
+            // sizes that leave partial tiles at the right and bottom now and then
+            const int nTileSize = 4 << random.Next( 3 );
+            const int nWidth = 1 + random.Next( 200 );
+            const int nHeight = 1 + random.Next( 120 );
+            const int nDensity = 1 + random.Next( 8 );
+
+            CTileMask mask;
+            mask.Configure( nWidth, nHeight, nTileSize );
+
+            for ( int ty = 0; ty < mask.GetTilesY(); ++ty )
+            {
+                for ( int tx = 0; tx < mask.GetTilesX(); ++tx )
+                {
+                    if ( random.Next( 8 ) < nDensity )
+                    {
+                        mask.Set( tx, ty );
+                    }
+                }
+            }
+
+            coverage.Build( mask, 1 << 20, 1.0f );
+
+            if ( !CheckRects( coverage, mask, nWidth, nHeight, nTileSize ) )
+            {
+                ++nFailed;
+            }
+        }
+
+        TEST_CHECK( nFailed == 0 );
+    }
+
+    void TestVerticalMerge()
+    {
+        CTileMask mask;
+        mask.Configure( 128, 128, 16 );
+
+        // a 3x4 tile panel becomes one rect
+        for ( int ty = 2; ty < 6; ++ty )
+        {
+            for ( int tx = 1; tx < 4; ++tx )
+            {
+                mask.Set( tx, ty );
+            }
+        }
+
+        CCoverageRects coverage;
+        TEST_CHECK( coverage.Build( mask, 16, 1.0f ) );
+        TEST_CHECK( coverage.GetRects().size() == 1 );
+        TEST_CHECK( coverage.GetRects().size() == 1 && coverage.GetRects()[0].x == 16 && coverage.GetRects()[0].y == 32
+                    && coverage.GetRects()[0].x2 == 64 && coverage.GetRects()[0].y2 == 96 );
+        TEST_CHECK( coverage.GetArea() == 48 * 64 );
+
+        // rows of a different extent below start a rect of their own
+        mask.Set( 1, 6 );
+        coverage.Build( mask, 16, 1.0f );
+        TEST_CHECK( coverage.GetRects().size() == 2 );
+        TEST_CHECK( CheckRects( coverage, mask, 128, 128, 16 ) );
+    }
+
+    void TestSideBySideColumns()
+    {
+        // two columns next to each other in every row stay two rects and keep merging downwards
+        CTileMask mask;
+        mask.Configure( 64, 64, 8 );
+
+        for ( int ty = 0; ty < 8; ++ty )
+        {
+            mask.Set( 0, ty );
+            mask.Set( 5, ty );
+            mask.Set( 6, ty );
+        }
+
+        CCoverageRects coverage;
+        coverage.Build( mask, 16, 1.0f );
+        TEST_CHECK( coverage.GetRects().size() == 2 );
+        TEST_CHECK( CheckRects( coverage, mask, 64, 64, 8 ) );
+    }
+
+    void TestFallback()
+    {
+        CTileMask mask;
+        mask.Configure( 100, 100, 10 );
+
+        CCoverageRects coverage;
+
+        // nothing covered: nothing to draw, the rect path is still the cheaper one
+        TEST_CHECK( coverage.Build( mask, 4, 0.5f ) );
+        TEST_CHECK( coverage.GetRects().empty() && coverage.GetArea() == 0 );
+
+        // a checkerboard needs too many rects
+        for ( int ty = 0; ty < 10; ++ty )
+        {
+            for ( int tx = ty % 2; tx < 10; tx += 2 )
+            {
+                mask.Set( tx, ty );
+            }
+        }
+
+        TEST_CHECK( !coverage.Build( mask, 4, 1.0f ) );
+        TEST_CHECK( coverage.Build( mask, 100, 1.0f ) );
+
+        // half the surface covered is over a 40% limit
+        TEST_CHECK( coverage.GetArea() == 5000 );
+        TEST_CHECK( !coverage.Build( mask, 100, 0.4f ) );
+        TEST_CHECK( coverage.Build( mask, 100, 0.5f ) );
+
+        // an unconfigured mask has no surface to draw
+        CTileMask empty;
+        TEST_CHECK( !coverage.Build( empty, 4, 1.0f ) );
+    }
+}
+
+int main()
+{
+    TestVerticalMerge();
+    TestSideBySideColumns();
+    TestFallback();
+    TestRandomMasks();
+    return TEST_RESULT();
+}
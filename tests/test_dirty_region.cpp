@@ -0,0 +1,179 @@
+/* CryHTML5 - for licensing and copyright see license.txt */
+
+// Random rect sequences against a pixel mask: rects stay disjoint, cover every dirty pixel and never exceed eMaxRects.
+
+#include "StdAfx.h"
+#include "DirtyRegion.h"
+#include "TestCheck.h"
+
+using namespace HTML5Plugin;
+
+namespace
+{
+    enum
+    {
+        eSize = 256,
+    };
+
+    /** @brief small deterministic generator so failures reproduce */
+    struct SRandom
+    {
+        uint32 nState;
+
+        explicit SRandom( uint32 nSeed )
+            : nState( nSeed )
+        {
+        }
+
+        int Next( int nRange )
+        {
+            nState = nState * 1664525u + 1013904223u;
+            return int( ( nState >> 8 ) % uint32( nRange ) );
+        }
+    };
+
+    /** @brief check the region invariants against the pixels that were marked dirty */
+    bool CheckRegion( const CDirtyRegion& region, const std::vector<uint8>& dirty )
+    {
+        bool bOk = region.GetCount() <= CDirtyRegion::eMaxRects;
+
+        for ( int i = 0; i < region.GetCount(); ++i )
+        {
+            bOk = bOk && !region[i].IsEmpty();
+
+            for ( int j = i + 1; j < region.GetCount(); ++j )
+            {
+                bOk = bOk && !region[i].Overlaps( region[j] );
+            }
+        }
+
+        // every dirty pixel is covered by a rect
+        std::vector<uint8> covered( dirty.size(), 0 );
+
+        for ( int i = 0; i < region.GetCount(); ++i )
+        {
+            const SDirtyRect& rect = region[i];
+
+            for ( int y = max( rect.y, 0 ); y < min( rect.y2, int( eSize ) ); ++y )
+            {
+                for ( int x = max( rect.x, 0 ); x < min( rect.x2, int( eSize ) ); ++x )
+                {
+                    covered[y * eSize + x] = 1;
+                }
+            }
+        }
+
+        for ( size_t i = 0; i < dirty.size(); ++i )
+        {
+            bOk = bOk && ( !dirty[i] || covered[i] );
+        }
+
+        return bOk;
+    }
+
+    void TestRandomSequences()
+    {
+        SRandom random( 12345 );
+        int nFailed = 0;
+
+        for ( int nRun = 0; nRun < 300; ++nRun )
+        {
+            CDirtyRegion region;
+            std::vector<uint8> dirty( eSize * eSize, 0 );
+            const int nRects = 1 + random.Next( 40 );
+
+            for ( int i = 0; i < nRects; ++i )
+            {
+                // mostly small widgets, now and then a large panel
+                const int nMax = random.Next( 8 ) == 0 ? 160 : 24;
+                const int x = random.Next( eSize );
+                const int y = random.Next( eSize );
+                SDirtyRect rect( x, y, x + 1 + random.Next( nMax ), y + 1 + random.Next( nMax ) );
+                rect.Clip( eSize, eSize );
+
+                region.Add( rect );
+
+                for ( int py = rect.y; py < rect.y2; ++py )
+                {
+                    for ( int px = rect.x; px < rect.x2; ++px )
+                    {
+                        dirty[py * eSize + px] = 1;
+                    }
+                }
+
+                if ( !CheckRegion( region, dirty ) )
+                {
+                    ++nFailed;
+                }
+            }
+        }
+
+        TEST_CHECK( nFailed == 0 );
+    }
+
+    void TestDistantRectsStaySeparate()
+    {
+        // a blinking cursor in one corner and a spinner in the other must not upload the whole surface
+        CDirtyRegion region;
+        region.Add( SDirtyRect( 2, 2, 4, 20 ) );
+        region.Add( SDirtyRect( 1000, 1000, 1016, 1016 ) );
+
+        TEST_CHECK( region.GetCount() == 2 );
+        TEST_CHECK( region.GetArea() == 2 * 18 + 16 * 16 );
+    }
+
+    void TestNearbyRectsMerge()
+    {
+        // the bounding box wastes fewer pixels than an extra call is worth
+        CDirtyRegion region;
+        region.Add( SDirtyRect( 0, 0, 10, 10 ) );
+        region.Add( SDirtyRect( 12, 0, 22, 10 ) );
+
+        TEST_CHECK( region.GetCount() == 1 );
+        TEST_CHECK( region.GetBounds().Contains( SDirtyRect( 0, 0, 22, 10 ) ) );
+    }
+
+    void TestContainedAndOverlapping()
+    {
+        CDirtyRegion region;
+        region.SetCallCost( 0 );
+        region.Add( SDirtyRect( 0, 0, 100, 100 ) );
+        region.Add( SDirtyRect( 10, 10, 20, 20 ) );
+
+        TEST_CHECK( region.GetCount() == 1 );
+        TEST_CHECK( region.GetArea() == 100 * 100 );
+
+        // an overlapping rect only adds the pixels not covered yet
+        region.Add( SDirtyRect( 50, 50, 150, 100 ) );
+        TEST_CHECK( region.GetArea() == 100 * 100 + 50 * 50 );
+    }
+
+    void TestClipAndAddRegion()
+    {
+        CDirtyRegion a;
+        a.Add( SDirtyRect( -10, -10, 10, 10 ) );
+        a.Add( SDirtyRect( 500, 500, 600, 600 ) );
+        a.Clip( 256, 256 );
+
+        TEST_CHECK( a.GetCount() == 1 );
+        TEST_CHECK( a.GetArea() == 100 );
+
+        CDirtyRegion b;
+        b.Add( SDirtyRect( 200, 200, 210, 210 ) );
+        b.Add( a );
+        TEST_CHECK( b.GetArea() == 200 );
+
+        b.Reset();
+        TEST_CHECK( b.IsEmpty() );
+    }
+}
+
+int main()
+{
+    TestDistantRectsStaySeparate();
+    TestNearbyRectsMerge();
+    TestContainedAndOverlapping();
+    TestClipAndAddRegion();
+    TestRandomSequences();
+    return TEST_RESULT();
+}
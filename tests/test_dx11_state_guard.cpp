@@ -0,0 +1,437 @@
+/* CryHTML5 - for licensing and copyright see license.txt */
+
+// The minimal DX11 state guard against a mock context: every slot a UI draw changes is restored, every reference it takes is released
+// and the calls it reports are the ones the context received.
+
+#include "StdAfx.h"
+
+// just enough of the Direct3D 11 declarations for the guard, the objects count their references
+typedef float FLOAT;
+typedef unsigned int UINT;
+
+enum DXGI_FORMAT
+{
+    DXGI_FORMAT_UNKNOWN = 0,
+    DXGI_FORMAT_R32_UINT = 42,
+    DXGI_FORMAT_R16_UINT = 57,
+};
+
+enum D3D11_PRIMITIVE_TOPOLOGY
+{
+    D3D11_PRIMITIVE_TOPOLOGY_UNDEFINED = 0,
+    D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST = 4,
+    D3D11_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP = 5,
+};
+
+struct SMockObject
+{
+    static int s_nReleases; //!< Release calls on all objects
+
+    int nRefs;
+
+    SMockObject()
+        : nRefs( 1 )
+    {
+    }
+
+    void AddRef()
+    {
+        ++nRefs;
+    }
+
+    void Release()
+    {
+        --nRefs;
+        ++s_nReleases;
+    }
+};
+
+int SMockObject::s_nReleases = 0;
+
+struct ID3D11BlendState : SMockObject {};
+struct ID3D11VertexShader : SMockObject {};
+struct ID3D11PixelShader : SMockObject {};
+struct ID3D11SamplerState : SMockObject {};
+struct ID3D11ShaderResourceView : SMockObject {};
+struct ID3D11InputLayout : SMockObject {};
+struct ID3D11Buffer : SMockObject {};
+struct ID3D11ClassInstance;
+struct ID3D11DeviceContext;
+
+#include "DX11MinimalStateGuard.h"
+#include "TestCheck.h"
+
+using namespace HTML5Plugin;
+
+namespace
+{
+    /** @brief holds one reference to what is bound, the getters add one for the caller like Direct3D does, counts the calls it receives */
+    class CMockContext
+    {
+        public:
+            CMockContext()
+                : m_nGets( 0 )
+                , m_nSets( 0 )
+                , m_pBlendState( nullptr )
+                , m_SampleMask( 0xFFFFFFFF )
+                , m_Topology( D3D11_PRIMITIVE_TOPOLOGY_UNDEFINED )
+                , m_pIndexBuffer( nullptr )
+                , m_IndexFormat( DXGI_FORMAT_UNKNOWN )
+                , m_IndexOffset( 0 )
+                , m_pInputLayout( nullptr )
+                , m_pVertexBuffer( nullptr )
+                , m_VertexStride( 0 )
+                , m_VertexOffset( 0 )
+                , m_pVertexShader( nullptr )
+                , m_pPixelShader( nullptr )
+                , m_pSampler( nullptr )
+                , m_pResource( nullptr )
+            {
+                m_BlendFactor[0] = m_BlendFactor[1] = m_BlendFactor[2] = m_BlendFactor[3] = 1.0f;
+            }
+
+            void OMGetBlendState( ID3D11BlendState** ppState, FLOAT factor[4], UINT* pMask )
+            {
+                ++m_nGets;
+                *ppState = Get( m_pBlendState );
+                memcpy( factor, m_BlendFactor, sizeof( m_BlendFactor ) );
+                *pMask = m_SampleMask;
+            }
+
+            void OMSetBlendState( ID3D11BlendState* pState, const FLOAT factor[4], UINT nMask )
+            {
+                ++m_nSets;
+                Set( m_pBlendState, pState );
+                memcpy( m_BlendFactor, factor, sizeof( m_BlendFactor ) );
+                m_SampleMask = nMask;
+            }
+
+            void IAGetPrimitiveTopology( D3D11_PRIMITIVE_TOPOLOGY* pTopology )
+            {
+                ++m_nGets;
+                *pTopology = m_Topology;
+            }
+
+            void IASetPrimitiveTopology( D3D11_PRIMITIVE_TOPOLOGY topology )
+            {
+                ++m_nSets;
+                m_Topology = topology;
+            }
+
+            void IAGetIndexBuffer( ID3D11Buffer** ppBuffer, DXGI_FORMAT* pFormat, UINT* pOffset )
+            {
+                ++m_nGets;
+                *ppBuffer = Get( m_pIndexBuffer );
+                *pFormat = m_IndexFormat;
+                *pOffset = m_IndexOffset;
+            }
+
+            void IASetIndexBuffer( ID3D11Buffer* pBuffer, DXGI_FORMAT format, UINT nOffset )
+            {
+                ++m_nSets;
+                Set( m_pIndexBuffer, pBuffer );
+                m_IndexFormat = format;
+                m_IndexOffset = nOffset;
+            }
+
+            void IAGetInputLayout( ID3D11InputLayout** ppLayout )
+            {
+                ++m_nGets;
+                *ppLayout = Get( m_pInputLayout );
+            }
+
+            void IASetInputLayout( ID3D11InputLayout* pLayout )
+            {
+                ++m_nSets;
+                Set( m_pInputLayout, pLayout );
+            }
+
+            void IAGetVertexBuffers( UINT nSlot, UINT nCount, ID3D11Buffer** ppBuffer, UINT* pStride, UINT* pOffset )
+            {
+                ++m_nGets;
+                TEST_CHECK( nSlot == 0 && nCount == 1 );
+                *ppBuffer = Get( m_pVertexBuffer );
+                *pStride = m_VertexStride;
+                *pOffset = m_VertexOffset;
+            }
+
+            void IASetVertexBuffers( UINT nSlot, UINT nCount, ID3D11Buffer* const* ppBuffer, const UINT* pStride, const UINT* pOffset )
+            {
+                ++m_nSets;
+                TEST_CHECK( nSlot == 0 && nCount == 1 );
+                Set( m_pVertexBuffer, *ppBuffer );
+                m_VertexStride = *pStride;
+                m_VertexOffset = *pOffset;
+            }
+
+            void VSGetShader( ID3D11VertexShader** ppShader, ID3D11ClassInstance** /*ppInstances*/, UINT* /*pCount*/ )
+            {
+                ++m_nGets;
+                *ppShader = Get( m_pVertexShader );
+            }
+
+            void VSSetShader( ID3D11VertexShader* pShader, ID3D11ClassInstance* const* /*ppInstances*/, UINT /*nCount*/ )
+            {
+                ++m_nSets;
+                Set( m_pVertexShader, pShader );
+            }
+
+            void PSGetShader( ID3D11PixelShader** ppShader, ID3D11ClassInstance** /*ppInstances*/, UINT* /*pCount*/ )
+            {
+                ++m_nGets;
+                *ppShader = Get( m_pPixelShader );
+            }
+
+            void PSSetShader( ID3D11PixelShader* pShader, ID3D11ClassInstance* const* /*ppInstances*/, UINT /*nCount*/ )
+            {
+                ++m_nSets;
+                Set( m_pPixelShader, pShader );
+            }
+
+            void PSGetSamplers( UINT nSlot, UINT nCount, ID3D11SamplerState** ppSampler )
+            {
+                ++m_nGets;
+                TEST_CHECK( nSlot == 0 && nCount == 1 );
+                *ppSampler = Get( m_pSampler );
+            }
+
+            void PSSetSamplers( UINT nSlot, UINT nCount, ID3D11SamplerState* const* ppSampler )
+            {
+                ++m_nSets;
+                TEST_CHECK( nSlot == 0 && nCount == 1 );
+                Set( m_pSampler, *ppSampler );
+            }
+
+            void PSGetShaderResources( UINT nSlot, UINT nCount, ID3D11ShaderResourceView** ppResource )
+            {
+                ++m_nGets;
+                TEST_CHECK( nSlot == 0 && nCount == 1 );
+                *ppResource = Get( m_pResource );
+            }
+
+            void PSSetShaderResources( UINT nSlot, UINT nCount, ID3D11ShaderResourceView* const* ppResource )
+            {
+                ++m_nSets;
+                TEST_CHECK( nSlot == 0 && nCount == 1 );
+                Set( m_pResource, *ppResource );
+            }
+
+            int m_nGets; //!< Get* calls received
+            int m_nSets; //!< Set* calls received
+
+            ID3D11BlendState* m_pBlendState;
+            FLOAT m_BlendFactor[4];
+            UINT m_SampleMask;
+            D3D11_PRIMITIVE_TOPOLOGY m_Topology;
+            ID3D11Buffer* m_pIndexBuffer;
+            DXGI_FORMAT m_IndexFormat;
+            UINT m_IndexOffset;
+            ID3D11InputLayout* m_pInputLayout;
+            ID3D11Buffer* m_pVertexBuffer;
+            UINT m_VertexStride;
+            UINT m_VertexOffset;
+            ID3D11VertexShader* m_pVertexShader;
+            ID3D11PixelShader* m_pPixelShader;
+            ID3D11SamplerState* m_pSampler;
+            ID3D11ShaderResourceView* m_pResource;
+
+        private:
+            template<class T>
+            static T* Get( T* pObject )
+            {
+                if ( pObject )
+                {
+                    pObject->AddRef();
+                }
+
+                return pObject;
+            }
+
+            template<class T>
+            static void Set( T*& pSlot, T* pObject )
+            {
+                if ( pObject )
+                {
+                    pObject->AddRef();
+                }
+
+                if ( pSlot )
+                {
+                    pSlot->Release();
+                }
+
+                pSlot = pObject;
+            }
+    };
+
+    typedef CDX11MinimalStateGuardT<CMockContext> CMockGuard;
+
+    /** @brief one object of every kind, used as the renderer state or as the UI draw state */
+    struct SStateObjects
+    {
+        ID3D11BlendState blendState;
+        ID3D11Buffer indexBuffer;
+        ID3D11InputLayout inputLayout;
+        ID3D11Buffer vertexBuffer;
+        ID3D11VertexShader vertexShader;
+        ID3D11PixelShader pixelShader;
+        ID3D11SamplerState sampler;
+        ID3D11ShaderResourceView resource;
+
+        /** @return every object is back to the single reference its owner holds */
+        bool IsBalanced( int nBound ) const
+        {
+            return blendState.nRefs == 1 + nBound && indexBuffer.nRefs == 1 + nBound && inputLayout.nRefs == 1 + nBound
+                   && vertexBuffer.nRefs == 1 + nBound && vertexShader.nRefs == 1 + nBound && pixelShader.nRefs == 1 + nBound
+                   && sampler.nRefs == 1 + nBound && resource.nRefs == 1 + nBound;
+        }
+    };
+
+    /** @brief bind a whole state set like a draw would */
+    void Bind( CMockContext& context, SStateObjects& objects, D3D11_PRIMITIVE_TOPOLOGY topology, DXGI_FORMAT format, UINT nStride, float fFactor )
+    {
+        const FLOAT factor[4] = { fFactor, fFactor, fFactor, fFactor };
+        const UINT nOffset = nStride / 4;
+        ID3D11Buffer* pVertexBuffer = &objects.vertexBuffer;
+        ID3D11SamplerState* pSampler = &objects.sampler;
+        ID3D11ShaderResourceView* pResource = &objects.resource;
+
+        context.OMSetBlendState( &objects.blendState, factor, nStride );
+        context.IASetPrimitiveTopology( topology );
+        context.IASetIndexBuffer( &objects.indexBuffer, format, nOffset );
+        context.IASetInputLayout( &objects.inputLayout );
+        context.IASetVertexBuffers( 0, 1, &pVertexBuffer, &nStride, &nOffset );
+        context.VSSetShader( &objects.vertexShader, nullptr, 0 );
+        context.PSSetShader( &objects.pixelShader, nullptr, 0 );
+        context.PSSetSamplers( 0, 1, &pSampler );
+        context.PSSetShaderResources( 0, 1, &pResource );
+    }
+
+    /** @return the context has exactly the renderer state bound */
+    bool IsRendererState( const CMockContext& context, SStateObjects& objects )
+    {
+        return context.m_pBlendState == &objects.blendState && context.m_BlendFactor[3] == 0.5f && context.m_SampleMask == 32
+               && context.m_Topology == D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST && context.m_pIndexBuffer == &objects.indexBuffer
+               && context.m_IndexFormat == DXGI_FORMAT_R32_UINT && context.m_IndexOffset == 8 && context.m_pInputLayout == &objects.inputLayout
+               && context.m_pVertexBuffer == &objects.vertexBuffer && context.m_VertexStride == 32 && context.m_VertexOffset == 8
+               && context.m_pVertexShader == &objects.vertexShader && context.m_pPixelShader == &objects.pixelShader
+               && context.m_pSampler == &objects.sampler && context.m_pResource == &objects.resource;
+    }
+
+    void TestRestoresRendererState()
+    {
+        SStateObjects renderer;
+        SStateObjects ui;
+        CMockContext context;
+        Bind( context, renderer, D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST, DXGI_FORMAT_R32_UINT, 32, 0.5f );
+
+        SDX11CallCount calls;
+        {
+            CMockGuard guard( &context, &calls );
+
+            // the UI draw replaces every slot the guard keeps
+            Bind( context, ui, D3D11_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP, DXGI_FORMAT_R16_UINT, 16, 1.0f );
+            TEST_CHECK( !IsRendererState( context, renderer ) );
+        }
+
+        TEST_CHECK( IsRendererState( context, renderer ) );
+
+        // the guard gave back every reference it took, the context only holds its own
+        TEST_CHECK( renderer.IsBalanced( 1 ) );
+        TEST_CHECK( ui.IsBalanced( 0 ) );
+    }
+
+    /**
+    * @brief per draw cost of the full guard (DX11StateGuard.h), from its calls and the Direct3D 11 slot counts:
+    * it gets the immediate context in the constructor and the destructor and queries and restores 10 states,
+    * releasing up to 2 context references, 4 single objects, 2 shaders and every vertex buffer, class instance,
+    * sampler and shader resource slot (32, 2 x 253, 16 and 128)
+    */
+    enum
+    {
+        eFullGuardGets = 2 + 10,
+        eFullGuardSets = 10,
+        eFullGuardReleases = 2 + 4 + 2 + 32 + 2 * 253 + 16 + 128,
+    };
+
+    /** @brief one query and one restore per state the minimal guard keeps, one release per object among them */
+    enum
+    {
+        eMinimalGuardStates = 9, //!< blend, topology, index buffer, layout, vertex buffer 0, 2 shaders, sampler 0, resource 0
+        eMinimalGuardObjects = 8, //!< all but the topology
+    };
+
+    void TestCallCounts()
+    {
+        SStateObjects renderer;
+        SStateObjects ui;
+        CMockContext context;
+        Bind( context, renderer, D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST, DXGI_FORMAT_R32_UINT, 32, 0.5f );
+
+        // the counts the guard reports are the calls the context received
+        SDX11CallCount calls;
+        const int nGets = context.m_nGets;
+        const int nSets = context.m_nSets;
+        CMockGuard* pGuard = new CMockGuard( &context, &calls );
+        TEST_CHECK( int( calls.nGets ) == context.m_nGets - nGets && calls.nSets == 0 && context.m_nSets == nSets );
+
+        Bind( context, ui, D3D11_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP, DXGI_FORMAT_R16_UINT, 16, 1.0f );
+
+        const int nDrawSets = context.m_nSets;
+        const int nDrawReleases = SMockObject::s_nReleases;
+        delete pGuard;
+
+        TEST_CHECK( int( calls.nSets ) == context.m_nSets - nDrawSets );
+        TEST_CHECK( int( calls.nReleases ) == SMockObject::s_nReleases - nDrawReleases - eMinimalGuardObjects );
+        TEST_CHECK( int( calls.nGets ) == context.m_nGets - nGets );
+
+        // the restores release the UI objects bound by the draw, the guard its own references
+        TEST_CHECK( calls.nGets == eMinimalGuardStates && calls.nSets == eMinimalGuardStates && calls.nReleases == eMinimalGuardObjects );
+
+        // the point of the minimal guard
+        TEST_CHECK( calls.nGets < eFullGuardGets && calls.nSets < eFullGuardSets && calls.nReleases * 50 < eFullGuardReleases );
+    }
+
+    void TestEmptySlots()
+    {
+        // nothing bound yet: the guard restores the empty slots and has nothing to release
+        SStateObjects ui;
+        CMockContext context;
+
+        SDX11CallCount calls;
+        {
+            CMockGuard guard( &context, &calls );
+            Bind( context, ui, D3D11_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP, DXGI_FORMAT_R16_UINT, 16, 1.0f );
+        }
+
+        TEST_CHECK( context.m_pBlendState == nullptr && context.m_pIndexBuffer == nullptr && context.m_pInputLayout == nullptr );
+        TEST_CHECK( context.m_pVertexBuffer == nullptr && context.m_pVertexShader == nullptr && context.m_pPixelShader == nullptr );
+        TEST_CHECK( context.m_pSampler == nullptr && context.m_pResource == nullptr );
+        TEST_CHECK( context.m_Topology == D3D11_PRIMITIVE_TOPOLOGY_UNDEFINED && context.m_SampleMask == 0xFFFFFFFF );
+        TEST_CHECK( calls.nReleases == 0 );
+        TEST_CHECK( ui.IsBalanced( 0 ) );
+    }
+
+    void TestWithoutCount()
+    {
+        SStateObjects renderer;
+        CMockContext context;
+        Bind( context, renderer, D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST, DXGI_FORMAT_R32_UINT, 32, 0.5f );
+
+        {
+            CMockGuard guard( &context );
+        }
+
+        TEST_CHECK( IsRendererState( context, renderer ) );
+        TEST_CHECK( renderer.IsBalanced( 1 ) );
+    }
+}
+
+int main()
+{
+    TestRestoresRendererState();
+    TestCallCounts();
+    TestEmptySlots();
+    TestWithoutCount();
+    return TEST_RESULT();
+}
@@ -0,0 +1,182 @@
+/* CryHTML5 - for licensing and copyright see license.txt */
+
+// One paint thread and one render thread hammer the triple buffered mailbox, every acquired frame has to match the paint it claims to be.
+
+#include "StdAfx.h"
+#include "FrameMailbox.h"
+#include "TestCheck.h"
+
+#include <atomic>
+#include <thread>
+
+using namespace HTML5Plugin;
+
+namespace
+{
+    enum
+    {
+        eWidth = 192,
+        eHeight = 96,
+        ePaints = 20000,
+    };
+
+    /** @brief rect painted by paint nPaint (1 based), every 16th paint covers the whole frame */
+    SDirtyRect GetPaintRect( uint32 nPaint )
+    {
+        if ( nPaint % 16 == 1 )
+        {
+            return SDirtyRect( 0, 0, eWidth, eHeight );
+        }
+
+        uint32 nHash = nPaint * 2654435761u;
+        const int x = int( nHash % eWidth );
+        nHash = nHash * 2246822519u + 3266489917u;
+        const int y = int( ( nHash >> 8 ) % eHeight );
+        nHash = nHash * 2246822519u + 3266489917u;
+        const int w = 1 + int( ( nHash >> 4 ) % 64 );
+        const int h = 1 + int( ( nHash >> 16 ) % 32 );
+
+        SDirtyRect rect( x, y, x + w, y + h );
+        rect.Clip( eWidth, eHeight );
+        return rect;
+    }
+
+    /** @brief write the pixels of paint nPaint into a frame */
+    void ApplyPaint( uint32* pPixels, uint32 nPaint )
+    {
+        const SDirtyRect rect = GetPaintRect( nPaint );
+
+        for ( int y = rect.y; y < rect.y2; ++y )
+        {
+            for ( int x = rect.x; x < rect.x2; ++x )
+            {
+                pPixels[y * eWidth + x] = nPaint;
+            }
+        }
+    }
+
+    void TestStress()
+    {
+        CFrameMailbox mailbox( eWidth, eHeight );
+        std::atomic<bool> bDone( false );
+
+        std::thread painter( [&]()
+        {
+            std::vector<uint32> source( eWidth * eHeight, 0 );
+
+            for ( uint32 nPaint = 1; nPaint <= ePaints; ++nPaint )
+            {
+                ApplyPaint( &source[0], nPaint );
+
+                CDirtyRegion dirty;
+                dirty.Add( GetPaintRect( nPaint ) );
+                mailbox.Publish( &source[0], eWidth, eHeight, dirty, nPaint );
+
+                // the sandbox may have a single core, let the render thread in now and then
+                if ( nPaint % 64 == 0 )
+                {
+                    std::this_thread::yield();
+                }
+            }
+
+            bDone = true;
+        } );
+
+        // the render thread rebuilds every frame it sees from the paint sequence
+        std::vector<uint32> expected( eWidth * eHeight, 0 );
+        uint32 nApplied = 0;
+        uint32 nAcquired = 0;
+        uint32 nTorn = 0;
+        bool bOrdered = true;
+
+        for ( ;; )
+        {
+            const bool bLast = bDone.load();
+            const CFrameMailbox::SFrame* pFrame = mailbox.Acquire();
+
+            if ( pFrame )
+            {
+                ++nAcquired;
+                bOrdered = bOrdered && pFrame->nSequence > nApplied && pFrame->nPaintTime == pFrame->nSequence;
+
+                while ( nApplied < pFrame->nSequence )
+                {
+                    ApplyPaint( &expected[0], ++nApplied );
+                }
+
+                if ( pFrame->width != eWidth || pFrame->height != eHeight || memcmp( &pFrame->buffer[0], &expected[0], expected.size() * 4 ) != 0 )
+                {
+                    ++nTorn;
+                }
+            }
+
+            else if ( bLast )
+            {
+                break;
+            }
+
+            else
+            {
+                std::this_thread::yield();
+            }
+        }
+
+        painter.join();
+
+        printf( "stress: %u paints, %u frames acquired, %u torn\n", uint32( ePaints ), nAcquired, nTorn );
+        TEST_CHECK( nTorn == 0 );
+        TEST_CHECK( bOrdered );
+        TEST_CHECK( nApplied == ePaints );
+        TEST_CHECK( nAcquired > 0 );
+    }
+
+    void TestResize()
+    {
+        CFrameMailbox mailbox( 4, 4 );
+        std::vector<uint32> source( 8 * 6, 0x11223344 );
+
+        // a paint of a new size is copied completely even when it reports a small dirty area
+        CDirtyRegion dirty;
+        dirty.Add( SDirtyRect( 0, 0, 1, 1 ) );
+        TEST_CHECK( mailbox.Publish( &source[0], 8, 6, dirty, 1 ) );
+
+        const CFrameMailbox::SFrame* pFrame = mailbox.Acquire();
+        TEST_CHECK( pFrame != nullptr );
+        TEST_CHECK( pFrame && pFrame->width == 8 && pFrame->height == 6 );
+        TEST_CHECK( pFrame && memcmp( &pFrame->buffer[0], &source[0], source.size() * 4 ) == 0 );
+        TEST_CHECK( mailbox.Acquire() == nullptr );
+
+        // nothing to publish
+        TEST_CHECK( !mailbox.Publish( nullptr, 8, 6, dirty, 2 ) );
+    }
+
+    void TestUnconsumedArea()
+    {
+        CFrameMailbox mailbox( 16, 16 );
+        std::vector<uint32> source( 16 * 16, 0 );
+
+        // paints the render thread didn't take in between add up (the region may merge them into one rect)
+        CDirtyRegion a;
+        a.Add( SDirtyRect( 0, 0, 4, 4 ) );
+        CDirtyRegion b;
+        b.Add( SDirtyRect( 8, 8, 12, 12 ) );
+        mailbox.Publish( &source[0], 16, 16, a, 1 );
+        mailbox.Publish( &source[0], 16, 16, b, 2 );
+
+        const CFrameMailbox::SFrame* pFrame = mailbox.Acquire();
+        TEST_CHECK( pFrame && pFrame->upload.GetArea() >= 32 && pFrame->upload.GetArea() <= 12 * 12 );
+
+        // once taken, only the new paint is reported
+        mailbox.Publish( &source[0], 16, 16, a, 3 );
+        pFrame = mailbox.Acquire();
+        TEST_CHECK( pFrame && pFrame->upload.GetArea() == 16 );
+    }
+}
+
+int main()
+{
+    TestResize();
+    TestUnconsumedArea();
+    TestStress();
+    return TEST_RESULT();
+}
@@ -0,0 +1,364 @@
+/* CryHTML5 - for licensing and copyright see license.txt */
+
+// Frame sources driven through a mock device: the newest paint is presented in order, resizes recreate the surface and no frame of the old size shows up after one.
+
+#include "StdAfx.h"
+#include "SurfacePipeline.h"
+#include "TestCheck.h"
+
+#include <atomic>
+#include <thread>
+
+using namespace HTML5Plugin;
+
+namespace
+{
+    /** @brief records what a frame source does with the device and keeps a copy of the surface contents */
+    class CMockDevice : public ISurfaceDevice
+    {
+        public:
+            CMockDevice()
+                : m_nWidth( 0 )
+                , m_nHeight( 0 )
+                , m_hShared( nullptr )
+                , m_bHasSurface( false )
+                , m_bRefuseShared( false )
+                , m_nCreates( 0 )
+                , m_nOpens( 0 )
+                , m_nUploads( 0 )
+                , m_nOutside( 0 )
+            {
+            }
+
+            virtual bool CreateSurface( int nWidth, int nHeight ) override
+            {
+                ++m_nCreates;
+                m_nWidth = nWidth;
+                m_nHeight = nHeight;
+                m_hShared = nullptr;
+                m_bHasSurface = true;
+                m_texture.assign( size_t( nWidth ) * nHeight * 4, 0 );
+                return true;
+            }
+
+            virtual bool OpenSharedSurface( void* hShared, int nWidth, int nHeight ) override
+            {
+                if ( m_bRefuseShared )
+                {
+                    return false;
+                }
+
+                if ( m_bHasSurface && hShared == m_hShared )
+                {
+                    return true;
+                }
+
+                ++m_nOpens;
+                m_hShared = hShared;
+                m_nWidth = nWidth;
+                m_nHeight = nHeight;
+                m_bHasSurface = true;
+                return true;
+            }
+
+            virtual void ReleaseSurface() override
+            {
+                m_hShared = nullptr;
+                m_bHasSurface = false;
+                m_texture.clear();
+            }
+
+            virtual bool HasSurface() const override
+            {
+                return m_bHasSurface;
+            }
+
+            virtual void Upload( const uint8* pSource, int nPitch, const SDirtyRect* pRects, int nRects ) override
+            {
+                ++m_nUploads;
+
+                for ( int i = 0; i < nRects; ++i )
+                {
+                    const SDirtyRect& rect = pRects[i];
+
+                    if ( rect.IsEmpty() || rect.x < 0 || rect.y < 0 || rect.x2 > m_nWidth || rect.y2 > m_nHeight || nPitch != m_nWidth * 4 )
+                    {
+                        ++m_nOutside;
+                        continue;
+                    }
+
+                    for ( int y = rect.y; y < rect.y2; ++y )
+                    {
+                        const size_t nOffset = ( size_t( y ) * m_nWidth + rect.x ) * 4;
+                        memcpy( &m_texture[nOffset], pSource + nOffset, size_t( rect.x2 - rect.x ) * 4 );
+                    }
+                }
+            }
+
+            std::vector<uint8> m_texture; //!< surface contents
+            int m_nWidth; //!< surface size
+            int m_nHeight;
+            void* m_hShared; //!< shared texture opened last
+            bool m_bHasSurface;
+            bool m_bRefuseShared; //!< fail OpenSharedSurface like a device without shared textures
+            int m_nCreates; //!< CreateSurface calls
+            int m_nOpens; //!< OpenSharedSurface calls that opened another texture
+            int m_nUploads; //!< Upload calls
+            int m_nOutside; //!< rects outside the surface
+    };
+
+    /** @brief color of every pixel of a test frame, telling its paint number and width apart */
+    uint32 GetFrameColor( uint32 nPaint, int nWidth )
+    {
+        return 0xFF000000u | ( uint32( nWidth & 0xFF ) << 16 ) | ( nPaint & 0xFFFF );
+    }
+
+    void FillFrame( std::vector<uint8>& frame, uint32 nPaint, int nWidth, int nHeight )
+    {
+        frame.resize( size_t( nWidth ) * nHeight * 4 );
+        const uint32 nColor = GetFrameColor( nPaint, nWidth );
+
+        for ( size_t i = 0; i < frame.size(); i += 4 )
+        {
+            memcpy( &frame[i], &nColor, 4 );
+        }
+    }
+
+    /** @return true when every pixel of a buffer has the color of one paint, which is returned (0 for a blank frame) */
+    bool GetPaint( const uint8* pPixels, int nWidth, int nHeight, uint32& nPaint )
+    {
+        uint32 nColor;
+        memcpy( &nColor, pPixels, 4 );
+
+        for ( size_t i = 0; i < size_t( nWidth ) * nHeight * 4; i += 4 )
+        {
+            if ( memcmp( pPixels + i, &nColor, 4 ) != 0 )
+            {
+                return false;
+            }
+        }
+
+        // the blank frame before the first paint
+        nPaint = nColor & 0xFFFF;
+        return nColor == 0 || nColor == GetFrameColor( nPaint, nWidth );
+    }
+
+    /** @brief paint a complete frame of one color */
+    void PaintFull( IFrameSource& source, std::vector<uint8>& frame, uint32 nPaint, int nWidth, int nHeight, int nTileSize )
+    {
+        FillFrame( frame, nPaint, nWidth, nHeight );
+
+        CDirtyRegion dirty;
+        dirty.Add( SDirtyRect( 0, 0, nWidth, nHeight ) );
+        source.Paint( &frame[0], nWidth, nHeight, dirty, nTileSize );
+    }
+
+    void TestSharedOrdering()
+    {
+        CSharedFrameSource source;
+        CMockDevice device;
+
+        // nothing painted yet
+        TEST_CHECK( !source.Present( device, 0.0f, 0.0f ) );
+        TEST_CHECK( device.m_nOpens == 0 );
+
+        char textures[3];
+        source.PaintShared( &textures[0], 64, 32 );
+        TEST_CHECK( source.Present( device, 0.1f, 0.0f ) );
+        TEST_CHECK( device.m_hShared == &textures[0] && source.GetWidth() == 64 && source.GetHeight() == 32 );
+        TEST_CHECK( !source.GetPixels() && !source.GetCoverage() );
+
+        // paints in between presents are coalesced, the newest one wins
+        source.PaintShared( &textures[1], 64, 32 );
+        source.PaintShared( &textures[2], 64, 32 );
+        TEST_CHECK( source.Present( device, 0.2f, 0.0f ) );
+        TEST_CHECK( device.m_hShared == &textures[2] && device.m_nOpens == 2 );
+
+        // repainting into the same texture opens nothing
+        source.PaintShared( &textures[2], 64, 32 );
+        TEST_CHECK( source.Present( device, 0.3f, 0.0f ) && source.Present( device, 0.4f, 0.0f ) );
+        TEST_CHECK( device.m_nOpens == 2 );
+
+        // a paced source keeps the texture it has until the next upload is due
+        source.PaintShared( &textures[0], 64, 32 );
+        TEST_CHECK( source.Present( device, 0.5f, 10.0f ) );
+        TEST_CHECK( device.m_hShared == &textures[0] );
+
+        source.PaintShared( &textures[1], 64, 32 );
+        TEST_CHECK( source.Present( device, 0.52f, 10.0f ) );
+        TEST_CHECK( device.m_hShared == &textures[0] );
+        TEST_CHECK( source.Present( device, 0.6f, 10.0f ) );
+        TEST_CHECK( device.m_hShared == &textures[1] );
+
+        // a device without shared textures can't draw them
+        CMockDevice refusing;
+        refusing.m_bRefuseShared = true;
+        TEST_CHECK( !source.Present( refusing, 2.0f, 0.0f ) );
+    }
+
+    void TestSharedResize()
+    {
+        CSharedFrameSource source;
+        CMockDevice device;
+
+        char textures[2];
+        source.PaintShared( &textures[0], 64, 32 );
+        TEST_CHECK( source.Present( device, 0.0f, 0.0f ) );
+
+        // the resized texture replaces the old one at once, its size comes with it
+        source.PaintShared( &textures[1], 128, 96 );
+        TEST_CHECK( source.Present( device, 0.1f, 0.0f ) );
+        TEST_CHECK( device.m_hShared == &textures[1] && device.m_nWidth == 128 && device.m_nHeight == 96 );
+        TEST_CHECK( source.GetWidth() == 128 && source.GetHeight() == 96 );
+
+        // presenting again doesn't go back to the old texture
+        TEST_CHECK( source.Present( device, 0.2f, 0.0f ) );
+        TEST_CHECK( device.m_hShared == &textures[1] && device.m_nOpens == 2 );
+    }
+
+    void TestPipelineOrdering()
+    {
+        CSurfacePipeline pipeline( 64, 32 );
+        CMockDevice device;
+        std::vector<uint8> frame;
+
+        PaintFull( pipeline, frame, 1, 64, 32, 0 );
+        TEST_CHECK( pipeline.Present( device, 0.0f, 0.0f ) );
+        TEST_CHECK( device.m_nCreates == 1 && device.m_texture == pipeline.GetFront().buffer );
+
+        // the newest of several paints is uploaded
+        PaintFull( pipeline, frame, 2, 64, 32, 0 );
+        PaintFull( pipeline, frame, 3, 64, 32, 0 );
+        TEST_CHECK( pipeline.Present( device, 0.1f, 0.0f ) );
+
+        uint32 nPaint = 0;
+        TEST_CHECK( GetPaint( &device.m_texture[0], 64, 32, nPaint ) && nPaint == 3 );
+        TEST_CHECK( GetPaint( pipeline.GetPixels(), 64, 32, nPaint ) && nPaint == 3 );
+
+        // nothing new: nothing uploaded
+        const int nUploads = device.m_nUploads;
+        TEST_CHECK( pipeline.Present( device, 0.2f, 0.0f ) );
+        TEST_CHECK( device.m_nUploads == nUploads );
+
+        // partial paints only upload their rects, the surface follows the frame
+        FillFrame( frame, 3, 64, 32 );
+
+        for ( int i = 0; i < 8; ++i )
+        {
+            frame[( ( i * 3 ) * 64 + i * 7 ) * 4] = uint8( i );
+
+            CDirtyRegion dirty;
+            dirty.Add( SDirtyRect( i * 7, i * 3, i * 7 + 1, i * 3 + 1 ) );
+            pipeline.Paint( &frame[0], 64, 32, dirty, i % 2 ? 16 : 0 );
+            TEST_CHECK( pipeline.Present( device, 0.3f + i * 0.1f, 0.0f ) );
+        }
+
+        TEST_CHECK( device.m_texture == frame && device.m_nCreates == 1 && device.m_nOutside == 0 );
+    }
+
+    void TestPipelineResize()
+    {
+        CSurfacePipeline pipeline( 64, 32 );
+        CMockDevice device;
+        std::vector<uint8> frame;
+
+        PaintFull( pipeline, frame, 1, 64, 32, 0 );
+        TEST_CHECK( pipeline.Present( device, 0.0f, 0.0f ) );
+
+        // the surface is recreated at the new size and gets the complete new frame
+        PaintFull( pipeline, frame, 2, 96, 48, 0 );
+        TEST_CHECK( pipeline.Present( device, 0.1f, 10.0f ) );
+        TEST_CHECK( device.m_nCreates == 2 && device.m_nWidth == 96 && device.m_nHeight == 48 );
+        TEST_CHECK( pipeline.GetWidth() == 96 && pipeline.GetHeight() == 48 );
+
+        uint32 nPaint = 0;
+        TEST_CHECK( GetPaint( &device.m_texture[0], 96, 48, nPaint ) && nPaint == 2 );
+
+        // a paced source keeps showing the frame it has, at that frame's size
+        PaintFull( pipeline, frame, 3, 64, 32, 16 );
+        TEST_CHECK( pipeline.Present( device, 0.12f, 10.0f ) );
+        TEST_CHECK( device.m_nWidth == 96 && pipeline.GetWidth() == 96 );
+
+        TEST_CHECK( pipeline.Present( device, 1.0f, 10.0f ) );
+        TEST_CHECK( device.m_nCreates == 3 && device.m_nWidth == 64 && pipeline.GetWidth() == 64 );
+        TEST_CHECK( GetPaint( &device.m_texture[0], 64, 32, nPaint ) && nPaint == 3 );
+        TEST_CHECK( device.m_nOutside == 0 );
+    }
+
+    void TestConcurrentResizes()
+    {
+        // sizes the paint thread cycles through
+        static const int sizes[][2] = { { 64, 32 }, { 96, 48 }, { 33, 17 }, { 128, 8 } };
+        const uint32 nPaints = 20000;
+
+        CSurfacePipeline pipeline( 64, 32 );
+        CMockDevice device;
+        std::atomic<bool> bDone( false );
+
+        std::thread painter( [&]()
+        {
+            std::vector<uint8> frame;
+
+            for ( uint32 nPaint = 1; nPaint <= nPaints; ++nPaint )
+            {
+                const int* size = sizes[( nPaint / 7 ) % 4];
+                PaintFull( pipeline, frame, nPaint, size[0], size[1], nPaint % 3 ? 0 : 16 );
+            }
+
+            bDone = true;
+        } );
+
+        // every presented frame is complete, matches the surface and is never older than the one before
+        int nBroken = 0;
+        int nBackwards = 0;
+        int nPresents = 0;
+        uint32 nLast = 0;
+        bool bFinal = false;
+
+        while ( !bFinal )
+        {
+            bFinal = bDone;
+
+            if ( !pipeline.Present( device, float( nPresents ) * 0.001f, 0.0f ) )
+            {
+                ++nBroken;
+                break;
+            }
+
+            ++nPresents;
+
+            const int nWidth = pipeline.GetWidth();
+            const int nHeight = pipeline.GetHeight();
+            uint32 nPaint = 0;
+            uint32 nUploaded = 0;
+
+            if ( nWidth != device.m_nWidth || nHeight != device.m_nHeight || !GetPaint( pipeline.GetPixels(), nWidth, nHeight, nPaint )
+                    || !GetPaint( &device.m_texture[0], nWidth, nHeight, nUploaded ) || nUploaded != nPaint )
+            {
+                ++nBroken;
+                continue;
+            }
+
+            // paints start at 1, 0 is the blank initial frame
+            const int* size = sizes[( nPaint / 7 ) % 4];
+            nBroken += nPaint == 0 || ( nWidth == size[0] && nHeight == size[1] ) ? 0 : 1;
+            nBackwards += nPaint < nLast ? 1 : 0;
+            nLast = nPaint;
+        }
+
+        painter.join();
+
+        TEST_CHECK( nBroken == 0 && nBackwards == 0 );
+        TEST_CHECK( nLast == nPaints && device.m_nOutside == 0 );
+    }
+}
+
+int main()
+{
+    TestSharedOrdering();
+    TestSharedResize();
+    TestPipelineOrdering();
+    TestPipelineResize();
+    TestConcurrentResizes();
+    return TEST_RESULT();
+}
@@ -0,0 +1,227 @@
+/* CryHTML5 - for licensing and copyright see license.txt */
+
+// Random input frames replayed into a fake browser with and without batching: the browser has to see the same clicks, keys, wheel totals and pointer positions.
+
+#include "StdAfx.h"
+#include "InputBatch.h"
+#include "TestCheck.h"
+
+using namespace HTML5Plugin;
+
+namespace
+{
+    /** @brief small deterministic generator so failures reproduce */
+    struct SRandom
+    {
+        uint32 nState;
+
+        explicit SRandom( uint32 nSeed )
+            : nState( nSeed )
+        {
+        }
+
+        int Next( int nRange )
+        {
+            nState = nState * 1664525u + 1013904223u;
+            return int( ( nState >> 8 ) % uint32( nRange ) );
+        }
+    };
+
+    enum EEventType
+    {
+        eET_Move = 0,
+        eET_Wheel,
+        eET_Click,
+        eET_Key,
+    };
+
+    struct SEvent
+    {
+        EEventType eType;
+        int nA; //!< x, wheel delta, button or key
+        int nB; //!< y
+    };
+
+    /** @brief what the browser observed of an event: plain moves only show up as the position of the next entry */
+    struct SObserved
+    {
+        EEventType eType;
+        int nValue; //!< wheel total of a run, button or key
+        int x; //!< pointer position at the time of the event
+        int y;
+
+        bool operator==( const SObserved& other ) const
+        {
+            return eType == other.eType && nValue == other.nValue && x == other.x && y == other.y;
+        }
+    };
+
+    /** @brief records what a browser would react to, consecutive wheel events scroll as one */
+    class CFakeBrowser
+    {
+        public:
+            CFakeBrowser()
+                : m_x( 0 )
+                , m_y( 0 )
+                , m_nCalls( 0 )
+                , m_bWheelRun( false )
+            {
+            }
+
+            void Send( const SEvent& event )
+            {
+                ++m_nCalls;
+
+                if ( event.eType == eET_Move )
+                {
+                    m_x = event.nA;
+                    m_y = event.nB;
+                    m_bWheelRun = false;
+                    return;
+                }
+
+                if ( event.eType == eET_Wheel && m_bWheelRun )
+                {
+                    m_log.back().nValue += event.nA;
+                    return;
+                }
+
+                SObserved observed = { event.eType, event.nA, m_x, m_y };
+                m_log.push_back( observed );
+                m_bWheelRun = event.eType == eET_Wheel;
+            }
+
+            bool IsSame( const CFakeBrowser& other ) const
+            {
+                return m_log == other.m_log && m_x == other.m_x && m_y == other.m_y;
+            }
+
+            int GetCalls() const
+            {
+                return m_nCalls;
+            }
+
+        private:
+            std::vector<SObserved> m_log;
+            int m_x;
+            int m_y;
+            int m_nCalls;
+            bool m_bWheelRun; //!< the last event was a wheel event
+    };
+
+    EInputBatchKind GetKind( const SEvent& event )
+    {
+        return event.eType == eET_Move ? eIBK_Move : event.eType == eET_Wheel ? eIBK_Wheel : eIBK_Other;
+    }
+
+    void MergeWheel( SEvent& into, const SEvent& next )
+    {
+        into.nA += next.nA;
+    }
+
+    /** @brief a frame of mostly moves with some wheel, clicks and keys in between */
+    std::vector<SEvent> MakeFrame( SRandom& random )
+    {
+        std::vector<SEvent> events;
+        const int nEvents = random.Next( 64 );
+
+        for ( int i = 0; i < nEvents; ++i )
+        {
+            const int nRoll = random.Next( 100 );
+            SEvent event = { eET_Move, random.Next( 1920 ), random.Next( 1080 ) };
+
+            if ( nRoll >= 95 )
+            {
+                event.eType = eET_Key;
+                event.nA = random.Next( 256 );
+            }
+
+            else if ( nRoll >= 88 )
+            {
+                event.eType = eET_Click;
+                event.nA = random.Next( 3 );
+            }
+
+            else if ( nRoll >= 80 )
+            {
+                event.eType = eET_Wheel;
+                event.nA = random.Next( 2 ) ? 50 : -50;
+            }
+
+            events.push_back( event );
+        }
+
+        return events;
+    }
+
+    void TestReplay()
+    {
+        SRandom random( 7 );
+        int nDifferent = 0;
+        int nRunsLeft = 0;
+        int nCalls = 0;
+        int nBatchedCalls = 0;
+
+        for ( int nFrame = 0; nFrame < 20000; ++nFrame )
+        {
+            const std::vector<SEvent> events = MakeFrame( random );
+            CFakeBrowser reference;
+
+            for ( size_t i = 0; i < events.size(); ++i )
+            {
+                reference.Send( events[i] );
+            }
+
+            std::vector<SEvent> batched = events;
+            batched.resize( batched.empty() ? 0 : BatchInput( &batched[0], batched.size(), GetKind, MergeWheel ) );
+
+            CFakeBrowser browser;
+
+            for ( size_t i = 0; i < batched.size(); ++i )
+            {
+                browser.Send( batched[i] );
+
+                // no run of moves or wheel events is left
+                if ( i > 0 && batched[i].eType == batched[i - 1].eType && GetKind( batched[i] ) != eIBK_Other )
+                {
+                    ++nRunsLeft;
+                }
+            }
+
+            nDifferent += browser.IsSame( reference ) ? 0 : 1;
+            nCalls += reference.GetCalls();
+            nBatchedCalls += browser.GetCalls();
+        }
+
+        printf( "replay: %d calls batched to %d (%.1f%% saved)\n", nCalls, nBatchedCalls, 100.0 * ( nCalls - nBatchedCalls ) / max( nCalls, 1 ) );
+        TEST_CHECK( nDifferent == 0 );
+        TEST_CHECK( nRunsLeft == 0 );
+        TEST_CHECK( nBatchedCalls < nCalls );
+    }
+
+    void TestRunsDontCrossOtherEvents()
+    {
+        SEvent events[] =
+        {
+            { eET_Move, 1, 1 }, { eET_Move, 2, 2 }, { eET_Click, 0, 0 }, { eET_Move, 3, 3 },
+            { eET_Wheel, 10, 0 }, { eET_Wheel, 20, 0 }, { eET_Move, 4, 4 }, { eET_Wheel, 5, 0 },
+        };
+
+        const size_t nEvents = BatchInput( events, sizeof( events ) / sizeof( events[0] ), GetKind, MergeWheel );
+
+        TEST_CHECK( nEvents == 6 );
+        TEST_CHECK( events[0].eType == eET_Move && events[0].nA == 2 );
+        TEST_CHECK( events[1].eType == eET_Click );
+        TEST_CHECK( events[2].eType == eET_Move && events[2].nA == 3 );
+        TEST_CHECK( events[3].eType == eET_Wheel && events[3].nA == 30 );
+        TEST_CHECK( events[4].eType == eET_Move && events[4].nA == 4 );
+        TEST_CHECK( events[5].eType == eET_Wheel && events[5].nA == 5 );
+    }
+}
+
+int main()
+{
+    TestRunsDontCrossOtherEvents();
+    TestReplay();
+    return TEST_RESULT();
+}
@@ -0,0 +1,210 @@
+/* CryHTML5 - for licensing and copyright see license.txt */
+
+// Several producer threads and one consumer hammer the input ring: nothing arrives twice or out of order per producer and the counters add up under both overflow policies.
+
+#include "StdAfx.h"
+#include "InputRing.h"
+#include "TestCheck.h"
+
+#include <atomic>
+#include <thread>
+
+using namespace HTML5Plugin;
+
+namespace
+{
+    enum
+    {
+        eCapacity = 1024,
+        eEvents = 200000, //!< events per producer
+    };
+
+    /** @brief event tagged with the thread that sent it */
+    struct SEvent
+    {
+        int nProducer;
+        int nIndex;
+
+        SEvent()
+            : nProducer( -1 )
+            , nIndex( 0 )
+        {
+        }
+
+        SEvent( int producer, int index )
+            : nProducer( producer )
+            , nIndex( index )
+        {
+        }
+    };
+
+    typedef CInputRing<SEvent, eCapacity> TRing;
+
+    /**
+    * @brief run producers against one consumer
+    * @param bRetry producers retry a dropped event until it is queued
+    */
+    void Stress( EInputOverflowPolicy ePolicy, int nProducers, bool bRetry )
+    {
+        // too large for the stack of the test thread
+        std::unique_ptr<TRing> pRing( new TRing( ePolicy ) );
+        std::atomic<int> nDone( 0 );
+        std::vector<std::thread> producers;
+
+        for ( int p = 0; p < nProducers; ++p )
+        {
+            producers.push_back( std::thread( [&, p]()
+            {
+                for ( int i = 0; i < eEvents; ++i )
+                {
+                    while ( !pRing->Push( SEvent( p, i ) ) && bRetry )
+                    {
+                        std::this_thread::yield();
+                    }
+
+                    // the sandbox may have a single core, let the consumer in now and then
+                    if ( i % 64 == 0 )
+                    {
+                        std::this_thread::yield();
+                    }
+                }
+
+                ++nDone;
+            } ) );
+        }
+
+        std::vector<int> last( nProducers, -1 );
+        uint32 nReceived = 0;
+        uint32 nDuplicates = 0;
+        uint32 nUnordered = 0;
+        SEvent event;
+
+        for ( ;; )
+        {
+            const bool bLast = nDone.load() == nProducers;
+
+            if ( pRing->Pop( event ) )
+            {
+                ++nReceived;
+
+                if ( event.nProducer < 0 || event.nProducer >= nProducers )
+                {
+                    ++nUnordered;
+                }
+
+                else if ( event.nIndex == last[event.nProducer] )
+                {
+                    ++nDuplicates;
+                }
+
+                else if ( event.nIndex < last[event.nProducer] )
+                {
+                    ++nUnordered;
+                }
+
+                else
+                {
+                    last[event.nProducer] = event.nIndex;
+                }
+            }
+
+            else if ( bLast )
+            {
+                break;
+            }
+
+            else
+            {
+                std::this_thread::yield();
+            }
+        }
+
+        for ( size_t i = 0; i < producers.size(); ++i )
+        {
+            producers[i].join();
+        }
+
+        const TRing::SCounters counters = pRing->GetCounters();
+        const uint32 nSent = uint32( nProducers ) * eEvents;
+
+        printf( "policy %d producers %d retry %d: %u received, %u dropped, peak %u\n", int( ePolicy ), nProducers, bRetry ? 1 : 0, nReceived,
+                counters.nDropped, counters.nPeak );
+
+        TEST_CHECK( nDuplicates == 0 );
+        TEST_CHECK( nUnordered == 0 );
+        TEST_CHECK( counters.nPopped == nReceived );
+        TEST_CHECK( counters.nPeak <= uint32( eCapacity ) );
+
+        if ( ePolicy == eIOP_DropNewest )
+        {
+            // a dropped event is never queued, a retried one counts as dropped each time it didn't fit
+            TEST_CHECK( counters.nPushed == nReceived );
+            TEST_CHECK( bRetry ? nReceived == nSent : counters.nPushed + counters.nDropped == nSent );
+        }
+
+        else
+        {
+            // every event is queued, the ones pushed out are lost
+            TEST_CHECK( counters.nPushed == nSent );
+            TEST_CHECK( nReceived + counters.nDropped == nSent );
+        }
+    }
+
+    void TestOverflowPolicies()
+    {
+        SEvent event;
+
+        CInputRing<SEvent, 4> newest;
+
+        for ( int i = 0; i < 6; ++i )
+        {
+            newest.Push( SEvent( 0, i ) );
+        }
+
+        TEST_CHECK( newest.GetCounters().nDropped == 2 && newest.GetCounters().nPeak == 4 );
+        TEST_CHECK( newest.Pop( event ) && event.nIndex == 0 );
+
+        CInputRing<SEvent, 4> oldest( eIOP_DropOldest );
+
+        for ( int i = 0; i < 6; ++i )
+        {
+            oldest.Push( SEvent( 0, i ) );
+        }
+
+        TEST_CHECK( oldest.GetCounters().nDropped == 2 );
+        TEST_CHECK( oldest.Pop( event ) && event.nIndex == 2 );
+
+        oldest.Clear();
+        TEST_CHECK( !oldest.Pop( event ) );
+        TEST_CHECK( oldest.GetCounters().nPopped == 4 );
+    }
+
+    void TestWrapAround()
+    {
+        // many laps over a small ring keep the order
+        CInputRing<SEvent, 8> ring;
+        SEvent event;
+        bool bOk = true;
+
+        for ( int i = 0; i < 1000; ++i )
+        {
+            bOk = bOk && ring.Push( SEvent( 0, i * 2 ) ) && ring.Push( SEvent( 0, i * 2 + 1 ) );
+            bOk = bOk && ring.Pop( event ) && event.nIndex == i * 2;
+            bOk = bOk && ring.Pop( event ) && event.nIndex == i * 2 + 1;
+        }
+
+        TEST_CHECK( bOk );
+        TEST_CHECK( !ring.Pop( event ) );
+    }
+}
+
+int main()
+{
+    TestOverflowPolicies();
+    TestWrapAround();
+    Stress( eIOP_DropNewest, 1, true );
+    Stress( eIOP_DropNewest, 4, true );
+    Stress( eIOP_DropNewest, 4, false );
+    Stress( eIOP_DropOldest, 4, false );
+    return TEST_RESULT();
+}
@@ -0,0 +1,212 @@
+/* CryHTML5 - for licensing and copyright see license.txt */
+
+// Key and modifier tables: every key id and every modifier mask reads back what was set, ids and masks outside the tables are reported as such,
+// and the default keys and modifier flags the input handler uses are consistent.
+
+#include "StdAfx.h"
+#include "KeyTable.h"
+#include "TestCheck.h"
+
+using namespace HTML5Plugin;
+
+namespace
+{
+    /** @brief made up translation of a modifier mask, spreads the bits so a wrong slot can't give the same flags */
+    uint32 GetFlags( uint32 nMask )
+    {
+        return ( ( nMask & 3 ) ? 1 : 0 ) | ( ( nMask & 0x30 ) ? 2 : 0 ) | ( ( nMask >> 8 ) << 4 ) | ( ( nMask * 2654435761u ) >> 28 << 8 );
+    }
+
+    /** @brief key code a key id is set to, distinct per key */
+    uint16 GetKeyCode( uint32 nKey )
+    {
+        return uint16( 0x1000 + nKey * 7 );
+    }
+
+    void TestEmptyTable()
+    {
+        // unknown keys have no key code and are printable, so their character is sent
+        static CKeyTable table;
+        bool bOk = true;
+
+        for ( uint32 nKey = 0; nKey < CKeyTable::eMaxKeys; ++nKey )
+        {
+            bOk = bOk && table.GetKey( nKey ).nKeyCode == 0 && table.GetKey( nKey ).bPrintable;
+        }
+
+        TEST_CHECK( bOk );
+
+        uint32 nFlags = 1;
+        TEST_CHECK( table.GetModifiers( 0, nFlags ) && nFlags == 0 );
+    }
+
+    void TestKeyRoundTrip()
+    {
+        static CKeyTable table;
+
+        for ( uint32 nKey = 0; nKey < CKeyTable::eMaxKeys; ++nKey )
+        {
+            table.SetKey( nKey, GetKeyCode( nKey ), nKey % 3 == 0 );
+        }
+
+        bool bOk = true;
+
+        for ( uint32 nKey = 0; nKey < CKeyTable::eMaxKeys; ++nKey )
+        {
+            bOk = bOk && table.GetKey( nKey ).nKeyCode == GetKeyCode( nKey ) && table.GetKey( nKey ).bPrintable == ( nKey % 3 == 0 );
+        }
+
+        TEST_CHECK( bOk );
+
+        // ids past the table, including negative offsets from the first keyboard key, are unknown
+        bool bUnknown = true;
+
+        for ( uint32 nKey = CKeyTable::eMaxKeys; nKey < 100000; ++nKey )
+        {
+            bUnknown = bUnknown && table.GetKey( nKey ).nKeyCode == 0;
+        }
+
+        TEST_CHECK( bUnknown );
+        TEST_CHECK( table.GetKey( uint32( -5 ) ).nKeyCode == 0 );
+
+        // setting a key outside the table changes nothing
+        table.SetKey( CKeyTable::eMaxKeys, 1, false );
+        TEST_CHECK( table.GetKey( CKeyTable::eMaxKeys ).nKeyCode == 0 );
+        TEST_CHECK( table.GetKey( CKeyTable::eMaxKeys - 1 ).nKeyCode == GetKeyCode( CKeyTable::eMaxKeys - 1 ) );
+    }
+
+    void TestModifierRoundTrip()
+    {
+        static CKeyTable table;
+        table.SetModifiers( GetFlags );
+
+        const uint32 nTabled = 1u << CKeyTable::eModifierBits;
+        bool bOk = true;
+
+        for ( uint32 nMask = 0; nMask < nTabled * 2; ++nMask )
+        {
+            uint32 nFlags = 0;
+            const bool bTabled = table.GetModifiers( nMask, nFlags );
+
+            // masks past the table are left to the caller
+            bOk = bOk && bTabled == ( nMask < nTabled ) && ( !bTabled || nFlags == GetFlags( nMask ) );
+        }
+
+        TEST_CHECK( bOk );
+    }
+
+    /** @return the virtual key produces a character */
+    bool IsCharacterKey( uint16 nKeyCode )
+    {
+        return ( nKeyCode >= '0' && nKeyCode <= '9' ) || ( nKeyCode >= 'A' && nKeyCode <= 'Z' ) || nKeyCode == 0x09 || nKeyCode == 0x0D || nKeyCode == 0x20
+               || ( nKeyCode >= 0x60 && nKeyCode <= 0x6F ) || ( nKeyCode >= 0xBA && nKeyCode <= 0xC0 ) || ( nKeyCode >= 0xDB && nKeyCode <= 0xDF );
+    }
+
+    void TestDefaultKeys()
+    {
+#define HTML5_KEY_NAME( name ) #name,
+        const char* names[] = { HTML5_DEFAULT_KEYS( HTML5_KEY_NAME ) };
+#undef HTML5_KEY_NAME
+
+        TEST_CHECK( sizeof( names ) / sizeof( names[0] ) == eDK_Count );
+
+        // every key is in its slot, names and key codes are unique apart from the keypad enter sending VK_RETURN as well
+        int nWrong = 0;
+        int nShared = 0;
+
+        for ( int i = 0; i < eDK_Count; ++i )
+        {
+            const SDefaultKey& key = GetDefaultKey( EDefaultKey( i ) );
+            nWrong += key.eKey == i && key.nKeyCode != 0 && key.bPrintable == IsCharacterKey( key.nKeyCode ) ? 0 : 1;
+
+            for ( int n = i + 1; n < eDK_Count; ++n )
+            {
+                nWrong += strcmp( names[i], names[n] ) == 0 ? 1 : 0;
+                nShared += key.nKeyCode == GetDefaultKey( EDefaultKey( n ) ).nKeyCode ? 1 : 0;
+            }
+        }
+
+        TEST_CHECK( nWrong == 0 );
+        TEST_CHECK( nShared == 1 && GetDefaultKey( eDK_NP_Enter ).nKeyCode == GetDefaultKey( eDK_Enter ).nKeyCode );
+
+        // the table holds every default key under its key id and nothing else
+        static CKeyTable table;
+        uint32 keyIds[eDK_Count];
+
+        for ( int i = 0; i < eDK_Count; ++i )
+        {
+            keyIds[i] = uint32( eDK_Count - 1 - i ) * 2;
+        }
+
+        table.SetDefaultKeys( keyIds );
+        int nMissing = 0;
+
+        for ( uint32 nKey = 0; nKey < CKeyTable::eMaxKeys; ++nKey )
+        {
+            const bool bDefault = nKey % 2 == 0 && nKey / 2 < eDK_Count;
+            const SKeyInfo& info = table.GetKey( nKey );
+
+            if ( !bDefault )
+            {
+                nMissing += info.nKeyCode == 0 ? 0 : 1;
+                continue;
+            }
+
+            const SDefaultKey& key = GetDefaultKey( EDefaultKey( eDK_Count - 1 - nKey / 2 ) );
+            nMissing += info.nKeyCode == key.nKeyCode && info.bPrintable == key.bPrintable ? 0 : 1;
+        }
+
+        TEST_CHECK( nMissing == 0 );
+    }
+
+    void TestModifierFlags()
+    {
+        // CEF flags of every modifier bit: caps lock 1, shift 2, control 4, alt 8, num lock 256, left 1024, right 2048
+        const uint32 bitFlags[][2] =
+        {
+            { eKM_LCtrl, 4 | 1024 },
+            { eKM_LShift, 2 | 1024 },
+            { eKM_LAlt, 8 | 1024 },
+            { eKM_LWin, 0 },
+            { eKM_RCtrl, 4 | 2048 },
+            { eKM_RShift, 2 | 2048 },
+            { eKM_RAlt, 8 | 2048 },
+            { eKM_RWin, 0 },
+            { eKM_NumLock, 256 },
+            { eKM_CapsLock, 1 },
+            { eKM_ScrollLock, 0 },
+        };
+
+        TEST_CHECK( sizeof( bitFlags ) / sizeof( bitFlags[0] ) == CKeyTable::eModifierBits );
+
+        // a mask gets the flags of all its bits, the filled table agrees for every mask
+        static CKeyTable table;
+        table.SetModifiers( GetModifierFlags );
+        int nWrong = 0;
+
+        for ( uint32 nMask = 0; nMask < ( 1u << CKeyTable::eModifierBits ); ++nMask )
+        {
+            uint32 nExpected = 0;
+
+            for ( size_t i = 0; i < sizeof( bitFlags ) / sizeof( bitFlags[0] ); ++i )
+            {
+                nExpected |= ( nMask & bitFlags[i][0] ) ? bitFlags[i][1] : 0;
+            }
+
+            uint32 nFlags = 0;
+            nWrong += table.GetModifiers( nMask, nFlags ) && nFlags == nExpected && GetModifierFlags( nMask ) == nExpected ? 0 : 1;
+        }
+
+        TEST_CHECK( nWrong == 0 );
+    }
+}
+
+int main()
+{
+    TestEmptyTable();
+    TestKeyRoundTrip();
+    TestModifierRoundTrip();
+    TestDefaultKeys();
+    TestModifierFlags();
+    return TEST_RESULT();
+}
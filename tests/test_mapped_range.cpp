@@ -0,0 +1,324 @@
+/* CryHTML5 - for licensing and copyright see license.txt */
+
+// Mappings of plain files at offsets that aren't page aligned, and pak streams serving stored entries from a mapping while scrambled and compressed ones fall back to reads.
+
+#include "StdAfx.h"
+#include "MappedRange.h"
+#include "PakStream.h"
+#include "TestCheck.h"
+
+#include <atomic>
+#include <cstdio>
+#include <map>
+
+using namespace HTML5Plugin;
+
+namespace
+{
+    const char* const s_sPlainFile = "test_mapped_range.bin";
+    const char* const s_sArchive = "test_mapped_range.pak";
+
+    /** @brief byte at a position of the plain file */
+    uint8 GetPlainByte( uint64 nPos )
+    {
+        return uint8( ( nPos * 7 ) & 255 );
+    }
+
+    bool WritePlainFile( size_t nSize )
+    {
+        FILE* pFile = fopen( s_sPlainFile, "wb" );
+
+        if ( !pFile )
+        {
+            return false;
+        }
+
+        for ( size_t i = 0; i < nSize; ++i )
+        {
+            fputc( GetPlainByte( i ), pFile );
+        }
+
+        fclose( pFile );
+        return true;
+    }
+
+    void TestUnalignedRanges()
+    {
+        const size_t nFileSize = 100000;
+        TEST_CHECK( WritePlainFile( nFileSize ) );
+
+        CMappedRange mapping;
+
+        // offsets on, around and between page boundaries (4 KB and 64 KB granularity), up to the last byte
+        const uint64 offsets[] = { 0, 1, 4095, 4096, 4097, 12345, 65535, 65536, 65537, 99999 };
+        int nWrong = 0;
+
+        for ( size_t i = 0; i < sizeof( offsets ) / sizeof( offsets[0] ); ++i )
+        {
+            const uint64 nOffset = offsets[i];
+            const size_t nSize = size_t( nFileSize - nOffset );
+
+            if ( !mapping.Map( s_sPlainFile, nOffset, nSize ) || mapping.GetSize() != nSize )
+            {
+                ++nWrong;
+                continue;
+            }
+
+            for ( size_t k = 0; k < nSize; k += 97 )
+            {
+                nWrong += mapping.GetData()[k] == GetPlainByte( nOffset + k ) ? 0 : 1;
+            }
+
+            nWrong += mapping.GetData()[nSize - 1] == GetPlainByte( nOffset + nSize - 1 ) ? 0 : 1;
+        }
+
+        TEST_CHECK( nWrong == 0 );
+
+        // a short range in the middle of a page
+        TEST_CHECK( mapping.Map( s_sPlainFile, 5000, 3 ) );
+        TEST_CHECK( mapping.GetData() && mapping.GetData()[0] == GetPlainByte( 5000 ) && mapping.GetData()[2] == GetPlainByte( 5002 ) );
+
+        mapping.Unmap();
+        TEST_CHECK( !mapping.GetData() && mapping.GetSize() == 0 );
+    }
+
+    void TestInvalidRanges()
+    {
+        TEST_CHECK( WritePlainFile( 100000 ) );
+
+        CMappedRange mapping;
+        TEST_CHECK( mapping.Map( s_sPlainFile, 0, 10 ) );
+
+        // a failed map releases the previous one
+        TEST_CHECK( !mapping.Map( "test_mapped_range.missing", 0, 10 ) );
+        TEST_CHECK( !mapping.GetData() );
+
+        TEST_CHECK( !mapping.Map( s_sPlainFile, 0, 0 ) );
+        TEST_CHECK( !mapping.Map( s_sPlainFile, 99990, 11 ) );
+        TEST_CHECK( !mapping.Map( s_sPlainFile, 200000, 1 ) );
+        TEST_CHECK( !mapping.GetData() && mapping.GetSize() == 0 );
+    }
+
+    /** @brief an entry of the fake archive */
+    struct SEntry
+    {
+        uint64 nOffset; //!< position in the archive
+        std::string data; //!< contents as the pak returns them
+        bool bStored; //!< FindRange locates it
+    };
+
+    /** @brief pak over an archive on disk, scrambled entries are stored differently from what Read returns like encrypted ones */
+    class CFakePak : public IPakFiles
+    {
+        public:
+            CFakePak()
+                : m_nReads( 0 )
+            {
+            }
+
+            bool Write()
+            {
+                FILE* pFile = fopen( s_sArchive, "wb" );
+
+                if ( !pFile )
+                {
+                    return false;
+                }
+
+                uint64 nOffset = 0;
+                Add( pFile, nOffset, "big", 3000000, true, false );
+                Add( pFile, nOffset, "scrambled", 600000, true, true );
+                Add( pFile, nOffset, "compressed", 700000, false, false );
+                Add( pFile, nOffset, "small", 1000, true, false );
+                Add( pFile, nOffset, "edge", 256 * 1024, true, false );
+                fclose( pFile );
+                return true;
+            }
+
+            const std::string& GetData( const char* sPath )
+            {
+                return m_entries[sPath].data;
+            }
+
+            virtual void* Open( const char* sPath ) override
+            {
+                std::map<std::string, SEntry>::const_iterator it = m_entries.find( sPath );
+
+                if ( it == m_entries.end() )
+                {
+                    return nullptr;
+                }
+
+                SFile* pFile = new SFile;
+                pFile->pEntry = &it->second;
+                pFile->nPos = 0;
+                return pFile;
+            }
+
+            virtual size_t GetSize( void* hFile ) override
+            {
+                return static_cast<SFile*>( hFile )->pEntry->data.size();
+            }
+
+            virtual uint64 GetStamp( void* /*hFile*/ ) override
+            {
+                return 1;
+            }
+
+            virtual bool FindRange( void* hFile, const char* /*sPath*/, std::string& sArchive, uint64& nOffset ) override
+            {
+                const SEntry* pEntry = static_cast<SFile*>( hFile )->pEntry;
+
+                if ( !pEntry->bStored )
+                {
+                    return false;
+                }
+
+                sArchive = s_sArchive;
+                nOffset = pEntry->nOffset;
+                return true;
+            }
+
+            virtual size_t Read( void* hFile, void* pDest, size_t nBytes ) override
+            {
+                SFile* pFile = static_cast<SFile*>( hFile );
+                nBytes = min( nBytes, pFile->pEntry->data.size() - pFile->nPos );
+                memcpy( pDest, pFile->pEntry->data.data() + pFile->nPos, nBytes );
+                pFile->nPos += nBytes;
+                ++m_nReads;
+                return nBytes;
+            }
+
+            virtual void Close( void* hFile ) override
+            {
+                delete static_cast<SFile*>( hFile );
+            }
+
+            std::atomic<int> m_nReads; //!< Read calls so far
+
+        private:
+            struct SFile
+            {
+                const SEntry* pEntry;
+                size_t nPos;
+            };
+
+            /** @brief append an entry behind a 4 byte header, so no entry starts page aligned */
+            void Add( FILE* pFile, uint64& nOffset, const char* sPath, size_t nSize, bool bStored, bool bScrambled )
+            {
+                SEntry entry;
+                entry.data.resize( nSize );
+
+                for ( size_t i = 0; i < nSize; ++i )
+                {
+                    entry.data[i] = char( ( i * 13 + nSize ) & 255 );
+                }
+
+                std::string stored = entry.data;
+
+                for ( size_t i = 0; bScrambled && i < nSize; ++i )
+                {
+                    stored[i] ^= 0x5A;
+                }
+
+                fwrite( "HDR.", 1, 4, pFile );
+                nOffset += 4;
+                entry.nOffset = nOffset;
+                entry.bStored = bStored;
+                fwrite( stored.data(), 1, nSize, pFile );
+                nOffset += nSize;
+
+                m_entries[sPath] = entry;
+            }
+
+            std::map<std::string, SEntry> m_entries;
+    };
+
+    /**
+    * @brief read a file through a stream, waiting for the notifications
+    * @param nReads receives the Read calls the pak saw for it
+    */
+    std::string Fetch( const std::shared_ptr<CFakePak>& pPak, CPakWorkerPool& pool, const char* sPath, int& nReads )
+    {
+        const int nReadsBefore = pPak->m_nReads;
+        std::atomic<int> nReady( 0 );
+
+        const CPakStream::TNotify notify = [&nReady]()
+        {
+            ++nReady;
+        };
+
+        std::shared_ptr<CPakStream> pStream = std::make_shared<CPakStream>( pPak, pool, sPath, ePP_Image );
+        pStream->Open( notify );
+
+        while ( nReady == 0 )
+        {
+            std::this_thread::yield();
+        }
+
+        std::string received;
+        std::vector<char> buffer( 65536 );
+
+        for ( ;; )
+        {
+            const int nBefore = nReady;
+            int nRead = 0;
+
+            if ( !pStream->Read( &buffer[0], int( buffer.size() ), nRead, notify ) )
+            {
+                break;
+            }
+
+            if ( nRead > 0 )
+            {
+                received.append( &buffer[0], nRead );
+                continue;
+            }
+
+            while ( nReady == nBefore )
+            {
+                std::this_thread::yield();
+            }
+        }
+
+        nReads = pPak->m_nReads - nReadsBefore;
+        return received;
+    }
+
+    void TestMappedStreams()
+    {
+        std::shared_ptr<CFakePak> pPak = std::make_shared<CFakePak>();
+        TEST_CHECK( pPak->Write() );
+
+        CPakWorkerPool pool;
+        int nReads = 0;
+
+        // stored entries are only read to verify the head of the mapping
+        TEST_CHECK( Fetch( pPak, pool, "big", nReads ) == pPak->GetData( "big" ) );
+        TEST_CHECK( nReads == 1 );
+        TEST_CHECK( Fetch( pPak, pool, "edge", nReads ) == pPak->GetData( "edge" ) );
+        TEST_CHECK( nReads == 1 );
+
+        // the head doesn't match the mapping: streamed, continuing after the head
+        TEST_CHECK( Fetch( pPak, pool, "scrambled", nReads ) == pPak->GetData( "scrambled" ) );
+        TEST_CHECK( nReads > 1 );
+
+        // not stored as is, or too small to be worth a mapping
+        TEST_CHECK( Fetch( pPak, pool, "compressed", nReads ) == pPak->GetData( "compressed" ) );
+        TEST_CHECK( nReads > 1 );
+        TEST_CHECK( Fetch( pPak, pool, "small", nReads ) == pPak->GetData( "small" ) );
+
+        pool.Stop();
+    }
+}
+
+int main()
+{
+    TestUnalignedRanges();
+    TestInvalidRanges();
+    TestMappedStreams();
+
+    remove( s_sPlainFile );
+    remove( s_sArchive );
+    return TEST_RESULT();
+}
@@ -0,0 +1,453 @@
+/* CryHTML5 - for licensing and copyright see license.txt */
+
+// Pak streams against an in-memory fake pak: every file arrives complete through the continue notifications, opens run by priority and cancelled streams close their files.
+
+#include "StdAfx.h"
+#include "PakStream.h"
+#include "TestCheck.h"
+
+#include <atomic>
+#include <chrono>
+#include <map>
+
+using namespace HTML5Plugin;
+
+namespace
+{
+    /** @brief files held in memory, opens are slow like a disk seek */
+    class CFakePak : public IPakFiles
+    {
+        public:
+            CFakePak()
+                : m_nOpen( 0 )
+                , m_nReads( 0 )
+            {
+            }
+
+            void Add( const std::string& sPath, const std::string& data )
+            {
+                m_files[sPath] = data;
+            }
+
+            const std::string& GetFile( const std::string& sPath )
+            {
+                return m_files[sPath];
+            }
+
+            virtual void* Open( const char* sPath ) override
+            {
+                std::this_thread::sleep_for( std::chrono::milliseconds( 1 ) );
+                {
+                    std::lock_guard<std::mutex> lock( m_lock );
+                    m_opened.push_back( sPath );
+                }
+
+                std::map<std::string, std::string>::const_iterator it = m_files.find( sPath );
+
+                if ( it == m_files.end() )
+                {
+                    return nullptr;
+                }
+
+                ++m_nOpen;
+                SFile* pFile = new SFile;
+                pFile->pData = &it->second;
+                pFile->nPos = 0;
+                return pFile;
+            }
+
+            virtual size_t GetSize( void* hFile ) override
+            {
+                return static_cast<SFile*>( hFile )->pData->size();
+            }
+
+            virtual uint64 GetStamp( void* /*hFile*/ ) override
+            {
+                return 1;
+            }
+
+            virtual bool FindRange( void* /*hFile*/, const char* /*sPath*/, std::string& /*sArchive*/, uint64& /*nOffset*/ ) override
+            {
+                // stored compressed as far as the stream knows, everything is read
+                return false;
+            }
+
+            virtual size_t Read( void* hFile, void* pDest, size_t nBytes ) override
+            {
+                SFile* pFile = static_cast<SFile*>( hFile );
+                nBytes = min( nBytes, pFile->pData->size() - pFile->nPos );
+                memcpy( pDest, pFile->pData->data() + pFile->nPos, nBytes );
+                pFile->nPos += nBytes;
+                ++m_nReads;
+                return nBytes;
+            }
+
+            virtual void Close( void* hFile ) override
+            {
+                --m_nOpen;
+                delete static_cast<SFile*>( hFile );
+            }
+
+            /** @return paths in the order they were opened */
+            std::vector<std::string> GetOpened()
+            {
+                std::lock_guard<std::mutex> lock( m_lock );
+                return m_opened;
+            }
+
+            std::atomic<int> m_nOpen; //!< files open now
+            std::atomic<int> m_nReads; //!< Read calls so far
+
+        private:
+            struct SFile
+            {
+                const std::string* pData;
+                size_t nPos;
+            };
+
+            std::map<std::string, std::string> m_files;
+            std::mutex m_lock; //!< guards m_opened
+            std::vector<std::string> m_opened;
+    };
+
+    /** @brief stands in for the CEF IO thread, notifications post the stream that can continue */
+    class CIOLoop
+    {
+        public:
+            void Post( int nStream )
+            {
+                std::lock_guard<std::mutex> lock( m_lock );
+                m_ready.push_back( nStream );
+                m_wake.notify_one();
+            }
+
+            int Wait()
+            {
+                std::unique_lock<std::mutex> lock( m_lock );
+
+                while ( m_ready.empty() )
+                {
+                    m_wake.wait( lock );
+                }
+
+                const int nStream = m_ready.front();
+                m_ready.erase( m_ready.begin() );
+                return nStream;
+            }
+
+        private:
+            std::mutex m_lock;
+            std::condition_variable m_wake;
+            std::vector<int> m_ready;
+    };
+
+    std::string GetPath( int i )
+    {
+        char sPath[32];
+        sprintf( sPath, "ui/file%d", i );
+        return sPath;
+    }
+
+    /** @brief holds the workers of a pool until Release, so queued jobs pile up */
+    class CPoolGate
+    {
+        public:
+            CPoolGate( CPakWorkerPool& pool, int nThreads )
+                : m_nBlocked( 0 )
+            {
+                m_lock.lock();
+
+                for ( int i = 0; i < nThreads; ++i )
+                {
+                    pool.Submit( 1000, [this]()
+                    {
+                        ++m_nBlocked;
+                        std::lock_guard<std::mutex> lock( m_lock );
+                    } );
+                }
+
+                while ( m_nBlocked < nThreads )
+                {
+                    std::this_thread::yield();
+                }
+            }
+
+            void Release()
+            {
+                m_lock.unlock();
+            }
+
+        private:
+            std::mutex m_lock;
+            std::atomic<int> m_nBlocked;
+    };
+
+    /** @brief read every file through streams, the way the resource handler drives them */
+    void TestStreamAll()
+    {
+        enum
+        {
+            eFiles = 120,
+        };
+
+        std::shared_ptr<CFakePak> pPak = std::make_shared<CFakePak>();
+
+        for ( int i = 0; i < eFiles; ++i )
+        {
+            // icons and a few files larger than a chunk
+            const size_t nSize = i % 7 == 0 ? 700000 : 1000 + i * 37;
+            std::string data( nSize, '\0' );
+
+            for ( size_t k = 0; k < nSize; ++k )
+            {
+                data[k] = char( ( k * 31 + i ) & 255 );
+            }
+
+            pPak->Add( GetPath( i ), data );
+        }
+
+        CPakWorkerPool pool;
+        pool.SetThreadCount( 2 );
+
+        CIOLoop loop;
+        std::vector< std::shared_ptr<CPakStream> > streams;
+
+        // the last one doesn't exist
+        for ( int i = 0; i <= eFiles; ++i )
+        {
+            streams.push_back( std::make_shared<CPakStream>( pPak, pool, i < eFiles ? GetPath( i ).c_str() : "ui/missing", i % 4 ) );
+            streams[i]->Open( [&loop, i]()
+            {
+                loop.Post( i );
+            } );
+        }
+
+        std::vector<std::string> received( eFiles + 1 );
+        std::vector<bool> opened( eFiles + 1, false );
+        std::vector<char> buffer( 32768 );
+        int nMissing = 0;
+        int nDone = 0;
+
+        while ( nDone <= eFiles )
+        {
+            const int i = loop.Wait();
+
+            if ( !opened[i] )
+            {
+                opened[i] = true;
+
+                if ( streams[i]->IsMissing() )
+                {
+                    ++nMissing;
+                    ++nDone;
+                    continue;
+                }
+            }
+
+            // take what is there, a read without data ends this turn until the stream posts again
+            for ( ;; )
+            {
+                int nRead = 0;
+                const bool bMore = streams[i]->Read( &buffer[0], int( buffer.size() ), nRead, [&loop, i]()
+                {
+                    loop.Post( i );
+                } );
+
+                if ( !bMore )
+                {
+                    ++nDone;
+                    break;
+                }
+
+                if ( nRead == 0 )
+                {
+                    break;
+                }
+
+                received[i].append( &buffer[0], nRead );
+            }
+        }
+
+        int nWrong = 0;
+
+        for ( int i = 0; i < eFiles; ++i )
+        {
+            nWrong += received[i] == pPak->GetFile( GetPath( i ) ) && streams[i]->GetSize() == received[i].size() ? 0 : 1;
+        }
+
+        TEST_CHECK( nWrong == 0 );
+        TEST_CHECK( nMissing == 1 && streams[eFiles]->IsMissing() && received[eFiles].empty() );
+
+        // finished streams closed their files
+        streams.clear();
+        pool.Stop();
+        TEST_CHECK( pPak->m_nOpen == 0 );
+    }
+
+    void TestPriorityOrder()
+    {
+        std::shared_ptr<CFakePak> pPak = std::make_shared<CFakePak>();
+
+        for ( int i = 0; i < 40; ++i )
+        {
+            pPak->Add( GetPath( i ), "data" );
+        }
+
+        // one worker, so the opens are logged in the order the pool hands them out
+        CPakWorkerPool pool;
+        pool.SetThreadCount( 1 );
+        CPoolGate gate( pool, 1 );
+
+        std::atomic<int> nOpened( 0 );
+        std::vector< std::shared_ptr<CPakStream> > streams;
+
+        for ( int i = 0; i < 40; ++i )
+        {
+            streams.push_back( std::make_shared<CPakStream>( pPak, pool, GetPath( i ).c_str(), i % 4 ) );
+            streams[i]->Open( [&nOpened]()
+            {
+                ++nOpened;
+            } );
+        }
+
+        TEST_CHECK( pool.GetQueued() == 40 );
+        gate.Release();
+
+        while ( nOpened < 40 )
+        {
+            std::this_thread::yield();
+        }
+
+        // documents first, background last, submission order within a priority
+        const std::vector<std::string> opened = pPak->GetOpened();
+        bool bOrdered = opened.size() == 40;
+
+        for ( size_t k = 1; bOrdered && k < opened.size(); ++k )
+        {
+            const int nPrevious = atoi( opened[k - 1].c_str() + 7 );
+            const int nIndex = atoi( opened[k].c_str() + 7 );
+            bOrdered = nPrevious % 4 > nIndex % 4 || ( nPrevious % 4 == nIndex % 4 && nPrevious < nIndex );
+        }
+
+        TEST_CHECK( bOrdered );
+
+        streams.clear();
+        pool.Stop();
+        TEST_CHECK( pPak->m_nOpen == 0 );
+    }
+
+    void TestCancel()
+    {
+        std::shared_ptr<CFakePak> pPak = std::make_shared<CFakePak>();
+        pPak->Add( GetPath( 0 ), std::string( 600000, 'x' ) );
+
+        CPakWorkerPool pool;
+        std::atomic<int> nNotified( 0 );
+
+        // cancelled mid-stream: the file is closed and no notification follows
+        std::shared_ptr<CPakStream> pStream = std::make_shared<CPakStream>( pPak, pool, GetPath( 0 ).c_str(), ePP_Image );
+        pStream->Open( [&nNotified]()
+        {
+            ++nNotified;
+        } );
+
+        while ( !pStream->IsOpen() )
+        {
+            std::this_thread::yield();
+        }
+
+        // the read stays queued until the stream is cancelled
+        CPoolGate readGate( pool, 2 );
+        char buffer[16];
+        int nRead = 0;
+        TEST_CHECK( pStream->Read( buffer, sizeof( buffer ), nRead, [&nNotified]()
+        {
+            ++nNotified;
+        } ) && nRead == 0 );
+
+        pStream->Cancel();
+        TEST_CHECK( !pStream->Read( buffer, sizeof( buffer ), nRead, CPakStream::TNotify() ) && nRead == 0 );
+        pStream.reset();
+        readGate.Release();
+
+        // cancelled before the open ran
+        CPoolGate openGate( pool, 2 );
+        std::shared_ptr<CPakStream> pEarly = std::make_shared<CPakStream>( pPak, pool, GetPath( 0 ).c_str(), ePP_Image );
+        pEarly->Open( [&nNotified]()
+        {
+            ++nNotified;
+        } );
+        pEarly->Cancel();
+        pEarly.reset();
+        openGate.Release();
+
+        while ( pool.GetQueued() > 0 )
+        {
+            std::this_thread::yield();
+        }
+
+        pool.Stop();
+        TEST_CHECK( pPak->m_nOpen == 0 );
+        TEST_CHECK( nNotified == 1 );
+    }
+
+    void TestCachedStreams()
+    {
+        std::shared_ptr<CFakePak> pPak = std::make_shared<CFakePak>();
+        pPak->Add( GetPath( 0 ), std::string( 5000, 'c' ) );
+
+        CResourceCache cache;
+        cache.SetBudget( 1024 * 1024 );
+
+        CPakWorkerPool pool;
+        int nReadsFirst = 0;
+
+        // the first stream reads the file into the cache, the second is served from it
+        for ( int nPass = 0; nPass < 2; ++nPass )
+        {
+            std::atomic<bool> bOpened( false );
+            std::shared_ptr<CPakStream> pStream = std::make_shared<CPakStream>( pPak, pool, GetPath( 0 ).c_str(), ePP_Layout, &cache );
+            pStream->Open( [&bOpened]()
+            {
+                bOpened = true;
+            } );
+
+            while ( !bOpened )
+            {
+                std::this_thread::yield();
+            }
+
+            std::string received;
+            char buffer[1024];
+            int nRead = 0;
+
+            // a cached file is in memory once open, it never waits for a worker
+            while ( pStream->Read( buffer, sizeof( buffer ), nRead, CPakStream::TNotify() ) && nRead > 0 )
+            {
+                received.append( buffer, nRead );
+            }
+
+            TEST_CHECK( received == pPak->GetFile( GetPath( 0 ) ) );
+
+            if ( nPass == 0 )
+            {
+                nReadsFirst = pPak->m_nReads;
+            }
+        }
+
+        TEST_CHECK( nReadsFirst > 0 && pPak->m_nReads == nReadsFirst );
+        TEST_CHECK( cache.GetCounters().nHits == 1 && cache.GetCounters().nMisses == 1 );
+
+        pool.Stop();
+        TEST_CHECK( pPak->m_nOpen == 0 );
+    }
+}
+
+int main()
+{
+    TestPriorityOrder();
+    TestCancel();
+    TestCachedStreams();
+    TestStreamAll();
+    return TEST_RESULT();
+}
@@ -0,0 +1,215 @@
+/* CryHTML5 - for licensing and copyright see license.txt */
+
+// The SSE2 and AVX2 kernels have to match the scalar reference for every length and alignment, including the scalar tails,
+// and the scalar swizzle and premultiply have to give the exact channel order and c * a / 255 rounded.
+
+#include "StdAfx.h"
+#include "PixelKernels.h"
+#include "TestCheck.h"
+
+using namespace HTML5Plugin;
+
+namespace
+{
+    enum
+    {
+        eMaxBytes = 1024,
+        eMaxOffset = 35,
+    };
+
+    /** @brief fill with a pattern that differs per byte and per call */
+    void Fill( std::vector<uint8>& data, uint32 nSeed )
+    {
+        for ( size_t i = 0; i < data.size(); ++i )
+        {
+            nSeed = nSeed * 1664525u + 1013904223u;
+            data[i] = uint8( nSeed >> 24 );
+        }
+    }
+
+    void TestCopyRow( const SPixelKernels& kernels )
+    {
+        std::vector<uint8> source( eMaxBytes + eMaxOffset );
+        std::vector<uint8> dest( eMaxBytes + eMaxOffset * 2 );
+        int nFailed = 0;
+
+        for ( size_t nBytes = 0; nBytes <= eMaxBytes; nBytes += ( nBytes < 300 ? 1 : 37 ) )
+        {
+            for ( size_t nOffset = 0; nOffset < eMaxOffset; nOffset += 3 )
+            {
+                Fill( source, uint32( nBytes * 131 + nOffset ) );
+                std::fill( dest.begin(), dest.end(), uint8( 0xCD ) );
+
+                kernels.CopyRow( &dest[nOffset + 1], &source[nOffset], nBytes );
+
+                // the copy is exact and nothing around it is touched
+                bool bOk = memcmp( &dest[nOffset + 1], &source[nOffset], nBytes ) == 0;
+
+                for ( size_t i = 0; i < dest.size(); ++i )
+                {
+                    bOk = bOk && ( ( i > nOffset && i <= nOffset + nBytes ) || dest[i] == 0xCD );
+                }
+
+                nFailed += bOk ? 0 : 1;
+            }
+        }
+
+        TEST_CHECK( nFailed == 0 );
+    }
+
+    typedef void ( *TPixelOp )( uint8* pDest, const uint8* pSrc, size_t nPixels );
+
+    /** @brief a per pixel kernel against its scalar version, writing nothing outside the pixels */
+    int CheckPixelOp( TPixelOp op, TPixelOp reference )
+    {
+        std::vector<uint8> source( eMaxBytes + eMaxOffset );
+        std::vector<uint8> dest( eMaxBytes + eMaxOffset * 2 );
+        std::vector<uint8> expected( dest.size() );
+        int nFailed = 0;
+
+        for ( size_t nPixels = 0; nPixels * 4 <= eMaxBytes; ++nPixels )
+        {
+            for ( size_t nOffset = 0; nOffset < eMaxOffset; nOffset += 5 )
+            {
+                Fill( source, uint32( nPixels * 11 + nOffset ) );
+                std::fill( dest.begin(), dest.end(), uint8( 0xCD ) );
+                std::fill( expected.begin(), expected.end(), uint8( 0xCD ) );
+
+                op( &dest[nOffset + 1], &source[nOffset], nPixels );
+                reference( &expected[nOffset + 1], &source[nOffset], nPixels );
+
+                nFailed += dest == expected ? 0 : 1;
+            }
+        }
+
+        return nFailed;
+    }
+
+    void TestSwizzle( const SPixelKernels& kernels )
+    {
+        TEST_CHECK( CheckPixelOp( kernels.Swizzle, GetPixelKernels( ePKL_Scalar ).Swizzle ) == 0 );
+
+        // in place, as the upload does it
+        uint8 pixels[4 * 9];
+
+        for ( int i = 0; i < int( sizeof( pixels ) ); ++i )
+        {
+            pixels[i] = uint8( i );
+        }
+
+        kernels.Swizzle( pixels, pixels, 9 );
+        bool bOk = true;
+
+        for ( int i = 0; i < 9; ++i )
+        {
+            bOk = bOk && pixels[i * 4] == i * 4 + 2 && pixels[i * 4 + 1] == i * 4 + 1 && pixels[i * 4 + 2] == i * 4 && pixels[i * 4 + 3] == i * 4 + 3;
+        }
+
+        TEST_CHECK( bOk );
+    }
+
+    void TestPremultiply( const SPixelKernels& kernels )
+    {
+        TEST_CHECK( CheckPixelOp( kernels.Premultiply, GetPixelKernels( ePKL_Scalar ).Premultiply ) == 0 );
+
+        // every color and alpha pair, in place: c * a / 255 rounded to nearest, alpha kept
+        std::vector<uint8> pixels( 256 * 256 * 4 );
+
+        for ( int a = 0; a < 256; ++a )
+        {
+            for ( int c = 0; c < 256; ++c )
+            {
+                uint8* pPixel = &pixels[( a * 256 + c ) * 4];
+                pPixel[0] = uint8( c );
+                pPixel[1] = uint8( 255 - c );
+                pPixel[2] = uint8( c );
+                pPixel[3] = uint8( a );
+            }
+        }
+
+        kernels.Premultiply( &pixels[0], &pixels[0], 256 * 256 );
+        int nWrong = 0;
+
+        for ( int a = 0; a < 256; ++a )
+        {
+            for ( int c = 0; c < 256; ++c )
+            {
+                const uint8* pPixel = &pixels[( a * 256 + c ) * 4];
+                nWrong += pPixel[0] == ( c * a + 127 ) / 255 && pPixel[1] == ( ( 255 - c ) * a + 127 ) / 255 && pPixel[3] == a ? 0 : 1;
+            }
+        }
+
+        TEST_CHECK( nWrong == 0 );
+    }
+
+    void TestAlphaRange( const SPixelKernels& kernels )
+    {
+        const SPixelKernels& scalar = GetPixelKernels( ePKL_Scalar );
+        std::vector<uint8> source( eMaxBytes + eMaxOffset );
+        int nFailed = 0;
+
+        for ( size_t nPixels = 1; nPixels * 4 <= eMaxBytes; ++nPixels )
+        {
+            for ( size_t nOffset = 0; nOffset < eMaxOffset; nOffset += 5 )
+            {
+                Fill( source, uint32( nPixels * 7 + nOffset ) );
+
+                // every third run is opaque except for one pixel, so min and max come from different lanes and the tail
+                if ( nPixels % 3 == 0 )
+                {
+                    for ( size_t i = 0; i < nPixels; ++i )
+                    {
+                        source[nOffset + i * 4 + 3] = 255;
+                    }
+
+                    source[nOffset + ( nPixels * 5 / 7 ) * 4 + 3] = uint8( nPixels );
+                }
+
+                uint8 nMin = 0, nMax = 0, nRefMin = 0, nRefMax = 0;
+                kernels.AlphaRange( &source[nOffset], nPixels, nMin, nMax );
+                scalar.AlphaRange( &source[nOffset], nPixels, nRefMin, nRefMax );
+
+                nFailed += ( nMin == nRefMin && nMax == nRefMax ) ? 0 : 1;
+            }
+        }
+
+        TEST_CHECK( nFailed == 0 );
+
+        // fully opaque and fully transparent spans
+        std::vector<uint8> opaque( 4 * 67, 255 );
+        uint8 nMin = 0, nMax = 0;
+        kernels.AlphaRange( &opaque[0], 67, nMin, nMax );
+        TEST_CHECK( nMin == 255 && nMax == 255 );
+
+        std::vector<uint8> clear( 4 * 67, 0 );
+        kernels.AlphaRange( &clear[0], 67, nMin, nMax );
+        TEST_CHECK( nMin == 0 && nMax == 0 );
+
+        TEST_CHECK( kernels.level != GetPixelKernels().level || ( IsOpaqueSpan( &opaque[0], 67 ) && !IsOpaqueSpan( &clear[0], 67 ) ) );
+    }
+}
+
+int main()
+{
+    const EPixelKernelLevel best = DetectPixelKernelLevel();
+    TEST_CHECK( GetPixelKernels().level == best );
+
+    for ( int n = ePKL_Scalar; n <= ePKL_AVX2; ++n )
+    {
+        const SPixelKernels& kernels = GetPixelKernels( EPixelKernelLevel( n ) );
+        TEST_CHECK( kernels.level == min( EPixelKernelLevel( n ), best ) );
+
+        if ( kernels.level != n )
+        {
+            printf( "level %d is not supported by this CPU, skipped\n", n );
+            continue;
+        }
+
+        TestCopyRow( kernels );
+        TestSwizzle( kernels );
+        TestPremultiply( kernels );
+        TestAlphaRange( kernels );
+    }
+
+    return TEST_RESULT();
+}
@@ -0,0 +1,119 @@
+/* CryHTML5 - for licensing and copyright see license.txt */
+
+// Resize debouncing: a size is only applied once it was stable for the delay, and readers on other threads never see half a resize.
+
+#include "StdAfx.h"
+#include "ResizeDebounce.h"
+#include "TestCheck.h"
+
+#include <atomic>
+#include <thread>
+
+using namespace HTML5Plugin;
+
+namespace
+{
+    const float fDelay = 0.25f;
+
+    void TestStableSizeIgnored()
+    {
+        CResizeDebounce size( 800, 600 );
+
+        for ( int i = 0; i < 10; ++i )
+        {
+            TEST_CHECK( !size.Update( 800, 600, i * 1.0f, fDelay ) );
+        }
+
+        TEST_CHECK( size.GetWidth() == 800 && size.GetHeight() == 600 );
+    }
+
+    void TestDragIsDebounced()
+    {
+        CResizeDebounce size( 800, 600 );
+        float fNow = 1.0f;
+
+        // a window being dragged changes size every frame, nothing is due
+        for ( int i = 0; i < 60; ++i, fNow += 0.016f )
+        {
+            TEST_CHECK( !size.Update( 800 + i * 4, 600 + i * 2, fNow, fDelay ) );
+        }
+
+        // the last size stays put, it becomes due once the delay passed
+        const int nWidth = 800 + 59 * 4;
+        const int nHeight = 600 + 59 * 2;
+        const float fSettled = fNow - 0.016f;
+
+        TEST_CHECK( !size.Update( nWidth, nHeight, fSettled + 0.1f, fDelay ) );
+        TEST_CHECK( size.Update( nWidth, nHeight, fSettled + fDelay, fDelay ) );
+
+        // not applied yet (e.g. no browser), the size stays due and the old one is reported
+        TEST_CHECK( size.GetWidth() == 800 && size.GetHeight() == 600 );
+        TEST_CHECK( size.Update( nWidth, nHeight, fSettled + 0.5f, fDelay ) );
+
+        size.Apply();
+        TEST_CHECK( size.GetWidth() == nWidth && size.GetHeight() == nHeight );
+        TEST_CHECK( !size.Update( nWidth, nHeight, fSettled + 0.6f, fDelay ) );
+    }
+
+    void TestDragBackCancels()
+    {
+        CResizeDebounce size( 800, 600 );
+
+        TEST_CHECK( !size.Update( 1024, 768, 1.0f, fDelay ) );
+
+        // back at the current size before the delay: nothing to do, and the next change starts a new wait
+        TEST_CHECK( !size.Update( 800, 600, 1.1f, fDelay ) );
+        TEST_CHECK( !size.Update( 1024, 768, 1.2f, fDelay ) );
+        TEST_CHECK( !size.Update( 1024, 768, 1.3f, fDelay ) );
+        TEST_CHECK( size.Update( 1024, 768, 1.45f, fDelay ) );
+    }
+
+    void TestZeroDelay()
+    {
+        CResizeDebounce size( 800, 600 );
+
+        // the first frame of a new size only starts the wait, the next one applies it
+        TEST_CHECK( !size.Update( 640, 480, 1.0f, 0.0f ) );
+        TEST_CHECK( size.Update( 640, 480, 1.0f, 0.0f ) );
+    }
+
+    void TestNoTornReads()
+    {
+        // the render thread resizes between sizes whose width and height always differ by 1000
+        CResizeDebounce size( 1000, 2000 );
+        std::atomic<bool> bDone( false );
+        uint32 nTorn = 0;
+
+        std::thread reader( [&]()
+        {
+            while ( !bDone )
+            {
+                int nWidth, nHeight;
+                size.GetSize( nWidth, nHeight );
+                nTorn += nHeight - nWidth != 1000 ? 1 : 0;
+            }
+        } );
+
+        for ( int i = 0; i < 200000; ++i )
+        {
+            const int nWidth = 1000 + ( i % 500 ) * 3;
+            size.Update( nWidth, nWidth + 1000, float( i ), 0.0f );
+            size.Update( nWidth, nWidth + 1000, float( i ), 0.0f );
+            size.Apply();
+        }
+
+        bDone = true;
+        reader.join();
+        TEST_CHECK( nTorn == 0 );
+    }
+}
+
+int main()
+{
+    TestStableSizeIgnored();
+    TestDragIsDebounced();
+    TestDragBackCancels();
+    TestZeroDelay();
+    TestNoTornReads();
+    return TEST_RESULT();
+}
@@ -0,0 +1,145 @@
+/* CryHTML5 - for licensing and copyright see license.txt */
+
+// LRU cache of cry:// files: eviction follows use within the byte budget, changed stamps miss, held buffers outlive eviction and paths are normalized.
+
+#include "StdAfx.h"
+#include "ResourceCache.h"
+#include "TestCheck.h"
+
+using namespace HTML5Plugin;
+
+namespace
+{
+    /** @brief file contents of nBytes bytes */
+    TResourceBuffer MakeBuffer( size_t nBytes )
+    {
+        return std::make_shared< std::vector<uint8> >( nBytes, uint8( nBytes ) );
+    }
+
+    void TestEvictionOrder()
+    {
+        CResourceCache cache;
+        cache.SetBudget( 1000 );
+
+        cache.Insert( "a", 1, MakeBuffer( 200 ) );
+        cache.Insert( "b", 1, MakeBuffer( 200 ) );
+        cache.Insert( "c", 1, MakeBuffer( 200 ) );
+        cache.Insert( "d", 1, MakeBuffer( 200 ) );
+
+        // a was used last, b is the least recently used one now
+        TEST_CHECK( cache.Find( "a", 1 ) );
+
+        cache.Insert( "e", 1, MakeBuffer( 200 ) );
+        TEST_CHECK( cache.GetCounters().nEvictions == 0 );
+
+        cache.Insert( "f", 1, MakeBuffer( 200 ) );
+        TEST_CHECK( cache.GetCounters().nEvictions == 1 );
+        TEST_CHECK( !cache.Find( "b", 1 ) );
+        TEST_CHECK( cache.Find( "a", 1 ) && cache.Find( "c", 1 ) && cache.Find( "f", 1 ) );
+
+        // d is the oldest now, then e
+        cache.Insert( "g", 1, MakeBuffer( 250 ) );
+        TEST_CHECK( !cache.Find( "d", 1 ) && !cache.Find( "e", 1 ) );
+        TEST_CHECK( cache.GetCounters().nEvictions == 3 );
+
+        const CResourceCache::SCounters counters = cache.GetCounters();
+        TEST_CHECK( counters.nEntries == 4 && counters.nBytes == 850 );
+    }
+
+    void TestBudget()
+    {
+        CResourceCache cache;
+        cache.SetBudget( 1000 );
+        TEST_CHECK( cache.GetMaxEntrySize() == 250 );
+
+        // larger than a quarter of the budget: only streamed
+        cache.Insert( "huge", 1, MakeBuffer( 300 ) );
+        TEST_CHECK( !cache.Find( "huge", 1 ) );
+        TEST_CHECK( cache.GetCounters().nEntries == 0 );
+
+        for ( int i = 0; i < 5; ++i )
+        {
+            char sPath[16];
+            sprintf( sPath, "f%d", i );
+            cache.Insert( sPath, 1, MakeBuffer( 150 ) );
+        }
+
+        // a smaller budget evicts the oldest entries at once
+        cache.SetBudget( 400 );
+        const CResourceCache::SCounters counters = cache.GetCounters();
+        TEST_CHECK( counters.nBytes <= 400 && counters.nEntries == 2 );
+        TEST_CHECK( cache.Find( "f4", 1 ) && cache.Find( "f3", 1 ) && !cache.Find( "f2", 1 ) );
+
+        // no budget, no cache
+        cache.SetBudget( 0 );
+        cache.Insert( "f5", 1, MakeBuffer( 1 ) );
+        TEST_CHECK( cache.GetCounters().nEntries == 0 && cache.GetCounters().nBytes == 0 );
+    }
+
+    void TestStamps()
+    {
+        CResourceCache cache;
+        cache.SetBudget( 1000 );
+        cache.Insert( "a", 1, MakeBuffer( 100 ) );
+
+        // the pak changed: the old version is dropped on the miss
+        TEST_CHECK( !cache.Find( "a", 2 ) );
+        TEST_CHECK( cache.GetCounters().nEntries == 0 );
+
+        cache.Insert( "a", 2, MakeBuffer( 50 ) );
+        TEST_CHECK( cache.Find( "a", 2 ) && cache.Find( "a", 2 )->size() == 50 );
+
+        // inserting the same file again replaces it instead of counting it twice
+        cache.Insert( "a", 2, MakeBuffer( 60 ) );
+        TEST_CHECK( cache.GetCounters().nEntries == 1 && cache.GetCounters().nBytes == 60 );
+
+        const CResourceCache::SCounters counters = cache.GetCounters();
+        TEST_CHECK( counters.nHits == 2 && counters.nMisses == 1 );
+    }
+
+    void TestHeldBuffers()
+    {
+        CResourceCache cache;
+        cache.SetBudget( 400 );
+        cache.Insert( "a", 1, MakeBuffer( 100 ) );
+
+        // a request still serving a buffer keeps it after eviction and clear
+        TResourceBuffer pHeld = cache.Find( "a", 1 );
+
+        for ( int i = 0; i < 4; ++i )
+        {
+            char sPath[16];
+            sprintf( sPath, "f%d", i );
+            cache.Insert( sPath, 1, MakeBuffer( 100 ) );
+        }
+
+        TEST_CHECK( !cache.Find( "a", 1 ) );
+        TEST_CHECK( pHeld && pHeld->size() == 100 && ( *pHeld )[99] == 100 );
+
+        pHeld = cache.Find( "f3", 1 );
+        cache.Clear();
+        TEST_CHECK( cache.GetCounters().nEntries == 0 && cache.GetCounters().nBytes == 0 );
+        TEST_CHECK( pHeld && pHeld->size() == 100 );
+    }
+
+    void TestNormalizedKeys()
+    {
+        TEST_CHECK( CResourceCache::NormalizePath( "/UI\\./Menu//Main.CSS" ) == "ui/menu/main.css" );
+        TEST_CHECK( CResourceCache::NormalizePath( "./ui/../a.png" ) == "ui/../a.png" );
+        TEST_CHECK( CResourceCache::NormalizePath( "ui/.hidden" ) == "ui/.hidden" );
+
+        CResourceCache cache;
+        cache.Insert( "UI/Fonts/Main.ttf", 1, MakeBuffer( 10 ) );
+        TEST_CHECK( cache.Find( "ui\\fonts\\main.ttf", 1 ) );
+    }
+}
+
+int main()
+{
+    TestEvictionOrder();
+    TestBudget();
+    TestStamps();
+    TestHeldBuffers();
+    TestNormalizedKeys();
+    return TEST_RESULT();
+}
@@ -0,0 +1,182 @@
+/* CryHTML5 - for licensing and copyright see license.txt */
+
+// Batched world to screen projection: known positions land where CCamera::Project puts them, and the SSE path matches the scalar one.
+
+#include "StdAfx.h"
+#include "ScreenProjection.h"
+#include "TestCheck.h"
+
+using namespace HTML5Plugin;
+
+namespace
+{
+    const float fPi = 3.14159265f;
+
+    /** @brief positions and results of a batch */
+    struct SBatchData
+    {
+        std::vector<float> x, y, z, ox, oy, oz, sx, sy, depth;
+
+        explicit SBatchData( size_t nCount )
+            : x( nCount ), y( nCount ), z( nCount ), ox( nCount ), oy( nCount ), oz( nCount ), sx( nCount ), sy( nCount ), depth( nCount )
+        {
+        }
+
+        SWorldPosBatch GetBatch( bool bOffsets )
+        {
+            SWorldPosBatch batch;
+            batch.pWorldX = &x[0];
+            batch.pWorldY = &y[0];
+            batch.pWorldZ = &z[0];
+            batch.pOffsetX = bOffsets ? &ox[0] : nullptr;
+            batch.pOffsetY = bOffsets ? &oy[0] : nullptr;
+            batch.pOffsetZ = bOffsets ? &oz[0] : nullptr;
+            batch.pScreenX = &sx[0];
+            batch.pScreenY = &sy[0];
+            batch.pDepth = &depth[0];
+            batch.nCount = uint32( x.size() );
+            return batch;
+        }
+    };
+
+    /** @brief camera at the origin looking along y with z up, 90 degrees vertical field of view on 800x600 */
+    void SetDefaultCamera( CScreenProjection& projection )
+    {
+        const float pos[3] = { 0.0f, 0.0f, 0.0f };
+        const float right[3] = { 1.0f, 0.0f, 0.0f };
+        const float forward[3] = { 0.0f, 1.0f, 0.0f };
+        const float up[3] = { 0.0f, 0.0f, 1.0f };
+        projection.SetView( pos, right, forward, up, fPi * 0.5f, 800.0f / 600.0f, 800, 600 );
+    }
+
+    bool IsNear( float a, float b, float fTolerance )
+    {
+        return fabsf( a - b ) <= fTolerance * max( 1.0f, fabsf( b ) );
+    }
+
+    void TestKnownPositions()
+    {
+        CScreenProjection projection;
+        SetDefaultCamera( projection );
+
+        SBatchData data( 5 );
+        const float positions[5][3] =
+        {
+            { 0.0f, 10.0f, 0.0f }, // center
+            { 10.0f, 10.0f, 0.0f }, // right: ndc x = 1 / ( 800 / 600 ) = 0.75
+            { 0.0f, 10.0f, 5.0f }, // up: ndc y = 0.5
+            { -5.0f, 20.0f, -10.0f }, // left and down
+            { 0.0f, -10.0f, 0.0f }, // behind the camera
+        };
+
+        for ( int i = 0; i < 5; ++i )
+        {
+            data.x[i] = positions[i][0];
+            data.y[i] = positions[i][1];
+            data.z[i] = positions[i][2];
+        }
+
+        projection.ProjectScalar( data.GetBatch( false ) );
+
+        TEST_CHECK( IsNear( data.sx[0], 400.0f, 1e-5f ) && IsNear( data.sy[0], 300.0f, 1e-5f ) && IsNear( data.depth[0], 10.0f, 1e-5f ) );
+        TEST_CHECK( IsNear( data.sx[1], 700.0f, 1e-5f ) && IsNear( data.sy[1], 300.0f, 1e-5f ) );
+        TEST_CHECK( IsNear( data.sx[2], 400.0f, 1e-5f ) && IsNear( data.sy[2], 150.0f, 1e-5f ) );
+        TEST_CHECK( IsNear( data.sx[3], 400.0f - 0.25f * 0.75f * 400.0f, 1e-5f ) && IsNear( data.sy[3], 300.0f + 0.5f * 300.0f, 1e-5f ) );
+        TEST_CHECK( data.depth[4] < 0.0f && IsNear( data.depth[4], -10.0f, 1e-5f ) );
+
+        // the screen transform maps camera pixels to view pixels
+        projection.SetScreenTransform( 0.5f, 10.0f, 2.0f, -20.0f );
+        projection.ProjectScalar( data.GetBatch( false ) );
+        TEST_CHECK( IsNear( data.sx[1], 700.0f * 0.5f + 10.0f, 1e-5f ) && IsNear( data.sy[2], 150.0f * 2.0f - 20.0f, 1e-5f ) );
+    }
+
+    void TestOffsets()
+    {
+        CScreenProjection projection;
+        SetDefaultCamera( projection );
+
+        SBatchData data( 1 );
+        data.y[0] = 10.0f;
+
+        // straight ahead of the camera: x moves sideways, y away, z up
+        data.ox[0] = 2.0f;
+        projection.ProjectScalar( data.GetBatch( true ) );
+        TEST_CHECK( IsNear( data.sx[0], 400.0f + 0.2f * 0.75f * 400.0f, 1e-4f ) && IsNear( data.sy[0], 300.0f, 1e-4f ) );
+
+        data.ox[0] = 0.0f;
+        data.oy[0] = 5.0f;
+        projection.ProjectScalar( data.GetBatch( true ) );
+        TEST_CHECK( IsNear( data.depth[0], 15.0f, 1e-4f ) && IsNear( data.sx[0], 400.0f, 1e-4f ) );
+
+        data.oy[0] = 0.0f;
+        data.oz[0] = 5.0f;
+        projection.ProjectScalar( data.GetBatch( true ) );
+        TEST_CHECK( IsNear( data.sy[0], 150.0f, 1e-4f ) );
+    }
+
+    void TestSimdMatchesScalar()
+    {
+        CScreenProjection projection;
+
+        // a tilted camera away from the origin
+        const float pos[3] = { 12.0f, -30.0f, 8.0f };
+        const float c = cosf( 0.3f ), s = sinf( 0.3f );
+        const float right[3] = { c, -s, 0.0f };
+        const float forward[3] = { s, c, 0.0f };
+        const float up[3] = { 0.0f, 0.0f, 1.0f };
+        projection.SetView( pos, right, forward, up, 1.1f, 16.0f / 9.0f, 1920, 1080 );
+        projection.SetScreenTransform( 0.75f, 0.0f, 0.75f, 0.0f );
+
+        int nFailed = 0;
+        uint32 nState = 17;
+
+        // every remainder of four, with and without offsets
+        for ( size_t nCount = 1; nCount <= 67; ++nCount )
+        {
+            SBatchData data( nCount );
+            SBatchData reference( nCount );
+
+            for ( size_t i = 0; i < nCount; ++i )
+            {
+                float values[6];
+
+                for ( int v = 0; v < 6; ++v )
+                {
+                    nState = nState * 1664525u + 1013904223u;
+                    values[v] = float( int( nState >> 16 ) % 2000 - 1000 ) * 0.05f;
+                }
+
+                data.x[i] = reference.x[i] = values[0];
+                data.y[i] = reference.y[i] = values[1] + 40.0f;
+                data.z[i] = reference.z[i] = values[2];
+                data.ox[i] = reference.ox[i] = values[3] * 0.1f;
+                data.oy[i] = reference.oy[i] = values[4] * 0.1f;
+                data.oz[i] = reference.oz[i] = values[5] * 0.1f;
+            }
+
+            for ( int nOffsets = 0; nOffsets < 2; ++nOffsets )
+            {
+                projection.Project( data.GetBatch( nOffsets != 0 ) );
+                projection.ProjectScalar( reference.GetBatch( nOffsets != 0 ) );
+
+                for ( size_t i = 0; i < nCount; ++i )
+                {
+                    // rsqrt with a newton step and a division against a reciprocal differ in the last bits, far off screen positions magnify it
+                    const bool bOk = IsNear( data.sx[i], reference.sx[i], 1e-3f ) && IsNear( data.sy[i], reference.sy[i], 1e-3f )
+                                     && IsNear( data.depth[i], reference.depth[i], 1e-4f ) && ( data.depth[i] < 0.0f ) == ( reference.depth[i] < 0.0f );
+                    nFailed += bOk ? 0 : 1;
+                }
+            }
+        }
+
+        TEST_CHECK( nFailed == 0 );
+    }
+}
+
+int main()
+{
+    TestKnownPositions();
+    TestOffsets();
+    TestSimdMatchesScalar();
+    return TEST_RESULT();
+}
@@ -0,0 +1,175 @@
+/* CryHTML5 - for licensing and copyright see license.txt */
+
+// Snap grid queries on random layouts match a brute force search for the nearest rect, whatever the cell size, radius and query position.
+
+#include "StdAfx.h"
+#include "SnapGrid.h"
+#include "TestCheck.h"
+
+using namespace HTML5Plugin;
+
+namespace
+{
+    /** @brief small deterministic generator so failures reproduce */
+    struct SRandom
+    {
+        uint32 nState;
+
+        explicit SRandom( uint32 nSeed )
+            : nState( nSeed )
+        {
+        }
+
+        int Next( int nRange )
+        {
+            nState = nState * 1664525u + 1013904223u;
+            return int( ( nState >> 8 ) % uint32( nRange ) );
+        }
+    };
+
+    /** @return squared distance from a point to a rect, 0 inside */
+    float GetDistance( const SDirtyRect& rect, float fX, float fY )
+    {
+        const float dx = max( max( float( rect.x ) - fX, fX - float( rect.x2 ) ), 0.0f );
+        const float dy = max( max( float( rect.y ) - fY, fY - float( rect.y2 ) ), 0.0f );
+        return dx * dx + dy * dy;
+    }
+
+    /**
+    * @brief nearest rect by checking all of them
+    * @return index of the closest rect within the radius, the smallest of equally close ones, -1 if none
+    */
+    int FindNearestBruteForce( const std::vector<SDirtyRect>& rects, float fX, float fY, float fRadius )
+    {
+        int nBest = -1;
+
+        for ( size_t i = 0; i < rects.size(); ++i )
+        {
+            const float fDistance = GetDistance( rects[i], fX, fY );
+
+            if ( rects[i].IsEmpty() || fDistance > fRadius * fRadius )
+            {
+                continue;
+            }
+
+            if ( nBest < 0 )
+            {
+                nBest = int( i );
+                continue;
+            }
+
+            const float fBest = GetDistance( rects[nBest], fX, fY );
+
+            if ( fDistance < fBest || ( fDistance == fBest && rects[i].GetArea() < rects[nBest].GetArea() ) )
+            {
+                nBest = int( i );
+            }
+        }
+
+        return nBest;
+    }
+
+    void TestRandomLayouts()
+    {
+        SRandom random( 9 );
+        int nWrong = 0;
+        int nHits = 0;
+        int nQueries = 0;
+
+        for ( int nLayout = 0; nLayout < 60; ++nLayout )
+        {
+            // buttons and labels of all sizes, some empty, some hanging over the top left of the view
+            std::vector<SDirtyRect> rects;
+            const int nRects = 1 + random.Next( 300 );
+
+            for ( int i = 0; i < nRects; ++i )
+            {
+                const int x = random.Next( 1900 ) - 50;
+                const int y = random.Next( 1000 ) - 50;
+                rects.push_back( SDirtyRect( x, y, x + random.Next( 200 ), y + random.Next( 80 ) ) );
+            }
+
+            CSnapGrid grid;
+            grid.Build( &rects[0], int( rects.size() ), 16 + random.Next( 100 ) );
+
+            for ( int q = 0; q < 2000; ++q )
+            {
+                // a quarter of the queries sit on pixel edges, where rects end and cells begin
+                const bool bEdge = q % 4 == 0;
+                const float fX = float( random.Next( 2100 ) - 100 ) + ( bEdge ? 0.0f : random.Next( 100 ) * 0.01f );
+                const float fY = float( random.Next( 1200 ) - 100 ) + ( bEdge ? 0.0f : random.Next( 100 ) * 0.01f );
+                const float fRadius = float( random.Next( 120 ) );
+
+                SDirtyRect found;
+                const bool bFound = grid.FindNearest( fX, fY, fRadius, found );
+                const int nExpected = FindNearestBruteForce( rects, fX, fY, fRadius );
+
+                ++nQueries;
+
+                if ( bFound != ( nExpected >= 0 ) )
+                {
+                    ++nWrong;
+                    continue;
+                }
+
+                // equally close rects of the same size may be told apart either way
+                if ( bFound )
+                {
+                    const SDirtyRect& expected = rects[nExpected];
+                    nWrong += GetDistance( found, fX, fY ) == GetDistance( expected, fX, fY ) && found.GetArea() == expected.GetArea() ? 0 : 1;
+                    ++nHits;
+                }
+            }
+        }
+
+        TEST_CHECK( nWrong == 0 );
+
+        // the layouts are dense enough that both outcomes are covered
+        TEST_CHECK( nHits > nQueries / 4 && nHits < nQueries * 3 / 4 );
+    }
+
+    void TestContainedAndEdges()
+    {
+        // a panel with a button inside it, both contain the point and the button is picked
+        const SDirtyRect rects[] =
+        {
+            SDirtyRect( 0, 0, 400, 300 ),
+            SDirtyRect( 100, 100, 200, 140 ),
+            SDirtyRect( 500, 0, 600, 40 ),
+            SDirtyRect( 700, 700, 700, 800 ),
+        };
+
+        CSnapGrid grid;
+        grid.Build( rects, 4, 64 );
+        TEST_CHECK( grid.GetCount() == 3 );
+
+        SDirtyRect found;
+        TEST_CHECK( grid.FindNearest( 150.0f, 120.0f, 0.0f, found ) && found.x == 100 && found.x2 == 200 );
+        TEST_CHECK( grid.FindNearest( 10.0f, 10.0f, 0.0f, found ) && found.x == 0 && found.x2 == 400 );
+
+        // the right edge belongs to the rect for distances, a radius reaching exactly to it finds it
+        TEST_CHECK( grid.FindNearest( 440.0f, 20.0f, 40.0f, found ) && found.x == 0 );
+        TEST_CHECK( !grid.FindNearest( 440.0f, 20.0f, 39.0f, found ) );
+        TEST_CHECK( grid.FindNearest( 650.0f, 20.0f, 50.0f, found ) && found.x == 500 );
+
+        // equally close, the smaller one wins
+        TEST_CHECK( grid.FindNearest( 450.0f, 20.0f, 50.0f, found ) && found.x == 500 );
+
+        // the empty rect was dropped, nothing is near it
+        TEST_CHECK( !grid.FindNearest( 700.0f, 750.0f, 90.0f, found ) );
+
+        grid.Clear();
+        TEST_CHECK( grid.GetCount() == 0 && !grid.FindNearest( 150.0f, 120.0f, 1000.0f, found ) );
+
+        // only empty rects build an empty grid
+        grid.Build( rects + 3, 1 );
+        TEST_CHECK( grid.GetCount() == 0 && !grid.FindNearest( 700.0f, 700.0f, 1000.0f, found ) );
+    }
+}
+
+int main()
+{
+    TestRandomLayouts();
+    TestContainedAndEdges();
+    return TEST_RESULT();
+}
@@ -0,0 +1,236 @@
+/* CryHTML5 - for licensing and copyright see license.txt */
+
+// Staging ring against a fake device: slots are reused in order, busy slots are skipped and a ring that is all busy falls back.
+
+#include "StdAfx.h"
+#include "StagingRing.h"
+#include "TestCheck.h"
+
+using namespace HTML5Plugin;
+
+namespace
+{
+    /** @brief staging textures in memory, a slot stays busy for nLatency frames after its copy was queued (like MAP_FLAG_DO_NOT_WAIT failing) */
+    class CFakeStagingDevice : public IStagingDevice
+    {
+        public:
+            struct SSlot
+            {
+                std::vector<uint8> data;
+                int nBusyUntil; //!< frame the GPU is done with the slot
+                bool bMapped;
+            };
+
+            int nWidth;
+            int nHeight;
+            int nFrame;
+            int nLatency;
+            int nFailCreate; //!< slot id CreateStaging fails for (-1 = none)
+            SSlot slots[CStagingRing::eMaxSlots];
+            bool bCreated[CStagingRing::eMaxSlots];
+            std::vector<uint8> target;
+            std::vector<int> copies; //!< slot of every queued copy
+
+            CFakeStagingDevice( int nW, int nH )
+                : nWidth( nW )
+                , nHeight( nH )
+                , nFrame( 0 )
+                , nLatency( 0 )
+                , nFailCreate( -1 )
+                , target( nW * nH * 4, 0 )
+            {
+                for ( int i = 0; i < CStagingRing::eMaxSlots; ++i )
+                {
+                    bCreated[i] = false;
+                }
+            }
+
+            int GetCreated() const
+            {
+                int nCount = 0;
+
+                for ( int i = 0; i < CStagingRing::eMaxSlots; ++i )
+                {
+                    nCount += bCreated[i] ? 1 : 0;
+                }
+
+                return nCount;
+            }
+
+            virtual bool CreateStaging( int nSlot, int nW, int nH )
+            {
+                if ( nSlot == nFailCreate || nSlot >= CStagingRing::eMaxSlots )
+                {
+                    return false;
+                }
+
+                bCreated[nSlot] = true;
+                slots[nSlot].data.assign( nW * nH * 4, 0 );
+                slots[nSlot].nBusyUntil = 0;
+                slots[nSlot].bMapped = false;
+                return true;
+            }
+
+            virtual void ReleaseStaging( int nSlot )
+            {
+                bCreated[nSlot] = false;
+            }
+
+            virtual bool MapStaging( int nSlot, uint8*& pData, int& nPitch )
+            {
+                if ( !bCreated[nSlot] || slots[nSlot].nBusyUntil > nFrame )
+                {
+                    return false;
+                }
+
+                slots[nSlot].bMapped = true;
+                pData = &slots[nSlot].data[0];
+                nPitch = nWidth * 4;
+                return true;
+            }
+
+            virtual void UnmapStaging( int nSlot )
+            {
+                slots[nSlot].bMapped = false;
+            }
+
+            virtual void CopyToTarget( int nSlot, const SDirtyRect& rect )
+            {
+                TEST_CHECK( !slots[nSlot].bMapped );
+
+                for ( int y = rect.y; y < rect.y2; ++y )
+                {
+                    memcpy( &target[( y * nWidth + rect.x ) * 4], &slots[nSlot].data[( y * nWidth + rect.x ) * 4], ( rect.x2 - rect.x ) * 4 );
+                }
+
+                slots[nSlot].nBusyUntil = nFrame + nLatency;
+                copies.push_back( nSlot );
+            }
+    };
+
+    enum
+    {
+        eWidth = 64,
+        eHeight = 32,
+    };
+
+    /** @brief frame where every pixel holds nValue + its index */
+    std::vector<uint8> MakeFrame( uint8 nValue )
+    {
+        std::vector<uint8> frame( eWidth * eHeight * 4 );
+
+        for ( size_t i = 0; i < frame.size(); ++i )
+        {
+            frame[i] = uint8( nValue + i );
+        }
+
+        return frame;
+    }
+
+    /** @return true when rect of the target matches the frame */
+    bool TargetMatches( const CFakeStagingDevice& device, const std::vector<uint8>& frame, const SDirtyRect& rect )
+    {
+        bool bOk = true;
+
+        for ( int y = rect.y; y < rect.y2; ++y )
+        {
+            const size_t nOffset = ( y * eWidth + rect.x ) * 4;
+            bOk = bOk && memcmp( &device.target[nOffset], &frame[nOffset], ( rect.x2 - rect.x ) * 4 ) == 0;
+        }
+
+        return bOk;
+    }
+
+    void TestReuseInOrder()
+    {
+        CFakeStagingDevice device( eWidth, eHeight );
+        CStagingRing ring;
+        TEST_CHECK( ring.Configure( &device, 3, eWidth, eHeight ) == 3 );
+
+        // the GPU keeps up: every upload takes the next slot
+        const SDirtyRect rects[] = { SDirtyRect( 0, 0, 8, 8 ), SDirtyRect( 40, 10, 64, 32 ) };
+
+        for ( int i = 0; i < 7; ++i )
+        {
+            const std::vector<uint8> frame = MakeFrame( uint8( i * 17 ) );
+            TEST_CHECK( ring.Upload( &frame[0], eWidth * 4, rects, 2 ) );
+            TEST_CHECK( TargetMatches( device, frame, rects[0] ) && TargetMatches( device, frame, rects[1] ) );
+            ++device.nFrame;
+        }
+
+        static const int order[] = { 0, 0, 1, 1, 2, 2, 0, 0, 1, 1, 2, 2, 0, 0 };
+        TEST_CHECK( device.copies.size() == 14 && std::equal( device.copies.begin(), device.copies.end(), order ) );
+        TEST_CHECK( ring.GetStats().nUploads == 7 && ring.GetStats().nBusySkips == 0 && ring.GetStats().nFallbacks == 0 );
+    }
+
+    void TestBusySkipAndFallback()
+    {
+        CFakeStagingDevice device( eWidth, eHeight );
+        device.nLatency = 2;
+
+        CStagingRing ring;
+        ring.Configure( &device, 2, eWidth, eHeight );
+
+        const SDirtyRect rect( 4, 4, 20, 20 );
+        const std::vector<uint8> a = MakeFrame( 1 );
+        const std::vector<uint8> b = MakeFrame( 2 );
+        const std::vector<uint8> c = MakeFrame( 3 );
+
+        // two uploads in the same frame use both slots
+        TEST_CHECK( ring.Upload( &a[0], eWidth * 4, &rect, 1 ) );
+        TEST_CHECK( ring.Upload( &b[0], eWidth * 4, &rect, 1 ) );
+        TEST_CHECK( TargetMatches( device, b, rect ) );
+
+        // the third finds both in flight, the caller has to upload directly and the target stays untouched
+        TEST_CHECK( !ring.Upload( &c[0], eWidth * 4, &rect, 1 ) );
+        TEST_CHECK( TargetMatches( device, b, rect ) );
+        TEST_CHECK( ring.GetStats().nFallbacks == 1 && ring.GetStats().nBusySkips == 2 );
+
+        // once the GPU caught up the ring is used again
+        device.nFrame += 2;
+        TEST_CHECK( ring.Upload( &c[0], eWidth * 4, &rect, 1 ) );
+        TEST_CHECK( TargetMatches( device, c, rect ) );
+        TEST_CHECK( ring.GetStats().nUploads == 3 );
+
+        // slot 0 is busy again, slot 1 is free: the busy one is skipped instead of waited for
+        device.slots[1].nBusyUntil = 0;
+        device.slots[0].nBusyUntil = device.nFrame + 5;
+        TEST_CHECK( ring.Upload( &a[0], eWidth * 4, &rect, 1 ) );
+        TEST_CHECK( device.copies.back() == 1 );
+    }
+
+    void TestConfigure()
+    {
+        CFakeStagingDevice device( eWidth, eHeight );
+        CStagingRing ring;
+
+        // more slots than useful are clamped
+        TEST_CHECK( ring.Configure( &device, 100, eWidth, eHeight ) == CStagingRing::eMaxSlots );
+        TEST_CHECK( device.GetCreated() == CStagingRing::eMaxSlots );
+
+        // a slot that can't be created is left out
+        device.nFailCreate = 1;
+        TEST_CHECK( ring.Configure( &device, 3, eWidth, eHeight ) == 2 );
+        TEST_CHECK( device.GetCreated() == 2 && !device.bCreated[1] );
+
+        // without slots every upload falls back
+        ring.Configure( &device, -1, eWidth, eHeight );
+        TEST_CHECK( ring.GetSlots() == 0 && device.GetCreated() == 0 );
+
+        const std::vector<uint8> frame = MakeFrame( 0 );
+        const SDirtyRect rect( 0, 0, 4, 4 );
+        TEST_CHECK( !ring.Upload( &frame[0], eWidth * 4, &rect, 1 ) );
+
+        ring.Configure( &device, 2, eWidth, eHeight );
+        ring.Release();
+        TEST_CHECK( device.GetCreated() == 0 );
+    }
+}
+
+int main()
+{
+    TestReuseInOrder();
+    TestBusySkipAndFallback();
+    TestConfigure();
+    return TEST_RESULT();
+}
@@ -0,0 +1,171 @@
+/* CryHTML5 - for licensing and copyright see license.txt */
+
+// Tile diffing: repaints with identical pixels are skipped, real changes are found, including partial tiles at the edges.
+
+#include "StdAfx.h"
+#include "TileTracker.h"
+#include "TestCheck.h"
+
+using namespace HTML5Plugin;
+
+namespace
+{
+    /** @return number of set tiles */
+    int CountTiles( const CTileMask& mask )
+    {
+        int nCount = 0;
+
+        for ( int ty = 0; ty < mask.GetTilesY(); ++ty )
+        {
+            for ( int tx = 0; tx < mask.GetTilesX(); ++tx )
+            {
+                nCount += mask.Test( tx, ty ) ? 1 : 0;
+            }
+        }
+
+        return nCount;
+    }
+
+    /** @brief region covering a whole surface */
+    CDirtyRegion GetFull( int nWidth, int nHeight )
+    {
+        CDirtyRegion region;
+        region.Add( SDirtyRect( 0, 0, nWidth, nHeight ) );
+        return region;
+    }
+
+    void TestUnchangedTilesSkipped()
+    {
+        const int nWidth = 256;
+        const int nHeight = 128;
+        std::vector<uint8> frame( nWidth * nHeight * 4, 0x40 );
+
+        CTileTracker tracker;
+        tracker.Configure( nWidth, nHeight, 64 );
+
+        CTileMask changed;
+        CDirtyRegion changedRegion;
+
+        // nothing is known yet, every touched tile is new
+        tracker.Diff( &frame[0], GetFull( nWidth, nHeight ), changed, changedRegion );
+        TEST_CHECK( CountTiles( changed ) == 4 * 2 );
+        TEST_CHECK( changedRegion.GetArea() == nWidth * nHeight );
+
+        // the same pixels painted again
+        tracker.Diff( &frame[0], GetFull( nWidth, nHeight ), changed, changedRegion );
+        TEST_CHECK( changed.IsEmpty() );
+        TEST_CHECK( changedRegion.IsEmpty() );
+
+        // one pixel changes inside tile 2, 1
+        frame[( 100 * nWidth + 150 ) * 4 + 3] = 0x41;
+        tracker.Diff( &frame[0], GetFull( nWidth, nHeight ), changed, changedRegion );
+        TEST_CHECK( CountTiles( changed ) == 1 );
+        TEST_CHECK( changed.Test( 2, 1 ) );
+        TEST_CHECK( changedRegion.GetArea() == 64 * 64 );
+    }
+
+    void TestOnlyTouchedTilesHashed()
+    {
+        const int nWidth = 128;
+        const int nHeight = 128;
+        std::vector<uint8> frame( nWidth * nHeight * 4, 0 );
+
+        CTileTracker tracker;
+        tracker.Configure( nWidth, nHeight, 32 );
+
+        CTileMask changed;
+        CDirtyRegion changedRegion;
+        tracker.Diff( &frame[0], GetFull( nWidth, nHeight ), changed, changedRegion );
+
+        // a change outside the reported dirty area is not looked at
+        frame[( 10 * nWidth + 10 ) * 4] = 1;
+        frame[( 100 * nWidth + 100 ) * 4] = 1;
+
+        CDirtyRegion dirty;
+        dirty.Add( SDirtyRect( 96, 96, 100, 100 ) );
+        tracker.Diff( &frame[0], dirty, changed, changedRegion );
+        TEST_CHECK( CountTiles( changed ) == 1 );
+        TEST_CHECK( changed.Test( 3, 3 ) );
+    }
+
+    void TestEdgeTiles()
+    {
+        // 100x70 with 32 pixel tiles leaves partial tiles on the right and bottom
+        const int nWidth = 100;
+        const int nHeight = 70;
+        std::vector<uint8> frame( nWidth * nHeight * 4, 0 );
+
+        CTileTracker tracker;
+        tracker.Configure( nWidth, nHeight, 32 );
+
+        CTileMask changed;
+        CDirtyRegion changedRegion;
+        tracker.Diff( &frame[0], GetFull( nWidth, nHeight ), changed, changedRegion );
+        TEST_CHECK( changed.GetTilesX() == 4 && changed.GetTilesY() == 3 );
+        TEST_CHECK( changedRegion.GetArea() == nWidth * nHeight );
+
+        frame[( ( nHeight - 1 ) * nWidth + nWidth - 1 ) * 4] = 9;
+        tracker.Diff( &frame[0], GetFull( nWidth, nHeight ), changed, changedRegion );
+        TEST_CHECK( CountTiles( changed ) == 1 && changed.Test( 3, 2 ) );
+        TEST_CHECK( changedRegion.GetCount() == 1 && changedRegion[0].x2 == nWidth && changedRegion[0].y2 == nHeight );
+        TEST_CHECK( changedRegion.GetArea() == 4 * 6 );
+    }
+
+    void TestConfigureForgetsHashes()
+    {
+        std::vector<uint8> frame( 64 * 64 * 4, 7 );
+
+        CTileTracker tracker;
+        tracker.Configure( 64, 64, 16 );
+
+        CTileMask changed;
+        CDirtyRegion changedRegion;
+        tracker.Diff( &frame[0], GetFull( 64, 64 ), changed, changedRegion );
+
+        tracker.Configure( 64, 64, 16 );
+        tracker.Diff( &frame[0], GetFull( 64, 64 ), changed, changedRegion );
+        TEST_CHECK( CountTiles( changed ) == 16 );
+    }
+
+    void TestMaskSpans()
+    {
+        CTileMask a;
+        a.Configure( 100, 40, 20 );
+        a.Set( 1, 0 );
+        a.Set( 2, 0 );
+        a.Set( 4, 1 );
+
+        CTileMask b;
+        b.Configure( 100, 40, 20 );
+        TEST_CHECK( b.IsEmpty() );
+        TEST_CHECK( a.IsCompatible( b ) );
+        b.Set( 0, 1 );
+        b.Or( a );
+
+        std::vector<SDirtyRect> spans;
+        b.ForEachSpan( [&spans]( const SDirtyRect & rect )
+        {
+            spans.push_back( rect );
+        } );
+
+        // runs of neighbouring tiles become one rect
+        TEST_CHECK( spans.size() == 3 );
+        TEST_CHECK( spans.size() == 3 && spans[0].x == 20 && spans[0].x2 == 60 && spans[0].y == 0 && spans[0].y2 == 20 );
+        TEST_CHECK( spans.size() == 3 && spans[1].x == 0 && spans[1].x2 == 20 && spans[1].y == 20 );
+        TEST_CHECK( spans.size() == 3 && spans[2].x == 80 && spans[2].x2 == 100 );
+
+        CTileMask c;
+        c.Configure( 100, 40, 10 );
+        TEST_CHECK( !a.IsCompatible( c ) );
+    }
+}
+
+int main()
+{
+    TestUnchangedTilesSkipped();
+    TestOnlyTouchedTilesHashed();
+    TestEdgeTiles();
+    TestConfigureForgetsHashes();
+    TestMaskSpans();
+    return TEST_RESULT();
+}
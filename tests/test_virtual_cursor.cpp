@@ -0,0 +1,166 @@
+/* CryHTML5 - for licensing and copyright see license.txt */
+
+// Virtual cursor: the position stays inside the bounds and stops reporting moves against an edge, the response is clamped to full speed,
+// and a stick jittering on the edge of the dead zone doesn't release (and snap) until it falls past the hysteresis band.
+
+#include "StdAfx.h"
+#include "VirtualCursor.h"
+#include "TestCheck.h"
+
+using namespace HTML5Plugin;
+
+namespace
+{
+    enum
+    {
+        eWidth = 1920,
+        eHeight = 1080,
+    };
+
+    const float s_fFrame = 1.0f / 60.0f;
+
+    /** @brief default response without acceleration, bounds of a 1080p screen */
+    void Setup( CVirtualCursor& cursor )
+    {
+        SVirtualCursorSettings settings;
+        settings.fAccelTime = 0.0f;
+        cursor.SetSettings( settings );
+        cursor.SetBounds( 0.0f, 0.0f, float( eWidth - 1 ), float( eHeight - 1 ) );
+    }
+
+    void TestClamping()
+    {
+        CVirtualCursor cursor;
+        Setup( cursor );
+
+        // one second of full stick to the right ends on the last column, then stops reporting moves
+        float x = 1800.0f, y = 500.0f;
+        cursor.SetStick( 1.0f, 0.0f );
+        int nMoves = 0;
+
+        for ( int i = 0; i < 60; ++i )
+        {
+            nMoves += cursor.Update( s_fFrame, x, y ) ? 1 : 0;
+        }
+
+        TEST_CHECK( x == float( eWidth - 1 ) && y == 500.0f );
+        TEST_CHECK( nMoves == 8 );
+
+        // sliding along the edge still moves
+        cursor.SetStick( 0.7f, -0.7f );
+        TEST_CHECK( cursor.Update( s_fFrame, x, y ) && x == float( eWidth - 1 ) && y < 500.0f );
+
+        // into the top left corner
+        cursor.SetStick( -1.0f, -1.0f );
+
+        for ( int i = 0; i < 300; ++i )
+        {
+            cursor.Update( s_fFrame, x, y );
+        }
+
+        TEST_CHECK( x == 0.0f && y == 0.0f && !cursor.Update( s_fFrame, x, y ) );
+
+        // positions from elsewhere, like snap targets, are clamped the same way
+        float sx = -30.0f, sy = 5000.0f;
+        cursor.Clamp( sx, sy );
+        TEST_CHECK( sx == 0.0f && sy == float( eHeight - 1 ) );
+
+        // without bounds nothing is clamped
+        CVirtualCursor free;
+        float fx = 0.0f, fy = 0.0f;
+        free.SetStick( -1.0f, 0.0f );
+        TEST_CHECK( free.Update( s_fFrame, fx, fy ) && fx < 0.0f );
+        free.Clamp( fx, fy );
+        TEST_CHECK( fx < 0.0f );
+    }
+
+    void TestResponseClamped()
+    {
+        CVirtualCursor cursor;
+        Setup( cursor );
+        const float fMaxStep = cursor.GetSettings().fMaxSpeed * s_fFrame;
+
+        // deflections past the rim of the stick don't go faster than full speed, in any direction
+        TEST_CHECK( cursor.GetResponse( 1.0f ) == 1.0f && cursor.GetResponse( 1.5f ) == 1.0f );
+
+        float x = 900.0f, y = 500.0f;
+        cursor.SetStick( 1.0f, 1.0f );
+        TEST_CHECK( cursor.Update( s_fFrame, x, y ) );
+
+        const float fStep = sqrtf( ( x - 900.0f ) * ( x - 900.0f ) + ( y - 500.0f ) * ( y - 500.0f ) );
+        TEST_CHECK( fabsf( fStep - fMaxStep ) < 1e-3f && fabsf( ( x - 900.0f ) - ( y - 500.0f ) ) < 1e-4f );
+
+        // the dead zone is clamped below full deflection, so a full stick still moves
+        SVirtualCursorSettings settings = cursor.GetSettings();
+        settings.fDeadZone = 2.0f;
+        cursor.SetSettings( settings );
+        TEST_CHECK( cursor.GetResponse( 0.5f ) == 0.0f && cursor.GetResponse( 1.0f ) == 1.0f );
+    }
+
+    void TestSnapHysteresis()
+    {
+        CVirtualCursor cursor;
+        Setup( cursor );
+
+        const SVirtualCursorSettings& settings = cursor.GetSettings();
+        const float fInside = settings.fDeadZone - settings.fHysteresis * 0.5f; //!< in the dead zone, within the band
+        const float fOutside = settings.fDeadZone + 0.02f; //!< just out of the dead zone
+        const float fReleased = settings.fDeadZone - settings.fHysteresis * 1.5f; //!< below the band
+
+        float x = 900.0f, y = 500.0f;
+        cursor.SetStick( 0.8f, 0.0f );
+        TEST_CHECK( cursor.Update( s_fFrame, x, y ) && cursor.IsActive() );
+
+        // jitter on the edge of the dead zone moves while outside, but never releases
+        int nReleases = 0;
+        int nStillMoves = 0;
+
+        for ( int i = 0; i < 100; ++i )
+        {
+            const float fStick = i % 2 ? fInside : fOutside;
+            const float fOldX = x;
+            cursor.SetStick( fStick, 0.0f );
+            const bool bMoved = cursor.Update( s_fFrame, x, y );
+
+            nStillMoves += fStick == fInside && ( bMoved || x != fOldX ) ? 1 : 0;
+            nStillMoves += fStick == fOutside && !bMoved ? 1 : 0;
+            nReleases += cursor.ConsumeRelease() ? 1 : 0;
+        }
+
+        TEST_CHECK( nReleases == 0 && nStillMoves == 0 && cursor.IsActive() );
+
+        // falling past the band releases once
+        cursor.SetStick( fReleased, 0.0f );
+        TEST_CHECK( !cursor.Update( s_fFrame, x, y ) && !cursor.IsActive() );
+        TEST_CHECK( cursor.ConsumeRelease() && !cursor.ConsumeRelease() );
+
+        // from rest, the band doesn't hold anything: the stick has to leave the dead zone to count
+        cursor.SetStick( fInside, 0.0f );
+        TEST_CHECK( !cursor.Update( s_fFrame, x, y ) && !cursor.IsActive() );
+        cursor.SetStick( 0.0f, 0.0f );
+        TEST_CHECK( !cursor.Update( s_fFrame, x, y ) && !cursor.ConsumeRelease() );
+
+        // without hysteresis the same jitter releases on every dip
+        SVirtualCursorSettings edge = settings;
+        edge.fHysteresis = 0.0f;
+        cursor.SetSettings( edge );
+        nReleases = 0;
+
+        for ( int i = 0; i < 100; ++i )
+        {
+            cursor.SetStick( i % 2 ? fInside : fOutside, 0.0f );
+            cursor.Update( s_fFrame, x, y );
+            nReleases += cursor.ConsumeRelease() ? 1 : 0;
+        }
+
+        TEST_CHECK( nReleases == 50 );
+    }
+}
+
+int main()
+{
+    TestClamping();
+    TestResponseClamped();
+    TestSnapHysteresis();
+    return TEST_RESULT();
+}